@@ -118,8 +118,8 @@ ifeq ($(WITH_TLS),1)
   LDFLAGS += -lssl
 endif
 
-# Link against pthread and dependencies
-LDFLAGS += -lpthread -lredisx -lxchange 
+# Link against pthread, rt (for shm_open()) and dependencies
+LDFLAGS += -lpthread -lrt -lredisx -lxchange 
 
 # Search for libraries under LIB
 ifneq ($(findstring $(LIB),$(LD_LIBRARY_PATH)),$LIB)
@@ -17,7 +17,7 @@
 #include <smax.h>
 
 
-#define RELEASEID       "<release>"     ///< Redis PUB/SUB channel prefix for wait release notifications.
+#define SMAX_BINARY_HEADER_SIZE   2     ///< Bytes in the header of binary encoded values ('\0' + type code).
 
 /// \cond PROTECTED
 
@@ -28,9 +28,12 @@ typedef struct PullRequest {
   XType type;
   int count;
   XMeta *meta;
+  int *status;      ///< (optional) Pointer to where the completion status of the request is reported, or NULL.
   struct PullRequest *next;
 } PullRequest;
 
+typedef struct HashIndex HashIndex;     ///< Resizable hash index of variables (see smax-hash.c)
+
 
 int smaxLockConfig();
 int smaxUnlockConfig();
@@ -38,10 +41,13 @@ int smaxLockNotify();
 int smaxUnlockNotify();
 
 int smaxConfigTLSAsync(Redis *redis);
+Redis *smaxCreateRedisAsync();
 long smaxGetHash(const char *buf, int size);
 
 int smaxRead(PullRequest *req, int channel);
+int smaxSendReadAsync(RedisClient *cl, const PullRequest *req);
 int smaxWrite(const char *group, const XField *f);
+int smaxWriteArgs(char **args, const int *L);
 void smaxDestroyPullRequest(PullRequest *p);
 int smaxProcessReadResponse(RESP *reply, PullRequest *req);
 void smaxProcessPipedWritesAsync(RESP *reply);
@@ -53,6 +59,87 @@ int smaxScriptError(const char *name, int status);
 int smaxScriptErrorAsync(const char *name, int status);
 boolean smaxIsDisabled();
 
+// in smax-numeric.c
+int smaxDecimalDigits(unsigned long long value);
+int smaxPrintLongSize(long long value);
+int smaxPrintLong(char *str, long long value);
+int smaxPrintFloat(char *str, float value);
+int smaxPrintDouble(char *str, double value);
+const char *smaxSkipSpaces(const char *str, const char *end);
+int smaxParseLong(const char *str, const char *end, long long *value);
+int smaxParseFloat(const char *str, const char *end, float *value);
+int smaxParseDouble(const char *str, const char *end, double *value);
+
+// in smax-binary.c
+boolean smaxIsBinaryType(XType type);
+char *smaxBinaryStringType(XType type);
+XType smaxGetBinaryType(const char *data, int len);
+int smaxGetBinaryCount(const char *data, int len);
+int smaxGetSerializedSize(const XField *f);
+char *smaxValuesToBinary(const void *value, XType type, int eCount, int *bytes);
+int smaxValuesToBinaryBuffer(const void *value, XType type, int eCount, char *buf, int size);
+int smaxGetBinaryRulesVersion();
+int smaxBinaryToValues(const char *data, int len, void *value, XType type, int eCount);
+char *smaxBinaryToString(const char *data, int len);
+
+// in smax-lazy.c
+int smaxLazyPullMonitor(void **monitor, const char *table, const char *key, XType type, int count, void *value, XMeta *meta, boolean isCached);
+void smaxLazyReleaseMonitor(void *monitor);
+void smaxLazyInvalidate(const char *table);
+void smaxLazyMirrorAll();
+boolean smaxLazyWriteThrough(const char *table, const char *key, const char *data, int length, const char *typeName, const char *dims);
+void smaxLazyWriteFailed(const char *table, const char *key);
+
+// in smax-queue.c
+int smaxQueueBorrowed(const char *table, const char *key, XType type, int count, void *value, XMeta *meta);
+
+// in smax-executor.c
+void smaxRunCompletion(void (*f)(void *), void *arg);
+
+// in smax-epoch.c
+void smaxEpochEnter();
+void smaxEpochExit();
+void smaxEpochRetire(void *ptr, void (*destroy)(void *));
+
+// in smax-hash.c
+unsigned long long smaxHashID(const char *table, int lTab, const char *key, int lKey);
+HashIndex *smaxCreateHashIndex();
+void smaxDestroyHashIndex(HashIndex *idx);
+int smaxHashCount(const HashIndex *idx);
+void *smaxHashFind(const HashIndex *idx, unsigned long long hash, boolean (*match)(const void *item, const void *arg), const void *arg);
+int smaxHashAdd(HashIndex *idx, unsigned long long hash, void *item);
+boolean smaxHashRemove(HashIndex *idx, unsigned long long hash, const void *item);
+void **smaxHashItems(const HashIndex *idx, int *n);
+void *smaxHashNext(const HashIndex *idx, int *pos);
+void smaxHashClear(HashIndex *idx);
+
+// in smax-tracking.c
+void smaxConnectTracking();
+void smaxDisconnectTracking();
+boolean smaxIsTracked(const char *table);
+boolean smaxIsTrackingRedis(const Redis *r);
+
+// in smax-shm.c
+void smaxMirrorUpdate(const char *table, const char *key, const char *data, const XMeta *meta);
+void smaxMirrorInvalidate(const char *table, const char *key);
+boolean smaxIsMirrored(const char *table, const char *key);
+int smaxMirrorRead(const char *table, const char *key, XType type, int count, void *value, XMeta *meta);
+
+// in smax-dispatch.c
+int smaxAddRoute(const char *id, boolean isExact, RedisSubscriberCall f);
+int smaxRemoveRoute(const char *id, boolean isExact, RedisSubscriberCall f);
+int smaxRemoveRoutes(RedisSubscriberCall f);
+void smaxWaitDispatched();
+
+// in smax-pool.c
+int smaxCreatePoolAsync(Redis *main);
+void smaxDestroyPoolAsync();
+void smaxConnectPool();
+void smaxDisconnectPool();
+boolean smaxIsPoolRedis(const Redis *r);
+RedisClient *smaxGetInteractiveClient(boolean isWrite);
+void smaxReleaseInteractiveClient(RedisClient *cl);
+
 /// \endcond
 
 #endif /* SMAX_PRIVATE_H_ */
@@ -49,6 +49,10 @@
 #  define SMAX_RECONNECT_RETRY_SECONDS      3           ///< (s) Time between reconnection attempts on lost SMA-X connections.
 #endif
 
+#ifndef SMAX_DEFAULT_VALUE_NOTIFY_BYTES
+#  define SMAX_DEFAULT_VALUE_NOTIFY_BYTES   1024        ///< (bytes) Default size limit for values sent with update notifications.
+#endif
+
 /// API major version
 #define SMAX_MAJOR_VERSION  1
 
@@ -191,6 +195,118 @@ typedef struct XMeta {
  */
 #define X_META_INIT             { 0, X_UNKNOWN, -1, {0}, -1, {'\0'}, {}, 0 }
 
+/**
+ * \brief An element in a batch of pull requests.
+ *
+ * \sa smaxPullBatch()
+ */
+typedef struct {
+  const char *table;            ///< Hash table name
+  const char *key;              ///< Variable name under which the data is stored
+  XType type;                   ///< SMA-X variable type, e.g. X_FLOAT or X_CHARS(40), of the buffer
+  int count;                    ///< Number of points to retrieve into the buffer
+  void *value;                  ///< Pointer to the buffer to which the data is to be retrieved
+  XMeta *meta;                  ///< (optional) Pointer to metadata or NULL if no metadata is needed
+  int status;                   ///< [out] Pull status: X_SUCCESS (0), X_INCOMPLETE, or an error code (&lt;0)
+} XPullItem;
+
+/**
+ * \brief Handle to a queued pull, for monitoring, waiting on, or cancelling it.
+ *
+ * \sa smaxQueueWithDeadline()
+ */
+typedef struct XPullHandle XPullHandle;
+
+/**
+ * \brief A pre-resolved SMA-X variable, for pulling and sharing with minimal overhead.
+ *
+ * \sa smaxCreateVar()
+ */
+typedef struct SmaxVar SmaxVar;
+
+/**
+ * \brief A batch of shares, which are sent to SMA-X together.
+ *
+ * \sa smaxShareBegin()
+ */
+typedef struct XShareBatch XShareBatch;
+
+/**
+ * \brief How interactive connections are selected from the pool for pulling data.
+ *
+ * \sa smaxSetPoolPolicy()
+ * \sa smaxSetInteractivePoolSize()
+ */
+enum smax_pool_policy {
+  SMAX_POOL_THREAD_AFFINITY = 0,  ///< Each thread uses the same connection for all requests (default).
+  SMAX_POOL_LEAST_BUSY            ///< Pulls use the connection with the fewest users at the time.
+};
+
+/**
+ * \brief What happens when a pipelined pull is submitted while the queue is full.
+ *
+ * \sa smaxSetQueueOverflowPolicy()
+ * \sa smaxSetMaxPendingPulls()
+ */
+enum smax_queue_overflow {
+  SMAX_QUEUE_BLOCK = 0,         ///< Wait until the queue drains sufficiently (default).
+  SMAX_QUEUE_FAIL,              ///< Return X_INCOMPLETE immediately, without queuing the pull.
+  SMAX_QUEUE_INTERACTIVE        ///< Pull the value on an interactive connection instead.
+};
+
+/**
+ * \brief Statistics on overflows of the pipelined pull queue.
+ *
+ * \sa smaxGetQueueStats()
+ */
+typedef struct {
+  long stalls;                  ///< Number of times callers had to wait for the queue to drain.
+  double stallTime;             ///< [s] Total time callers spent waiting for the queue to drain.
+  double maxStallTime;          ///< [s] Longest single wait for the queue to drain.
+  long rejected;                ///< Number of pulls rejected with X_INCOMPLETE (SMAX_QUEUE_FAIL policy).
+  long redirected;              ///< Number of pulls done interactively instead (SMAX_QUEUE_INTERACTIVE policy).
+} XQueueStats;
+
+/**
+ * \brief An update notification, received via an event queue.
+ *
+ * \sa smaxNextEvent()
+ */
+typedef struct {
+  char *table;                  ///< Hash table name of the updated variable
+  char *key;                    ///< Name of the updated variable, or NULL if not specified.
+  char *origin;                 ///< The origin of the update, as published, or NULL.
+  int dropped;                  ///< Number of events dropped, because the queue was full, right before this one.
+} XEvent;
+
+/**
+ * \brief Statistics of an event queue.
+ *
+ * \sa smaxGetEventQueueStats()
+ */
+typedef struct {
+  long received;                ///< Number of matching events received.
+  long overflows;               ///< Number of events dropped because the queue was full.
+  int pending;                  ///< Number of events currently in the queue.
+  int capacity;                 ///< The maximum number of events the queue can hold.
+} XEventQueueStats;
+
+typedef struct XEventQueue XEventQueue;   ///< A queue of update notifications for a consumer (see smaxCreateEventQueue()).
+
+/**
+ * \brief Occupancy and eviction statistics of the lazy cache.
+ *
+ * \sa smaxGetLazyCacheStats()
+ */
+typedef struct {
+  int entries;                  ///< Number of variables currently monitored (cached).
+  long bytes;                   ///< [bytes] Approximate memory used by the monitored variables.
+  int maxEntries;               ///< Maximum number of monitored variables, or 0 if unlimited.
+  long maxBytes;                ///< [bytes] Memory budget for the monitored variables, or 0 if unlimited.
+  long evicted;                 ///< Number of variables evicted to stay within the limits.
+  long collected;               ///< Number of variables no longer monitored, because they were not being read.
+} XLazyCacheStats;
+
 /**
  * \brief SMA-X program message
  *
@@ -256,6 +372,10 @@ int smaxPull(const char *table, const char *key, XType type, int count, void *va
 int smaxShare(const char *table, const char *key, const void *value, XType type, int count);
 int smaxShareArray(const char *table, const char *key, const void *value, XType type, int ndim, const int *sizes);
 int smaxShareField(const char *table, const XField *f);
+XShareBatch *smaxShareBegin();
+int smaxShareAdd(XShareBatch *b, const char *table, const char *key, const void *value, XType type, int count);
+int smaxShareCommit(XShareBatch *b);
+void smaxShareCancel(XShareBatch *b);
 
 // Some convenience methods for simpler pulls ------------>
 char *smaxPullRaw(const char *table, const char *key, XMeta *meta, int *status);
@@ -282,9 +402,26 @@ int smaxGetArrayField(const XStructure *s, const char *name, void *dst, XType ty
 int smaxQueue(const char *table, const char *key, XType type, int count, void *value, XMeta *meta);
 XSyncPoint *smaxCreateSyncPoint();
 int smaxQueueCallback(void (*f)(void *), void *arg);
+int smaxQueueInlineCallback(void (*f)(void *), void *arg);
+int smaxSetCompletionThreads(int n);
+int smaxGetCompletionThreads();
 void smaxDestroySyncPoint(XSyncPoint *sync);
 int smaxSync(XSyncPoint *sync, int timeoutMillis);
 int smaxWaitQueueComplete(int timeoutMillis);
+int smaxPullBatch(XPullItem *items, int n, int timeoutMillis);
+SmaxVar *smaxCreateVar(const char *table, const char *key, XType type, int count);
+void smaxDestroyVar(SmaxVar *v);
+const char *smaxGetVarChannel(const SmaxVar *v);
+int smaxPullVar(SmaxVar *v, void *value, XMeta *meta);
+int smaxShareVar(SmaxVar *v, const void *value);
+int smaxLazyPullVar(SmaxVar *v, void *value, XMeta *meta);
+int smaxGetCachedVar(SmaxVar *v, void *value, XMeta *meta);
+int smaxQueueVar(SmaxVar *v, void *value, XMeta *meta);
+int smaxQueueWithDeadline(const char *table, const char *key, XType type, int count, void *value, XMeta *meta, int timeoutMillis, XPullHandle **handle);
+int smaxGetPullStatus(XPullHandle *h);
+int smaxWaitPull(XPullHandle *h);
+int smaxCancelPull(XPullHandle *h);
+void smaxDestroyPullHandle(XPullHandle *h);
 
 
 // Lazy pulling ------------------------------------------>
@@ -296,6 +433,7 @@ int smaxLazyPullChars(const char *table, const char *key, char *buf, int n);
 char *smaxLazyPullString(const char *table, const char *key);
 int smaxLazyPullStruct(const char *id, XStructure *s);
 int smaxCache(const char *table, const char *key, XType type);
+int smaxCachePattern(const char *pattern);
 int smaxGetCached(const char *table, const char *key, XType type, int count, void *value, XMeta *meta);
 long long smaxGetCachedLong(const char *table, const char *key, long long defaultValue);
 double smaxGetCachedDouble(const char *table, const char *key);
@@ -303,9 +441,21 @@ double smaxGetCachedDoubleDefault(const char *table, const char *key, double def
 int smaxGetCachedChars(const char *table, const char *key, char *buf, int n);
 char *smaxGetCachedString(const char *table, const char *key);
 int smaxGetCachedStruct(const char *id, XStructure *s);
+const void *smaxGetCachedView(const char *table, const char *key, XType type, int count, XMeta *meta);
+void smaxReleaseCachedView(const void *view);
+int smaxGetCachedMany(XPullItem *items, int n);
 int smaxLazyEnd(const char *table, const char *key);
+int smaxLazyEndPattern(const char *pattern);
 int smaxLazyFlush();
 int smaxGetLazyUpdateCount(const char *table, const char *key);
+int smaxSetLazyTracking(boolean value, const char *keyPrefix);
+boolean smaxIsLazyTracking();
+int smaxShareLazyCache(const char *name, int slots, long bytes);
+int smaxAttachLazyCache(const char *name);
+int smaxDetachLazyCache();
+int smaxSetLazyCacheLimits(int n, long bytes);
+int smaxGetLazyCacheStats(XLazyCacheStats *stats);
+void smaxResetLazyCacheStats();
 
 
 // Some convenience methods for simpler shares ----------->
@@ -330,6 +480,8 @@ int smaxShareStruct(const char *id, const XStructure *s);
 // Notifications ---------------------------------------------->
 int smaxSubscribe(const char *table, const char *key);
 int smaxUnsubscribe(const char *table, const char *key);
+int smaxSubscribeMany(const char **tables, const char **keys, int n);
+int smaxUnsubscribeMany(const char **tables, const char **keys, int n);
 int smaxWaitOnSubscribed(const char *table, const char *key, int timeout, sem_t *gating);
 int smaxWaitOnSubscribedGroup(const char *matchTable, char **changedKey, int timeout, sem_t *gating);
 int smaxWaitOnSubscribedVar(const char *matchKey, char **changedTable, int timeout, sem_t *gating);
@@ -337,6 +489,11 @@ int smaxWaitOnAnySubscribed(char **changedTable, char **changedKey, int timeout,
 int smaxReleaseWaits();
 int smaxAddSubscriber(const char *stem, RedisSubscriberCall f);
 int smaxRemoveSubscribers(RedisSubscriberCall f);
+XEventQueue *smaxCreateEventQueue(const char *table, const char *key, int capacity);
+void smaxDestroyEventQueue(XEventQueue *q);
+int smaxNextEvent(XEventQueue *q, XEvent *event, int timeoutMillis);
+void smaxClearEvent(XEvent *event);
+int smaxGetEventQueueStats(XEventQueue *q, XEventQueueStats *stats);
 
 // Messages --------------------------------------------------->
 int smaxSendStatus(const char *msg, ...);
@@ -419,9 +576,24 @@ boolean smaxIsVerbose();
 void smaxSetResilient(boolean value);
 boolean smaxIsResilient();
 void smaxSetResilientExit(boolean value);
+void smaxSetBinaryEncoding(boolean value);
+boolean smaxIsBinaryEncoding();
+int smaxSetBinaryEncodingFor(const char *table, const char *key, boolean value);
+int smaxClearBinaryEncodingFor(const char *table, const char *key);
+boolean smaxIsBinaryEncodingFor(const char *table, const char *key);
 int smaxSetPipelined(boolean isEnabled);
+int smaxSetInteractivePoolSize(int n);
+int smaxGetInteractivePoolSize();
+int smaxSetPoolPolicy(enum smax_pool_policy p);
+enum smax_pool_policy smaxGetPoolPolicy();
 boolean smaxIsPipelined();
+int smaxSetValueNotifications(boolean value, int maxBytes);
+boolean smaxIsValueNotifications();
 int smaxSetMaxPendingPulls(int n);
+int smaxSetQueueOverflowPolicy(enum smax_queue_overflow policy);
+enum smax_queue_overflow smaxGetQueueOverflowPolicy();
+int smaxGetQueueStats(XQueueStats *stats);
+void smaxResetQueueStats();
 char *smaxGetScriptSHA1(const char *scriptName, int *status);
 char *smaxGetHostName();
 void smaxSetHostName(const char *name);
@@ -0,0 +1,613 @@
+/**
+ * \file
+ *
+ * \date Oct 16, 2026
+ * \author Attila Kovacs
+ *
+ * \brief
+ *      Optional native binary encoding of numerical arrays in SMA-X. By default, all values are
+ *      stored as space-separated ASCII text, which is portable and human readable, but inflates
+ *      floating-point data about 3-fold, and costs CPU time on both ends for formatting and
+ *      parsing. When enabled (globally, or for selected variables), numerical arrays are stored
+ *      instead as packed little-endian binary data, behind a 2-byte header:
+ *
+ *        `\0` `<code>` `<element bytes>...`
+ *
+ *      where `<code>` is one of `b`, `h`, `i`, `q` (for 8, 16, 32 and 64-bit signed integers), or `f`
+ *      and `d` (for 32 and 64-bit IEEE floating-point values). The leading `\0` byte cannot start a
+ *      text-encoded numerical value, so readers can always tell the two encodings apart. The type
+ *      recorded in `<types>` is also marked as binary, e.g. `float32-le`.
+ *
+ *      Binary values are decoded transparently by smaxPull() and the like, including conversion to
+ *      the requested type, while clients that request raw or string values, or structures, receive
+ *      the same ASCII representation as they would for text-encoded values.
+ *
+ *      \sa smaxSetBinaryEncoding()
+ *      \sa smaxSetBinaryEncodingFor()
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "smax-private.h"
+
+/// \cond PRIVATE
+
+typedef struct BinaryRule {
+  char *id;                     ///< Aggregated id of the variable, i.e. table:key
+  unsigned long long hash;      ///< The hash of the variable's table and key
+  boolean enabled;              ///< Whether binary encoding is enabled for the variable
+} BinaryRule;
+
+static HashIndex *rules;
+static int nRules;
+static int rulesVersion;        ///< Incremented every time the encoding settings change
+static pthread_mutex_t rulesLock = PTHREAD_MUTEX_INITIALIZER;
+
+static boolean isBinaryDefault = FALSE;
+
+/// \endcond
+
+/**
+ * Enables or disables the native binary encoding of numerical arrays by default, i.e. for all variables
+ * that have no specific setting via smaxSetBinaryEncodingFor(). Binary encoding applies to integer and
+ * floating-point types (not to booleans, strings, or structures) shared via smaxShareArray() and the
+ * functions that rely on it, like smaxShare() or smaxShareFloats().
+ *
+ * Readers using this library decode binary values transparently, regardless of this setting. Other
+ * clients may not, so binary encoding is disabled by default.
+ *
+ * @param value     TRUE (non-zero) to enable, or FALSE (0) to disable binary encoding by default.
+ *
+ * @sa smaxIsBinaryEncoding()
+ * @sa smaxSetBinaryEncodingFor()
+ */
+void smaxSetBinaryEncoding(boolean value) {
+  isBinaryDefault = value ? TRUE : FALSE;
+  __atomic_add_fetch(&rulesVersion, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Checks if native binary encoding of numerical arrays is enabled by default.
+ *
+ * @return    TRUE (1) if binary encoding is enabled by default, or else FALSE (0).
+ *
+ * @sa smaxSetBinaryEncoding()
+ */
+boolean smaxIsBinaryEncoding() {
+  return isBinaryDefault;
+}
+
+static boolean IsRuleFor(const void *rule, const void *id) {
+  return !strcmp(((const BinaryRule *) rule)->id, (const char *) id);
+}
+
+static BinaryRule *FindRuleAsync(const char *id, unsigned long long hash) {
+  return (BinaryRule *) smaxHashFind(rules, hash, IsRuleFor, id);
+}
+
+/**
+ * Enables or disables the native binary encoding of numerical arrays for a specific variable, overriding
+ * the default set by smaxSetBinaryEncoding().
+ *
+ * @param table     The hash table name
+ * @param key       The variable name under which the data is stored.
+ * @param value     TRUE (non-zero) to enable, or FALSE (0) to disable binary encoding for the variable.
+ * @return          X_SUCCESS (0) if successful, or else X_GROUP_INVALID if the table name is NULL,
+ *                  or X_NAME_INVALID if the key is NULL.
+ *
+ * @sa smaxClearBinaryEncodingFor()
+ * @sa smaxIsBinaryEncodingFor()
+ */
+int smaxSetBinaryEncodingFor(const char *table, const char *key, boolean value) {
+  static const char *fn = "smaxSetBinaryEncodingFor";
+
+  BinaryRule *r;
+  char *id;
+  unsigned long long hash;
+
+  if(!table) return x_error(X_GROUP_INVALID, EINVAL, fn, "table is NULL");
+  if(!key) return x_error(X_NAME_INVALID, EINVAL, fn, "key is NULL");
+
+  id = xGetAggregateID(table, key);
+  if(!id) return x_trace(fn, NULL, X_NULL);
+
+  hash = smaxHashID(table, 0, key, 0);
+
+  pthread_mutex_lock(&rulesLock);
+
+  if(!rules) rules = smaxCreateHashIndex();
+
+  r = FindRuleAsync(id, hash);
+  if(r) free(id);
+  else {
+    r = (BinaryRule *) calloc(1, sizeof(BinaryRule));
+    x_check_alloc(r);
+    r->id = id;
+    r->hash = hash;
+    smaxHashAdd(rules, hash, r);
+    nRules++;
+  }
+
+  r->enabled = value ? TRUE : FALSE;
+  __atomic_add_fetch(&rulesVersion, 1, __ATOMIC_RELEASE);
+
+  pthread_mutex_unlock(&rulesLock);
+
+  return X_SUCCESS;
+}
+
+/**
+ * Removes the variable specific binary encoding setting, if any, so that the variable will use the
+ * default encoding again.
+ *
+ * @param table     The hash table name
+ * @param key       The variable name under which the data is stored.
+ * @return          X_SUCCESS (0) if successful, or else X_GROUP_INVALID if the table name is NULL,
+ *                  or X_NAME_INVALID if the key is NULL.
+ *
+ * @sa smaxSetBinaryEncodingFor()
+ */
+int smaxClearBinaryEncodingFor(const char *table, const char *key) {
+  static const char *fn = "smaxClearBinaryEncodingFor";
+
+  BinaryRule *r;
+  char *id;
+  unsigned long long hash;
+
+  if(!table) return x_error(X_GROUP_INVALID, EINVAL, fn, "table is NULL");
+  if(!key) return x_error(X_NAME_INVALID, EINVAL, fn, "key is NULL");
+
+  id = xGetAggregateID(table, key);
+  if(!id) return x_trace(fn, NULL, X_NULL);
+
+  hash = smaxHashID(table, 0, key, 0);
+
+  pthread_mutex_lock(&rulesLock);
+
+  r = FindRuleAsync(id, hash);
+  if(r) {
+    smaxHashRemove(rules, hash, r);
+    free(r->id);
+    free(r);
+    nRules--;
+    __atomic_add_fetch(&rulesVersion, 1, __ATOMIC_RELEASE);
+  }
+
+  pthread_mutex_unlock(&rulesLock);
+
+  free(id);
+
+  return X_SUCCESS;
+}
+
+/**
+ * Checks if a variable is to be shared with native binary encoding, either because it was specifically
+ * enabled for it, or else by default.
+ *
+ * @param table     The hash table name
+ * @param key       The variable name under which the data is stored.
+ * @return          TRUE (1) if the variable is to be shared in binary format, or else FALSE (0).
+ *
+ * @sa smaxSetBinaryEncodingFor()
+ * @sa smaxSetBinaryEncoding()
+ */
+boolean smaxIsBinaryEncodingFor(const char *table, const char *key) {
+  const BinaryRule *r;
+  boolean enabled = isBinaryDefault;
+  char *id;
+
+  if(!table || !key) return enabled;
+  if(!nRules) return enabled;           // No variable specific settings, nothing to look up.
+
+  id = xGetAggregateID(table, key);
+  if(!id) return enabled;
+
+  pthread_mutex_lock(&rulesLock);
+  r = FindRuleAsync(id, smaxHashID(table, 0, key, 0));
+  if(r) enabled = r->enabled;
+  pthread_mutex_unlock(&rulesLock);
+
+  free(id);
+
+  return enabled;
+}
+
+/// \cond PROTECTED
+
+/**
+ * Returns a number that changes every time the binary encoding settings change, so that callers
+ * may cache the outcome of smaxIsBinaryEncodingFor() until it does.
+ *
+ * @return    The current version of the binary encoding settings.
+ *
+ * @sa smaxIsBinaryEncodingFor()
+ */
+int smaxGetBinaryRulesVersion() {
+  return __atomic_load_n(&rulesVersion, __ATOMIC_ACQUIRE);
+}
+
+/// \endcond
+
+/**
+ * Returns the binary type code for a given SMA-X type.
+ *
+ * @param type    SMA-X type, e.g. X_FLOAT
+ * @return        The type code character, or 0 if the type has no binary encoding.
+ */
+static char GetBinaryCode(XType type) {
+  if(type == X_BOOLEAN || type == X_STRING || type == X_RAW || type == X_STRUCT) return 0;
+  if(type == X_FLOAT) return 'f';
+  if(type == X_DOUBLE) return 'd';
+  if(type == X_BYTE) return 'b';
+  if(type == X_INT16) return 'h';
+  if(type == X_INT32) return 'i';
+  if(type == X_INT64) return 'q';
+  return 0;
+}
+
+/**
+ * Returns the SMA-X type for a given binary type code.
+ *
+ * @param code    Binary type code, e.g. 'f'.
+ * @return        The corresponding SMA-X type, e.g. X_FLOAT, or X_UNKNOWN if the code is invalid.
+ */
+static XType GetBinaryCodeType(char code) {
+  switch(code) {
+    case 'b': return X_BYTE;
+    case 'h': return X_INT16;
+    case 'i': return X_INT32;
+    case 'q': return X_INT64;
+    case 'f': return X_FLOAT;
+    case 'd': return X_DOUBLE;
+    default: return X_UNKNOWN;
+  }
+}
+
+/**
+ * Copies a single element between host and little-endian byte order.
+ *
+ */
+static __inline__ void CopyLittleEndian(void *dst, const void *src, int size) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  const char *s = (const char *) src;
+  char *d = (char *) dst;
+  int i;
+  for(i = 0; i < size; i++) d[i] = s[size - 1 - i];
+#else
+  memcpy(dst, src, size);
+#endif
+}
+
+/**
+ * Returns the i-th element of a packed little-endian binary array as an integer.
+ *
+ */
+static long long GetIntegerElement(const char *data, XType type, int i) {
+  if(type == X_BYTE) return ((const signed char *) data)[i];
+  if(type == X_INT16) {
+    int16_t v;
+    CopyLittleEndian(&v, data + i * sizeof(v), sizeof(v));
+    return v;
+  }
+  if(type == X_INT32) {
+    int32_t v;
+    CopyLittleEndian(&v, data + i * sizeof(v), sizeof(v));
+    return v;
+  }
+  else {
+    int64_t v;
+    CopyLittleEndian(&v, data + i * sizeof(v), sizeof(v));
+    return v;
+  }
+}
+
+/**
+ * Returns the i-th element of a packed little-endian binary array as a double.
+ *
+ */
+static double GetDoubleElement(const char *data, XType type, int i) {
+  if(type == X_FLOAT) {
+    float v;
+    CopyLittleEndian(&v, data + i * sizeof(v), sizeof(v));
+    return v;
+  }
+  if(type == X_DOUBLE) {
+    double v;
+    CopyLittleEndian(&v, data + i * sizeof(v), sizeof(v));
+    return v;
+  }
+  return (double) GetIntegerElement(data, type, i);
+}
+
+/// \cond PROTECTED
+
+/**
+ * Checks if values of the given type can be stored in binary format.
+ *
+ * @param type    SMA-X type, e.g. X_FLOAT
+ * @return        TRUE (1) if the type has a binary encoding, or else FALSE (0).
+ */
+boolean smaxIsBinaryType(XType type) {
+  return GetBinaryCode(type) != 0;
+}
+
+/**
+ * Returns the `<types>` string for binary encoded values of the given type, e.g. `float32-le`.
+ *
+ * @param type    SMA-X type, e.g. X_FLOAT
+ * @return        The corresponding type string for binary encoded values, or else the regular
+ *                type string, if the type has no binary encoding.
+ *
+ * @sa smaxStringType()
+ */
+char *smaxBinaryStringType(XType type) {
+  switch(GetBinaryCode(type)) {
+    case 'b': return "int8-le";
+    case 'h': return "int16-le";
+    case 'i': return "int32-le";
+    case 'q': return "int64-le";
+    case 'f': return "float32-le";
+    case 'd': return "float64-le";
+    default: return smaxStringType(type);
+  }
+}
+
+/**
+ * Returns the type of binary encoded data, or X_UNKNOWN if the data is not in binary format (i.e.
+ * ASCII text).
+ *
+ * @param data    The serialized data, as stored in Redis.
+ * @param len     Number of bytes in the serialized data.
+ * @return        The type of the binary encoded elements, or X_UNKNOWN if the data is not binary.
+ */
+XType smaxGetBinaryType(const char *data, int len) {
+  if(!data || len < SMAX_BINARY_HEADER_SIZE) return X_UNKNOWN;
+  if(data[0] != '\0') return X_UNKNOWN;
+  return GetBinaryCodeType(data[1]);
+}
+
+/**
+ * Returns the number of elements contained in binary encoded data.
+ *
+ * @param data    The serialized data, as stored in Redis.
+ * @param len     Number of bytes in the serialized data.
+ * @return        The number of elements contained, or else X_TYPE_INVALID if the data is not in
+ *                binary format.
+ */
+int smaxGetBinaryCount(const char *data, int len) {
+  XType type = smaxGetBinaryType(data, len);
+  if(type == X_UNKNOWN) return x_error(X_TYPE_INVALID, EINVAL, "smaxGetBinaryCount", "not binary data");
+  return (len - SMAX_BINARY_HEADER_SIZE) / xElementSizeOf(type);
+}
+
+/**
+ * Returns the number of bytes in the serialized value of an SMA-X field, which may be binary.
+ *
+ * @param f     Pointer to an SMA-X field with serialized value.
+ * @return      The number of bytes in the serialized value (excluding string termination).
+ */
+int smaxGetSerializedSize(const XField *f) {
+  const char *data;
+  XType type;
+
+  if(!f || !f->value) return 0;
+
+  data = (const char *) f->value;
+  if(!f->isSerialized || !smaxIsBinaryType(f->type) || data[0] != '\0') return strlen(data);
+
+  type = GetBinaryCodeType(data[1]);
+  if(type == X_UNKNOWN) return 0;
+
+  return SMAX_BINARY_HEADER_SIZE + xGetFieldCount(f) * xElementSizeOf(type);
+}
+
+/**
+ * Serializes native values into packed little-endian binary format with a type header.
+ *
+ * @param[in]  value    Pointer to the native values, or NULL to serialize zeroes.
+ * @param[in]  type     SMA-X type of the values, e.g. X_FLOAT. It must be an integer or floating-point
+ *                      type (other than boolean).
+ * @param[in]  eCount   Number of elements.
+ * @param[out] bytes    (optional) pointer to where to return the number of bytes in the
+ *                      serialized data, or NULL if not required.
+ * @return              A newly allocated buffer with the binary serialized data, or NULL if there
+ *                      was an error.
+ *
+ * @sa smaxBinaryToValues()
+ */
+char *smaxValuesToBinary(const void *value, XType type, int eCount, int *bytes) {
+  static const char *fn = "smaxValuesToBinary";
+
+  char *data;
+  int n;
+
+  if(!GetBinaryCode(type)) return x_trace_null(fn, NULL);
+  if(eCount <= 0) return x_trace_null(fn, NULL);
+
+  n = SMAX_BINARY_HEADER_SIZE + eCount * xElementSizeOf(type);
+
+  data = (char *) malloc(n + 1);     // We'll terminate it, just in case...
+  if(!data) {
+    x_error(0, errno, fn, "malloc() error (%d bytes)", n + 1);
+    return NULL;
+  }
+
+  smaxValuesToBinaryBuffer(value, type, eCount, data, n + 1);
+
+  if(bytes) *bytes = n;
+  return data;
+}
+
+/**
+ * Same as smaxValuesToBinary(), but serializing into the supplied buffer.
+ *
+ * @param[in]  value    Pointer to the native values, or NULL to serialize zeroes.
+ * @param[in]  type     SMA-X type of the values, e.g. X_FLOAT. It must be an integer or floating-point
+ *                      type (other than boolean).
+ * @param[in]  eCount   Number of elements.
+ * @param[out] buf      The buffer to serialize into.
+ * @param[in]  size     Size of the buffer in bytes.
+ * @return              The number of bytes in the serialized data (excluding the termination), or else
+ *                      X_TYPE_INVALID if the type has no binary encoding, or X_SIZE_INVALID if the
+ *                      element count is invalid, or if the buffer is too small.
+ *
+ * @sa smaxValuesToBinary()
+ */
+int smaxValuesToBinaryBuffer(const void *value, XType type, int eCount, char *buf, int size) {
+  static const char *fn = "smaxValuesToBinaryBuffer";
+
+  char code = GetBinaryCode(type);
+  char *data = buf;
+  int eSize, n;
+
+  if(!code) return x_error(X_TYPE_INVALID, EINVAL, fn, "no binary encoding for type %d", type);
+  if(eCount <= 0) return x_error(X_SIZE_INVALID, EINVAL, fn, "invalid element count: %d", eCount);
+
+  eSize = xElementSizeOf(type);
+  n = SMAX_BINARY_HEADER_SIZE + eCount * eSize;
+
+  if(n >= size) return X_SIZE_INVALID;    // Not an error for callers with a fallback...
+
+  data[0] = '\0';
+  data[1] = code;
+
+  if(!value) memset(&data[SMAX_BINARY_HEADER_SIZE], 0, eCount * eSize);   // Zeroes, as with text encoding
+  else {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    const char *from = (const char *) value;
+    int i;
+    for(i = 0; i < eCount; i++) CopyLittleEndian(&data[SMAX_BINARY_HEADER_SIZE + i * eSize], &from[i * eSize], eSize);
+#else
+    memcpy(&data[SMAX_BINARY_HEADER_SIZE], value, eCount * eSize);
+#endif
+  }
+
+  data[n] = '\0';
+
+  return n;
+}
+
+/**
+ * Deserializes binary encoded data into native values of the requested type, converting
+ * the elements as necessary. If the data contains fewer elements than requested, the remaining
+ * elements are zeroed.
+ *
+ * @param[in]  data     The binary serialized data (with header).
+ * @param[in]  len      Number of bytes in the serialized data.
+ * @param[out] value    Pointer to the native buffer to populate.
+ * @param[in]  type     The native type, e.g. X_DOUBLE. It must be a numerical type, or X_BOOLEAN.
+ * @param[in]  eCount   Number of elements to populate.
+ * @return              The number of elements deserialized, or else an error code (&lt;0), such as
+ *                      X_TYPE_INVALID if the data is not binary or if the requested type is not
+ *                      numerical.
+ *
+ * @sa smaxValuesToBinary()
+ */
+int smaxBinaryToValues(const char *data, int len, void *value, XType type, int eCount) {
+  static const char *fn = "smaxBinaryToValues";
+
+  XType from = smaxGetBinaryType(data, len);
+  int i, n;
+
+  if(from == X_UNKNOWN) return x_error(X_TYPE_INVALID, EINVAL, fn, "not binary data");
+  if(!value) return x_error(X_NULL, EINVAL, fn, "value is NULL");
+  if(type != X_BOOLEAN && !smaxIsBinaryType(type)) return x_error(X_TYPE_INVALID, EINVAL, fn, "invalid type: %d", type);
+
+  n = smaxGetBinaryCount(data, len);
+  if(n > eCount) n = eCount;
+
+  data += SMAX_BINARY_HEADER_SIZE;
+
+  if(type == from) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    const int eSize = xElementSizeOf(type);
+    for(i = 0; i < n; i++) CopyLittleEndian((char *) value + i * eSize, data + i * eSize, eSize);
+#else
+    memcpy(value, data, n * xElementSizeOf(type));
+#endif
+  }
+  else if(from == X_FLOAT || from == X_DOUBLE) {
+    // Floating-point to other type conversion
+    for(i = 0; i < n; i++) {
+      double d = GetDoubleElement(data, from, i);
+
+      if(type == X_FLOAT) ((float *) value)[i] = (float) d;
+      else if(type == X_DOUBLE) ((double *) value)[i] = d;
+      else if(type == X_BOOLEAN) ((boolean *) value)[i] = (d != 0.0);
+      else {
+        // Truncate, as if parsing the ASCII representation as integer...
+        long long l = isnan(d) ? 0 : (d >= 9.2233720368547758e18 ? LLONG_MAX : (d <= -9.2233720368547758e18 ? LLONG_MIN : (long long) d));
+
+        if(type == X_BYTE) ((char *) value)[i] = (char) l;
+        else if(type == X_INT16) ((int16_t *) value)[i] = (int16_t) l;
+        else if(type == X_INT32) ((int32_t *) value)[i] = (int32_t) l;
+        else ((int64_t *) value)[i] = (int64_t) l;
+      }
+    }
+  }
+  else {
+    // Integer to other type conversion
+    for(i = 0; i < n; i++) {
+      long long l = GetIntegerElement(data, from, i);
+
+      if(type == X_FLOAT) ((float *) value)[i] = (float) l;
+      else if(type == X_DOUBLE) ((double *) value)[i] = (double) l;
+      else if(type == X_BOOLEAN) ((boolean *) value)[i] = (l != 0);
+      else if(type == X_BYTE) ((char *) value)[i] = (char) l;
+      else if(type == X_INT16) ((int16_t *) value)[i] = (int16_t) l;
+      else if(type == X_INT32) ((int32_t *) value)[i] = (int32_t) l;
+      else ((int64_t *) value)[i] = (int64_t) l;
+    }
+  }
+
+  // Zero out the remaining elements...
+  if(n < eCount) xZero((char *) value + n * xElementSizeOf(type), type, eCount - n);
+
+  return n;
+}
+
+/**
+ * Converts binary encoded data to the equivalent ASCII text representation, which is the same as
+ * what text-encoded storage would have produced for the same values.
+ *
+ * @param data    The binary serialized data (with header).
+ * @param len     Number of bytes in the serialized data.
+ * @return        A newly allocated string with the ASCII representation of the values, or NULL
+ *                if there was an error.
+ *
+ * @sa smaxValuesToString()
+ */
+char *smaxBinaryToString(const char *data, int len) {
+  static const char *fn = "smaxBinaryToString";
+
+  XType type = smaxGetBinaryType(data, len);
+  char *str;
+  void *value;
+  int n;
+
+  if(type == X_UNKNOWN) return x_trace_null(fn, NULL);
+
+  n = smaxGetBinaryCount(data, len);
+  if(n <= 0) return xStringCopyOf("");
+
+  value = malloc(n * xElementSizeOf(type));
+  if(!value) {
+    x_error(0, errno, fn, "malloc() error (%d x %d bytes)", n, xElementSizeOf(type));
+    return NULL;
+  }
+
+  smaxBinaryToValues(data, len, value, type, n);
+  str = smaxValuesToString(value, type, n, NULL, 0);
+  free(value);
+
+  return str;
+}
+
+/// \endcond
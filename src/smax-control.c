@@ -392,11 +392,9 @@ int smaxSetControlFunction(const char *table, const char *key, SMAXControlFuncti
   if(!key) return x_error(X_NAME_INVALID, EINVAL, fn, "Control variable name is NULL");
   if(!key[0]) return x_error(X_NAME_INVALID, EINVAL, fn, "Control variable name is empty");
 
-  id = (char *) malloc(sizeof(SMAX_UPDATES) + strlen(table) + strlen(key) + X_SEP_LENGTH);
+  id = xGetAggregateID(table, key);
   x_check_alloc(id);
 
-  sprintf(id, SMAX_UPDATES "%s" X_SEP "%s", table, key);
-
   pthread_mutex_lock(&mutex);
 
   // Remove and destroy any prior entry for the table, and unsubscribe updates for the control
@@ -412,7 +410,10 @@ int smaxSetControlFunction(const char *table, const char *key, SMAXControlFuncti
       prior->value = NULL;
       xDestroyField(prior);
 
-      if(!func) smaxUnsubscribe(table, key);
+      if(!func) {
+        smaxRemoveRoute(id, TRUE, ProcessControls);
+        smaxUnsubscribe(table, key);
+      }
     }
   }
 
@@ -420,17 +421,18 @@ int smaxSetControlFunction(const char *table, const char *key, SMAXControlFuncti
     XField *f;
     ControlSet *control;
 
-    // Create controls lookup table as necessary, and set up subscriber to process updates
+    // Create controls lookup table as necessary
     if(!controls) {
       controls = xAllocLookup(SMAX_CONTROL_TABLE_SIZE);
       x_check_alloc(controls);
+    }
 
-      // Start processing control calls...
-      status = smaxAddSubscriber(NULL, ProcessControls);
-      if(status) {
-        pthread_mutex_unlock(&mutex);
-        return x_trace(fn, NULL, status);
-      }
+    // Route the updates of the control variable (only) for processing control calls...
+    status = smaxAddRoute(id, TRUE, ProcessControls);
+    if(status) {
+      pthread_mutex_unlock(&mutex);
+      free(id);
+      return x_trace(fn, NULL, status);
     }
 
     control = (ControlSet *) calloc(1, sizeof(ControlSet));
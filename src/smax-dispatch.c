@@ -0,0 +1,359 @@
+/**
+ * \file
+ *
+ * \date Oct 16, 2026
+ * \author Attila Kovacs
+ *
+ * \brief
+ *      A single dispatcher for SMA-X update notifications. Rather than registering each subscriber callback
+ *      with Redis individually, such that every callback is invoked for every incoming message, the
+ *      subscribers of the library and of the application are routed by the SMA-X IDs they are interested in.
+ *      The dispatcher checks the channel of each incoming message only once, and walks a character trie of
+ *      the registered ID stems along the ID that was updated, to call only the callbacks registered for that
+ *      ID or for a stem of it. The cost of dispatching a message thus scales with the length of the ID, rather
+ *      than with the number of subscribers.
+ *
+ *      Routes can match IDs that begin with a given stem (as with smaxAddSubscriber()), or else only a specific
+ *      ID exactly (e.g. for control variables).
+ *
+ *      Callbacks are invoked without holding the routing lock, so they may add or remove routes themselves.
+ *      As such, a callback may still be called once after its route was removed, by a notification that
+ *      was being dispatched at the time. smaxWaitDispatched() waits for such notifications to complete.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "smax-private.h"
+
+/// \cond PRIVATE
+
+#define SMAX_DISPATCH_LOCAL_CALLS     32        ///< Number of callbacks per message that need no allocation
+
+/**
+ * A subscriber callback that was registered for a route.
+ */
+typedef struct Route {
+  RedisSubscriberCall f;          ///< The function to call
+  struct Route *next;             ///< The next callback registered for the same route.
+} Route;
+
+/**
+ * A node of the routing trie, representing the ID stem that is spelled by the path from the root to the node.
+ */
+typedef struct RouteNode {
+  char c;                         ///< The last character of the stem
+  Route *prefixed;                ///< Callbacks for IDs that begin with the stem
+  Route *exact;                   ///< Callbacks for the ID that equals the stem
+  struct RouteNode *children;     ///< The first of the nodes for stems that are one character longer
+  struct RouteNode *sibling;      ///< The next node with the same parent
+} RouteNode;
+
+/**
+ * The callbacks to invoke for a message, collected while the routes are locked.
+ */
+typedef struct {
+  RedisSubscriberCall *f;         ///< The callbacks
+  int n;                          ///< The number of callbacks
+  int size;                       ///< The capacity of the callback array
+  RedisSubscriberCall local[SMAX_DISPATCH_LOCAL_CALLS];   ///< Initial storage for the callbacks
+} CallList;
+
+static RouteNode root;                ///< The root node of the routing trie (for all IDs)
+static Redis *registered;             ///< The Redis instance on which the dispatcher is registered
+static pthread_mutex_t routeLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t dispatched = PTHREAD_COND_INITIALIZER;   ///< Signalled when a dispatch completes
+static unsigned long nStarted;        ///< Number of notifications whose dispatch started -- with routeLock only!
+static unsigned long nFinished;       ///< Number of notifications whose dispatch completed -- with routeLock only!
+static __thread boolean isDispatching; ///< Whether the calling thread is dispatching a notification
+
+/// \endcond
+
+/**
+ * Returns the child node of a routing node, for the given next character of the stem.
+ *
+ * @param node      The routing node
+ * @param c         The next character of the stem
+ * @param create    Whether to create the child if it does not exist.
+ * @return          The child node, or NULL if there is no such child (and it was not created).
+ */
+static RouteNode *GetChildAsync(RouteNode *node, char c, boolean create) {
+  RouteNode *child;
+
+  for(child = node->children; child != NULL; child = child->sibling) if(child->c == c) return child;
+
+  if(!create) return NULL;
+
+  child = (RouteNode *) calloc(1, sizeof(RouteNode));
+  x_check_alloc(child);
+
+  child->c = c;
+  child->sibling = node->children;
+  node->children = child;
+
+  return child;
+}
+
+/**
+ * Removes all instances of a callback from a list of routes.
+ *
+ * @param list    Pointer to the head of the list
+ * @param f       The callback to remove.
+ * @return        The number of callbacks removed.
+ */
+static int RemoveFromAsync(Route **list, RedisSubscriberCall f) {
+  int n = 0;
+
+  while(*list) {
+    Route *r = *list;
+    if(r->f == f) {
+      *list = r->next;
+      free(r);
+      n++;
+    }
+    else list = &r->next;
+  }
+
+  return n;
+}
+
+/**
+ * Removes a callback from a routing node and from all nodes below it, and frees the nodes that no longer
+ * hold any routes.
+ *
+ * @param node      The routing node
+ * @param f         The callback to remove, or NULL to remove empty nodes only.
+ * @return          The number of callbacks removed.
+ */
+static int PruneAsync(RouteNode *node, RedisSubscriberCall f) {
+  RouteNode **child = &node->children;
+  int n = 0;
+
+  if(f) {
+    n += RemoveFromAsync(&node->prefixed, f);
+    n += RemoveFromAsync(&node->exact, f);
+  }
+
+  while(*child) {
+    RouteNode *c = *child;
+
+    n += PruneAsync(c, f);
+
+    if(!c->children && !c->prefixed && !c->exact) {
+      *child = c->sibling;
+      free(c);
+    }
+    else child = &c->sibling;
+  }
+
+  return n;
+}
+
+/**
+ * Adds the callbacks of a route to the list of callbacks to invoke.
+ *
+ * @param calls     The list of callbacks to invoke
+ * @param r         The callbacks registered for a route.
+ */
+static void AddCalls(CallList *calls, const Route *r) {
+  for(; r != NULL; r = r->next) {
+    if(calls->n >= calls->size) {
+      RedisSubscriberCall *f = (RedisSubscriberCall *) malloc(2 * calls->size * sizeof(RedisSubscriberCall));
+      if(!f) {
+        perror("WARNING! SMA-X: alloc error dispatching update notification");
+        return;
+      }
+      memcpy(f, calls->f, calls->n * sizeof(RedisSubscriberCall));
+      if(calls->f != calls->local) free(calls->f);
+      calls->f = f;
+      calls->size *= 2;
+    }
+    calls->f[calls->n++] = r->f;
+  }
+}
+
+/**
+ * Dispatches an incoming update notification to the callbacks that were registered for its ID, or for a
+ * stem of it.
+ *
+ * @param pattern   The subscription pattern that matched the message.
+ * @param channel   The PUB/SUB channel on which the message was received.
+ * @param msg       The message
+ * @param length    [bytes] The length of the message.
+ */
+static void Dispatch(const char *pattern, const char *channel, const char *msg, long length) {
+  const RouteNode *node = &root;
+  const char *id;
+  CallList calls;
+  int i;
+
+  if(!channel) return;
+  if(strncmp(channel, SMAX_UPDATES, SMAX_UPDATES_LENGTH)) return;   // Not an update notification
+
+  id = channel + SMAX_UPDATES_LENGTH;
+
+  calls.f = calls.local;
+  calls.n = 0;
+  calls.size = SMAX_DISPATCH_LOCAL_CALLS;
+
+  pthread_mutex_lock(&routeLock);
+
+  // Walk the trie along the ID, collecting the callbacks for each stem of it.
+  while(node) {
+    AddCalls(&calls, node->prefixed);
+    if(!*id) {
+      AddCalls(&calls, node->exact);
+      break;
+    }
+    node = GetChildAsync((RouteNode *) node, *(id++), FALSE);
+  }
+
+  nStarted++;
+
+  pthread_mutex_unlock(&routeLock);
+
+  // Call outside of the lock, so callbacks may add or remove routes themselves.
+  isDispatching = TRUE;
+  for(i = 0; i < calls.n; i++) calls.f[i](pattern, channel, msg, length);
+  isDispatching = FALSE;
+
+  pthread_mutex_lock(&routeLock);
+  nFinished++;
+  pthread_cond_broadcast(&dispatched);
+  pthread_mutex_unlock(&routeLock);
+
+  if(calls.f != calls.local) free(calls.f);
+}
+
+/// \cond PROTECTED
+
+/**
+ * Routes update notifications for an SMA-X ID, or for IDs beginning with a given stem, to a callback
+ * function. Adding the same callback for the same route again has no effect.
+ *
+ * @param id        The SMA-X ID (table:key) or stem to match, or NULL to match all IDs.
+ * @param isExact   Whether to route only the notifications for the ID itself (TRUE), or else those for
+ *                  all IDs beginning with it (FALSE).
+ * @param f         The function to call with matching update notifications.
+ * @return          X_SUCCESS (0) if successful, or else an error code (&lt;0).
+ *
+ * @sa smaxRemoveRoute()
+ * @sa smaxRemoveRoutes()
+ */
+int smaxAddRoute(const char *id, boolean isExact, RedisSubscriberCall f) {
+  static const char *fn = "smaxAddRoute";
+
+  Redis *redis = smaxGetRedis();
+  RouteNode *node = &root;
+  Route **list, *r;
+
+  if(!f) return x_error(X_NULL, EINVAL, fn, "callback function is NULL");
+  if(!redis) return smaxError(fn, X_NO_INIT);
+
+  pthread_mutex_lock(&routeLock);
+
+  if(redis != registered) {
+    int status = redisxAddSubscriber(redis, SMAX_UPDATES, Dispatch);
+    if(status) {
+      pthread_mutex_unlock(&routeLock);
+      return x_trace(fn, NULL, status);
+    }
+    registered = redis;
+  }
+
+  if(id) for(; *id; id++) node = GetChildAsync(node, *id, TRUE);
+
+  list = isExact ? &node->exact : &node->prefixed;
+  for(r = *list; r != NULL; r = r->next) if(r->f == f) break;
+
+  if(!r) {
+    r = (Route *) calloc(1, sizeof(Route));
+    x_check_alloc(r);
+    r->f = f;
+    r->next = *list;
+    *list = r;
+  }
+
+  pthread_mutex_unlock(&routeLock);
+
+  return X_SUCCESS;
+}
+
+/**
+ * Stops routing update notifications for an SMA-X ID, or ID stem, to a callback function. It does not
+ * wait for a notification that is being dispatched to the callback at the time (see smaxWaitDispatched()).
+ *
+ * @param id        The SMA-X ID (table:key) or stem, as it was routed, or NULL for all IDs.
+ * @param isExact   Whether the route was for the ID itself (TRUE), or else for all IDs beginning with it
+ *                  (FALSE).
+ * @param f         The function that was called with matching update notifications.
+ * @return          X_SUCCESS (0) if the route was removed, or else X_NAME_INVALID if there was no such
+ *                  route.
+ *
+ * @sa smaxAddRoute()
+ */
+int smaxRemoveRoute(const char *id, boolean isExact, RedisSubscriberCall f) {
+  RouteNode *node = &root;
+  int n = 0;
+
+  pthread_mutex_lock(&routeLock);
+
+  if(id) for(; *id && node; id++) node = GetChildAsync(node, *id, FALSE);
+
+  if(node) {
+    n = RemoveFromAsync(isExact ? &node->exact : &node->prefixed, f);
+    if(n) PruneAsync(&root, NULL);
+  }
+
+  pthread_mutex_unlock(&routeLock);
+
+  return n ? X_SUCCESS : X_NAME_INVALID;
+}
+
+/**
+ * Stops routing update notifications to a callback function, for all routes it was added to. It does not
+ * wait for a notification that is being dispatched to the callback at the time (see smaxWaitDispatched()).
+ *
+ * @param f     The function that was called with matching update notifications.
+ * @return      The number of routes from which the function was removed.
+ *
+ * @sa smaxAddRoute()
+ * @sa smaxWaitDispatched()
+ */
+int smaxRemoveRoutes(RedisSubscriberCall f) {
+  int n;
+
+  if(!f) return 0;
+
+  pthread_mutex_lock(&routeLock);
+  n = PruneAsync(&root, f);
+  pthread_mutex_unlock(&routeLock);
+
+  return n;
+}
+
+/**
+ * Waits until the update notifications, whose dispatch has started before this call, have been processed
+ * by all callbacks. Thus, once it returns, callbacks whose routes were removed before are no longer called.
+ * Notifications are dispatched by the single subscription thread of the Redis instance, and so they
+ * complete in the order they were started. It returns immediately if called from within a callback, which
+ * is itself part of a dispatch. The caller must not hold locks that callbacks may also need.
+ *
+ * @sa smaxRemoveRoute()
+ * @sa smaxRemoveRoutes()
+ */
+void smaxWaitDispatched() {
+  unsigned long n;
+
+  if(isDispatching) return;
+
+  pthread_mutex_lock(&routeLock);
+  n = nStarted;
+  while(nFinished < n) pthread_cond_wait(&dispatched, &routeLock);
+  pthread_mutex_unlock(&routeLock);
+}
+
+/// \endcond
@@ -0,0 +1,255 @@
+/**
+ * \file
+ *
+ * \date Oct 16, 2026
+ * \author Attila Kovacs
+ *
+ * \brief
+ *      Epoch-based memory reclamation, which lets readers access shared data without locks, and without
+ *      writing to shared memory. Readers bracket their accesses between smaxEpochEnter() and
+ *      smaxEpochExit(). Writers, after unpublishing some data, hand it to smaxEpochRetire(). The data
+ *      is destroyed only once no reader that may have seen it remains inside its read section.
+ *
+ *      Each thread has its own record (on a cache line of its own), in which it announces the global
+ *      epoch at which it entered its read section. Retired data is tagged with the global epoch at
+ *      the time of retirement, which is then advanced. Retired data can be reclaimed once all active
+ *      readers have entered at a later epoch. Reclamation is attempted whenever data is retired, and
+ *      also when the last reader leaves its read section while retired data is pending.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "smax-private.h"
+
+/// \cond PRIVATE
+
+#define EPOCH_CACHE_LINE      64          ///< [bytes] Cache line size, for separating reader records
+
+/**
+ * A reader's record. Only the owning thread writes to it (apart from claiming a free record).
+ */
+typedef struct EpochRecord {
+  unsigned long epoch;                ///< The epoch at which the reader entered, or 0 if not reading.
+  int depth;                          ///< Nesting depth of read sections
+  int inUse;                          ///< Whether the record belongs to a live thread
+  struct EpochRecord *next;           ///< The next record in the list of all records
+} EpochRecord;
+
+/**
+ * Data that was retired, and awaits destruction.
+ */
+typedef struct Retired {
+  void *ptr;                          ///< The retired data
+  void (*destroy)(void *);            ///< The function that destroys it
+  unsigned long epoch;                ///< The global epoch at the time it was retired
+  struct Retired *next;               ///< The next item in the list of retired data
+} Retired;
+
+static unsigned long globalEpoch = 1;           ///< The current global epoch
+static EpochRecord *records;                    ///< All reader records (never freed, but reused)
+static pthread_mutex_t recordsLock = PTHREAD_MUTEX_INITIALIZER;
+
+static Retired *retired;                        ///< Data waiting to be destroyed
+static int nRetired;                            ///< (atomic) Number of items waiting to be destroyed
+static pthread_mutex_t retireLock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_key_t recordKey;                 ///< For releasing the record when the thread exits
+static pthread_once_t recordKeyOnce = PTHREAD_ONCE_INIT;
+
+static __thread EpochRecord *myRecord;          ///< The calling thread's record
+
+/// \endcond
+
+static void Reclaim(boolean isBlocking);
+
+/**
+ * Frees up the record of a thread that is exiting, so that it may be reused by another thread.
+ *
+ */
+static void ReleaseRecord(void *arg) {
+  EpochRecord *r = (EpochRecord *) arg;
+
+  __atomic_store_n(&r->epoch, 0, __ATOMIC_RELEASE);
+  r->depth = 0;
+  __atomic_store_n(&r->inUse, FALSE, __ATOMIC_RELEASE);
+}
+
+static void InitRecordKey() {
+  pthread_key_create(&recordKey, ReleaseRecord);
+}
+
+/**
+ * Returns the calling thread's record, claiming a free one, or else creating one, on the first call
+ * from a given thread.
+ *
+ */
+static EpochRecord *GetRecord() {
+  EpochRecord *r;
+
+  if(myRecord) return myRecord;
+
+  pthread_once(&recordKeyOnce, InitRecordKey);
+
+  // Try reuse a record of a thread that has exited.
+  for(r = __atomic_load_n(&records, __ATOMIC_ACQUIRE); r != NULL; r = r->next) {
+    int expected = FALSE;
+    if(__atomic_compare_exchange_n(&r->inUse, &expected, TRUE, FALSE, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) break;
+  }
+
+  if(!r) {
+    void *p = NULL;
+
+    if(posix_memalign(&p, EPOCH_CACHE_LINE, EPOCH_CACHE_LINE * ((sizeof(EpochRecord) + EPOCH_CACHE_LINE - 1) / EPOCH_CACHE_LINE))) {
+      perror("ERROR! smax-epoch: posix_memalign()");
+      exit(errno);
+    }
+
+    r = (EpochRecord *) p;
+    memset(r, 0, sizeof(EpochRecord));
+    r->inUse = TRUE;
+
+    pthread_mutex_lock(&recordsLock);
+    r->next = records;
+    __atomic_store_n(&records, r, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&recordsLock);
+  }
+
+  pthread_setspecific(recordKey, r);
+  myRecord = r;
+
+  return r;
+}
+
+/// \cond PROTECTED
+
+/**
+ * Enters a read section, in which shared data protected by epochs may be accessed without locking.
+ * Read sections may be nested, and should be kept short, since they hold up the reclamation of
+ * retired data.
+ *
+ * @sa smaxEpochExit()
+ */
+void smaxEpochEnter() {
+  EpochRecord *r = GetRecord();
+
+  if(r->depth++ > 0) return;
+
+  __atomic_store_n(&r->epoch, __atomic_load_n(&globalEpoch, __ATOMIC_ACQUIRE), __ATOMIC_RELAXED);
+
+  // Make our epoch visible before we read any shared pointers.
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+/**
+ * Exits a read section, entered via smaxEpochEnter().
+ *
+ * @sa smaxEpochEnter()
+ */
+void smaxEpochExit() {
+  EpochRecord *r = myRecord;
+
+  if(!r || r->depth <= 0) return;
+  if(--r->depth > 0) return;
+
+  __atomic_store_n(&r->epoch, 0, __ATOMIC_RELEASE);
+
+  // We may have been holding up the destruction of retired data.
+  if(__atomic_load_n(&nRetired, __ATOMIC_RELAXED) > 0) Reclaim(FALSE);
+}
+
+/**
+ * Returns the lowest epoch among the readers currently in their read section.
+ *
+ */
+static unsigned long GetOldestActiveEpoch() {
+  const EpochRecord *r;
+  unsigned long oldest = ~0UL;
+
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+  for(r = __atomic_load_n(&records, __ATOMIC_ACQUIRE); r != NULL; r = r->next) {
+    unsigned long e = __atomic_load_n(&r->epoch, __ATOMIC_ACQUIRE);
+    if(e && e < oldest) oldest = e;
+  }
+
+  return oldest;
+}
+
+/**
+ * Retires data that is no longer reachable by new readers, i.e. it has been unlinked, or replaced, in
+ * the shared data structures already. The data is destroyed with the supplied function once all readers
+ * that might still access it have exited their read sections, which may be during this call, or
+ * during a later one.
+ *
+ * @param ptr       The data to retire, or NULL.
+ * @param destroy   The function to destroy the data with.
+ *
+ * @sa smaxEpochEnter()
+ */
+void smaxEpochRetire(void *ptr, void (*destroy)(void *)) {
+  Retired *item;
+
+  if(!ptr || !destroy) return;
+
+  item = (Retired *) calloc(1, sizeof(Retired));
+  x_check_alloc(item);
+
+  item->ptr = ptr;
+  item->destroy = destroy;
+
+  // Readers that enter after this point can no longer reach the data.
+  item->epoch = __atomic_fetch_add(&globalEpoch, 1, __ATOMIC_SEQ_CST);
+
+  pthread_mutex_lock(&retireLock);
+  item->next = retired;
+  retired = item;
+  __atomic_add_fetch(&nRetired, 1, __ATOMIC_RELAXED);
+  pthread_mutex_unlock(&retireLock);
+
+  Reclaim(TRUE);
+}
+
+/// \endcond
+
+/**
+ * Destroys the retired data that no reader can access any longer.
+ *
+ * @param isBlocking  Whether to wait if another thread is retiring or reclaiming data at the same time, or
+ *                    else to leave it to that thread (e.g. when called from a read section's exit).
+ */
+static void Reclaim(boolean isBlocking) {
+  Retired *ready = NULL, **pItem;
+  unsigned long oldest;
+
+  if(isBlocking) pthread_mutex_lock(&retireLock);
+  else if(pthread_mutex_trylock(&retireLock) != 0) return;
+
+  // Only after all items in the list were retired, so active readers that might see any of them are counted.
+  oldest = GetOldestActiveEpoch();
+
+  // Collect the items that no reader can access any longer.
+  for(pItem = &retired; *pItem != NULL; ) {
+    Retired *r = *pItem;
+    if(r->epoch < oldest) {
+      *pItem = r->next;
+      r->next = ready;
+      ready = r;
+      __atomic_sub_fetch(&nRetired, 1, __ATOMIC_RELAXED);
+    }
+    else pItem = &r->next;
+  }
+
+  pthread_mutex_unlock(&retireLock);
+
+  // Destroy them outside of the lock.
+  while(ready) {
+    Retired *next = ready->next;
+    ready->destroy(ready->ptr);
+    free(ready);
+    ready = next;
+  }
+}
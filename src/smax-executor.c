@@ -0,0 +1,225 @@
+/**
+ * \file
+ *
+ * \date Oct 16, 2026
+ * \author Attila Kovacs
+ *
+ * \brief
+ *      An optional completion executor, i.e. a small pool of worker threads with a bounded task queue,
+ *      which runs the callbacks of the pipelined pull queue. This way slow user callbacks do not hold up
+ *      the processing of other pipelined responses. Without worker threads (the default), callbacks run
+ *      on the pipeline consumer thread, as they always have. (Synchronization points are always signalled
+ *      on the pipeline consumer thread, since that is cheap, and since waiters may destroy them as soon
+ *      as the queue is drained.)
+ *
+ *      \sa smaxSetCompletionThreads()
+ *      \sa smaxQueueInlineCallback()
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "smax-private.h"
+
+/// \cond PRIVATE
+
+#define SMAX_MAX_COMPLETION_THREADS   64      ///< Maximum number of completion threads
+#define SMAX_COMPLETION_QUEUE_SIZE    1024    ///< Maximum number of completions waiting for a thread
+
+typedef struct {
+  void (*f)(void *);            ///< The completion function
+  void *arg;                    ///< The argument to call the function with
+} Completion;
+
+static Completion tasks[SMAX_COMPLETION_QUEUE_SIZE];  ///< Ring buffer of pending completions
+static int first;               ///< Index of the first pending completion
+static int nTasks;              ///< Number of pending completions
+
+static pthread_t *workers;      ///< The running worker threads
+static int nWorkers;            ///< Number of running worker threads
+static boolean isStopping;      ///< Whether the worker threads should exit once the queue is empty
+
+static pthread_mutex_t execLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t hasTasks = PTHREAD_COND_INITIALIZER;
+
+static pthread_mutex_t configLock = PTHREAD_MUTEX_INITIALIZER;
+
+/// \endcond
+
+/**
+ * The worker thread, which runs completions until stopped.
+ *
+ */
+static void *CompletionThread(void *arg) {
+  (void) arg;
+
+  pthread_mutex_lock(&execLock);
+
+  while(TRUE) {
+    Completion c;
+
+    while(!nTasks && !isStopping) pthread_cond_wait(&hasTasks, &execLock);
+    if(!nTasks) break;
+
+    c = tasks[first];
+    first = (first + 1) % SMAX_COMPLETION_QUEUE_SIZE;
+    nTasks--;
+
+    pthread_mutex_unlock(&execLock);
+    c.f(c.arg);
+    pthread_mutex_lock(&execLock);
+  }
+
+  pthread_mutex_unlock(&execLock);
+
+  return NULL;
+}
+
+/**
+ * Stops the running worker threads, after they complete all pending tasks.
+ *
+ */
+static void StopWorkers() {
+  pthread_t *w;
+  int i, n;
+
+  pthread_mutex_lock(&execLock);
+  w = workers;
+  n = nWorkers;
+  isStopping = TRUE;
+  pthread_cond_broadcast(&hasTasks);
+  pthread_mutex_unlock(&execLock);
+
+  for(i = 0; i < n; i++) pthread_join(w[i], NULL);
+
+  pthread_mutex_lock(&execLock);
+  workers = NULL;
+  nWorkers = 0;
+  isStopping = FALSE;
+  pthread_mutex_unlock(&execLock);
+
+  if(w) free(w);
+}
+
+/**
+ * Sets the number of threads that run the callbacks of the pipelined pull queue. With 0 threads
+ * (default), they run on the pipeline consumer thread, s.t. a slow callback will delay the processing
+ * of all pipelined responses that follow. With 1 thread, callbacks are called in the order they were
+ * queued (as long as the executor's queue does not fill up). With more threads, they may run
+ * concurrently, and hence may complete in a different order. Either way, synchronization points are
+ * reached once the pulls before them have completed, but possibly before callbacks queued before them
+ * have run. (The library's own callbacks, such as those updating the lazy cache, always run inline, and
+ * hence complete before any later synchronization point is reached.)
+ *
+ * Callbacks may still run on the pipeline consumer thread if queued via smaxQueueInlineCallback(), or if
+ * the executor's queue is full.
+ *
+ * This function must not be called from a callback.
+ *
+ * @param n     Number of completion threads (0 -- 64). Any previously running threads are stopped after
+ *              completing the pending tasks.
+ * @return      X_SUCCESS (0) if successful, or else X_SIZE_INVALID if n is out of range, or X_FAILURE if
+ *              the threads could not be started.
+ *
+ * @sa smaxGetCompletionThreads()
+ * @sa smaxQueueCallback()
+ * @sa smaxQueueInlineCallback()
+ */
+int smaxSetCompletionThreads(int n) {
+  static const char *fn = "smaxSetCompletionThreads";
+
+  pthread_t *w;
+  int i;
+
+  if(n < 0 || n > SMAX_MAX_COMPLETION_THREADS) return x_error(X_SIZE_INVALID, EINVAL, fn, "invalid number of threads: %d", n);
+
+  pthread_mutex_lock(&configLock);
+
+  StopWorkers();
+
+  if(n == 0) {
+    pthread_mutex_unlock(&configLock);
+    return X_SUCCESS;
+  }
+
+  w = (pthread_t *) calloc(n, sizeof(pthread_t));
+  if(!w) {
+    pthread_mutex_unlock(&configLock);
+    return x_error(X_FAILURE, errno, fn, "calloc() error (%d pthread_t)", n);
+  }
+
+  for(i = 0; i < n; i++) if(pthread_create(&w[i], NULL, CompletionThread, NULL)) {
+    int err = errno;
+
+    // Stop the ones already started.
+    pthread_mutex_lock(&execLock);
+    workers = w;
+    nWorkers = i;
+    pthread_mutex_unlock(&execLock);
+
+    StopWorkers();
+    pthread_mutex_unlock(&configLock);
+
+    return x_error(X_FAILURE, err, fn, "pthread_create() error");
+  }
+
+  pthread_mutex_lock(&execLock);
+  workers = w;
+  nWorkers = n;
+  pthread_mutex_unlock(&execLock);
+
+  pthread_mutex_unlock(&configLock);
+
+  return X_SUCCESS;
+}
+
+/**
+ * Returns the number of threads currently running the completions of the pipelined pull queue.
+ *
+ * @return    The number of completion threads, or 0 if completions run on the pipeline consumer thread.
+ *
+ * @sa smaxSetCompletionThreads()
+ */
+int smaxGetCompletionThreads() {
+  int n;
+
+  pthread_mutex_lock(&execLock);
+  n = nWorkers;
+  pthread_mutex_unlock(&execLock);
+
+  return n;
+}
+
+/// \cond PROTECTED
+
+/**
+ * Runs a completion function, on one of the completion threads if available, or else on the calling
+ * thread. Completions also run on the calling thread when the executor's queue is full, rather than
+ * holding up the caller.
+ *
+ * @param f     The completion function
+ * @param arg   The argument to call the function with.
+ *
+ * @sa smaxSetCompletionThreads()
+ */
+void smaxRunCompletion(void (*f)(void *), void *arg) {
+  pthread_mutex_lock(&execLock);
+
+  if(nWorkers == 0 || isStopping || nTasks >= SMAX_COMPLETION_QUEUE_SIZE) {
+    pthread_mutex_unlock(&execLock);
+    f(arg);
+    return;
+  }
+
+  tasks[(first + nTasks) % SMAX_COMPLETION_QUEUE_SIZE].f = f;
+  tasks[(first + nTasks) % SMAX_COMPLETION_QUEUE_SIZE].arg = arg;
+  nTasks++;
+
+  pthread_cond_signal(&hasTasks);
+  pthread_mutex_unlock(&execLock);
+}
+
+/// \endcond
@@ -0,0 +1,392 @@
+/**
+ * \file
+ *
+ * \date Oct 16, 2026
+ * \author Attila Kovacs
+ *
+ * \brief
+ *      A resizable, open-addressing hash index of SMA-X variables (or other named items), with a strong
+ *      64-bit hash of the variable's table and key names. It is shared by the subsystems that keep track
+ *      of local per-variable state, such as the lazy cache, the resilient push store, or the binary
+ *      encoding settings, so that lookups remain O(1) also for 100,000+ variables.
+ *
+ *      The index stores item pointers only, while the callers provide the means to match their items
+ *      to whatever they are looking for. Modifications must be serialized by the caller (e.g. via a mutex).
+ *      Lookups may either hold the same lock, or else run concurrently with modifications, from within
+ *      an epoch read section (see smaxEpochEnter()). Slot arrays that are replaced, when the index is
+ *      resized, are reclaimed via smaxEpochRetire().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "smax-private.h"
+
+/// \cond PRIVATE
+
+#define HASH_MIN_SIZE         16                      ///< Minimum number of slots in an index
+#define HASH_SEED             0x9e3779b97f4a7c15ULL   ///< Initial seed value for hashing
+#define HASH_C1               0x87c37b91114253d5ULL   ///< Mixing constant
+#define HASH_C2               0x4cf5ad432745937fULL   ///< Mixing constant
+
+/**
+ * A slot in the index. Empty slots have a zero hash. Vacated slots keep their hash (tombstones), with a
+ * NULL item, so that probing continues past them.
+ */
+typedef struct {
+  unsigned long long hash;      ///< The hash of the item in the slot, or 0 if the slot was never used.
+  void *item;                   ///< The item in the slot, or NULL.
+} HashSlot;
+
+typedef struct {
+  int size;                     ///< Number of slots (a power of 2).
+  HashSlot slot[];              ///< The slots.
+} HashSlots;
+
+struct HashIndex {
+  HashSlots *slots;             ///< The current array of slots
+  int count;                    ///< Number of items in the index
+  int used;                     ///< Number of slots that are not empty (including tombstones)
+};
+
+/// \endcond
+
+static __inline__ unsigned long long RotateLeft(unsigned long long x, int bits) {
+  return (x << bits) | (x >> (64 - bits));
+}
+
+/**
+ * Final avalanche mixing of a 64-bit hash value (as in MurmurHash3).
+ *
+ */
+static __inline__ unsigned long long Mix(unsigned long long h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+/**
+ * Hashes a sequence of bytes, 8 bytes at a time, continuing from a prior hash value.
+ *
+ */
+static unsigned long long HashBytes(const char *buf, int size, unsigned long long h) {
+  const char *end;
+
+  if(!buf) return RotateLeft(h, 17) ^ HASH_C2;
+  if(size <= 0) size = strlen(buf);
+
+  end = buf + (size & ~7);
+
+  h ^= size * HASH_C1;
+
+  for(; buf < end; buf += 8) {
+    unsigned long long k;
+    memcpy(&k, buf, 8);
+    k *= HASH_C1;
+    k = RotateLeft(k, 31);
+    k *= HASH_C2;
+    h ^= k;
+    h = RotateLeft(h, 27) * 5 + 0x52dce729;
+  }
+
+  if(size & 7) {
+    unsigned long long k = 0;
+    memcpy(&k, buf, size & 7);
+    k *= HASH_C1;
+    k = RotateLeft(k, 31);
+    k *= HASH_C2;
+    h ^= k;
+  }
+
+  return Mix(h);
+}
+
+/// \cond PROTECTED
+
+/**
+ * Returns a well-distributed 64-bit hash for the given table (group) name and Redis field (key) name,
+ * for use with a hash index. A given variable has the same hash, whether its table and key are
+ * given separately, or as parts of its aggregate ID (e.g. notification channel), as long as they
+ * are split at the same separator.
+ *
+ * \param table     Hash table name, or NULL.
+ * \param lTab      Number of characters to process from table, or 0 to use full string.
+ * \param key       Key/field name, or NULL.
+ * \param lKey      Number of characters to process from the key, or 0 to use full string.
+ *
+ * \return          A non-zero 64-bit hash value.
+ *
+ * @sa smaxHashFind()
+ */
+unsigned long long smaxHashID(const char *table, int lTab, const char *key, int lKey) {
+  unsigned long long h = HashBytes(key, lKey, HashBytes(table, lTab, HASH_SEED));
+  return h ? h : 1;
+}
+
+/**
+ * Creates a new, empty, hash index.
+ *
+ * @return    The new hash index, or NULL if there was an error.
+ *
+ * @sa smaxDestroyHashIndex()
+ */
+HashIndex *smaxCreateHashIndex() {
+  HashIndex *idx = (HashIndex *) calloc(1, sizeof(HashIndex));
+  x_check_alloc(idx);
+
+  idx->slots = (HashSlots *) calloc(1, sizeof(HashSlots) + HASH_MIN_SIZE * sizeof(HashSlot));
+  x_check_alloc(idx->slots);
+  idx->slots->size = HASH_MIN_SIZE;
+
+  return idx;
+}
+
+/**
+ * Destroys a hash index, but not the items it contains. The caller should make sure that no other
+ * thread is accessing the index any longer.
+ *
+ * @param idx   The hash index, or NULL.
+ *
+ * @sa smaxCreateHashIndex()
+ */
+void smaxDestroyHashIndex(HashIndex *idx) {
+  if(!idx) return;
+  free(idx->slots);
+  free(idx);
+}
+
+/**
+ * Returns the number of items in a hash index.
+ *
+ * @param idx   The hash index
+ * @return      The number of items in the index, or 0 if the index is NULL.
+ */
+int smaxHashCount(const HashIndex *idx) {
+  return idx ? __atomic_load_n(&idx->count, __ATOMIC_RELAXED) : 0;
+}
+
+/**
+ * Finds an item in the hash index. It may be called while holding the lock that serializes the
+ * modifications of the index, or else from within an epoch read section.
+ *
+ * @param idx       The hash index
+ * @param hash      The hash of the item, e.g. from smaxHashID().
+ * @param match     Function that checks if an item (with the same hash) is the one we are looking for.
+ * @param arg       The argument to pass to the matching function, such as a name.
+ * @return          The matching item, or NULL if there is no matching item in the index.
+ *
+ * @sa smaxHashAdd()
+ */
+void *smaxHashFind(const HashIndex *idx, unsigned long long hash, boolean (*match)(const void *item, const void *arg), const void *arg) {
+  const HashSlots *s;
+  int i, n;
+
+  if(!idx || !match) return NULL;
+
+  s = __atomic_load_n(&idx->slots, __ATOMIC_ACQUIRE);
+
+  for(i = hash & (s->size - 1), n = s->size; --n >= 0; i = (i + 1) & (s->size - 1)) {
+    const unsigned long long h = __atomic_load_n(&s->slot[i].hash, __ATOMIC_ACQUIRE);
+    void *item;
+
+    if(!h) break;               // Empty slot, end of probe sequence
+    if(h != hash) continue;
+
+    item = __atomic_load_n(&s->slot[i].item, __ATOMIC_ACQUIRE);
+    if(item) if(match(item, arg)) return item;
+  }
+
+  return NULL;
+}
+
+/**
+ * Moves all items of the index into a new slot array of the appropriate size for the current
+ * number of items, dropping tombstones also.
+ *
+ */
+static void Rehash(HashIndex *idx) {
+  HashSlots *old = idx->slots, *s;
+  int i, size = HASH_MIN_SIZE;
+
+  while(size < 4 * (idx->count + 1)) size <<= 1;
+
+  s = (HashSlots *) calloc(1, sizeof(HashSlots) + size * sizeof(HashSlot));
+  x_check_alloc(s);
+  s->size = size;
+
+  for(i = 0; i < old->size; i++) if(old->slot[i].item) {
+    int k = old->slot[i].hash & (size - 1);
+    while(s->slot[k].hash) k = (k + 1) & (size - 1);
+    s->slot[k] = old->slot[i];
+  }
+
+  idx->used = idx->count;
+
+  __atomic_store_n(&idx->slots, s, __ATOMIC_RELEASE);
+
+  // Concurrent readers may still be probing the old slots.
+  smaxEpochRetire(old, free);
+}
+
+/**
+ * Adds an item to the hash index. The caller should make sure that the index does not already contain
+ * a matching item, and that modifications to the index are serialized.
+ *
+ * @param idx       The hash index
+ * @param hash      The hash of the item, e.g. from smaxHashID().
+ * @param item      The item to add.
+ * @return          X_SUCCESS (0) if successful, or else X_NULL if the index or item is NULL.
+ *
+ * @sa smaxHashRemove()
+ * @sa smaxHashFind()
+ */
+int smaxHashAdd(HashIndex *idx, unsigned long long hash, void *item) {
+  static const char *fn = "smaxHashAdd";
+
+  HashSlots *s;
+  int i;
+
+  if(!idx) return x_error(X_NULL, EINVAL, fn, "index is NULL");
+  if(!item) return x_error(X_NULL, EINVAL, fn, "item is NULL");
+
+  // Keep the load (including tombstones) under 1/2
+  if(2 * (idx->used + 1) > idx->slots->size) Rehash(idx);
+
+  s = idx->slots;
+
+  // Use the first empty slot or tombstone in the probe sequence.
+  for(i = hash & (s->size - 1); s->slot[i].item; i = (i + 1) & (s->size - 1));
+
+  if(!s->slot[i].hash) idx->used++;
+
+  // Set the item before the hash, so readers that match the hash find the item.
+  __atomic_store_n(&s->slot[i].item, item, __ATOMIC_RELEASE);
+  __atomic_store_n(&s->slot[i].hash, hash, __ATOMIC_RELEASE);
+
+  __atomic_store_n(&idx->count, idx->count + 1, __ATOMIC_RELAXED);
+
+  return X_SUCCESS;
+}
+
+/**
+ * Removes an item from the hash index. Modifications to the index must be serialized by the caller.
+ * Concurrent readers may still return the item until their epoch read section ends.
+ *
+ * @param idx       The hash index
+ * @param hash      The hash of the item, with which it was added.
+ * @param item      The item to remove.
+ * @return          TRUE (1) if the item was removed, or else FALSE (0) if it was not in the index.
+ *
+ * @sa smaxHashAdd()
+ */
+boolean smaxHashRemove(HashIndex *idx, unsigned long long hash, const void *item) {
+  HashSlots *s;
+  int i, n;
+
+  if(!idx || !item) return FALSE;
+
+  s = idx->slots;
+
+  for(i = hash & (s->size - 1), n = s->size; --n >= 0; i = (i + 1) & (s->size - 1)) {
+    if(!s->slot[i].hash) break;
+    if(s->slot[i].item != item) continue;
+
+    // Leave a tombstone.
+    __atomic_store_n(&s->slot[i].item, NULL, __ATOMIC_RELEASE);
+    __atomic_store_n(&idx->count, idx->count - 1, __ATOMIC_RELAXED);
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+/**
+ * Returns all items in the hash index, in an unspecified order. The caller should hold the lock that
+ * serializes modifications to the index.
+ *
+ * @param idx       The hash index
+ * @param[out] n    Pointer to where the number of items is returned.
+ * @return          A newly allocated array of the items, which the caller should free() after use, or
+ *                  NULL if the index is empty (or NULL).
+ *
+ * @sa smaxHashClear()
+ */
+void **smaxHashItems(const HashIndex *idx, int *n) {
+  const HashSlots *s;
+  void **items;
+  int i, k = 0;
+
+  *n = 0;
+
+  if(!idx || !idx->count) return NULL;
+
+  items = (void **) calloc(idx->count, sizeof(void *));
+  x_check_alloc(items);
+
+  s = idx->slots;
+  for(i = 0; i < s->size && k < idx->count; i++) if(s->slot[i].item) items[k++] = s->slot[i].item;
+
+  *n = k;
+  return items;
+}
+
+/**
+ * Returns the next item in the hash index, starting at the given slot position and wrapping around
+ * at the end, such that repeated calls walk the index in a circular fashion (e.g. for a CLOCK sweep).
+ * The caller should hold the lock that serializes modifications to the index.
+ *
+ * @param idx           The hash index
+ * @param[in,out] pos   Pointer to the slot position at which to start. It is updated to the position
+ *                      following the returned item.
+ * @return              The next item in the index, or NULL if the index is empty (or NULL).
+ *
+ * @sa smaxHashItems()
+ */
+void *smaxHashNext(const HashIndex *idx, int *pos) {
+  const HashSlots *s;
+  int n;
+
+  if(!idx || !pos || !idx->count) return NULL;
+
+  s = idx->slots;
+
+  for(n = s->size; --n >= 0; ) {
+    const int i = *pos & (s->size - 1);
+    *pos = i + 1;
+    if(s->slot[i].item) return s->slot[i].item;
+  }
+
+  return NULL;
+}
+
+/**
+ * Removes all items from the hash index (without destroying them). Modifications to the index must be
+ * serialized by the caller.
+ *
+ * @param idx       The hash index
+ *
+ * @sa smaxHashItems()
+ */
+void smaxHashClear(HashIndex *idx) {
+  HashSlots *old, *s;
+
+  if(!idx) return;
+
+  old = idx->slots;
+
+  s = (HashSlots *) calloc(1, sizeof(HashSlots) + HASH_MIN_SIZE * sizeof(HashSlot));
+  x_check_alloc(s);
+  s->size = HASH_MIN_SIZE;
+
+  idx->count = idx->used = 0;
+
+  __atomic_store_n(&idx->slots, s, __ATOMIC_RELEASE);
+  smaxEpochRetire(old, free);
+}
+
+/// \endcond
@@ -9,62 +9,493 @@
  *      infrequently, from the SMA-X database. Rather than querying the database on every call, the first lazy pull of
  *      a variable initiates monitoring for updates. The pull requests will return the current state of the variable at all times,
  *      but it generates minimal network traffic only when the underlying value in the database is changed.
+ *
+ *      Monitor points are kept in a hash index (see smax-hash.c), and are guarded by striped mutexes, so that
+ *      accesses to unrelated variables do not contend. Reads of current, fixed-size data bypass the locks entirely:
+ *      the index is searched, and the cached data is read, within epoch-protected read sections (see smax-epoch.c), with a
+ *      per-monitor sequence counter to detect (and retry) reads that overlap with an update. Such reads do not
+ *      write to shared memory at all. Data that is replaced, and monitors that are discarded, are destroyed only
+ *      once no reader can be accessing them any longer.
+ *
+ *      The decoded (binary) values of the cached data are memoized for the types and element counts they were
+ *      requested with (up to a few per variable), until the next update, so repeat reads of the same data
+ *      need not parse it again. They may also be accessed directly, without copying, via smaxGetCachedView().
+ *
+ *      The cache may be bounded in the number of variables and / or in memory (see smaxSetLazyCacheLimits()).
+ *      When over budget, variables are evicted in approximate least-recently-used order, using a CLOCK sweep
+ *      of the monitor index: variables that were read since the hand last passed get a second chance.
+ *      Independently, variables that keep getting updated without being read are unsubscribed from, once
+ *      they have gone unread for considerably longer than their typical interval between reads.
+ *
+ *      Whole subtrees of variables may be cached at once, via smaxCachePattern(), with a single pattern
+ *      subscription for all of them, and with pipelined pulls of their initial values. Variables that appear
+ *      under the pattern later are added to the cache automatically, as their first update notification arrives.
+ *
+ *      Sets of related cached variables may be read together, consistently, via smaxGetCachedMany(). Each variable
+ *      is read briefly under its own lock, and the set is read again if any of them was updated in the meantime (as
+ *      told by their sequence counters), so the background updates are never held up for reading the whole set.
+ *
+ *      Alternatively to subscribing to update notifications, variables may be invalidated by the server, via
+ *      Redis client-side caching support (see smax-tracking.c). Such tracked monitors are also indexed by their
+ *      hash table, since the server invalidates tables rather than the individual variables in them.
+ *
+ *      The cached variables may also be shared with other processes on the same host, via a shared-memory
+ *      mirror (see smax-shm.c), which is kept in sync as the variables are updated, invalidated, or discarded.
+ *
+ *      Our own writes to monitored variables are applied to the cache directly (write-through), and the update
+ *      notifications that originate from them are ignored, so that we do not pull back the data we just sent.
+ *      Likewise, the values that other programs send along with their update notifications (see
+ *      smaxSetValueNotifications()) are applied to the cache directly, rather than pulled from the database.
  */
 
+#define _POSIX_C_SOURCE 199309    ///< for clock_gettime()
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <pthread.h>
 #include <string.h>
 #include <unistd.h>
 #include <semaphore.h>
 #include <errno.h>
 #include <math.h>
+#include <fnmatch.h>
 
 #include "smax-private.h"
 
 /// \cond PRIVATE
 
-#define MAX_UNPULLED_LAZY_UPDATES       10      ///< Number of unprocessed updates, before unsubscribing from notifications...
+#define MAX_UNPULLED_LAZY_UPDATES       10      ///< Number of unprocessed updates, before considering to unsubscribe from notifications...
+#define LAZY_MIN_IDLE_TIME              10.0    ///< [s] Minimum time without reads, before unsubscribing from notifications.
+#define LAZY_IDLE_FACTOR                4.0     ///< Unsubscribe only if unread for this many times the typical interval between reads.
+#define LAZY_READ_SMOOTHING             0.25    ///< Weight of the latest sample in the running average interval between reads.
+#define MAX_SNAPSHOT_ATTEMPTS           100     ///< Maximum number of attempts to read a mutually consistent set of cached values.
+#define LAZY_SCAN_COUNT                 "1000"  ///< Number of keys to scan per SCAN request, when looking for tables that match a pattern.
+#define MAX_DECODED_FORMATS             4       ///< Maximum number of decoded type / count combinations memoized per variable
+
+/**
+ * Decoded values of the cached data, for a given type and element count. They are immutable, and are discarded
+ * when the cached data is updated, once no longer in use.
+ */
+typedef struct LazyDecoded {
+  int refs;                 ///< Number of references: one while attached to the monitor, plus one for each view.
+  XType type;               ///< The type of the decoded values
+  int count;                ///< The number of decoded elements
+  int bytes;                ///< The size of the decoded values
+  struct LazyDecoded *next; ///< Decoded values of the same data, in another format.
+  double data[];            ///< The decoded values (declared double for alignment)
+} LazyDecoded;
 
 typedef struct LazyMonitor {
   boolean isLinked;         ///< If the monitor is linked in list and not to be destroyed as such.
-  int users;                ///< Number of callers currently using this monitor point -- update with monitorLock only!
+  int users;                ///< Number of callers currently using this monitor point -- update with the bucket's lock only!
+  unsigned long long hash;  ///< The hash of the variable's table and key, with which it is indexed.
+  int bucket;               ///< The lock stripe to which the monitor belongs.
+  unsigned int seq;         ///< Sequence counter, which is odd while data / metadata is being replaced.
   char *table;              ///< The Redis hash table name in which the data is stored
   char *key;                ///< The hash field name, or NULL if the monitor is for the structure represented by the table.
   char *channel;            ///< The pub/sub channel, e.g. "smax:<group>:<key>"
   char *data;               ///< The serialized data, as stored in Redis, or a pointer to an XStructure
   XMeta *meta;              ///< (optional) metadata
+  LazyDecoded *decoded;     ///< Memoized decoded values of the current data, or NULL.
+  int nDecoded;             ///< The number of memoized decoded formats.
   boolean isCached;         ///< Whether the variable is continuously caching 'current' data.
+  boolean isSubscribed;     ///< Whether the monitor has its own subscription to update notifications.
+  boolean isTracked;        ///< Whether the monitor is invalidated by the server instead (see smax-tracking.c).
+  boolean isPatterned;      ///< Whether the monitor was created for a cached pattern (see smaxCachePattern()).
   boolean isCurrent;        ///< If the locally stored data is current.
   boolean isPending;        ///< Whether already queued for an update.
   time_t updateTime;        ///< Time of last update.
   int updateCount;          ///< Number of times the variable was updated.
-  int unpulledCount;        ///< Number of updates since last pull...
-  struct LazyMonitor *prev;
-  struct LazyMonitor *next;
+  int unpulledCount;        ///< (atomic) Number of updates since last pull...
+  int ownWrites;            ///< Number of our own writes applied to the cache, whose notifications are yet to arrive.
+  double lastReadTime;      ///< [s] Monotonic time of the last read that followed an update (or of creation).
+  double readInterval;      ///< [s] Running average interval between the reads that follow updates, or 0 if unknown.
+  boolean isReferenced;     ///< (atomic) Whether the variable was read since the CLOCK hand last passed it.
+  long dataBytes;           ///< [bytes] Memory used by the cached data (and decoded values).
+  long bytes;               ///< [bytes] Total memory used by the monitor point.
+  struct LazyMonitor *target; ///< (staging only) the monitor to which a queued update is to be applied.
 } LazyMonitor;
 
+/**
+ * The name of a variable we are looking for in the monitor index.
+ */
+typedef struct {
+  const char *table;        ///< The hash table name
+  const char *key;          ///< The hash field name, or NULL for structures.
+} LazyName;
+
+/**
+ * The tracked monitors in a given hash table.
+ */
+typedef struct {
+  char *name;               ///< The hash table name
+  unsigned long long hash;  ///< The hash of the table name, with which it is indexed
+  int n;                    ///< The number of monitors in the table
+  int size;                 ///< The capacity of the monitors array
+  LazyMonitor **monitors;   ///< The tracked monitors in the table
+} LazyTable;
+
+/**
+ * A glob pattern of variables, which are cached as a whole.
+ */
+typedef struct LazyPattern {
+  char *table;              ///< The table name pattern
+  char *key;                ///< The key name pattern
+  char *channel;            ///< The update notification channel pattern, i.e. "smax:<table>:<key>"
+  struct LazyPattern *next; ///< The next pattern in the list
+} LazyPattern;
+
+/**
+ * The contents of an update notification that carries the new value of the variable (see
+ * smaxSetValueNotifications()). The message body consists of the newline-separated origin, timestamp,
+ * serial number, type, and dimensions of the update, followed by the serialized value itself.
+ */
+typedef struct {
+  char *buf;                ///< Copy of the message, with the fields terminated in it, or NULL if it has no value.
+  char *origin;             ///< The origin of the update
+  struct timespec timestamp;///< The time of the update
+  int serial;               ///< The serial number of the update
+  char *type;               ///< The type of the value, as stored in Redis.
+  char *dims;               ///< The dimensions of the value, as stored in Redis.
+  char *data;               ///< The serialized value
+  int length;               ///< [bytes] The length of the serialized value
+} LazyPayload;
+
 /// \endcond
 
-static int nMonitors;                                           ///< Number of lazy variables monitored.
+static LazyPattern *patterns;                                   ///< Patterns of variables cached as a whole -- update with subscriberLock only!
+static int nMonitors;                                           ///< Number of lazy variables monitored -- update with subscriberLock only!
+static pthread_mutex_t subscriberLock = PTHREAD_MUTEX_INITIALIZER; ///< Mutex for the monitor count and the update subscriber.
 
-static LazyMonitor *monitorTable[SMAX_LOOKUP_SIZE];             ///< hashed monitor tables
-static pthread_mutex_t monitorLock = PTHREAD_MUTEX_INITIALIZER; ///< Mutex for accessing monitor tables
-static pthread_mutex_t dataLock = PTHREAD_MUTEX_INITIALIZER;    ///< mutex for accessing monitor data/metadata
+static HashIndex *monitors;                                     ///< Index of monitored variables
+static HashIndex *tables;                                       ///< Index of tables with tracked monitors -- with indexLock only!
+static pthread_mutex_t indexLock = PTHREAD_MUTEX_INITIALIZER;   ///< Mutex for modifying the monitor index.
+static pthread_mutex_t bucketLock[SMAX_LOOKUP_SIZE];            ///< Striped mutexes for the monitors.
+static pthread_once_t monitorsOnce = PTHREAD_ONCE_INIT;
 
-static LazyMonitor *CreateMonitorAsync(const char *table, const char *key, XType type, boolean withMeta);
+static pthread_mutex_t refLock = PTHREAD_MUTEX_INITIALIZER;     ///< Mutex for persistent monitor references.
+
+static int maxEntries;                                          ///< Maximum number of monitored variables, or 0 if unlimited.
+static long maxBytes;                                           ///< [bytes] Memory budget for the monitored variables, or 0 if unlimited.
+static long cacheBytes;                                         ///< [bytes] Memory used by the monitored variables -- update atomically!
+static long nEvicted;                                           ///< Number of variables evicted to stay within budget -- update atomically!
+static long nCollected;                                         ///< Number of variables unsubscribed for lack of reads -- update atomically!
+static int clockHand;                                           ///< Position of the CLOCK hand in the monitor index -- with evictLock only!
+static pthread_mutex_t evictLock = PTHREAD_MUTEX_INITIALIZER;   ///< Mutex for the eviction sweep.
+
+static LazyMonitor *CreateMonitorAsync(const char *table, const char *key, XType type, boolean withMeta, unsigned long long hash, boolean subscribe);
 static boolean DestroyMonitorAsync(LazyMonitor *m);
-static int GetChannelLookupIndex(const char *channel);
-static __inline__ int GetTableIndex(const LazyMonitor *m);
-static LazyMonitor *GetMonitorAsync(const char *table, const char *key);
-static LazyMonitor *GetExistingMonitorAsync(const char *table, const char *key);
+static unsigned long long GetChannelHash(const char *channel);
+static __inline__ unsigned long long GetHash(const char *table, const char *key);
+static LazyMonitor *GetMonitor(const char *table, const char *key);
+static LazyMonitor *FindMonitor(const char *table, const char *key, unsigned long long hash);
+static LazyMonitor *GetExistingMonitorAsync(const char *table, const char *key, unsigned long long hash);
 static void ProcessLazyUpdates(const char *pattern, const char *channel, const char *msg, long length);
+static void RemoveMonitorAsync(LazyMonitor *m);
+static void AddPatterned(const char *channel);
+static void DestroyPatterns(LazyPattern *p);
+static void AddTrackedAsync(LazyMonitor *m);
+static void RemoveTrackedAsync(LazyMonitor *m);
+static void DiscardTablesAsync();
+
+static void InitMonitors() {
+  int i;
+  for(i = 0; i < SMAX_LOOKUP_SIZE; i++) pthread_mutex_init(&bucketLock[i], NULL);
+  tables = smaxCreateHashIndex();
+  __atomic_store_n(&monitors, smaxCreateHashIndex(), __ATOMIC_RELEASE);
+}
+
+/**
+ * Returns the lock stripe for a given variable hash.
+ *
+ * @param hash      The variable's hash, e.g. from GetHash().
+ * @return          The lock stripe, i.e. the index of the mutex that guards monitors with the given hash.
+ */
+static __inline__ int GetBucket(unsigned long long hash) {
+  return (int) (hash & (SMAX_LOOKUP_SIZE - 1));
+}
+
+/**
+ * Obtains exclusive access to the monitors in a given lock stripe.
+ *
+ * @param bucket    The lock stripe, e.g. from GetBucket().
+ *
+ * @sa UnlockBucket()
+ */
+static void LockBucket(int bucket) {
+  pthread_once(&monitorsOnce, InitMonitors);
+  pthread_mutex_lock(&bucketLock[bucket]);
+}
+
+static void UnlockBucket(int bucket) {
+  pthread_mutex_unlock(&bucketLock[bucket]);
+}
+
+/**
+ * Marks the start of changes to the data / metadata of a monitor point, for lock-free readers. The
+ * bucket of the monitor must be locked.
+ *
+ * @param m     Pointer to lazy monitor
+ *
+ * @sa EndWriteAsync()
+ */
+static __inline__ void BeginWriteAsync(LazyMonitor *m) {
+  __atomic_store_n(&m->seq, m->seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/**
+ * Marks the end of changes to the data / metadata of a monitor point, for lock-free readers. The
+ * bucket of the monitor must be locked.
+ *
+ * @param m     Pointer to lazy monitor
+ *
+ * @sa BeginWriteAsync()
+ */
+static __inline__ void EndWriteAsync(LazyMonitor *m) {
+  __atomic_store_n(&m->seq, m->seq + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Returns the current monotonic time, for timing the reads of lazy variables.
+ *
+ * @return    [s] The monotonic time.
+ */
+static double GetTime() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+/**
+ * Changes the memory accounted for a monitor point, and for the cache as a whole while the monitor
+ * is part of it. The monitor's bucket should be locked.
+ *
+ * @param m       Pointer to a lazy monitor datum.
+ * @param delta   [bytes] The change in the memory used by the monitor.
+ */
+static void ResizeAsync(LazyMonitor *m, long delta) {
+  m->bytes += delta;
+  if(m->isLinked) __atomic_add_fetch(&cacheBytes, delta, __ATOMIC_RELAXED);
+}
+
+/**
+ * Returns the (approximate) memory used by cached data.
+ *
+ * @param m       Pointer to the lazy monitor (or staging) that holds the data.
+ * @return        [bytes] The memory used by the data.
+ */
+static long GetDataBytes(const LazyMonitor *m) {
+  if(!m->data) return 0;
+  if(!m->key) return sizeof(XStructure);
+  if(m->meta) if(m->meta->storeBytes > 0) return m->meta->storeBytes;
+  return strlen(m->data) + 1;
+}
+
+/**
+ * Records a read of a monitor point, for the eviction and unsubscribing policies. The first read after
+ * an update also resets the unread updates counter, and updates the typical interval between such reads.
+ * It should be called without locking. Subsequent reads of the same update do not write shared memory,
+ * while the first read after an update records it under the bucket lock, unless the lock is busy, in
+ * which case a later read will record it instead (we'd rather not wait).
+ *
+ * @param m       Pointer to a lazy monitor datum.
+ */
+static void MarkRead(LazyMonitor *m) {
+  if(__atomic_load_n(&m->unpulledCount, __ATOMIC_RELAXED)) if(pthread_mutex_trylock(&bucketLock[m->bucket]) == 0) {
+    if(m->unpulledCount) {
+      const double now = GetTime(), dt = now - m->lastReadTime;
+
+      m->readInterval = m->readInterval > 0.0 ? m->readInterval + LAZY_READ_SMOOTHING * (dt - m->readInterval) : dt;
+      m->lastReadTime = now;
+      __atomic_store_n(&m->unpulledCount, 0, __ATOMIC_RELAXED);     // Reset the unread updates counter
+    }
+    UnlockBucket(m->bucket);
+  }
+
+  if(!__atomic_load_n(&m->isReferenced, __ATOMIC_RELAXED)) __atomic_store_n(&m->isReferenced, TRUE, __ATOMIC_RELAXED);
+}
+
+/**
+ * Checks if a monitor point, which accumulated unread updates, has also gone unread long enough,
+ * relative to its typical interval between reads, that we should stop monitoring it. The monitor's
+ * bucket should be locked.
+ *
+ * @param m       Pointer to a lazy monitor datum.
+ * @return        TRUE (1) if the variable should be no longer monitored, or else FALSE (0).
+ */
+static boolean IsIdleAsync(const LazyMonitor *m) {
+  double idle;
+
+  if(m->isPatterned) return FALSE;      // Cached via a pattern, on demand
+  if(m->unpulledCount <= MAX_UNPULLED_LAZY_UPDATES) return FALSE;
+
+  idle = GetTime() - m->lastReadTime;
+  if(idle <= LAZY_MIN_IDLE_TIME || idle <= LAZY_IDLE_FACTOR * m->readInterval) return FALSE;
+
+  // Other processes may be reading it from the shared mirror, without us knowing.
+  return !(m->key && smaxIsMirrored(m->table, m->key));
+}
+
+/**
+ * Checks if the cache exceeds the configured number of variables or memory budget.
+ *
+ * @return    TRUE (1) if the cache is over budget, or else FALSE (0).
+ */
+static boolean IsOverBudget() {
+  const int maxn = __atomic_load_n(&maxEntries, __ATOMIC_RELAXED);
+  const long maxb = __atomic_load_n(&maxBytes, __ATOMIC_RELAXED);
+
+  if(maxn > 0) if(smaxHashCount(monitors) > maxn) return TRUE;
+  if(maxb > 0) if(__atomic_load_n(&cacheBytes, __ATOMIC_RELAXED) > maxb) return TRUE;
+  return FALSE;
+}
+
+/**
+ * Evicts monitor points from the cache, in approximate least-recently-used order, until the cache
+ * is within the configured limits. Recently read variables get a second chance (CLOCK). If another
+ * thread is evicting already, it returns immediately. It should be called without holding any lock.
+ *
+ * @sa smaxSetLazyCacheLimits()
+ */
+static void EnforceLimits() {
+  int n;
+
+  if(!IsOverBudget()) return;
+  if(pthread_mutex_trylock(&evictLock) != 0) return;
+
+  // At most two full turns: one to clear reference bits, and one to evict.
+  for(n = 2 * smaxHashCount(monitors) + 1; --n >= 0 && IsOverBudget(); ) {
+    LazyMonitor *m;
+    int bucket;
+
+    pthread_mutex_lock(&indexLock);
+    m = (LazyMonitor *) smaxHashNext(monitors, &clockHand);
+    smaxEpochEnter();         // Keep it from being deallocated until we lock its bucket.
+    pthread_mutex_unlock(&indexLock);
+
+    if(!m) {
+      smaxEpochExit();
+      break;
+    }
+
+    bucket = m->bucket;
+    LockBucket(bucket);
+
+    if(__atomic_load_n(&m->isReferenced, __ATOMIC_RELAXED)) __atomic_store_n(&m->isReferenced, FALSE, __ATOMIC_RELAXED);
+    else if(m->isLinked && !(m->key && smaxIsMirrored(m->table, m->key))) {
+      xvprintf("SMA-X: Evicting lazy variable %s:%s.\n", m->table, m->key ? m->key : "");
+      RemoveMonitorAsync(m);
+      DestroyMonitorAsync(m);
+      __atomic_add_fetch(&nEvicted, 1, __ATOMIC_RELAXED);
+    }
+
+    UnlockBucket(bucket);
+    smaxEpochExit();
+  }
+
+  pthread_mutex_unlock(&evictLock);
+}
+
+/**
+ * Drops a reference to decoded values, destroying them when no longer referenced.
+ *
+ * @param d     Pointer to decoded values.
+ */
+static void ReleaseDecoded(LazyDecoded *d) {
+  if(__atomic_sub_fetch(&d->refs, 1, __ATOMIC_ACQ_REL) == 0) free(d);
+}
+
+/**
+ * Drops the monitor's references to a list of decoded values.
+ *
+ * @param d     Pointer to the first decoded values in the list, or NULL.
+ */
+static void ReleaseDecodedList(LazyDecoded *d) {
+  while(d) {
+    LazyDecoded *next = d->next;
+    ReleaseDecoded(d);
+    d = next;
+  }
+}
+
+/**
+ * Returns the memoized decoded values of the current data, for the given type and count. It may be
+ * called either with the monitor's bucket locked, or else from within an epoch read section.
+ *
+ * @param m       Pointer to a lazy monitor datum.
+ * @param type    SMA-X type requested
+ * @param count   Number of elements requested
+ * @return        The matching decoded values, or NULL if there are none.
+ */
+static LazyDecoded *FindDecoded(const LazyMonitor *m, XType type, int count) {
+  LazyDecoded *d;
+
+  for(d = __atomic_load_n(&m->decoded, __ATOMIC_ACQUIRE); d != NULL; d = d->next)
+    if(d->type == type && d->count == count) return d;
+
+  return NULL;
+}
+
+/**
+ * Decodes serialized data into a new (unattached) set of decoded values.
+ *
+ * @param data    The serialized data
+ * @param type    SMA-X type requested
+ * @param count   Number of elements requested
+ * @return        The decoded values, or NULL if the data could not be decoded as requested.
+ */
+static LazyDecoded *CreateDecoded(const char *data, XType type, int count) {
+  LazyDecoded *d;
+  int eSize = xElementSizeOf(type), n;
+
+  if(eSize <= 0 || count <= 0) return NULL;
+
+  d = (LazyDecoded *) calloc(1, sizeof(LazyDecoded) + count * eSize);
+  x_check_alloc(d);
+
+  d->refs = 1;
+  d->type = type;
+  d->count = count;
+  d->bytes = count * eSize;
+
+  if(smaxStringToValues(data, d->data, type, count, &n) <= 0) {
+    free(d);
+    return NULL;
+  }
+
+  return d;
+}
+
+/**
+ * Attaches (memoizes) decoded values to a monitor, provided that the monitor's data has not changed since
+ * they were decoded. The monitor's bucket should be locked.
+ *
+ * @param m       Pointer to a lazy monitor datum.
+ * @param seq     The monitor's sequence counter value at which the values were decoded.
+ * @param d       The decoded values. The monitor takes over their reference if attached.
+ * @return        TRUE (1) if the decoded values were attached, or else FALSE (0).
+ */
+static boolean AttachDecodedAsync(LazyMonitor *m, unsigned int seq, LazyDecoded *d) {
+  if(m->seq != seq) return FALSE;
+  if(m->nDecoded >= MAX_DECODED_FORMATS) return FALSE;
+  if(FindDecoded(m, d->type, d->count)) return FALSE;
+
+  d->next = m->decoded;
+  __atomic_store_n(&m->decoded, d, __ATOMIC_RELEASE);
+  m->nDecoded++;
+
+  m->dataBytes += sizeof(LazyDecoded) + d->bytes;
+  ResizeAsync(m, sizeof(LazyDecoded) + d->bytes);
+
+  return TRUE;
+}
 
 /**
  * Decrements the number of concurrent user calls that currently need access to the specific
  * lazy monitor data. If the monitor has no users left and is not currently monitored
- * (that is unlinked from the active monitor tables) it will be destroyed. The table mutex
+ * (that is unlinked from the active monitor tables) it will be destroyed. The monitor's bucket
  * should be locked when calling this routine.
  *
  * @param m     Pointer to lazy monitor
@@ -80,7 +511,7 @@ static void ReleaseAsync(LazyMonitor *m) {
  * Decrements the number of concurrent user calls that currently need access to the specific
  * lazy monitor data. If the monitor has no users left and is not currently monitored
  * (that is unlinked from the active monitor tables) it will be destroyed. It will
- * acquire an exclusive lock to the table monitor and call ReleaseAsync()
+ * acquire an exclusive lock to the monitor's bucket and call ReleaseAsync()
  *
  * @param m     Pointer to lazy monitor
  * @return      X_SUCCESS (0)
@@ -88,46 +519,92 @@ static void ReleaseAsync(LazyMonitor *m) {
  * @sa ReleaseAsync()
  */
 static int Release(LazyMonitor *m) {
+  int bucket;
+
   if(!m) return x_error(X_NULL, EINVAL, "Release", "NULL argument");
 
-  pthread_mutex_lock(&monitorLock);
+  bucket = m->bucket;
+
+  LockBucket(bucket);
   ReleaseAsync(m);
-  pthread_mutex_unlock(&monitorLock);
+  UnlockBucket(bucket);
   return X_SUCCESS;
 }
 
+/**
+ * Increments the number of concurrent user calls that need access to the specific lazy monitor,
+ * so it is not destroyed until Release() is called on it.
+ *
+ * @param m     Pointer to lazy monitor
+ *
+ * @sa Release()
+ */
+static void Retain(LazyMonitor *m) {
+  LockBucket(m->bucket);
+  m->users++;
+  UnlockBucket(m->bucket);
+}
+
 /**
  * Applies an update to a cached lazy monitor. It swaps the contents of the update with that
  * of the specified monitor, s.t. the previous monitor content is available in the update
  * after the call. The caller can use it and/or destroy it if it's not longer important.
+ * It should be called without locking the monitor's bucket.
  *
  * @param update    Pointer to the update, usually created via CreateStaging().
  * @param m         Pointer to the cached monitor point.
+ * @param isQueued  Whether the update is the one that was queued for the monitor (see QueueUpdateAsync()),
+ *                  in which case the monitor no longer has an update pending after the call.
  *
  * @sa CreateStaging()
  */
-static void ApplyUpdateAsync(LazyMonitor *update, LazyMonitor *m) {
+static void ApplyUpdateAsync(LazyMonitor *update, LazyMonitor *m, boolean isQueued) {
   char *oldData;
   XMeta *oldMeta;
+  LazyDecoded *oldDecoded;
+  int oldCount;
+  long bytes;
 
   if(!m) return;
 
   xvprintf("SMA: Applying update for %s" X_SEP "%s\n", m->table, m->key);
 
+  LockBucket(m->bucket);
+
   // Update the stored data 'atomically'
-  pthread_mutex_lock(&dataLock);
   oldData = m->data;
   oldMeta = m->meta;
-  m->data = update->data;
-  m->meta = update->meta;
+  oldDecoded = m->decoded;
+  oldCount = m->nDecoded;
+
+  BeginWriteAsync(m);
+  __atomic_store_n(&m->data, update->data, __ATOMIC_RELEASE);
+  __atomic_store_n(&m->meta, update->meta, __ATOMIC_RELEASE);
+  __atomic_store_n(&m->decoded, NULL, __ATOMIC_RELEASE);
+  m->nDecoded = 0;
   m->updateTime = time(NULL);
   m->isCurrent = TRUE;
-  m->isPending = FALSE;
-  pthread_mutex_unlock(&dataLock);
+  if(isQueued) m->isPending = FALSE;
+  EndWriteAsync(m);
+
+  if(m->key) smaxMirrorUpdate(m->table, m->key, m->data, m->meta);
+
+  // Account for the memory change (the old decoded values are discarded with the old data).
+  bytes = GetDataBytes(m);
+  ResizeAsync(m, bytes - m->dataBytes);
+  m->dataBytes = bytes;
+  if(m->meta && !oldMeta) ResizeAsync(m, sizeof(XMeta));
+  else if(oldMeta && !m->meta) ResizeAsync(m, -(long) sizeof(XMeta));
+
+  UnlockBucket(m->bucket);
 
-  // we'll destroy the old data / meta with the update!
+  // we'll destroy the old data / meta with the update (once readers are done with it)!
   update->data = oldData;
   update->meta = oldMeta;
+  update->decoded = oldDecoded;
+  update->nDecoded = oldCount;
+
+  EnforceLimits();
 }
 
 /**
@@ -138,17 +615,13 @@ static void ApplyUpdateAsync(LazyMonitor *update, LazyMonitor *m) {
  */
 static void ApplyUpdate(void *arg) {
   LazyMonitor *update = (LazyMonitor *) arg;
-  LazyMonitor *m;
 
   if(!update) return;
 
-  pthread_mutex_lock(&monitorLock);
-  m = GetExistingMonitorAsync(update->table, update->key);
-  pthread_mutex_unlock(&monitorLock);
-
-  if(m) {
-    ApplyUpdateAsync(update, m);
-    Release(m);
+  if(update->target) {
+    ApplyUpdateAsync(update, update->target, TRUE);
+    Release(update->target);
+    update->target = NULL;
   }
 
   DestroyMonitorAsync(update);
@@ -173,6 +646,7 @@ static LazyMonitor *CreateStaging(const LazyMonitor *m) {
   // Copy table/key
   s->table = xStringCopyOf(m->table);
   s->key = xStringCopyOf(m->key);
+  s->bucket = m->bucket;
 
   // 'pending' needs a data container where it can store the data.
   if(!m->key) s->data = (char *) xCreateStruct();
@@ -184,28 +658,41 @@ static LazyMonitor *CreateStaging(const LazyMonitor *m) {
 }
 
 /**
- * Updates the monitored data in the cache, by pulling from SMA-X. The update is essentially atomic
- * as it happens with a single reassignment of a pointer.
+ * Queues an update of the monitored data in the cache, to be pulled from SMA-X in the background. The
+ * update is essentially atomic as it happens with a single reassignment of a pointer. It should be called
+ * without locking the monitor's bucket.
  *
  * @param m     Pointer to a lazy monitor datum.
- * @return      X_SUCCESS (0) if successfull or else an error (&lt;0) from smaxPull().
+ * @return      X_SUCCESS (0) if successfull or else an error (&lt;0) from smaxQueue().
  */
 static int QueueUpdateAsync(LazyMonitor *m) {
+  static const char *fn = "QueueUpdateAsync";
+
   LazyMonitor *staging;
   XType type;
   void *ptr;
   int status = X_SUCCESS;
 
+  if(!m) return x_error(X_NULL, EINVAL, fn, "input parameter 'm' is NULL");
+
   xvprintf("SMA-X: Initiate queueing aync update for %s" X_SEP "%s\n", m->table, m->key);
 
-  if(!m) return x_error(X_NULL, EINVAL, "QueueUpdateAsync", "input parameter 'm' is NULL");
+  LockBucket(m->bucket);
 
   if(m->isPending) {
+    UnlockBucket(m->bucket);
     xvprintf("SMA-X: An update is already pending for %s" X_SEP "%s\n", m->table, m->key);
     return X_SUCCESS;
   }
 
+  // The pending update keeps the monitor alive until it is applied.
+  m->isPending = TRUE;
+  m->users++;
+
+  UnlockBucket(m->bucket);
+
   staging = CreateStaging(m);
+  staging->target = m;
 
   if(m->key) {
     type = X_RAW;
@@ -216,22 +703,29 @@ static int QueueUpdateAsync(LazyMonitor *m) {
     ptr = staging->data;
   }
 
-
   xvprintf("SMA-X: Queueing async update for %s" X_SEP "%s\n", m->table, m->key);
 
-  m->isPending = TRUE;
   status = smaxQueue(m->table, m->key, type, 1, ptr, staging->meta);
-  if(!status) {
-    m->users++;
-    smaxQueueCallback(ApplyUpdate, staging);
+  // Apply inline, so the cache is updated by the time subsequent sync points are reached.
+  if(!status) status = smaxQueueInlineCallback(ApplyUpdate, staging);
+  else {
+    LockBucket(m->bucket);
+    m->isPending = FALSE;
+    ReleaseAsync(m);
+    UnlockBucket(m->bucket);
+
+    staging->target = NULL;
+    DestroyMonitorAsync(staging);
   }
 
+  prop_error(fn, status);
   return X_SUCCESS;
 }
 
 /**
  * Updates the monitored data in the cache, by pulling from SMA-X. The update is essentially atomic
- * as it happens with a single reassignment of a pointer.
+ * as it happens with a single reassignment of a pointer. It should be called without locking the
+ * monitor's bucket.
  *
  * @param m     Pointer to a lazy monitor datum.
  * @return      X_SUCCESS (0) if successfull or else an error (&lt;0) from smaxPull().
@@ -257,7 +751,7 @@ static int UpdateCachedAsync(LazyMonitor *m) {
   }
 
   status = smaxPull(m->table, m->key, type, 1, ptr, staging->meta);
-  if(!status) ApplyUpdateAsync(staging, m);
+  if(!status) ApplyUpdateAsync(staging, m, FALSE);
   DestroyMonitorAsync(staging);
 
   prop_error(fn, status);
@@ -266,7 +760,7 @@ static int UpdateCachedAsync(LazyMonitor *m) {
 
 /**
  * Returns the currently cached value of a lazy monitor point into the supplied buffer as
- * the requested type and element count.
+ * the requested type and element count. The monitor's bucket should be locked.
  *
  *
  * @param[in]  m        Pointer to a lazy monitor datum.
@@ -313,19 +807,160 @@ static int GetCachedAsync(const LazyMonitor *m, XType type, int count, void *val
       break;
     }
 
-    default:
+    default: {
+      const LazyDecoded *d = FindDecoded(m, type, count);
+      if(d) {
+        memcpy(value, d->data, d->bytes);
+        break;
+      }
       status = smaxStringToValues(m->data, value, type, count, &n);
       if(status <= 0) return x_trace(fn, NULL, status);
+    }
   }
 
   return X_SUCCESS;
 }
 
+/**
+ * Attempts to return current cached data, without locking and without writing to shared memory (well,
+ * apart from recording the first read after an update, or since the eviction sweep last passed the
+ * variable, and memoizing the decoded values on the first read after an update). It is only for types that
+ * parse into the caller's buffer without allocating memory. Must be called from within an epoch read
+ * section.
+ *
+ * @param[in]  m          Pointer to a lazy monitor datum.
+ * @param[in]  type       SMA-X type requested
+ * @param[in]  count      Number of elements requested
+ * @param[out] value      Buffer to fill with the requested data type/count.
+ * @param[out] meta       Optional metadata pointer, or NULL if metadata is not required.
+ * @param[in]  isCached   Whether the monitor should be already continuously cached.
+ * @return                TRUE if the data was returned, or else FALSE if the data is not current, or not
+ *                        readily available, in which case the caller should get it the regular way.
+ *
+ * @sa smaxEpochEnter()
+ */
+static boolean ReadCurrentAsync(LazyMonitor *m, XType type, int count, void *value, XMeta *meta, boolean isCached) {
+  LazyDecoded *fresh = NULL;
+  unsigned int seq;
+
+  if(!m->key) return FALSE;
+  if(isCached && !m->isCached) return FALSE;
+
+  switch(type) {
+    case X_STRUCT:
+    case X_RAW:
+    case X_STRING:
+      return FALSE;
+    default:
+      ;
+  }
+
+  while(TRUE) {
+    const char *data;
+    const XMeta *cachedMeta;
+    const LazyDecoded *d;
+
+    seq = __atomic_load_n(&m->seq, __ATOMIC_ACQUIRE);
+    if(seq & 1) continue;     // Update in progress...
+
+    data = __atomic_load_n(&m->data, __ATOMIC_ACQUIRE);
+    cachedMeta = __atomic_load_n(&m->meta, __ATOMIC_ACQUIRE);
+
+    if(!m->isCurrent || !data || (meta && !cachedMeta)) return FALSE;
+
+    // Decode the data (once per update), unless memoized already. We'll memoize it below...
+    d = FindDecoded(m, type, count);
+    if(!d) d = fresh = CreateDecoded(data, type, count);
+
+    if(d) memcpy(value, d->data, d->bytes);
+    if(meta) *meta = *cachedMeta;
+
+    // Make sure the data was not replaced while we were reading it.
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if(__atomic_load_n(&m->seq, __ATOMIC_RELAXED) == seq) {
+      if(d) break;
+      return FALSE;
+    }
+
+    if(fresh) {
+      free(fresh);
+      fresh = NULL;
+    }
+  }
+
+  if(fresh) {
+    // Memoize, unless someone else holds the lock (we'd rather not wait).
+    boolean isAttached = FALSE;
+
+    if(pthread_mutex_trylock(&bucketLock[m->bucket]) == 0) {
+      isAttached = AttachDecodedAsync(m, seq, fresh);
+      UnlockBucket(m->bucket);
+    }
+
+    if(!isAttached) free(fresh);
+  }
+
+  MarkRead(m);
+
+  return TRUE;
+}
+
+/**
+ * Attempts to return current cached data for a variable that is already monitored, without
+ * locking, and without writing to shared memory.
+ *
+ * @param table     The hash table name.
+ * @param key       The variable name under which the data is stored.
+ * @param type      The SMA-X variable type, e.g. X_FLOAT or X_CHARS(40), of the buffer.
+ * @param count     The number of elements to retrieve
+ * @param value     Pointer to the native data buffer in which to restore values
+ * @param meta      Optional metadata pointer, or NULL if metadata is not required.
+ * @param isCached  Whether the monitor should be already continuously cached.
+ * @return          TRUE if the data was returned, or else FALSE.
+ *
+ * @sa ReadCurrentAsync()
+ */
+static boolean TryReadCurrent(const char *table, const char *key, XType type, int count, void *value, XMeta *meta, boolean isCached) {
+  LazyMonitor *m;
+  boolean success = FALSE;
+
+  if(!table || !key || !value) return FALSE;
+
+  smaxEpochEnter();
+  m = FindMonitor(table, key, GetHash(table, key));
+  if(m) success = ReadCurrentAsync(m, type, count, value, meta, isCached);
+  smaxEpochExit();
+
+  return success;
+}
+
+/**
+ * Adds metadata to a monitor point that did not have it before. The monitor's data is no longer
+ * considered current after, so that the metadata will be pulled on the next access.
+ *
+ * @param m     Pointer to a lazy monitor datum.
+ */
+static void AddMeta(LazyMonitor *m) {
+  LockBucket(m->bucket);
+
+  if(!m->meta) {
+    BeginWriteAsync(m);
+    __atomic_store_n(&m->meta, smaxCreateMeta(), __ATOMIC_RELEASE);
+    m->isCurrent = FALSE;
+    EndWriteAsync(m);
+    ResizeAsync(m, sizeof(XMeta));
+  }
+
+  UnlockBucket(m->bucket);
+}
+
 static LazyMonitor *GetCreateMonitor(const char *table, const char *key, XType type, boolean withMeta) {
   static const char *fn = "GetCreateMonitor";
 
   LazyMonitor *m;
   char *lazytab = (char *) table;
+  unsigned long long hash;
+  boolean isNew = FALSE;
 
   if(type == X_STRUCT) {
     lazytab = xGetAggregateID(table, key);
@@ -334,17 +969,25 @@ static LazyMonitor *GetCreateMonitor(const char *table, const char *key, XType t
 
   if(!lazytab) return x_trace_null(fn, NULL);
 
-  pthread_mutex_lock(&monitorLock);
+  hash = GetHash(lazytab, key);
+
+  LockBucket(GetBucket(hash));
 
-  m = GetExistingMonitorAsync(lazytab, key);
-  if(!m) m = CreateMonitorAsync(lazytab, key, type, withMeta);
+  m = GetExistingMonitorAsync(lazytab, key, hash);
+  if(!m) {
+    m = CreateMonitorAsync(lazytab, key, type, withMeta, hash, TRUE);
+    isNew = (m != NULL);
+  }
 
-  pthread_mutex_unlock(&monitorLock);
+  UnlockBucket(GetBucket(hash));
+
+  if(lazytab != table) free(lazytab);
 
   if(!m) return x_trace_null(fn, NULL);
-  if(withMeta && !m->meta) m->meta = smaxCreateMeta();
+  if(withMeta && !m->meta) AddMeta(m);
 
-  if(lazytab != table) free(lazytab);
+  // Make room for the new variable, if need be (the new one is spared, since it's referenced).
+  if(isNew) EnforceLimits();
 
   return m;
 }
@@ -354,13 +997,10 @@ static int FetchDataAsync(LazyMonitor *m, XType type, int count, void *value, XM
 
   int status = X_SUCCESS;
 
-  if(meta && !m->meta) {
-    // Update monitor to include metadata and pull to set it.
-    m->meta = (XMeta *) calloc(1, sizeof(XMeta));
-    x_check_alloc(m->meta);
-    status = UpdateCachedAsync(m);
-  }
-  else if(!m->isCurrent) status = (m->isCached && smaxIsPipelined()) ? QueueUpdateAsync(m) : UpdateCachedAsync(m);
+  // Update monitor to include metadata, which we'll pull below.
+  if(meta && !m->meta) AddMeta(m);
+
+  if(!m->isCurrent) status = (m->isCached && smaxIsPipelined()) ? QueueUpdateAsync(m) : UpdateCachedAsync(m);
 
   xvprintf("SMA-X: Lazy pull %s:%s (status=%d)\n", m->table, m->key ? m->key : "", status);
 
@@ -369,45 +1009,120 @@ static int FetchDataAsync(LazyMonitor *m, XType type, int count, void *value, XM
     if(meta) if(meta != m->meta) smaxResetMeta(meta);
   }
   else {
-    m->unpulledCount = 0;   // Reset the unread updates counter
+    MarkRead(m);
 
     // Copy/parse the cached data into the requested destination.
-    pthread_mutex_lock(&dataLock);
+    LockBucket(m->bucket);
     status = GetCachedAsync(m, type, count, value);
     if(meta) if(meta != m->meta) *meta = *m->meta;
-    pthread_mutex_unlock(&dataLock);
+    UnlockBucket(m->bucket);
   }
 
   prop_error(fn, status);
   return X_SUCCESS;
 }
 
+/// \cond PROTECTED
+
 /**
- * Specify that a specific variable should be cached for minimum overhead lazy access. When a variable is lazy cached
- * its local copy is automatically updated in the background so that accessing it is always nearly instantaneous.
- * Lazy caching is a good choice for variables that change less frequently than they are polled typically. For
- * variables that change frequently (ans used less frequently), lazy caching is not a great choice since it consumes
- * network bandwidth even when the variable is not being accessed.
- *
- * Once a variable is lazy cached, it can be accessed instantaneously via smaxGetCached() without any blocking
- * network operations.
- *
- * @param table   The hash table name.
- * @param key     The variable name under which the data is stored.
- * @param type    The SMA-X variable type, e.g. X_FLOAT or X_CHARS(40), of the buffer.
- * @return        X_SUCCESS (0) or X_NO_SERVICE.
- *
- * @sa smaxGetCached()
+ * Lazy pulls (or gets cached) data via a persistent reference to the variable's monitor point, such
+ * as held by a variable handle, so that the monitor need not be looked up by name on every call. The
+ * reference is (re)established as needed, e.g. on the first call, or if the monitor point was
+ * discarded since the last call (by smaxLazyEnd(), smaxLazyFlush(), or for lack of use).
+ *
+ * @param[in,out] monitor   Pointer to the persistent monitor reference (initially NULL).
+ * @param table             The hash table name (or the aggregate ID for structures).
+ * @param key               The variable name under which the data is stored (or NULL for structures).
+ * @param type              The SMA-X variable type, e.g. X_FLOAT or X_CHARS(40), of the buffer.
+ * @param count             The number of elements to retrieve
+ * @param value             Pointer to the native data buffer in which to restore values
+ * @param meta              Optional metadata pointer, or NULL if metadata is not required.
+ * @param isCached          Whether to keep the variable continuously cached, as with smaxGetCached().
+ * @return                  X_SUCCESS (0), or X_NO_SERVICE is SMA-X is not accessible, or another
+ *                          error (&lt;0) from smax.h or xchange.h.
+ *
+ * @sa smaxLazyReleaseMonitor()
  */
-int smaxCache(const char *table, const char *key, XType type) {
-  LazyMonitor *m;
+int smaxLazyPullMonitor(void **monitor, const char *table, const char *key, XType type, int count, void *value, XMeta *meta, boolean isCached) {
+  static const char *fn = "smaxLazyPullMonitor";
 
-  m = GetCreateMonitor(table, key, type, TRUE);
-  if(!m) return x_trace("smaxCache", NULL, X_NO_SERVICE);
+  LazyMonitor *m, *old;
+  boolean isDone = FALSE;
+  int status;
 
-  UpdateCachedAsync(m);
-  m->isCached = TRUE;
-  Release(m);
+  if(!value) return x_error(X_NULL, EINVAL, fn, "value is NULL");
+
+  // Try return current data without locking...
+  smaxEpochEnter();
+  m = __atomic_load_n((LazyMonitor **) monitor, __ATOMIC_ACQUIRE);
+  if(m) if(m->isLinked) isDone = ReadCurrentAsync(m, type, count, value, meta, isCached);
+  smaxEpochExit();
+
+  if(isDone) return X_SUCCESS;
+
+  m = GetCreateMonitor(table, key, type, meta != NULL);
+  if(!m) return x_trace(fn, NULL, X_NO_SERVICE);
+
+  // (Re)establish the persistent reference to the monitor for the caller, dropping the
+  // reference to a monitor that was discarded, if any.
+  pthread_mutex_lock(&refLock);
+  old = (LazyMonitor *) *monitor;
+  if(old != m) {
+    Retain(m);
+    __atomic_store_n((LazyMonitor **) monitor, m, __ATOMIC_RELEASE);
+  }
+  else old = NULL;
+  pthread_mutex_unlock(&refLock);
+
+  if(old) Release(old);
+
+  status = FetchDataAsync(m, type, count, value, meta);
+  if(isCached) if(!m->isCached) m->isCached = TRUE;
+  Release(m);
+
+  prop_error(fn, status);
+  return X_SUCCESS;
+}
+
+/**
+ * Releases a persistent monitor reference obtained via smaxLazyPullMonitor().
+ *
+ * @param monitor   The monitor reference, or NULL.
+ *
+ * @sa smaxLazyPullMonitor()
+ */
+void smaxLazyReleaseMonitor(void *monitor) {
+  if(monitor) Release((LazyMonitor *) monitor);
+}
+
+/// \endcond
+
+/**
+ * Specify that a specific variable should be cached for minimum overhead lazy access. When a variable is lazy cached
+ * its local copy is automatically updated in the background so that accessing it is always nearly instantaneous.
+ * Lazy caching is a good choice for variables that change less frequently than they are polled typically. For
+ * variables that change frequently (ans used less frequently), lazy caching is not a great choice since it consumes
+ * network bandwidth even when the variable is not being accessed.
+ *
+ * Once a variable is lazy cached, it can be accessed instantaneously via smaxGetCached() without any blocking
+ * network operations.
+ *
+ * @param table   The hash table name.
+ * @param key     The variable name under which the data is stored.
+ * @param type    The SMA-X variable type, e.g. X_FLOAT or X_CHARS(40), of the buffer.
+ * @return        X_SUCCESS (0) or X_NO_SERVICE.
+ *
+ * @sa smaxGetCached()
+ */
+int smaxCache(const char *table, const char *key, XType type) {
+  LazyMonitor *m;
+
+  m = GetCreateMonitor(table, key, type, TRUE);
+  if(!m) return x_trace("smaxCache", NULL, X_NO_SERVICE);
+
+  UpdateCachedAsync(m);
+  m->isCached = TRUE;
+  Release(m);
 
 
   return X_SUCCESS;
@@ -416,7 +1131,9 @@ int smaxCache(const char *table, const char *key, XType type) {
 /**
  * Retrieve a variable from the local cache (if available), or else pull from the SMA-X database. If local caching was not
  * previously eanbled, it will be enabled with this call, so that subsequent calls will always return data from the locally
- * updated cache with minimal overhead and effectively no latency.
+ * updated cache with minimal overhead and effectively no latency. Reading current cached data of fixed size types (i.e.
+ * not strings, raw data, or structures) never blocks on other threads. If attached to the lazy cache of another
+ * process (see smaxAttachLazyCache()), the variables in that cache are returned from it instead.
  *
  * @param table   The hash table name.
  * @param key     The variable name under which the data is stored.
@@ -436,22 +1153,278 @@ int smaxGetCached(const char *table, const char *key, XType type, int count, voi
   LazyMonitor *m;
   int status;
 
+  // Try the cache shared by another process (if attached), unless the variable is not in it.
+  status = smaxMirrorRead(table, key, type, count, value, meta);
+  if(status == X_INCOMPLETE) status = smaxPull(table, key, type, count, value, meta);
+  if(status != X_NAME_INVALID) {
+    prop_error(fn, status);
+    return X_SUCCESS;
+  }
+
+  if(TryReadCurrent(table, key, type, count, value, meta, TRUE)) return X_SUCCESS;
+
   m = GetCreateMonitor(table, key, type, meta != NULL);
   if(!m) return x_trace(fn, NULL, X_NO_SERVICE);
 
   status = FetchDataAsync(m, type, count, value, meta);
-  m->isCached = TRUE; // Set after the first non-cached fetch...
+  if(!m->isCached) m->isCached = TRUE; // Set after the first non-cached fetch...
+  Release(m);
+
+  prop_error(fn, status);
+  return X_SUCCESS;
+}
+
+/**
+ * Returns a read-only pointer to the decoded values of a cached variable, without copying them. Otherwise,
+ * it is the same as smaxGetCached(), that is the variable is pulled from SMA-X if it is not yet cached,
+ * and will be updated in the background after. The values pointed to remain valid, and unchanged, until
+ * released via smaxReleaseCachedView(), even if the cached variable is updated (or discarded) in the
+ * meantime. Call the function again to get the latest values.
+ *
+ * Views are for fixed size types only, that is not for strings, raw data, or structures.
+ *
+ * @param table   The hash table name.
+ * @param key     The variable name under which the data is stored.
+ * @param type    The SMA-X variable type, e.g. X_FLOAT or X_CHARS(40), of the values.
+ * @param count   The number of elements to decode
+ * @param meta    Optional metadata pointer, or NULL if metadata is not required.
+ * @return        Pointer to the decoded values (`count` elements of `type`), or NULL if there was an
+ *                error (errno is set to indicate the type of error).
+ *
+ * @sa smaxReleaseCachedView()
+ * @sa smaxGetCached()
+ */
+const void *smaxGetCachedView(const char *table, const char *key, XType type, int count, XMeta *meta) {
+  static const char *fn = "smaxGetCachedView";
+
+  LazyMonitor *m;
+  LazyDecoded *d = NULL;
+  int status = X_SUCCESS;
+
+  if(!table) {
+    x_error(0, EINVAL, fn, "table is NULL");
+    return NULL;
+  }
+
+  if(!key) {
+    x_error(0, EINVAL, fn, "key is NULL");
+    return NULL;
+  }
+
+  if(type == X_STRUCT || type == X_RAW || type == X_STRING || xElementSizeOf(type) <= 0) {
+    x_error(0, EINVAL, fn, "unsupported type: %d", type);
+    return NULL;
+  }
+
+  if(count <= 0) {
+    x_error(0, EINVAL, fn, "invalid count: %d", count);
+    return NULL;
+  }
+
+  m = GetCreateMonitor(table, key, type, meta != NULL);
+  if(!m) return x_trace_null(fn, NULL);
+
+  if(!m->isCurrent) status = (m->isCached && smaxIsPipelined()) ? QueueUpdateAsync(m) : UpdateCachedAsync(m);
+
+  if(!status) {
+    LockBucket(m->bucket);
+
+    d = FindDecoded(m, type, count);
+    if(d) __atomic_add_fetch(&d->refs, 1, __ATOMIC_ACQ_REL);
+    else if(m->data) {
+      // One reference for the monitor (if attached), and one for the view
+      d = CreateDecoded(m->data, type, count);
+      if(d) if(AttachDecodedAsync(m, m->seq, d)) __atomic_add_fetch(&d->refs, 1, __ATOMIC_ACQ_REL);
+    }
+
+    if(d) if(meta) if(meta != m->meta) *meta = *m->meta;
+
+    UnlockBucket(m->bucket);
+  }
+
+  if(!m->isCached) m->isCached = TRUE;
   Release(m);
 
+  if(status) return x_trace_null(fn, NULL);
+
+  if(!d) {
+    x_error(0, EINVAL, fn, "could not decode %s" X_SEP "%s as the requested type", table, key);
+    return NULL;
+  }
+
+  return d->data;
+}
+
+/**
+ * Discards the (dynamically allocated) contents of a value that was read from the cache, e.g. because
+ * it was read as part of an inconsistent set of values.
+ *
+ * @param type    SMA-X type of the value
+ * @param count   Number of elements in the value
+ * @param value   Pointer to the value.
+ */
+static void DiscardValue(XType type, int count, void *value) {
+  switch(type) {
+    case X_STRUCT:
+      xClearStruct((XStructure *) value);
+      break;
+
+    case X_RAW: {
+      char **p = (char **) value;
+      if(*p) free(*p);
+      *p = NULL;
+      break;
+    }
+
+    case X_STRING: {
+      char **s = (char **) value;
+      int i;
+      for(i = 0; i < count; i++) {
+        if(s[i]) free(s[i]);
+        s[i] = NULL;
+      }
+      break;
+    }
+
+    default:
+      ;
+  }
+}
+
+/**
+ * Retrieves a mutually consistent set of cached variables (and their metadata), such as related values
+ * that are meant to be used together (e.g. azimuth, elevation, and time). Otherwise it is the same as calling
+ * smaxGetCached() on each of the variables: those that are not yet cached are pulled from SMA-X first, and will
+ * be updated in the background after.
+ *
+ * The values returned are those that were all in the cache at the same time, that is no background update
+ * was applied to any of them while the set was being read. Each variable is locked only while it is being copied,
+ * and the whole set is read again if any of the variables was updated in the meantime. Thus, the background
+ * updates are never delayed by more than a single variable copy.
+ *
+ * Strings (X_STRING) and raw (X_RAW) values are returned in newly allocated memory, as with smaxGetCached().
+ *
+ * @param[in,out] items   Array of variables to read. The status field of each item is set to indicate
+ *                        whether the variable was retrieved successfully (X_SUCCESS), or else the error.
+ * @param n               Number of items in the array.
+ * @return                X_SUCCESS (0) if all variables were retrieved successfully, or else
+ *                        X_NULL if the items argument is NULL,
+ *                        X_SIZE_INVALID if n is not positive,
+ *                        X_INCOMPLETE if a consistent set could not be read in a reasonable number of attempts,
+ *                        or else the first error among the items.
+ *
+ * @sa smaxGetCached()
+ * @sa smaxPullBatch()
+ */
+int smaxGetCachedMany(XPullItem *items, int n) {
+  static const char *fn = "smaxGetCachedMany";
+
+  LazyMonitor **m;
+  unsigned int *seq;
+  int i, attempt, status = X_SUCCESS;
+
+  if(!items) return x_error(X_NULL, EINVAL, fn, "items is NULL");
+  if(n <= 0) return x_error(X_SIZE_INVALID, EINVAL, fn, "invalid number of items: %d", n);
+
+  m = (LazyMonitor **) calloc(n, sizeof(LazyMonitor *));
+  x_check_alloc(m);
+
+  seq = (unsigned int *) calloc(n, sizeof(unsigned int));
+  x_check_alloc(seq);
+
+  // Make sure all variables are cached, pulling those that aren't yet.
+  for(i = 0; i < n; i++) {
+    XPullItem *it = &items[i];
+    LazyMonitor *mi;
+
+    if(!it->value) {
+      it->status = x_error(X_NULL, EINVAL, fn, "items[%d].value is NULL", i);
+      continue;
+    }
+
+    mi = GetCreateMonitor(it->table, it->key, it->type, it->meta != NULL);
+    if(!mi) {
+      it->status = x_trace(fn, NULL, X_NO_SERVICE);
+      continue;
+    }
+
+    it->status = X_SUCCESS;
+    if(!mi->isCurrent) it->status = (mi->isCached && mi->data && smaxIsPipelined()) ? QueueUpdateAsync(mi) : UpdateCachedAsync(mi);
+    if(!mi->isCached) mi->isCached = TRUE;
+
+    if(it->status) Release(mi);
+    else m[i] = mi;
+  }
+
+  // Read the set, until none of the variables changed while doing so.
+  for(attempt = 1; ; attempt++) {
+    boolean isConsistent = TRUE;
+
+    for(i = 0; i < n; i++) if(m[i]) {
+      XPullItem *it = &items[i];
+
+      // So we don't mistake the caller's pointers for our own, in case we need to discard them.
+      if(it->type == X_RAW) *(char **) it->value = NULL;
+      else if(it->type == X_STRING) memset(it->value, 0, it->count * sizeof(char *));
+
+      LockBucket(m[i]->bucket);
+      seq[i] = m[i]->seq;
+      it->status = GetCachedAsync(m[i], it->type, it->count, it->value);
+      if(it->meta && m[i]->meta) *it->meta = *m[i]->meta;
+      UnlockBucket(m[i]->bucket);
+    }
+
+    // Check that none of the variables were updated while we were reading the set.
+    for(i = 0; i < n; i++) if(m[i]) if(__atomic_load_n(&m[i]->seq, __ATOMIC_ACQUIRE) != seq[i]) {
+      isConsistent = FALSE;
+      break;
+    }
+
+    if(isConsistent) break;
+
+    if(attempt >= MAX_SNAPSHOT_ATTEMPTS) {
+      status = x_error(X_INCOMPLETE, EAGAIN, fn, "could not read a consistent set in %d attempts", attempt);
+      break;
+    }
+
+    for(i = 0; i < n; i++) if(m[i]) DiscardValue(items[i].type, items[i].count, items[i].value);
+  }
+
+  for(i = 0; i < n; i++) if(m[i]) {
+    if(!items[i].status) MarkRead(m[i]);
+    Release(m[i]);
+  }
+
+  free(m);
+  free(seq);
+
   prop_error(fn, status);
+
+  for(i = 0; i < n; i++) if(items[i].status) return x_trace(fn, NULL, items[i].status);
+
   return X_SUCCESS;
 }
 
+/**
+ * Releases a view of cached values, obtained via smaxGetCachedView(). The pointer may not be used
+ * after.
+ *
+ * @param view    Pointer to the viewed values, as returned by smaxGetCachedView(), or NULL.
+ *
+ * @sa smaxGetCachedView()
+ */
+void smaxReleaseCachedView(const void *view) {
+  if(!view) return;
+  ReleaseDecoded((LazyDecoded *) ((char *) view - offsetof(LazyDecoded, data)));
+}
+
 /**
  * Poll an infrequently changing variable without stressing out the network
  * or the SMA-X database. The first lazy pull for a variable will fetch its value from SMA-X and
  * subscribe to update notifications. Subsequent smaxLazyPull() calls to the same variable will
  * retrieve its value from a local cache (without contacting SMA-X) as long as it is unchanged.
+ * Such calls, for fixed size types (i.e. not strings, raw data, or structures), never block on
+ * other threads.
  *
  * Note, after you are done using a variable that has been lazy pulled, you should call smaxLazyEnd() to
  * signal that it no longer requires to be cached and updated in the background, or call
@@ -480,6 +1453,8 @@ int smaxLazyPull(const char *table, const char *key, XType type, int count, void
 
   if(!value) return x_error(X_NULL, EINVAL, fn, "value is NULL");
 
+  if(TryReadCurrent(table, key, type, count, value, meta, FALSE)) return X_SUCCESS;
+
   m = GetCreateMonitor(table, key, type, meta != NULL);
   if(!m) return x_trace(fn, NULL, X_NO_SERVICE);
 
@@ -741,7 +1716,8 @@ int smaxGetCachedStruct(const char *id, XStructure *s) {
 }
 
 /**
- * Stops processing updates in the background for a specific variable.
+ * Stops processing updates in the background for a specific variable. The monitor's bucket should be
+ * locked when calling this routine.
  *
  * \param m     Pointer to the variable'structure monitor point structure.
  *
@@ -749,19 +1725,27 @@ int smaxGetCachedStruct(const char *id, XStructure *s) {
 static void RemoveMonitorAsync(LazyMonitor *m) {
   if(!m->isLinked) return;
 
-  smaxUnsubscribe(m->table, m->key);
-  if(!m->key) smaxUnsubscribe(m->table, "*");
-
-  // Unlink the existing monitor point.
-  if(m->prev != NULL) m->prev->next = m->next;
-  else monitorTable[GetTableIndex(m)] = m->next;
+  if(m->isSubscribed) {
+    smaxUnsubscribe(m->table, m->key);
+    if(!m->key) smaxUnsubscribe(m->table, "*");
+  }
 
-  if(m->next != NULL) m->next->prev = m->prev;
+  // Remove the existing monitor point from the index. (Lock-free readers may still find it, until
+  // it is destroyed.)
+  pthread_mutex_lock(&indexLock);
+  smaxHashRemove(monitors, m->hash, m);
+  if(m->isTracked) RemoveTrackedAsync(m);
+  pthread_mutex_unlock(&indexLock);
 
+  __atomic_sub_fetch(&cacheBytes, m->bytes, __ATOMIC_RELAXED);
   m->isLinked = FALSE;
 
+  if(m->key) smaxMirrorUpdate(m->table, m->key, NULL, NULL);
+
   // Stop the subscriber if this was the last monitored point.
-  if(--nMonitors == 0) smaxRemoveSubscribers(ProcessLazyUpdates);
+  pthread_mutex_lock(&subscriberLock);
+  if(--nMonitors == 0 && !patterns) smaxRemoveRoutes(ProcessLazyUpdates);
+  pthread_mutex_unlock(&subscriberLock);
 }
 
 /**
@@ -776,46 +1760,45 @@ static void RemoveMonitorAsync(LazyMonitor *m) {
  */
 int smaxLazyEnd(const char *table, const char *key) {
   LazyMonitor *m;
+  int bucket;
 
-  pthread_mutex_lock(&monitorLock);
+  m = GetMonitor(table, key);
+  if(!m) return X_SUCCESS;
 
-  m = GetMonitorAsync(table, key);
-  if(m) {
-    RemoveMonitorAsync(m);
-    ReleaseAsync(m);
-  }
+  bucket = m->bucket;
 
-  pthread_mutex_unlock(&monitorLock);
+  LockBucket(bucket);
+  RemoveMonitorAsync(m);
+  ReleaseAsync(m);
+  UnlockBucket(bucket);
 
   return X_SUCCESS;
 }
 
 /**
- * Stops all background processing of lazy updates in a given monitor table (linked list of
- * monitor points.
+ * Stops background processing of lazy updates for a monitor point that was removed from the index
+ * already. The monitor's bucket should be locked when calling this routine.
  *
  * \param m     Pointer to the variable's monitor point structure.
  *
- * \return      Number of monitor points flushed.
+ * \return      1 if the monitor point was flushed, or 0 if it was discarded already.
  *
  */
-static int FlushTableAsync(LazyMonitor *m) {
-  int n;
+static int FlushMonitorAsync(LazyMonitor *m) {
+  if(!m->isLinked) return 0;
 
-  for(n=0; m != NULL; n++) {
-    LazyMonitor *next = m->next;
-    m->isLinked = FALSE;               // Important so we can destroy it...
-    smaxUnsubscribe(m->table, m->key);
-    DestroyMonitorAsync(m);
-    m = next;
-  }
+  __atomic_sub_fetch(&cacheBytes, m->bytes, __ATOMIC_RELAXED);
+  m->isLinked = FALSE;               // Important so we can destroy it...
+  if(m->isSubscribed) smaxUnsubscribe(m->table, m->key);
+  if(m->key) smaxMirrorUpdate(m->table, m->key, NULL, NULL);
+  DestroyMonitorAsync(m);
 
-  return n;
+  return 1;
 }
 
 /**
  * Discards caches for all lazy variables (i.e. stops all subscriptions to variable updates, at least until
- * the next smaxLazyPull() call). Generally speaking, it's a good idea to call this routine when one is done
+ * the next smaxLazyPull() call), including the patterns cached via smaxCachePattern(). Generally speaking, it's a good idea to call this routine when one is done
  * using a set of lazy variables for the time being, but want to avoid the tedium of calling smaxLazyEnd()
  * individually for each of them. Note however, that after flushing the lazy caches, the fist lazy call
  * following for each variable will inevitably result in a real SMA-X pull. So use it carefully!
@@ -826,21 +1809,48 @@ static int FlushTableAsync(LazyMonitor *m) {
  * @sa smaxLazyEnd()
  */
 int smaxLazyFlush() {
-  int i, n = 0;
+  LazyPattern *p;
+  void **list;
+  int i, k, n = 0;
+
+  pthread_once(&monitorsOnce, InitMonitors);
+
+  // Stop caching new variables under patterns
+  pthread_mutex_lock(&subscriberLock);
+  p = patterns;
+  __atomic_store_n(&patterns, NULL, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&subscriberLock);
 
-  pthread_mutex_lock(&monitorLock);
+  DestroyPatterns(p);
 
-  for(i=SMAX_LOOKUP_SIZE; --i >= 0; ) {
-    LazyMonitor *list;
-    list = monitorTable[i];
-    monitorTable[i] = NULL;
-    n += FlushTableAsync(list);
+  pthread_mutex_lock(&indexLock);
+  list = smaxHashItems(monitors, &k);
+  smaxHashClear(monitors);
+  DiscardTablesAsync();
+  pthread_mutex_unlock(&indexLock);
+
+  // The monitors may be discarded by others, until we lock their bucket, so keep them from being
+  // deallocated in the meantime...
+  smaxEpochEnter();
+
+  for(i = 0; i < k; i++) {
+    LazyMonitor *m = (LazyMonitor *) list[i];
+    const int bucket = m->bucket;
+
+    LockBucket(bucket);
+    n += FlushMonitorAsync(m);
+    UnlockBucket(bucket);
   }
 
-  nMonitors = 0;
-  smaxRemoveSubscribers(ProcessLazyUpdates);
+  smaxEpochExit();
+
+  if(list) free(list);
 
-  pthread_mutex_unlock(&monitorLock);
+  pthread_mutex_lock(&subscriberLock);
+  nMonitors -= n;
+  if(nMonitors < 0) nMonitors = 0;
+  if(!nMonitors && !patterns) smaxRemoveRoutes(ProcessLazyUpdates);
+  pthread_mutex_unlock(&subscriberLock);
 
   return n;
 }
@@ -864,115 +1874,554 @@ int smaxGetLazyUpdateCount(const char *table, const char *key) {
   if(!table) return -1;
   if(!key) return -1;
 
-  pthread_mutex_lock(&monitorLock);
+  m = GetMonitor(table, key);
+  if(!m) return -1;
 
-  m = GetMonitorAsync(table, key);
   n = m->updateCount;
-  ReleaseAsync(m);
-
-  pthread_mutex_unlock(&monitorLock);
+  Release(m);
 
   return n;
 }
 
 /**
- * Creates a new monitor point for the specified variable, and add it to the monitor table. It should be called
- * with exclusive access to the monitor table. You must also call Release() after done using the newly created
- * monitor.
- *
- * \param table     The hash table name.
- * \param key       The variable name under which the data is stored.
- * \param type      The expected data type
- * \param withMeta  If lazy pull with metadata.
+ * Limits the size of the lazy cache, in terms of the number of variables monitored, and / or the memory
+ * they use. When over the limit, the least recently read variables are evicted (approximately), that is
+ * they are no longer monitored, until they are accessed again. By default, the cache is unlimited.
  *
- * \return          Pointer to the variable's newly allocated monitor point structure or NULL if could not
- *                  subscribe to updates for this variable.
+ * \param n         Maximum number of variables to monitor, or 0 for no limit.
+ * \param bytes     [bytes] Approximate memory budget for the monitored variables (data, metadata, and
+ *                  bookkeeping), or 0 for no limit.
+ * \return          X_SUCCESS (0) if successful, or else X_SIZE_INVALID if either limit is negative.
  *
- * \sa Release()
+ * @sa smaxGetLazyCacheStats()
+ * @sa smaxLazyFlush()
  */
-static LazyMonitor *CreateMonitorAsync(const char *table, const char *key, XType type, boolean withMeta) {
-  static const char *fn = "CreateMonitorAsync";
+int smaxSetLazyCacheLimits(int n, long bytes) {
+  static const char *fn = "smaxSetLazyCacheLimits";
 
-  LazyMonitor *m;
-  char *id;
-  int i;
+  if(n < 0) return x_error(X_SIZE_INVALID, EINVAL, fn, "invalid entry limit: %d", n);
+  if(bytes < 0) return x_error(X_SIZE_INVALID, EINVAL, fn, "invalid memory limit: %ld", bytes);
 
-  // To create copies of variable length types, we'll need their actual sizes, and
-  // so we need metadata for these no matter what...
-  if(type == X_STRING || type == X_RAW) withMeta = TRUE;
+  __atomic_store_n(&maxEntries, n, __ATOMIC_RELAXED);
+  __atomic_store_n(&maxBytes, bytes, __ATOMIC_RELAXED);
 
-  if(smaxSubscribe(table, key) != X_SUCCESS) return x_trace_null(fn, NULL);
+  // Shrink to the new limits right away.
+  EnforceLimits();
 
-  // For structs subscribe to leaf updates also
-  if(!key) if(smaxSubscribe(table, "*") != X_SUCCESS) return x_trace_null(fn, NULL);
+  return X_SUCCESS;
+}
 
-  m = (LazyMonitor *) calloc(1, sizeof(LazyMonitor));
-  x_check_alloc(m);
+/**
+ * Returns the current occupancy of the lazy cache, its limits, and the number of variables that were
+ * dropped from it since the start (or since the last reset of the statistics).
+ *
+ * \param[out] stats   Pointer to the structure to populate.
+ * \return             X_SUCCESS (0) if successful, or else X_NULL if the argument is NULL.
+ *
+ * @sa smaxResetLazyCacheStats()
+ * @sa smaxSetLazyCacheLimits()
+ */
+int smaxGetLazyCacheStats(XLazyCacheStats *stats) {
+  if(!stats) return x_error(X_NULL, EINVAL, "smaxGetLazyCacheStats", "output stats is NULL");
 
-  m->users = 1;
-  m->table = xStringCopyOf(table);
-  m->key = xStringCopyOf(key);
+  stats->entries = smaxHashCount(__atomic_load_n(&monitors, __ATOMIC_ACQUIRE));
+  stats->bytes = __atomic_load_n(&cacheBytes, __ATOMIC_RELAXED);
+  stats->maxEntries = __atomic_load_n(&maxEntries, __ATOMIC_RELAXED);
+  stats->maxBytes = __atomic_load_n(&maxBytes, __ATOMIC_RELAXED);
+  stats->evicted = __atomic_load_n(&nEvicted, __ATOMIC_RELAXED);
+  stats->collected = __atomic_load_n(&nCollected, __ATOMIC_RELAXED);
 
-  if(withMeta) {
-    m->meta = calloc(1, sizeof(XMeta));
-    x_check_alloc(m->meta);
-    m->meta->storeType = type;
-  }
+  return X_SUCCESS;
+}
 
-  id = xGetAggregateID(table, key);
-  m->channel = calloc(1, sizeof(SMAX_UPDATES) + strlen(id));
-  if(!m->channel) {
-    free(m);
-    x_error(0, errno, fn, "calloc() error (%d bytes)", sizeof(SMAX_UPDATES) + strlen(id));
-    free(id);
-    return NULL;
-  }
+/**
+ * Resets the counters of evicted and collected variables of the lazy cache.
+ *
+ * @sa smaxGetLazyCacheStats()
+ */
+void smaxResetLazyCacheStats() {
+  __atomic_store_n(&nEvicted, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&nCollected, 0, __ATOMIC_RELAXED);
+}
 
-  sprintf(m->channel, SMAX_UPDATES "%s", id);
-  free(id);
+/**
+ * Destroys a list of variable patterns, unsubscribing from their update notifications.
+ *
+ * \param p     The first pattern in the list, or NULL.
+ */
+static void DestroyPatterns(LazyPattern *p) {
+  while(p) {
+    LazyPattern *next = p->next;
 
-  i = GetTableIndex(m);
+    smaxUnsubscribe(p->table, p->key);
 
-  m->prev = NULL;
-  m->next = monitorTable[i];
-  if(m->next) m->next->prev = m;
-  monitorTable[i] = m;
-  m->isLinked = TRUE;
+    if(p->table) free(p->table);
+    if(p->key) free(p->key);
+    if(p->channel) free(p->channel);
+    free(p);
 
-  // If this is our first lazy variable let's get the infrastructure in place (or refresh it)...
-  if(nMonitors <= 0) {
-    smaxAddSubscriber(NULL, ProcessLazyUpdates);    // Add/refresh the Redis subscriber to process lazy updates...
-    nMonitors = 0;
+    p = next;
   }
+}
 
-  nMonitors++;
+/**
+ * Checks if a variable belongs to one of the cached patterns. The subscriberLock should be held.
+ *
+ * \param channel   The variable's update notification channel.
+ * \return          TRUE (1) if the variable matches a cached pattern, or else FALSE (0).
+ */
+static boolean IsPatternedAsync(const char *channel) {
+  const LazyPattern *p;
 
-  return m;
+  for(p = patterns; p != NULL; p = p->next) if(fnmatch(p->channel, channel, 0) == 0) return TRUE;
+  return FALSE;
 }
 
 /**
- * Attempts to destroy (deallocate) a monitor point structure. It should be called only if the monitor point
- * is not in the monitor list, and assumed that the monitor'structure mutex is unlocked. If the monitor still has
- * active users, the call will return with FALSE, and let Release() handle the destruction when the monitor
- * point is no longer in use.
- *
- * \param m     Pointer to the variable's monitor point structure.
- *
- * \return      TRUE (non-zero) if the given monitor is destroyed, otherwise FALSE (0).
+ * Adds a variable pattern to the cached patterns, subscribing to update notifications for the variables
+ * that match it, unless the pattern was added already.
  *
+ * \param table     Table name pattern
+ * \param key       Key name pattern
+ * \return          X_SUCCESS (0) if successful, or else an error (&lt;0) from smaxSubscribe().
  */
-static boolean DestroyMonitorAsync(LazyMonitor *m) {
-  if(m == NULL) return TRUE;
+static int AddPattern(const char *table, const char *key) {
+  static const char *fn = "AddPattern";
 
-  if(m->isLinked) {
-    fprintf(stderr, "WARNING! smax-lazy: Blocked attempt to destroy linked monitor point.\n");
-    return FALSE;
+  LazyPattern *p;
+  int status = X_SUCCESS;
+
+  pthread_mutex_lock(&subscriberLock);
+
+  for(p = patterns; p != NULL; p = p->next) if(strcmp(p->table, table) == 0 && strcmp(p->key, key) == 0) break;
+
+  if(!p) {
+    status = smaxSubscribe(table, key);
+
+    if(!status) {
+      p = (LazyPattern *) calloc(1, sizeof(LazyPattern));
+      x_check_alloc(p);
+
+      p->table = xStringCopyOf(table);
+      p->key = xStringCopyOf(key);
+      p->channel = smaxGetUpdateChannelPattern(table, key);
+
+      if(nMonitors <= 0 && !patterns) smaxAddSubscriber(NULL, ProcessLazyUpdates);
+
+      p->next = patterns;
+      __atomic_store_n(&patterns, p, __ATOMIC_RELEASE);
+    }
   }
 
-  if(m->users > 0) return FALSE;                        // We'll destroy it when last user releases it.
+  pthread_mutex_unlock(&subscriberLock);
+
+  prop_error(fn, status);
+  return X_SUCCESS;
+}
+
+/**
+ * Splits a variable pattern into a table pattern and a key pattern, at the last separator.
+ *
+ * \param pattern     The variable pattern, e.g. "antenna*:rx:*".
+ * \param[out] key    Pointer to where the key pattern is returned, inside the returned string.
+ * \return            A newly allocated copy of the table pattern, or NULL if the pattern could not be split.
+ */
+static char *SplitPattern(const char *pattern, char **key) {
+  char *table = xStringCopyOf(pattern);
+
+  if(xSplitID(table, key) != X_SUCCESS || !table[0] || !**key) {
+    free(table);
+    return NULL;
+  }
+
+  return table;
+}
+
+/**
+ * Returns the names of the tables in the database that match a glob pattern, via SCAN. Metadata tables
+ * (whose names start with '&lt;') are excluded.
+ *
+ * \param r         The Redis instance.
+ * \param pattern   Glob pattern of table names.
+ * \param[out] n    Pointer to where the number of table names (&gt;=0) or an error (&lt;0) is returned.
+ * \return          A newly allocated array of newly allocated table names, or NULL if there are none.
+ */
+static char **ScanTables(Redis *r, const char *pattern, int *n) {
+  static const char *fn = "ScanTables";
+
+  char **names = NULL, cursor[32] = "0";
+
+  *n = 0;
+
+  do {
+    const char *args[] = { "SCAN", cursor, "MATCH", pattern, "COUNT", LAZY_SCAN_COUNT };
+    RESP *reply, **component = NULL, **keys;
+    int i, status;
+
+    reply = redisxArrayRequest(r, args, NULL, 6, &status);
+    if(!status) status = redisxCheckRESP(reply, RESP_ARRAY, 2);
+    if(!status) {
+      component = (RESP **) reply->value;
+      status = redisxCheckRESP(component[0], RESP_BULK_STRING, 0);
+      if(!status) status = redisxCheckRESP(component[1], RESP_ARRAY, 0);
+    }
+
+    if(status) {
+      redisxDestroyRESP(reply);
+      for(i = *n; --i >= 0; ) free(names[i]);
+      if(names) free(names);
+      *n = x_trace(fn, NULL, status);
+      return NULL;
+    }
+
+    snprintf(cursor, sizeof(cursor), "%s", (char *) component[0]->value);
+
+    keys = (RESP **) component[1]->value;
+
+    if(component[1]->n > 0) {
+      char **list = (char **) realloc(names, (*n + component[1]->n) * sizeof(char *));
+      x_check_alloc(list);
+      names = list;
+    }
+
+    for(i = 0; i < component[1]->n; i++) {
+      const char *name = (const char *) keys[i]->value;
+      if(keys[i]->type == RESP_BULK_STRING && name && name[0] != '<') names[(*n)++] = xStringCopyOf(name);
+    }
+
+    redisxDestroyRESP(reply);
+  } while(strcmp(cursor, "0") != 0);
+
+  return names;
+}
+
+/**
+ * Adds a variable to the cache, as part of a cached pattern (i.e. without subscribing to its updates
+ * individually), and initiates pulling its current value, unless it is cached already.
+ *
+ * \param table     The hash table name.
+ * \param key       The variable name under which the data is stored.
+ * \return          X_SUCCESS (0) if successful, or else an error (&lt;0).
+ */
+static int CachePatterned(const char *table, const char *key) {
+  static const char *fn = "CachePatterned";
+
+  LazyMonitor *m;
+  const unsigned long long hash = GetHash(table, key);
+  boolean isNew = FALSE;
+  int status = X_SUCCESS;
+
+  LockBucket(GetBucket(hash));
+
+  m = GetExistingMonitorAsync(table, key, hash);
+  if(!m) {
+    m = CreateMonitorAsync(table, key, X_RAW, TRUE, hash, FALSE);
+    isNew = (m != NULL);
+    if(isNew) m->isPatterned = TRUE;
+  }
+  if(m) m->isCached = TRUE;
+
+  UnlockBucket(GetBucket(hash));
+
+  if(!m) return x_trace(fn, NULL, X_NULL);
+
+  if(!m->isCurrent) status = smaxIsPipelined() ? QueueUpdateAsync(m) : UpdateCachedAsync(m);
+  Release(m);
+
+  if(isNew) EnforceLimits();
+
+  prop_error(fn, status);
+  return X_SUCCESS;
+}
+
+/**
+ * Adds a newly seen variable to the cache, if it matches one of the cached patterns, and if the
+ * cache has room for it.
+ *
+ * \param channel   The variable's update notification channel.
+ */
+static void AddPatterned(const char *channel) {
+  char *table, *key;
+  boolean isMatch;
+
+  pthread_mutex_lock(&subscriberLock);
+  isMatch = IsPatternedAsync(channel);
+  pthread_mutex_unlock(&subscriberLock);
+
+  if(!isMatch || IsOverBudget()) return;
+
+  table = xStringCopyOf(channel + SMAX_UPDATES_LENGTH);
+  if(xSplitID(table, &key) == X_SUCCESS) {
+    xvprintf("SMA-X: Caching new patterned variable %s:%s.\n", table, key);
+    CachePatterned(table, key);
+  }
+  free(table);
+}
+
+/**
+ * Caches all variables that match a glob pattern, such as all variables of a subtree, and keeps caching
+ * new variables that match the pattern as they appear (when they are first updated). Rather than subscribing to
+ * each variable individually, as smaxCache() does, a single pattern subscription covers all of them, and
+ * the initial values are pulled in bulk (pipelined, if pipelining is enabled). Once cached, the variables
+ * are accessed via smaxGetCached() (or smaxLazyPull()) as usual.
+ *
+ * The part of the pattern after the last separator is matched against the variable (field) names,
+ * while the part before it is matched against the table (structure) names, with the usual Redis glob
+ * syntax. E.g. "antenna*:rx:*" caches all variables in the 'rx' structures of all antennas.
+ *
+ * Variables cached via patterns are not dropped for lack of reads, but they are subject to the cache
+ * limits (see smaxSetLazyCacheLimits()).
+ *
+ * \param pattern   Glob pattern of aggregate variable IDs, containing at least one separator.
+ * \return          The number of matching variables currently in the database, which were cached (&gt;=0),
+ *                  or else an error code (&lt;0), e.g. X_NAME_INVALID if the pattern cannot be split
+ *                  into table and key patterns, or X_NO_INIT if not connected to SMA-X.
+ *
+ * @sa smaxLazyEndPattern()
+ * @sa smaxCache()
+ * @sa smaxGetCached()
+ */
+int smaxCachePattern(const char *pattern) {
+  static const char *fn = "smaxCachePattern";
+
+  Redis *r = smaxGetRedis();
+  char *table, *key, **tables;
+  int i, nt, n = 0, status;
+
+  if(!pattern) return x_error(X_NULL, EINVAL, fn, "pattern is NULL");
+  if(!r) return smaxError(fn, X_NO_INIT);
+
+  table = SplitPattern(pattern, &key);
+  if(!table) return x_error(X_NAME_INVALID, EINVAL, fn, "invalid variable pattern: %s", pattern);
+
+  // Subscribe first, so we do not miss updates to variables while we pull them...
+  status = AddPattern(table, key);
+  if(status) {
+    free(table);
+    return x_trace(fn, NULL, status);
+  }
+
+  tables = ScanTables(r, table, &nt);
+
+  for(i = 0; i < nt; i++) {
+    char **keys;
+    int k, nk;
+
+    keys = redisxGetKeys(r, tables[i], &nk);
+
+    for(k = 0; k < nk; k++) {
+      if(fnmatch(key, keys[k], 0) == 0) if(CachePatterned(tables[i], keys[k]) == X_SUCCESS) n++;
+      free(keys[k]);
+    }
+
+    if(keys) free(keys);
+    free(tables[i]);
+  }
+
+  if(tables) free(tables);
+  free(table);
+
+  if(nt < 0) return x_trace(fn, NULL, nt);
+
+  // Wait for the initial values to arrive.
+  if(n > 0) if(smaxIsPipelined()) prop_error(fn, smaxWaitQueueComplete(0));
+
+  return n;
+}
+
+/**
+ * Stops caching a pattern of variables that was cached via smaxCachePattern(), and discards the
+ * variables that were cached through it (unless they also match another cached pattern, or were
+ * lazy pulled or cached individually before).
+ *
+ * \param pattern   The same glob pattern that was used with smaxCachePattern().
+ * \return          X_SUCCESS (0) if successful (even if the pattern was not cached), or else
+ *                  X_NAME_INVALID if the pattern is NULL or invalid.
+ *
+ * @sa smaxCachePattern()
+ * @sa smaxLazyFlush()
+ */
+int smaxLazyEndPattern(const char *pattern) {
+  static const char *fn = "smaxLazyEndPattern";
+
+  LazyPattern *p, *prev = NULL;
+  char *table, *key, *channel;
+  void **list;
+  int i, n;
+
+  if(!pattern) return x_error(X_NAME_INVALID, EINVAL, fn, "pattern is NULL");
+
+  table = SplitPattern(pattern, &key);
+  if(!table) return x_error(X_NAME_INVALID, EINVAL, fn, "invalid variable pattern: %s", pattern);
+
+  pthread_mutex_lock(&subscriberLock);
+
+  for(p = patterns; p != NULL; prev = p, p = p->next) if(strcmp(p->table, table) == 0 && strcmp(p->key, key) == 0) {
+    if(prev) prev->next = p->next;
+    else __atomic_store_n(&patterns, p->next, __ATOMIC_RELEASE);
+    p->next = NULL;
+    break;
+  }
+
+  if(p) if(!nMonitors && !patterns) smaxRemoveRoutes(ProcessLazyUpdates);
+
+  pthread_mutex_unlock(&subscriberLock);
+
+  free(table);
+
+  if(!p) return X_SUCCESS;
+
+  channel = xStringCopyOf(p->channel);
+  DestroyPatterns(p);
+
+  // Discard the variables that were cached via the pattern.
+  pthread_once(&monitorsOnce, InitMonitors);
+
+  pthread_mutex_lock(&indexLock);
+  list = smaxHashItems(monitors, &n);
+  pthread_mutex_unlock(&indexLock);
+
+  smaxEpochEnter();
+
+  for(i = 0; i < n; i++) {
+    LazyMonitor *m = (LazyMonitor *) list[i];
+    const int bucket = m->bucket;
+
+    if(!m->isPatterned) continue;
+    if(fnmatch(channel, m->channel, 0) != 0) continue;
+
+    LockBucket(bucket);
+
+    if(m->isLinked) {
+      boolean isMatch;
+
+      pthread_mutex_lock(&subscriberLock);
+      isMatch = IsPatternedAsync(m->channel);
+      pthread_mutex_unlock(&subscriberLock);
+
+      if(!isMatch) {
+        RemoveMonitorAsync(m);
+        DestroyMonitorAsync(m);
+      }
+    }
+
+    UnlockBucket(bucket);
+  }
+
+  smaxEpochExit();
+
+  if(list) free(list);
+  free(channel);
+
+  return X_SUCCESS;
+}
+
+/**
+ * Creates a new monitor point for the specified variable, and add it to the monitor index. It should be called
+ * with the variable's bucket locked. You must also call Release() after done using the newly
+ * created monitor.
+ *
+ * \param table     The hash table name.
+ * \param key       The variable name under which the data is stored.
+ * \param type      The expected data type
+ * \param withMeta  If lazy pull with metadata.
+ * \param hash      The hash of the table / key.
+ *
+ * \return          Pointer to the variable's newly allocated monitor point structure or NULL if could not
+ *                  subscribe to updates for this variable.
+ *
+ * \sa Release()
+ */
+static LazyMonitor *CreateMonitorAsync(const char *table, const char *key, XType type, boolean withMeta, unsigned long long hash, boolean subscribe) {
+  static const char *fn = "CreateMonitorAsync";
+
+  LazyMonitor *m;
+  char *id;
+  boolean isTracked = FALSE;
+
+  // To create copies of variable length types, we'll need their actual sizes, and
+  // so we need metadata for these no matter what...
+  if(type == X_STRING || type == X_RAW) withMeta = TRUE;
+
+  // Variables in tracked tables are invalidated by the server, so they need no subscriptions.
+  if(subscribe) if(smaxIsTracked(table)) {
+    subscribe = FALSE;
+    isTracked = TRUE;
+  }
+
+  if(subscribe) {
+    if(smaxSubscribe(table, key) != X_SUCCESS) return x_trace_null(fn, NULL);
+
+    // For structs subscribe to leaf updates also
+    if(!key) if(smaxSubscribe(table, "*") != X_SUCCESS) return x_trace_null(fn, NULL);
+  }
+
+  m = (LazyMonitor *) calloc(1, sizeof(LazyMonitor));
+  x_check_alloc(m);
+
+  m->users = 1;
+  m->isSubscribed = subscribe;
+  m->isTracked = isTracked;
+  m->hash = hash;
+  m->bucket = GetBucket(hash);
+  m->table = xStringCopyOf(table);
+  m->key = xStringCopyOf(key);
+
+  if(withMeta) {
+    m->meta = calloc(1, sizeof(XMeta));
+    x_check_alloc(m->meta);
+    m->meta->storeType = type;
+  }
+
+  id = xGetAggregateID(table, key);
+  m->channel = calloc(1, sizeof(SMAX_UPDATES) + strlen(id));
+  if(!m->channel) {
+    free(m);
+    x_error(0, errno, fn, "calloc() error (%d bytes)", sizeof(SMAX_UPDATES) + strlen(id));
+    free(id);
+    return NULL;
+  }
+
+  sprintf(m->channel, SMAX_UPDATES "%s", id);
+  free(id);
+
+  m->lastReadTime = GetTime();
+  m->isReferenced = TRUE;
+
+  // Publish the fully initialized monitor to lock-free readers.
+  m->isLinked = TRUE;
+  ResizeAsync(m, sizeof(LazyMonitor) + strlen(m->table) + strlen(m->channel) + 2 + (m->key ? strlen(m->key) + 1 : 0) + (m->meta ? sizeof(XMeta) : 0));
+
+  pthread_mutex_lock(&indexLock);
+  smaxHashAdd(monitors, hash, m);
+  if(isTracked) AddTrackedAsync(m);
+  pthread_mutex_unlock(&indexLock);
+
+  // If this is our first lazy variable let's get the infrastructure in place (or refresh it)...
+  pthread_mutex_lock(&subscriberLock);
+
+  if(nMonitors <= 0 && !patterns) {
+    smaxAddSubscriber(NULL, ProcessLazyUpdates);    // Add/refresh the Redis subscriber to process lazy updates...
+    nMonitors = 0;
+  }
+
+  nMonitors++;
+
+  pthread_mutex_unlock(&subscriberLock);
+
+  return m;
+}
+
+/**
+ * Deallocates a monitor point structure, once no lock-free reader can be accessing it any longer.
+ *
+ * \param p     Pointer to the variable's monitor point structure.
+ *
+ * \sa DestroyMonitorAsync()
+ */
+static void FreeMonitor(void *p) {
+  LazyMonitor *m = (LazyMonitor *) p;
 
-  // Monitor is idle, go on destroy it...
-  // Free up allocations...
   if(m->channel != NULL) free(m->channel);
   if(m->data != NULL) {
     if(!m->key) xDestroyStruct((XStructure *) m->data);
@@ -981,24 +2430,51 @@ static boolean DestroyMonitorAsync(LazyMonitor *m) {
   if(m->table != NULL) free(m->table);
   if(m->key != NULL) free(m->key);
   if(m->meta != NULL) free(m->meta);
+  ReleaseDecodedList(m->decoded);
 
   free(m);
+}
+
+/**
+ * Attempts to destroy (deallocate) a monitor point structure. It should be called only if the monitor point
+ * is not in the monitor list. If the monitor still has active users, the call will return with FALSE, and let
+ * Release() handle the destruction when the monitor point is no longer in use. Otherwise, the monitor will be
+ * deallocated once all lock-free readers, which may still be accessing it, are done with it.
+ *
+ * \param m     Pointer to the variable's monitor point structure.
+ *
+ * \return      TRUE (non-zero) if the given monitor is destroyed, otherwise FALSE (0).
+ *
+ */
+static boolean DestroyMonitorAsync(LazyMonitor *m) {
+  if(m == NULL) return TRUE;
+
+  if(m->isLinked) {
+    fprintf(stderr, "WARNING! smax-lazy: Blocked attempt to destroy linked monitor point.\n");
+    return FALSE;
+  }
+
+  if(m->users > 0) return FALSE;                        // We'll destroy it when last user releases it.
+
+  // Monitor is idle, go on destroy it (when safe)...
+  smaxEpochRetire(m, FreeMonitor);
 
   return TRUE;
 }
 
 /**
- * Returns the hash lookup index for a given update channel. It is the same index as what xGetHashLookupIndex()
- * would return for the variable that has been updated in the given notification channel
+ * Returns the hash for a given update channel, or aggregate ID. It is the same hash as what GetHash() would
+ * return for the variable that has been updated in the given notification channel
  *
- * \param channel       The redis notification channel (string) for the update.
+ * \param channel       The redis notification channel (string) for the update, or the aggregate ID of a
+ *                      variable.
  *
- * \return              An integer (0-255) just like for xGetHashLookupIndex().
+ * \return              The 64-bit hash of the variable, as by smaxHashID().
  *
- * \sa xGetHashLookupIndex()
+ * \sa GetHash()
  *
  */
-static int GetChannelLookupIndex(const char *channel) {
+static unsigned long long GetChannelHash(const char *channel) {
   int lGroup;
   char *key;
 
@@ -1006,50 +2482,88 @@ static int GetChannelLookupIndex(const char *channel) {
   if(!strncmp(channel, SMAX_UPDATES, SMAX_UPDATES_LENGTH)) channel += SMAX_UPDATES_LENGTH;
 
   key = xLastSeparator(channel);
-  if(!key) return 0;
+  if(!key) return smaxHashID(channel, 0, NULL, 0);
 
   lGroup = key - channel;
   key += X_SEP_LENGTH;
 
-  return smaxGetHashLookupIndex(channel, lGroup, key, 0);
+  return smaxHashID(channel, lGroup, key, 0);
 }
 
-static __inline__ int GetLookupIndex(const char *table, const char *key) {
-  return key ? smaxGetHashLookupIndex(table, 0, key, 0) : GetChannelLookupIndex(table);
+static __inline__ unsigned long long GetHash(const char *table, const char *key) {
+  return key ? smaxHashID(table, 0, key, 0) : GetChannelHash(table);
 }
 
-static __inline__ int GetTableIndex(const LazyMonitor *m) {
-  return GetLookupIndex(m->table, m->key);
+/**
+ * Checks if a monitor point is for the variable of the given name.
+ *
+ * \param item      Pointer to a monitor point
+ * \param arg       Pointer to a LazyName
+ *
+ * \return          TRUE (1) if the monitor point is for the named variable, or else FALSE (0).
+ */
+static boolean MatchesName(const void *item, const void *arg) {
+  const LazyMonitor *m = (const LazyMonitor *) item;
+  const LazyName *name = (const LazyName *) arg;
+
+  if(strcmp(m->table, name->table)) return FALSE;
+  if(m->key == NULL) return name->key == NULL;
+  return name->key && !strcmp(m->key, name->key);
 }
 
 /**
- * Returns the monitor point for a given variable, or NULL if the variable is not currently monitored.
- * You must call Release() on the monitor point returned after you are done using it.
+ * Checks if a monitor point is for the given notification channel.
+ *
+ * \param item      Pointer to a monitor point
+ * \param arg       The notification channel
+ *
+ * \return          TRUE (1) if the monitor point receives updates on the channel, or else FALSE (0).
+ */
+static boolean MatchesChannel(const void *item, const void *arg) {
+  return !strcmp(((const LazyMonitor *) item)->channel, (const char *) arg);
+}
+
+/**
+ * Finds the monitor point for a given variable in the index, without altering anything. It may
+ * be called either with the variable's bucket locked, or else from within an epoch read section.
  *
  * \param table     The hash table name.
  * \param key       The variable name under which the data is stored.
+ * \param hash      The hash of the table / key.
  *
  * \return          Pointer to the variable'structure monitor point structure, or NULL if it is not (yet)
  *                  being monitored.
- *
- * \sa Release()
  */
-static LazyMonitor *GetExistingMonitorAsync(const char *table, const char *key) {
+static LazyMonitor *FindMonitor(const char *table, const char *key, unsigned long long hash) {
+  LazyName name = { table, key };
   LazyMonitor *m;
 
-  m = monitorTable[GetLookupIndex(table, key)];
+  // The index may be modified for other buckets concurrently.
+  smaxEpochEnter();
+  m = (LazyMonitor *) smaxHashFind(__atomic_load_n(&monitors, __ATOMIC_ACQUIRE), hash, MatchesName, &name);
+  smaxEpochExit();
 
-  for(; m != NULL; m = m->next) if(!strcmp(m->table, table)) {
-    if(m->key == NULL) {
-      if(key != NULL) continue;
-    }
-    else if(strcmp(m->key, key)) continue;
-
-    m->users++;
-    return m;
-  }
+  return m;
+}
 
-  return NULL;
+/**
+ * Returns the monitor point for a given variable, or NULL if the variable is not currently monitored.
+ * It should be called with the variable's bucket locked. You must call Release() on the monitor point
+ * returned after you are done using it.
+ *
+ * \param table     The hash table name.
+ * \param key       The variable name under which the data is stored.
+ * \param hash      The hash of the table / key.
+ *
+ * \return          Pointer to the variable'structure monitor point structure, or NULL if it is not (yet)
+ *                  being monitored.
+ *
+ * \sa Release()
+ */
+static LazyMonitor *GetExistingMonitorAsync(const char *table, const char *key, unsigned long long hash) {
+  LazyMonitor *m = FindMonitor(table, key, hash);
+  if(m) m->users++;
+  return m;
 }
 
 /**
@@ -1064,15 +2578,29 @@ static LazyMonitor *GetExistingMonitorAsync(const char *table, const char *key)
  *
  * \sa Release()
  */
-static LazyMonitor *GetMonitorAsync(const char *table, const char *key) {
-  LazyMonitor *m = GetExistingMonitorAsync(table, key);
-  if(!m) {
-    // Try as struct...
-    char *id = xGetAggregateID(table, key);
-    if(!id) return NULL;
-    m = GetExistingMonitorAsync(id, NULL);
-    free(id);
-  }
+static LazyMonitor *GetMonitor(const char *table, const char *key) {
+  LazyMonitor *m;
+  char *id;
+  unsigned long long hash = GetHash(table, key);
+
+  LockBucket(GetBucket(hash));
+  m = GetExistingMonitorAsync(table, key, hash);
+  UnlockBucket(GetBucket(hash));
+
+  if(m) return m;
+
+  // Try as struct...
+  id = xGetAggregateID(table, key);
+  if(!id) return NULL;
+
+  hash = GetHash(id, NULL);
+
+  LockBucket(GetBucket(hash));
+  m = GetExistingMonitorAsync(id, NULL, hash);
+  UnlockBucket(GetBucket(hash));
+
+  free(id);
+
   return m;
 }
 
@@ -1082,6 +2610,347 @@ static LazyMonitor *GetMonitorAsync(const char *table, const char *key) {
 
 // TODO Surgical updates for structure fields.
 
+/**
+ * Stops monitoring a variable that keeps being updated without being read, and destroys its monitor point.
+ * The monitor's bucket should be locked.
+ *
+ * \param m     Pointer to the variable's monitor point structure.
+ */
+static void CollectAsync(LazyMonitor *m) {
+  xvprintf("SMA-X: Unsubscribing from unused variable %s:%s.\n", m->table, m->key ? m->key : "");
+  RemoveMonitorAsync(m);
+  DestroyMonitorAsync(m);
+  __atomic_add_fetch(&nCollected, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * Marks a monitor point as outdated, after its variable was updated in SMA-X. Variables that keep changing
+ * without being read are no longer monitored after a while, while cached variables are to be refreshed in
+ * the background. The monitor's bucket should be locked.
+ *
+ * \param m     Pointer to the variable's monitor point structure.
+ * \return      The same monitor point, if it is to be refreshed, in which case the caller should call
+ *              QueueUpdateAsync() on it, and then Release() it, after unlocking its bucket. Or else NULL.
+ */
+static LazyMonitor *InvalidateAsync(LazyMonitor *m) {
+  m->isCurrent = FALSE;
+  if(m->key) smaxMirrorInvalidate(m->table, m->key);
+
+  m->updateCount++;
+  __atomic_add_fetch(&m->unpulledCount, 1, __ATOMIC_RELAXED);   // also read without locking by MarkRead()
+
+  if(IsIdleAsync(m)) {              // garbage collect...
+    CollectAsync(m);
+    return NULL;
+  }
+
+  if(m->isCached && !m->isPending) {
+    m->users++;
+    return m;
+  }
+
+  return NULL;
+}
+
+/**
+ * Accounts for an update of a monitor point, whose new value arrived with the update notification, so
+ * it can be applied without pulling it from SMA-X. The monitor's bucket should be locked, and it should
+ * have no pending update, which might otherwise overwrite the new value with older data.
+ *
+ * \param m     Pointer to the variable's monitor point structure.
+ * \return      The same monitor point, to which the caller should apply the new value via ApplyValue(),
+ *              and then Release() it, after unlocking its bucket. Or else NULL if the variable is no
+ *              longer monitored.
+ */
+static LazyMonitor *ReceiveAsync(LazyMonitor *m) {
+  m->updateCount++;
+  __atomic_add_fetch(&m->unpulledCount, 1, __ATOMIC_RELAXED);   // also read without locking by MarkRead()
+
+  if(IsIdleAsync(m)) {              // garbage collect...
+    CollectAsync(m);
+    return NULL;
+  }
+
+  m->users++;
+  return m;
+}
+
+/**
+ * Checks if an update notification originates from this program.
+ *
+ * @param msg     The notification message, i.e. the origin of the update.
+ * @return        TRUE (1) if the update was made by this program, or else FALSE (0).
+ */
+static boolean IsOwnOrigin(const char *msg) {
+  const char *id;
+  int n;
+
+  if(!msg) return FALSE;
+
+  id = smaxGetProgramID();
+  if(!id) return FALSE;
+
+  // The origin is on the first line (if the message carries the value also).
+  n = strlen(id);
+  return strncmp(msg, id, n) == 0 && (msg[n] == '\0' || msg[n] == '\n');
+}
+
+/**
+ * Checks if the cache holds the version of the variable that an update notification of our own write is
+ * about, so the notification can be ignored. The monitor's bucket should be locked.
+ *
+ * @param m       Pointer to the variable's monitor point structure.
+ * @param p       The parsed contents of the update notification (its buffer is NULL if the notification
+ *                carried no value).
+ * @return        TRUE (1) if the cached data is current, and its serial number matches that of the
+ *                notification (if it has one), or else FALSE (0).
+ */
+static boolean IsCachedUpdateAsync(const LazyMonitor *m, const LazyPayload *p) {
+  if(!m->isCurrent) return FALSE;
+  if(!p->buf) return TRUE;
+  return m->meta && m->meta->serial == p->serial;
+}
+
+/**
+ * Parses an update notification that carries the new value of the variable (see smaxSetValueNotifications()).
+ *
+ * @param msg           The notification message
+ * @param length        [bytes] The length of the message.
+ * @param[out] p        The parsed contents, whose buffer should be freed after use (if not NULL).
+ * @return              TRUE (1) if the message carried a value, or else FALSE (0).
+ */
+static boolean ParsePayload(const char *msg, long length, LazyPayload *p) {
+  char *field[5], *next;
+  time_t secs;
+  long nanos;
+  int i;
+
+  memset(p, 0, sizeof(*p));
+
+  if(!msg) return FALSE;
+  if(length <= 0) length = strlen(msg);
+  if(!memchr(msg, '\n', length)) return FALSE;     // Origin only.
+
+  p->buf = (char *) malloc(length + 1);
+  if(!p->buf) return FALSE;
+
+  memcpy(p->buf, msg, length);
+  p->buf[length] = '\0';
+
+  for(next = p->buf, i = 0; i < 5; i++) {
+    char *eol = (char *) memchr(next, '\n', length - (next - p->buf));
+    if(!eol) break;
+    *eol = '\0';
+    field[i] = next;
+    next = eol + 1;
+  }
+
+  if(i < 5 || smaxParseTime(field[1], &secs, &nanos) != X_SUCCESS) {
+    xvprintf("SMA-X: ignoring malformed value in notification.\n");
+    free(p->buf);
+    p->buf = NULL;
+    return FALSE;
+  }
+
+  p->origin = field[0];
+  p->timestamp.tv_sec = secs;
+  p->timestamp.tv_nsec = nanos;
+  p->serial = (int) strtol(field[2], NULL, 10);
+  p->type = field[3];
+  p->dims = field[4];
+  p->data = next;
+  p->length = length - (next - p->buf);
+
+  return TRUE;
+}
+
+/**
+ * Applies a new value of a variable to its monitor point directly, without pulling it from SMA-X. It should
+ * be called without locking the monitor's bucket.
+ *
+ * @param m           Pointer to the (retained) monitor point of the variable.
+ * @param data        The serialized data, as stored in Redis.
+ * @param length      [bytes] The length of the serialized data, or &lt;=0 if it is a string.
+ * @param typeName    The type of the data, as stored in Redis.
+ * @param dims        The dimensions of the data, as stored in Redis.
+ * @param timestamp   The time of the update.
+ * @param origin      The origin of the update.
+ * @param serial      The serial number of the update.
+ */
+static void ApplyValue(LazyMonitor *m, const char *data, int length, const char *typeName, const char *dims,
+                       const struct timespec *timestamp, const char *origin, int serial) {
+  LazyMonitor *staging;
+
+  if(length <= 0) length = strlen(data);
+
+  staging = CreateStaging(m);
+
+  staging->data = (char *) malloc(length + 1);
+  x_check_alloc(staging->data);
+  memcpy(staging->data, data, length);
+  staging->data[length] = '\0';
+
+  if(staging->meta) {
+    XMeta *meta = staging->meta;
+
+    meta->status = X_SUCCESS;
+    meta->storeType = smaxTypeForString(typeName);
+    meta->storeDim = xParseDims(dims, meta->storeSizes);
+    meta->storeBytes = length;
+    meta->timestamp = *timestamp;
+    smaxSetOrigin(meta, origin);
+    meta->serial = serial;
+  }
+
+  ApplyUpdateAsync(staging, m, FALSE);
+  DestroyMonitorAsync(staging);
+}
+
+/**
+ * Applies the value that arrived with an update notification to a monitor point. Binary encoded values
+ * are cached in their ASCII representation, the same as data that is pulled from the database. It should
+ * be called without locking the monitor's bucket.
+ *
+ * @param m     Pointer to the (retained) monitor point of the variable.
+ * @param p     The parsed contents of the update notification.
+ */
+static void ApplyPayload(LazyMonitor *m, const LazyPayload *p) {
+  const XType binaryType = smaxGetBinaryType(p->data, p->length);
+  char *ascii;
+
+  if(binaryType == X_UNKNOWN) {
+    ApplyValue(m, p->data, p->length, p->type, p->dims, &p->timestamp, p->origin, p->serial);
+    return;
+  }
+
+  ascii = smaxBinaryToString(p->data, p->length);
+  if(!ascii) {
+    // Pull it the regular way instead.
+    LockBucket(m->bucket);
+    m->isCurrent = FALSE;
+    smaxMirrorInvalidate(m->table, m->key);
+    UnlockBucket(m->bucket);
+    return;
+  }
+
+  ApplyValue(m, ascii, 0, smaxStringType(binaryType), p->dims, &p->timestamp, p->origin, p->serial);
+  free(ascii);
+}
+
+/// \cond PROTECTED
+
+/**
+ * Applies a write of ours to the cache directly (write-through), if the variable is being monitored, so we
+ * need not pull back the data that we send. It should be called before the data is sent, since the update
+ * notification that results from our write will be ignored, provided that the cache still holds the same
+ * version of the data (as per the serial number, if the notification carries the value also). The write does
+ * not affect an update that is pending for the variable.
+ * If an update of the variable is already pending, the cache is left alone, and it will be updated the
+ * regular way instead. Binary encoded data is cached in its ASCII representation, the same as data that
+ * is pulled from the database.
+ *
+ * @param table     The hash table name.
+ * @param key       The variable name under which the data is stored.
+ * @param data      The serialized data, as sent to Redis.
+ * @param length    [bytes] The length of the serialized data, or &lt;=0 if it is a string.
+ * @param typeName  The type of the data, as sent to Redis.
+ * @param dims      The dimensions of the data, as sent to Redis.
+ * @return          TRUE (1) if the cache was updated with the data, in which case the caller should call
+ *                  smaxLazyWriteFailed() if the data could not be sent after all, or else FALSE (0).
+ *
+ * @sa smaxWriteArgs()
+ * @sa smaxLazyWriteFailed()
+ */
+boolean smaxLazyWriteThrough(const char *table, const char *key, const char *data, int length, const char *typeName, const char *dims) {
+  LazyMonitor *m;
+  struct timespec now;
+  unsigned long long hash;
+  char *ascii = NULL;
+  XType binaryType;
+  int bucket, serial = 0;
+
+  if(!table || !key || !data) return FALSE;
+  if(!smaxHashCount(__atomic_load_n(&monitors, __ATOMIC_ACQUIRE))) return FALSE;
+
+  hash = GetHash(table, key);
+  bucket = GetBucket(hash);
+
+  LockBucket(bucket);
+
+  m = GetExistingMonitorAsync(table, key, hash);
+  if(m) {
+    if(m->isPending) {
+      ReleaseAsync(m);
+      m = NULL;
+    }
+    else {
+      if(!m->isTracked) m->ownWrites++;   // Tracking invalidations don't tell the origin...
+      if(m->meta) serial = m->meta->serial;
+    }
+  }
+
+  UnlockBucket(bucket);
+
+  if(!m) return FALSE;
+
+  binaryType = smaxGetBinaryType(data, length);
+  if(binaryType != X_UNKNOWN) {
+    ascii = smaxBinaryToString(data, length);
+    if(!ascii) {
+      // Leave it to the update notification to refresh the cache the regular way.
+      smaxLazyWriteFailed(table, key);
+      Release(m);
+      return FALSE;
+    }
+    data = ascii;
+    length = 0;
+    typeName = smaxStringType(binaryType);
+  }
+
+  clock_gettime(CLOCK_REALTIME, &now);
+  ApplyValue(m, data, length, typeName, dims, &now, smaxGetProgramID(), serial + 1);
+  Release(m);
+
+  if(ascii) free(ascii);
+
+  return TRUE;
+}
+
+/**
+ * Reverts a write-through to the cache, after the data could not be sent to the database. The cached
+ * data is no longer considered current, so it will be pulled again on the next access, but the variable
+ * remains monitored (and cached) as before.
+ *
+ * @param table     The hash table name.
+ * @param key       The variable name under which the data was to be stored.
+ *
+ * @sa smaxLazyWriteThrough()
+ */
+void smaxLazyWriteFailed(const char *table, const char *key) {
+  LazyMonitor *m;
+  unsigned long long hash;
+  int bucket;
+
+  if(!table || !key) return;
+
+  hash = GetHash(table, key);
+  bucket = GetBucket(hash);
+
+  LockBucket(bucket);
+
+  m = GetExistingMonitorAsync(table, key, hash);
+  if(m) {
+    m->isCurrent = FALSE;
+    smaxMirrorInvalidate(m->table, m->key);
+    if(!m->isTracked && m->ownWrites > 0) m->ownWrites--;   // No notification will come for it.
+    ReleaseAsync(m);
+  }
+
+  UnlockBucket(bucket);
+}
+
+/// \endcond
+
 /**
  * Callback function for processing lazy updates, added as a Redis subscriber routine.
  *
@@ -1089,12 +2958,12 @@ static LazyMonitor *GetMonitorAsync(const char *table, const char *key) {
  *
  */
 static void ProcessLazyUpdates(const char *pattern, const char *channel, const char *msg, long length) {
-  LazyMonitor *m;
   char *id;
-  boolean checkParents = TRUE;
+  const char *origin = msg;
+  boolean checkParents = TRUE, isLeaf = TRUE;
+  LazyPayload payload;
 
   (void) pattern;
-  (void) length;
 
   if(!channel) return;
 
@@ -1102,39 +2971,63 @@ static void ProcessLazyUpdates(const char *pattern, const char *channel, const c
 
   id = xStringCopyOf(channel);
 
-  // If the message body has a <hmset> tag, then don't check for parent monitors.
-  if(msg) if(strstr(msg, "<hmset>") || strstr(msg, "<nested>")) checkParents = FALSE;
+  // Small values may arrive with the notification, so we need not pull them.
+  if(ParsePayload(msg, length, &payload)) origin = payload.origin;
 
-  // Do the processing in single go so we do it in the shortest time possible
-  // even if we must hold up others for a bit...
-  // Nothing (apart from smaxLazyFlush()) blocks the mutex for prolonged periods,
-  // so it's OK to wait just a little...
-  pthread_mutex_lock(&monitorLock);
+  // If the message body has a <hmset> tag, then don't check for parent monitors.
+  if(origin) if(strstr(origin, "<hmset>") || strstr(origin, "<nested>")) checkParents = FALSE;
 
-  // Loop to check for possibly monitored parents also...
+  // Loop to check for possibly monitored parents also, locking only the bucket of
+  // each in turn...
   while(id) {
+    LazyMonitor *m, *update = NULL, *received = NULL;
+    const unsigned long long hash = GetChannelHash(id);
+    const int bucket = GetBucket(hash);
+
+    LockBucket(bucket);
+
     // Find the monitor point for this update, and deal with it quickly!.
-    m = monitorTable[GetChannelLookupIndex(id)];
+    smaxEpochEnter();
+    m = (LazyMonitor *) smaxHashFind(monitors, hash, MatchesChannel, id);
+    smaxEpochExit();
 
-    // Check through the monitors with the same hash, to find a match
-    for( ; m != NULL; m = m->next) if(!strcmp(id, m->channel)) {
+    if(m) {
       xvprintf("SMA-X: Found lazy match for %s:%s.\n", m->table, m->key ? m->key : "");
-      m->isCurrent = FALSE;
-      m->updateCount++;
 
-      if(++m->unpulledCount > MAX_UNPULLED_LAZY_UPDATES) {              // garbage collect...
-        xvprintf("SMA-X: Unsubscribing from unused variable %s:%s.\n", m->table, m->key ? m->key : "");
-        RemoveMonitorAsync(m);
-        DestroyMonitorAsync(m);
-      }
-      else if(m->isCached) {
-        QueueUpdateAsync(m);  // queue for a background update.
+      boolean isCachedWrite = FALSE;
+
+      if(isLeaf && m->ownWrites > 0) {
+        // Our own write, which was applied to the cache already (unless something else came in since)?
+        if(IsOwnOrigin(msg)) {
+          m->ownWrites--;
+          isCachedWrite = IsCachedUpdateAsync(m, &payload);
+        }
+        else m->ownWrites = 0;    // Updates by others may be interleaved with ours, so don't trust the cache.
       }
 
-      // We found the match and dealt with it. Done with this particular ID.
-      break;
+      if(isCachedWrite) xvprintf("SMA-X: Own write of %s:%s is cached already.\n", m->table, m->key);
+      else if(isLeaf && payload.buf && m->key && !m->isPending) received = ReceiveAsync(m);
+      else update = InvalidateAsync(m);
+    }
+
+    UnlockBucket(bucket);
+
+    // Apply the value that came with the notification (outside of the lock).
+    if(received) {
+      ApplyPayload(received, &payload);
+      Release(received);
+    }
+
+    // Queue for a background update (outside of the lock, in case the queue is full).
+    if(update) {
+      QueueUpdateAsync(update);
+      Release(update);
     }
 
+    // A new variable that belongs to a cached pattern?
+    if(!m && isLeaf) if(__atomic_load_n(&patterns, __ATOMIC_ACQUIRE)) AddPatterned(id);
+    isLeaf = FALSE;
+
     // Don't check for parents of grouped updates (whose origin field is tagged with <hmset>)
     // We should (have) received the parent update notification separately.
     if(!checkParents) break;
@@ -1143,8 +3036,203 @@ static void ProcessLazyUpdates(const char *pattern, const char *channel, const c
     if(xSplitID(id, NULL) != X_SUCCESS) break;
   }
 
-  pthread_mutex_unlock(&monitorLock);
+  free(id);
+  if(payload.buf) free(payload.buf);
+}
+
+// ---------------------------------------------------------------------------
+// Handling of server-assisted invalidations (see smax-tracking.c):
+// ---------------------------------------------------------------------------
+
+static boolean MatchesTable(const void *item, const void *arg) {
+  return strcmp(((const LazyTable *) item)->name, (const char *) arg) == 0;
+}
+
+static __inline__ unsigned long long GetTableHash(const char *table) {
+  return smaxHashID(table, 0, NULL, 0);
+}
+
+/**
+ * Adds a tracked monitor to the index of tracked tables. The indexLock should be held.
+ *
+ * \param m     Pointer to the variable's monitor point structure.
+ */
+static void AddTrackedAsync(LazyMonitor *m) {
+  const unsigned long long hash = GetTableHash(m->table);
+  LazyTable *t = (LazyTable *) smaxHashFind(tables, hash, MatchesTable, m->table);
+
+  if(!t) {
+    t = (LazyTable *) calloc(1, sizeof(LazyTable));
+    x_check_alloc(t);
+
+    t->name = xStringCopyOf(m->table);
+    t->hash = hash;
+    smaxHashAdd(tables, hash, t);
+  }
+
+  if(t->n >= t->size) {
+    LazyMonitor **list;
+
+    t->size = t->size ? 2 * t->size : 4;
+    list = (LazyMonitor **) realloc(t->monitors, t->size * sizeof(LazyMonitor *));
+    x_check_alloc(list);
+    t->monitors = list;
+  }
+
+  t->monitors[t->n++] = m;
+}
+
+/**
+ * Destroys a tracked table entry.
+ *
+ * \param t     The tracked table entry.
+ */
+static void DestroyTable(LazyTable *t) {
+  if(t->name) free(t->name);
+  if(t->monitors) free(t->monitors);
+  free(t);
+}
+
+/**
+ * Removes a tracked monitor from the index of tracked tables. The indexLock should be held.
+ *
+ * \param m     Pointer to the variable's monitor point structure.
+ */
+static void RemoveTrackedAsync(LazyMonitor *m) {
+  LazyTable *t = (LazyTable *) smaxHashFind(tables, GetTableHash(m->table), MatchesTable, m->table);
+  int i;
+
+  if(!t) return;
+
+  for(i = t->n; --i >= 0; ) if(t->monitors[i] == m) {
+    t->monitors[i] = t->monitors[--t->n];
+    break;
+  }
+
+  if(t->n == 0) {
+    smaxHashRemove(tables, t->hash, t);
+    DestroyTable(t);
+  }
+}
+
+/**
+ * Discards all entries from the index of tracked tables. The indexLock should be held.
+ *
+ */
+static void DiscardTablesAsync() {
+  void **list;
+  int i, n;
+
+  list = smaxHashItems(tables, &n);
+  smaxHashClear(tables);
+
+  for(i = 0; i < n; i++) DestroyTable((LazyTable *) list[i]);
+  if(list) free(list);
+}
+
+/// \cond PROTECTED
+
+/**
+ * Processes an invalidation of a hash table by the server, i.e. a notification that the table was modified.
+ * All tracked variables in the table, and the tracked structures that contain it, are marked as outdated
+ * (and are refreshed in the background if cached).
+ *
+ * \param table     The hash table (Redis key) that was modified.
+ *
+ * @sa smaxSetLazyTracking()
+ */
+void smaxLazyInvalidate(const char *table) {
+  char *id;
+  boolean isLeaf = TRUE;
+
+  if(!table) return;
+
+  pthread_once(&monitorsOnce, InitMonitors);
+
+  xvprintf("SMA-X: lazy invalidation of %s\n", table);
+
+  id = xStringCopyOf(table);
+
+  // The modified table itself, and then the structures that contain it...
+  do {
+    LazyMonitor **list = NULL;
+    const LazyTable *t;
+    int i, n = 0, k = 0;
+
+    // The monitors may be discarded by others, until we lock their bucket, so keep them from being
+    // deallocated in the meantime...
+    smaxEpochEnter();
+
+    pthread_mutex_lock(&indexLock);
+    t = (const LazyTable *) smaxHashFind(tables, GetTableHash(id), MatchesTable, id);
+    if(t) if(t->n > 0) {
+      n = t->n;
+      list = (LazyMonitor **) malloc(n * sizeof(LazyMonitor *));
+      x_check_alloc(list);
+      memcpy(list, t->monitors, n * sizeof(LazyMonitor *));
+    }
+    pthread_mutex_unlock(&indexLock);
+
+    for(i = 0; i < n; i++) {
+      LazyMonitor *m = list[i], *update = NULL;
+      const int bucket = m->bucket;
+
+      LockBucket(bucket);
+      if(m->isLinked) if(isLeaf || !m->key) update = InvalidateAsync(m);
+      UnlockBucket(bucket);
+
+      if(update) list[k++] = update;
+    }
+
+    smaxEpochExit();
+
+    // Queue background updates (outside of the locks, in case the queue is full).
+    for(i = 0; i < k; i++) {
+      QueueUpdateAsync(list[i]);
+      Release(list[i]);
+    }
+
+    if(list) free(list);
+
+    isLeaf = FALSE;
+  } while(xSplitID(id, NULL) == X_SUCCESS);
 
   free(id);
 }
 
+/// \endcond
+
+/// \cond PROTECTED
+
+/**
+ * Publishes the current data of all monitored variables (except structures) to the shared-memory mirror,
+ * e.g. after we start sharing the lazy cache with other processes.
+ *
+ * @sa smaxShareLazyCache()
+ */
+void smaxLazyMirrorAll() {
+  void **list;
+  int i, n;
+
+  pthread_once(&monitorsOnce, InitMonitors);
+
+  pthread_mutex_lock(&indexLock);
+  list = smaxHashItems(monitors, &n);
+  smaxEpochEnter();           // Keep them from being deallocated until we lock their bucket.
+  pthread_mutex_unlock(&indexLock);
+
+  for(i = 0; i < n; i++) {
+    LazyMonitor *m = (LazyMonitor *) list[i];
+    const int bucket = m->bucket;
+
+    LockBucket(bucket);
+    if(m->isLinked && m->key && m->data && m->isCurrent) smaxMirrorUpdate(m->table, m->key, m->data, m->meta);
+    UnlockBucket(bucket);
+  }
+
+  smaxEpochExit();
+
+  if(list) free(list);
+}
+
+/// \endcond
@@ -0,0 +1,820 @@
+/**
+ * \file
+ *
+ * \date Oct 16, 2026
+ * \author Attila Kovacs
+ *
+ * \brief
+ *      Fast, locale-independent conversion of numerical values to and from their ASCII representation
+ *      in SMA-X. Integers are printed two digits at a time using a lookup table, while floating-point
+ *      values are printed with the shortest (or nearly shortest) number of significant digits that
+ *      still round-trip to the same binary value, using the Grisu2 algorithm by Florian Loitsch
+ *      ("Printing Floating-Point Numbers Quickly and Accurately with Integers", PLDI 2010).
+ *
+ *      Floating-point values are printed in the same style as the `%g` format of printf(), i.e. in
+ *      decimal notation for moderate exponents and in exponential notation (e.g. `1.5e-07`)
+ *      otherwise, with trailing zeroes removed.
+ *
+ *      The parsers handle the common case of plain decimal tokens without libc, consuming 8 digits
+ *      at a time (SWAR) where possible, and using exact (Clinger) fast-path conversion for floating
+ *      point values. Tokens that do not qualify for the fast path (e.g. hexadecimal or octal
+ *      integers, NaN or infinite values, or too many significant digits) are left for the caller to
+ *      parse with the standard library functions, so the results are always correctly rounded.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#if __SSE2__
+#  include <emmintrin.h>
+#endif
+
+#include "smax-private.h"
+
+/// \cond PRIVATE
+#define DOUBLE_PRECISION          17        ///< Max. significant digits for doubles
+#define FLOAT_PRECISION           9         ///< Max. significant digits for floats
+
+#define MAX_LONG_DIGITS           18        ///< Max. decimal digits that always fit into a long long
+#define MAX_MANTISSA_DIGITS       19        ///< Max. significant digits that always fit into 64-bit unsigned
+#define MAX_EXACT_DOUBLE          (1ULL << 53)  ///< Integers up to this can be represented exactly as doubles
+#define MAX_EXACT_FLOAT           (1ULL << 24)  ///< Integers up to this can be represented exactly as floats
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#  define USE_SWAR                1         ///< Parse 8 digits at a time on little-endian machines
+#endif
+
+/**
+ * A floating-point value with a 64-bit integer significand, and a binary exponent, i.e. f * 2^e.
+ */
+typedef struct {
+  uint64_t f;         ///< significand
+  int e;              ///< binary exponent
+} DiyFp;
+/// \endcond
+
+/// Decimal digit pairs '00' to '99'
+static const char digitPairs[201] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+/// Normalized significands of the cached powers of 10 from 10<sup>-348</sup> to 10<sup>340</sup> in steps of 8
+static const uint64_t cachedPowerF[] = {
+  0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+  0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+  0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+  0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+  0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+  0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+  0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+  0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+  0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+  0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+  0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+  0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+  0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+  0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+  0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+  0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+  0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+  0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+  0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+  0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+  0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+  0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+  0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+  0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+  0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+  0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+  0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+  0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+  0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL
+};
+
+/// Binary exponents of the cached powers of 10
+static const short cachedPowerE[] = {
+  -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+  -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+  -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+  -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+  56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+  375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+  694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+  1013, 1039, 1066
+};
+
+/// Powers of 10 that fit into 64-bit unsigned integers
+static const uint64_t pow10[] = {
+  1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+  10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+  1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL,
+  10000000000000000000ULL
+};
+
+/// \cond PROTECTED
+
+/**
+ * Returns the number of decimal digits in an unsigned integer value.
+ *
+ * \param value     The unsigned integer value
+ *
+ * \return          The number of decimal digits needed to print the value (1 to 20).
+ */
+int smaxDecimalDigits(unsigned long long value) {
+  int n = 1;
+
+  while(n < 20 && value >= pow10[n]) n++;
+  return n;
+}
+
+/**
+ * Returns the number of characters needed to print an integer value, including the sign.
+ *
+ * \param value     The integer value
+ *
+ * \return          The number of characters needed to print the value in decimal (1 to 20).
+ *
+ * @sa smaxPrintLong()
+ */
+int smaxPrintLongSize(long long value) {
+  return value < 0 ? 1 + smaxDecimalDigits(-(unsigned long long) value) : smaxDecimalDigits(value);
+}
+
+/**
+ * Prints the decimal digits of an unsigned integer value, two digits at a time.
+ *
+ */
+static int PrintUnsigned(char *str, unsigned long long value) {
+  int n = smaxDecimalDigits(value), i = n;
+
+  while(value >= 100) {
+    const int k = (int) (value % 100) << 1;
+    value /= 100;
+    str[--i] = digitPairs[k + 1];
+    str[--i] = digitPairs[k];
+  }
+
+  if(value >= 10) {
+    const int k = (int) value << 1;
+    str[--i] = digitPairs[k + 1];
+    str[--i] = digitPairs[k];
+  }
+  else str[--i] = (char) ('0' + value);
+
+  str[n] = '\0';
+  return n;
+}
+
+/**
+ * Prints an integer value in decimal, in a locale-independent way. It is equivalent to `%lld` in
+ * printf(), but a lot faster.
+ *
+ * \param[out] str  The buffer in which to print, which must accommodate at least 21 characters
+ *                  (including the string termination).
+ * \param value     The integer value
+ *
+ * \return          The number of characters printed (not including the string termination).
+ *
+ * @sa smaxPrintLongSize()
+ * @sa smaxPrintDouble()
+ */
+int smaxPrintLong(char *str, long long value) {
+  if(value < 0) {
+    *str = '-';
+    return 1 + PrintUnsigned(str + 1, -(unsigned long long) value);
+  }
+  return PrintUnsigned(str, value);
+}
+
+/// \endcond
+
+static __inline__ DiyFp Multiply(DiyFp x, DiyFp y) {
+  const uint64_t M32 = 0xFFFFFFFFULL;
+  const uint64_t a = x.f >> 32, b = x.f & M32, c = y.f >> 32, d = y.f & M32;
+  const uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+  uint64_t tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+  DiyFp r;
+
+  tmp += 1ULL << 31;  // Round up
+  r.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+  r.e = x.e + y.e + 64;
+  return r;
+}
+
+static __inline__ DiyFp Normalize(DiyFp x) {
+  while(!(x.f & 0xFFC0000000000000ULL)) {
+    x.f <<= 10;
+    x.e -= 10;
+  }
+  while(!(x.f & 0x8000000000000000ULL)) {
+    x.f <<= 1;
+    x.e--;
+  }
+  return x;
+}
+
+/**
+ * Calculates the normalized boundaries of the rounding interval of a floating-point value.
+ *
+ * \param v             The value, with its (non-normalized) significand, and binary exponent
+ * \param hiddenBit     The implicit leading significand bit of normalized values of the type
+ * \param[out] minus    The lower boundary (normalized to the same exponent as the upper boundary)
+ * \param[out] plus     The upper boundary (normalized)
+ */
+static void GetBoundaries(DiyFp v, uint64_t hiddenBit, DiyFp *minus, DiyFp *plus) {
+  DiyFp pl, mi;
+
+  pl.f = (v.f << 1) + 1;
+  pl.e = v.e - 1;
+  pl = Normalize(pl);
+
+  // The lower boundary is closer if the value is a power of 2
+  if(v.f == hiddenBit) {
+    mi.f = (v.f << 2) - 1;
+    mi.e = v.e - 2;
+  }
+  else {
+    mi.f = (v.f << 1) - 1;
+    mi.e = v.e - 1;
+  }
+
+  mi.f <<= mi.e - pl.e;
+  mi.e = pl.e;
+
+  *minus = mi;
+  *plus = pl;
+}
+
+/**
+ * Returns a cached power of ten, such that the product with a value of the given binary exponent
+ * has a binary exponent in the range [-60:-32].
+ *
+ * \param e         binary exponent of the value to scale
+ * \param[out] K    The decimal exponent of the returned power of 10, negated.
+ *
+ * \return          The power of 10 as a DiyFp.
+ */
+static DiyFp GetCachedPower(int e, int *K) {
+  const double dk = (-61 - e) * 0.30102999566398114 + 347;   // log10(2)
+  int k = (int) dk;
+  unsigned index;
+  DiyFp c;
+
+  if(dk - k > 0.0) k++;
+
+  index = (unsigned) ((k >> 3) + 1);
+  *K = -(-348 + (int) (index << 3));
+
+  c.f = cachedPowerF[index];
+  c.e = cachedPowerE[index];
+  return c;
+}
+
+static __inline__ void GrisuRound(char *buf, int len, uint64_t delta, uint64_t rest, uint64_t tenKappa, uint64_t wpw) {
+  while(rest < wpw && delta - rest >= tenKappa && (rest + tenKappa < wpw || wpw - rest > rest + tenKappa - wpw)) {
+    buf[len - 1]--;
+    rest += tenKappa;
+  }
+}
+
+/**
+ * Generates the shortest digit sequence that lies within the rounding interval.
+ *
+ */
+static int DigitGen(DiyFp w, DiyFp mp, uint64_t delta, char *buf, int *K) {
+  const int shift = -mp.e;
+  const uint64_t one = 1ULL << shift;
+  const uint64_t wpw = mp.f - w.f;
+  uint32_t p1 = (uint32_t) (mp.f >> shift);
+  uint64_t p2 = mp.f & (one - 1);
+  int kappa = smaxDecimalDigits(p1), len = 0;
+
+  while(kappa > 0) {
+    const uint32_t div = (uint32_t) pow10[kappa - 1];
+    const uint32_t d = p1 / div;
+    uint64_t rest;
+
+    p1 %= div;
+
+    if(d || len) buf[len++] = (char) ('0' + d);
+
+    kappa--;
+    rest = ((uint64_t) p1 << shift) + p2;
+    if(rest <= delta) {
+      *K += kappa;
+      GrisuRound(buf, len, delta, rest, pow10[kappa] << shift, wpw);
+      return len;
+    }
+  }
+
+  // kappa == 0
+  while(TRUE) {
+    char d;
+
+    p2 *= 10;
+    delta *= 10;
+    d = (char) (p2 >> shift);
+    if(d || len) buf[len++] = (char) ('0' + d);
+    p2 &= one - 1;
+    kappa--;
+
+    if(p2 < delta) {
+      *K += kappa;
+      GrisuRound(buf, len, delta, p2, one, -kappa < 20 ? wpw * pow10[-kappa] : 0);
+      return len;
+    }
+  }
+}
+
+/**
+ * Generates the decimal digits of a positive finite floating-point value.
+ *
+ * \param v             The value as significand and binary exponent
+ * \param hiddenBit     The implicit leading significand bit of normalized values of the type
+ * \param[out] buf      Buffer for the digits (at least 20 characters)
+ * \param[out] K        Decimal exponent, such that value = digits * 10<sup>K</sup>
+ *
+ * \return              Number of digits generated.
+ */
+static int Grisu2(DiyFp v, uint64_t hiddenBit, char *buf, int *K) {
+  DiyFp wm, wp, c, w;
+
+  GetBoundaries(v, hiddenBit, &wm, &wp);
+
+  c = GetCachedPower(wp.e, K);
+
+  w = Multiply(Normalize(v), c);
+  wp = Multiply(wp, c);
+  wm = Multiply(wm, c);
+
+  wm.f++;
+  wp.f--;
+
+  return DigitGen(w, wp, wp.f - wm.f, buf, K);
+}
+
+/**
+ * Prints the decimal exponent in the same way as printf(), i.e. with a sign and at least 2 digits.
+ *
+ */
+static int PrintExponent(char *str, int exp) {
+  int n = 0;
+
+  str[n++] = 'e';
+  if(exp < 0) {
+    str[n++] = '-';
+    exp = -exp;
+  }
+  else str[n++] = '+';
+
+  if(exp >= 100) {
+    str[n++] = (char) ('0' + exp / 100);
+    exp %= 100;
+  }
+
+  str[n++] = digitPairs[exp << 1];
+  str[n++] = digitPairs[(exp << 1) + 1];
+  return n;
+}
+
+/**
+ * Formats the generated decimal digits similarly to the `%g` format of printf().
+ *
+ * \param[out] str          Output buffer
+ * \param digits            Significant digits (not terminated)
+ * \param len               Number of significant digits
+ * \param K                 Decimal exponent, such that value = digits * 10<sup>K</sup>
+ * \param precision         The maximum number of digits that are printed in decimal notation before the
+ *                          decimal point.
+ *
+ * \return                  Number of characters printed
+ */
+static int Prettify(char *str, const char *digits, int len, int K, int precision) {
+  const int exp = len + K - 1;    // decimal exponent of the first digit
+  int n = 0, i;
+
+  if(exp < -4 || exp >= precision) {
+    // Exponential notation d[.ddd]e+XX
+    str[n++] = digits[0];
+    if(len > 1) {
+      str[n++] = '.';
+      memcpy(&str[n], &digits[1], len - 1);
+      n += len - 1;
+    }
+    n += PrintExponent(&str[n], exp);
+  }
+  else if(K >= 0) {
+    // Integer value ddd000
+    memcpy(str, digits, len);
+    n = len;
+    for(i = K; --i >= 0; ) str[n++] = '0';
+  }
+  else if(exp >= 0) {
+    // ddd.ddd
+    memcpy(str, digits, exp + 1);
+    n = exp + 1;
+    str[n++] = '.';
+    memcpy(&str[n], &digits[exp + 1], len - exp - 1);
+    n += len - exp - 1;
+  }
+  else {
+    // 0.000ddd
+    str[n++] = '0';
+    str[n++] = '.';
+    for(i = -exp - 1; --i >= 0; ) str[n++] = '0';
+    memcpy(&str[n], digits, len);
+    n += len;
+  }
+
+  str[n] = '\0';
+  return n;
+}
+
+/// \cond PROTECTED
+
+/**
+ * Prints a double-precision floating point value with the shortest (or nearly shortest) representation
+ * that parses back to the same binary value, in a locale-independent way. Finite values are printed
+ * similarly to the `%g` format of printf(), while infinite and NaN values are printed by xPrintDouble().
+ *
+ * \param[out] str  The buffer in which to print, which must accommodate at least 25 characters
+ *                  (including the string termination).
+ * \param value     The value to print
+ *
+ * \return          The number of characters printed (not including the string termination).
+ *
+ * @sa smaxPrintFloat()
+ * @sa smaxPrintLong()
+ */
+int smaxPrintDouble(char *str, double value) {
+  char digits[24];
+  uint64_t bits;
+  DiyFp v;
+  int n = 0, len, K, bexp;
+
+  if(!isfinite(value)) return xPrintDouble(str, value);
+
+  memcpy(&bits, &value, sizeof(bits));
+
+  if(bits & 0x8000000000000000ULL) str[n++] = '-';
+
+  v.f = bits & 0x000FFFFFFFFFFFFFULL;
+  bexp = (int) ((bits >> 52) & 0x7FF);
+
+  if(bexp == 0 && v.f == 0) {
+    str[n++] = '0';
+    str[n] = '\0';
+    return n;
+  }
+
+  if(bexp) {
+    v.f += 0x0010000000000000ULL;
+    v.e = bexp - 1075;
+  }
+  else v.e = -1074;
+
+  len = Grisu2(v, 0x0010000000000000ULL, digits, &K);
+  return n + Prettify(&str[n], digits, len, K, DOUBLE_PRECISION);
+}
+
+/**
+ * Prints a single-precision floating point value with the shortest (or nearly shortest) representation
+ * that parses back to the same binary value, in a locale-independent way. Finite values are printed
+ * similarly to the `%g` format of printf(), while infinite and NaN values are printed by xPrintFloat().
+ *
+ * \param[out] str  The buffer in which to print, which must accommodate at least 16 characters
+ *                  (including the string termination).
+ * \param value     The value to print
+ *
+ * \return          The number of characters printed (not including the string termination).
+ *
+ * @sa smaxPrintDouble()
+ */
+int smaxPrintFloat(char *str, float value) {
+  char digits[24];
+  uint32_t bits;
+  DiyFp v;
+  int n = 0, len, K, bexp;
+
+  if(!isfinite(value)) return xPrintFloat(str, value);
+
+  memcpy(&bits, &value, sizeof(bits));
+
+  if(bits & 0x80000000U) str[n++] = '-';
+
+  v.f = bits & 0x007FFFFFU;
+  bexp = (int) ((bits >> 23) & 0xFF);
+
+  if(bexp == 0 && v.f == 0) {
+    str[n++] = '0';
+    str[n] = '\0';
+    return n;
+  }
+
+  if(bexp) {
+    v.f += 0x00800000U;
+    v.e = bexp - 150;
+  }
+  else v.e = -149;
+
+  len = Grisu2(v, 0x00800000U, digits, &K);
+  return n + Prettify(&str[n], digits, len, K, FLOAT_PRECISION);
+}
+
+/// \endcond
+
+/// Powers of 10 that are exactly representable as doubles
+static const double exactPow10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/// Powers of 10 that are exactly representable as floats
+static const float exactPow10f[] = {
+  1e0F, 1e1F, 1e2F, 1e3F, 1e4F, 1e5F, 1e6F, 1e7F, 1e8F, 1e9F, 1e10F
+};
+
+static __inline__ boolean IsSpace(char c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static __inline__ boolean IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+/**
+ * Checks if a token ends at the given position, i.e. at a white space or at the end of the input.
+ *
+ */
+static __inline__ boolean IsTokenEnd(const char *str, const char *end) {
+  return str >= end || IsSpace(*str);
+}
+
+#if USE_SWAR
+/**
+ * Checks if the 8 bytes (in little-endian order) are all decimal digits.
+ *
+ */
+static __inline__ boolean IsEightDigits(uint64_t v) {
+  return (((v & 0xF0F0F0F0F0F0F0F0ULL) | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL);
+}
+
+/**
+ * Converts 8 decimal digits (in little-endian byte order) to their integer value.
+ *
+ */
+static __inline__ uint32_t ParseEightDigits(uint64_t v) {
+  v = ((v & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+  v = ((v & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+  return (uint32_t) (((v & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32);
+}
+#endif
+
+/**
+ * Accumulates a run of decimal digits onto an integer value.
+ *
+ * \param str          Start of the digits
+ * \param end          End of the input
+ * \param[in,out] u    The accumulated value
+ *
+ * \return             Pointer to the first character after the digits.
+ */
+static __inline__ const char *ParseDigits(const char *str, const char *end, uint64_t *u) {
+  uint64_t v = *u;
+
+#if USE_SWAR
+  while(end - str >= 8) {
+    uint64_t chunk;
+    memcpy(&chunk, str, sizeof(chunk));
+    if(!IsEightDigits(chunk)) break;
+    v = v * 100000000ULL + ParseEightDigits(chunk);
+    str += 8;
+  }
+#endif
+
+  for(; str < end && IsDigit(*str); str++) v = v * 10 + (*str - '0');
+
+  *u = v;
+  return str;
+}
+
+/// \cond PROTECTED
+
+/**
+ * Skips white spaces in the input.
+ *
+ * \param str      Current parse position
+ * \param end      End of the input
+ *
+ * \return         Pointer to the first non-white-space character, or else to the end of the input.
+ */
+const char *smaxSkipSpaces(const char *str, const char *end) {
+  if(str < end && !IsSpace(*str)) return str;   // Nothing to skip (most common)
+
+#if __SSE2__
+  while(end - str >= 16) {
+    const __m128i c = _mm_loadu_si128((const __m128i *) str);
+    const __m128i t = _mm_sub_epi8(c, _mm_set1_epi8('\t'));
+    const __m128i isCtrl = _mm_and_si128(_mm_cmpgt_epi8(t, _mm_set1_epi8(-1)), _mm_cmplt_epi8(t, _mm_set1_epi8('\r' - '\t' + 1)));
+    const __m128i isSpace = _mm_or_si128(isCtrl, _mm_cmpeq_epi8(c, _mm_set1_epi8(' ')));
+    const unsigned mask = (unsigned) _mm_movemask_epi8(isSpace);
+
+    if(mask != 0xFFFF) return str + __builtin_ctz(~mask);
+    str += 16;
+  }
+#endif
+
+  while(str < end && IsSpace(*str)) str++;
+  return str;
+}
+
+/**
+ * Parses a decimal integer token without sign-prefixed octal or hexadecimal notation, without libc.
+ * Only tokens that are fully parsed up to a white space or the end of the input are accepted, and
+ * those that might not fit into a long long (more than 18 digits) are rejected, as are integers
+ * with leading zeroes (which would be octal in C).
+ *
+ * \param str          Start of the token
+ * \param end          End of the input
+ * \param[out] value   The parsed value
+ *
+ * \return             The number of characters parsed, or 0 if the token was not parsed (and
+ *                     should be parsed by other means, such as strtoll()).
+ */
+int smaxParseLong(const char *str, const char *end, long long *value) {
+  const char *p = str, *digits;
+  boolean isNegative = FALSE;
+  uint64_t u = 0;
+
+  if(p < end && (*p == '-' || *p == '+')) isNegative = (*(p++) == '-');
+
+  if(p >= end || !IsDigit(*p)) return 0;
+  if(*p == '0' && !IsTokenEnd(p + 1, end)) return 0;     // octal or hex...
+
+  digits = p;
+  p = ParseDigits(p, end, &u);
+
+  if(p - digits > MAX_LONG_DIGITS) return 0;
+  if(!IsTokenEnd(p, end)) return 0;
+
+  *value = isNegative ? -(long long) u : (long long) u;
+  return p - str;
+}
+
+/**
+ * Parses the decimal mantissa and exponent of a floating-point token.
+ *
+ * \return         The number of characters parsed, or 0 if the token does not qualify.
+ */
+static int ParseDecimal(const char *str, const char *end, boolean *isNegative, uint64_t *mantissa, int *exp10) {
+  const char *p = str, *start;
+  uint64_t m = 0;
+  int nDigits = 0, e = 0;
+
+  *isNegative = FALSE;
+  if(p < end && (*p == '-' || *p == '+')) *isNegative = (*(p++) == '-');
+
+  // Skip leading zeroes, which are not significant
+  start = p;
+  while(p < end && *p == '0') p++;
+
+  {
+    const char *digits = p;
+    p = ParseDigits(p, end, &m);
+    nDigits = p - digits;
+  }
+
+  if(p < end && *p == '.') {
+    const char *frac = ++p;
+
+    if(nDigits == 0) {
+      // Leading zeroes after the decimal point are not significant either
+      while(p < end && *p == '0') p++;
+      e -= p - frac;
+      frac = p;
+    }
+
+    p = ParseDigits(p, end, &m);
+    nDigits += p - frac;
+    e -= p - frac;
+  }
+
+  if(p == start || (p == start + 1 && *start == '.')) return 0;    // No digits at all...
+  if(nDigits > MAX_MANTISSA_DIGITS) return 0;
+
+  if(p < end && (*p == 'e' || *p == 'E')) {
+    boolean isNegativeExp = FALSE;
+    uint64_t x = 0;
+    const char *digits;
+
+    p++;
+    if(p < end && (*p == '-' || *p == '+')) isNegativeExp = (*(p++) == '-');
+
+    digits = p;
+    p = ParseDigits(p, end, &x);
+    if(p == digits || p - digits > 4) return 0;
+
+    e += isNegativeExp ? -(int) x : (int) x;
+  }
+
+  if(!IsTokenEnd(p, end)) return 0;
+
+  *mantissa = m;
+  *exp10 = e;
+  return p - str;
+}
+
+/**
+ * Parses a decimal floating-point token, without libc, whenever it can be converted exactly
+ * (i.e. correctly rounded) using simple floating-point arithmetic.
+ *
+ * \param str          Start of the token
+ * \param end          End of the input
+ * \param[out] value   The parsed value
+ *
+ * \return             The number of characters parsed, or 0 if the token was not parsed (and
+ *                     should be parsed by other means, such as xParseDouble()).
+ *
+ * @sa smaxParseFloat()
+ */
+int smaxParseDouble(const char *str, const char *end, double *value) {
+  boolean isNegative;
+  uint64_t m;
+  int n, e;
+  double d;
+
+  n = ParseDecimal(str, end, &isNegative, &m, &e);
+  if(!n) return 0;
+
+  if(m == 0) d = 0.0;
+  else if(m > MAX_EXACT_DOUBLE) return 0;
+  else if(e < 0) {
+    if(e < -22) return 0;
+    d = (double) m / exactPow10[-e];
+  }
+  else if(e <= 22) d = (double) m * exactPow10[e];
+  else {
+    // Shift some of the exponent into the mantissa, if it remains exact
+    if(e > 22 + 15) return 0;
+    if(m > MAX_EXACT_DOUBLE / pow10[e - 22]) return 0;
+    m *= pow10[e - 22];
+    d = (double) m * exactPow10[22];
+  }
+
+  *value = isNegative ? -d : d;
+  return n;
+}
+
+/**
+ * Parses a decimal single-precision floating-point token, without libc, whenever it can be converted
+ * exactly (i.e. correctly rounded) using simple floating-point arithmetic.
+ *
+ * \param str          Start of the token
+ * \param end          End of the input
+ * \param[out] value   The parsed value
+ *
+ * \return             The number of characters parsed, or 0 if the token was not parsed (and
+ *                     should be parsed by other means, such as xParseFloat()).
+ *
+ * @sa smaxParseDouble()
+ */
+int smaxParseFloat(const char *str, const char *end, float *value) {
+  boolean isNegative;
+  uint64_t m;
+  int n, e;
+  float f;
+
+  n = ParseDecimal(str, end, &isNegative, &m, &e);
+  if(!n) return 0;
+
+  if(m == 0) f = 0.0F;
+  else if(m > MAX_EXACT_FLOAT) return 0;
+  else if(e < 0) {
+#if FLT_EVAL_METHOD == 0
+    // Division must be rounded in single precision, to avoid double rounding.
+    if(e < -10) return 0;
+    f = (float) m / exactPow10f[-e];
+#else
+    return 0;
+#endif
+  }
+  else if(e <= 10) f = (float) ((double) m * exactPow10[e]);  // exact in double, so rounded once
+  else return 0;
+
+  *value = isNegative ? -f : f;
+  return n;
+}
+
+/// \endcond
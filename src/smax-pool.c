@@ -0,0 +1,377 @@
+/**
+ * \file
+ *
+ * \date Oct 16, 2026
+ * \author Attila Kovacs
+ *
+ * \brief
+ *      A pool of interactive Redis connections, so that multiple threads can share and pull data
+ *      concurrently, instead of serializing behind a single socket. The first member of the pool is
+ *      always the interactive client of the main SMA-X Redis instance. Additional members are
+ *      separate Redis instances, configured identically to the main one (server, authentication,
+ *      database, TLS), which are connected and disconnected together with it. As such, connect /
+ *      disconnect hooks, and resilient reconnection work the same as without a pool.
+ *
+ *      Writes are always sent on the connection assigned to the calling thread, so that the shares
+ *      from any given thread arrive in the order they were made. Reads may use the least busy
+ *      connection instead, if so configured, except for the first read after a write from the same thread,
+ *      which uses the same connection as the write did, so it cannot overtake the preceding (fire-and-forget)
+ *      shares of that thread.
+ *
+ *      \sa smaxSetInteractivePoolSize()
+ *      \sa smaxSetPoolPolicy()
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "smax-private.h"
+
+/// \cond PRIVATE
+
+#define SMAX_MAX_POOL_SIZE    256     ///< Maximum number of interactive connections in the pool
+
+typedef struct {
+  Redis *redis;                 ///< The Redis instance for this pool member (not owned for the first member)
+  int busy;                     ///< Number of threads using or waiting for the member's interactive client
+} PoolMember;
+
+static PoolMember *members;     ///< The pool members
+static int nMembers;            ///< Number of pool members currently allocated
+static int poolSize = 1;        ///< The configured pool size
+static int nextSlot;            ///< The next slot to assign to a new thread
+
+static enum smax_pool_policy policy = SMAX_POOL_THREAD_AFFINITY;
+
+static pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER;
+
+static __thread int threadSlot = -1;  ///< The pool slot assigned to the calling thread
+static __thread int unreadMember = -1;  ///< The member on which the calling thread wrote since its last read, or -1
+
+/// \endcond
+
+/**
+ * Sets the number of interactive connections to use for SMA-X. With a pool size larger than 1, multiple
+ * threads may share and pull data concurrently, each on their own connection. The change takes effect with
+ * the next connection to SMA-X, and it cannot be changed while connected.
+ *
+ * @param n     The number of concurrent interactive connections (1 or more).
+ * @return      X_SUCCESS (0) if successful, or else X_SIZE_INVALID if n is less than 1 or exceeds the
+ *              maximum (256), or X_ALREADY_OPEN if currently connected to SMA-X.
+ *
+ * @sa smaxGetInteractivePoolSize()
+ * @sa smaxSetPoolPolicy()
+ */
+int smaxSetInteractivePoolSize(int n) {
+  static const char *fn = "smaxSetInteractivePoolSize";
+
+  if(n < 1 || n > SMAX_MAX_POOL_SIZE) return x_error(X_SIZE_INVALID, EINVAL, fn, "invalid pool size: %d", n);
+
+  smaxLockConfig();
+
+  if(smaxIsConnected()) {
+    smaxUnlockConfig();
+    return x_error(X_ALREADY_OPEN, EALREADY, fn, "already in connected state");
+  }
+
+  poolSize = n;
+
+  smaxUnlockConfig();
+
+  return X_SUCCESS;
+}
+
+/**
+ * Returns the configured number of interactive connections to use for SMA-X.
+ *
+ * @return    The number of interactive connections (1 or more) configured for the pool.
+ *
+ * @sa smaxSetInteractivePoolSize()
+ */
+int smaxGetInteractivePoolSize() {
+  return poolSize;
+}
+
+/**
+ * Sets how the interactive connection is selected for pulling data when using a pool of connections.
+ * Shares always use the connection assigned to the calling thread, regardless of the policy, to
+ * guarantee that the updates from the same thread arrive in order.
+ *
+ * Since shares are sent without waiting for a response, a pull from another connection could be processed
+ * by Redis before a preceding share from the same thread. Therefore, with SMAX_POOL_LEAST_BUSY, the first
+ * pull following a share is always sent on the same connection as the share, so a thread will
+ * always read back its own writes. Once that pull completes, all earlier shares of the thread have been
+ * processed, and subsequent pulls may again use the least busy connection.
+ *
+ * @param p     SMAX_POOL_THREAD_AFFINITY (default) to always use the same connection from a given thread,
+ *              or SMAX_POOL_LEAST_BUSY to use the connection that has the fewest users at the time (except
+ *              for a first pull after a share, as explained above).
+ * @return      X_SUCCESS (0) if successful, or else X_FAILURE if the policy is invalid.
+ *
+ * @sa smaxGetPoolPolicy()
+ * @sa smaxSetInteractivePoolSize()
+ */
+int smaxSetPoolPolicy(enum smax_pool_policy p) {
+  if(p != SMAX_POOL_THREAD_AFFINITY && p != SMAX_POOL_LEAST_BUSY)
+    return x_error(X_FAILURE, EINVAL, "smaxSetPoolPolicy", "invalid policy: %d", p);
+
+  policy = p;
+  return X_SUCCESS;
+}
+
+/**
+ * Returns the currently set policy for selecting interactive connections from the pool for pulling
+ * data.
+ *
+ * @return    The pool selection policy, e.g. SMAX_POOL_THREAD_AFFINITY.
+ *
+ * @sa smaxSetPoolPolicy()
+ */
+enum smax_pool_policy smaxGetPoolPolicy() {
+  return policy;
+}
+
+/// \cond PROTECTED
+
+/**
+ * (Re)creates the pool members, as necessary, to match the configured pool size. The caller
+ * must hold the configuration lock (via smaxLockConfig()) and must not be connected.
+ *
+ * @param main    The main SMA-X Redis instance.
+ * @return        X_SUCCESS (0) if successful, or else an error code (&lt;0).
+ *
+ * @sa smaxDestroyPoolAsync()
+ */
+int smaxCreatePoolAsync(Redis *main) {
+  static const char *fn = "smaxCreatePoolAsync";
+
+  PoolMember *m;
+  int i;
+
+  if(!main) return x_error(X_NULL, EINVAL, fn, "main Redis is NULL");
+
+  if(members && nMembers == poolSize && members[0].redis == main) return X_SUCCESS;
+
+  smaxDestroyPoolAsync();
+
+  m = (PoolMember *) calloc(poolSize, sizeof(PoolMember));
+  if(!m) return x_error(X_FAILURE, errno, fn, "calloc() error (%d PoolMember)", poolSize);
+
+  m[0].redis = main;
+
+  for(i = 1; i < poolSize; i++) {
+    m[i].redis = smaxCreateRedisAsync();
+    if(!m[i].redis) {
+      while(--i > 0) redisxDestroy(m[i].redis);
+      free(m);
+      return x_trace(fn, NULL, X_NO_INIT);
+    }
+  }
+
+  pthread_mutex_lock(&poolLock);
+  members = m;
+  nMembers = poolSize;
+  pthread_mutex_unlock(&poolLock);
+
+  return X_SUCCESS;
+}
+
+/**
+ * Destroys the additional pool members. The caller must hold the configuration lock (via
+ * smaxLockConfig()) and must not be connected.
+ *
+ * @sa smaxCreatePoolAsync()
+ */
+void smaxDestroyPoolAsync() {
+  PoolMember *m;
+  int i, n;
+
+  pthread_mutex_lock(&poolLock);
+  m = members;
+  n = nMembers;
+  members = NULL;
+  nMembers = 0;
+  pthread_mutex_unlock(&poolLock);
+
+  if(!m) return;
+
+  for(i = 1; i < n; i++) redisxDestroy(m[i].redis);
+  free(m);
+}
+
+/**
+ * Returns the Redis instances of the pool members, as they are at the time of the call.
+ *
+ * @param[out] r    Array of at least SMAX_MAX_POOL_SIZE elements to populate.
+ * @return          The number of pool members.
+ */
+static int GetMembers(Redis **r) {
+  int i, n;
+
+  pthread_mutex_lock(&poolLock);
+  n = nMembers;
+  for(i = 0; i < n; i++) r[i] = members[i].redis;
+  pthread_mutex_unlock(&poolLock);
+
+  return n;
+}
+
+/**
+ * Connects the additional pool members. It is called as a connect hook of the main SMA-X Redis
+ * instance, so the pool is (re)connected together with it.
+ *
+ * @sa smaxDisconnectPool()
+ */
+void smaxConnectPool() {
+  Redis *r[SMAX_MAX_POOL_SIZE];
+  int i, n = GetMembers(r);
+
+  for(i = 1; i < n; i++) {
+    if(redisxIsConnected(r[i])) continue;
+    if(redisxConnect(r[i], FALSE) != X_SUCCESS)
+      fprintf(stderr, "WARNING! SMA-X : could not connect pool member %d. Will use the main connection instead.\n", i);
+  }
+}
+
+/**
+ * Disconnects the additional pool members. It is called as a disconnect hook of the main SMA-X Redis
+ * instance, so the pool is disconnected together with it.
+ *
+ * @sa smaxConnectPool()
+ */
+void smaxDisconnectPool() {
+  Redis *r[SMAX_MAX_POOL_SIZE];
+  int i, n = GetMembers(r);
+
+  for(i = 1; i < n; i++) if(redisxIsConnected(r[i])) redisxDisconnect(r[i]);
+}
+
+/**
+ * Checks if a Redis instance is one of the additional pool members.
+ *
+ * @param r     The Redis instance
+ * @return      TRUE (1) if it is an additional member of the SMA-X connection pool, or else FALSE (0).
+ */
+boolean smaxIsPoolRedis(const Redis *r) {
+  boolean isMember = FALSE;
+  int i;
+
+  if(!r) return FALSE;
+
+  pthread_mutex_lock(&poolLock);
+  for(i = 1; i < nMembers; i++) if(members[i].redis == r) {
+    isMember = TRUE;
+    break;
+  }
+  pthread_mutex_unlock(&poolLock);
+
+  return isMember;
+}
+
+/**
+ * Selects the pool member to use by the calling thread. The caller must hold the pool lock.
+ *
+ * Writes use the thread's own member, and the first read after writes uses the member that the writes were
+ * sent on, so that a read can never overtake the thread's own earlier writes (which are sent without waiting
+ * for a response).
+ *
+ * @param isWrite   Whether the member is selected for writing.
+ * @return          The index of the selected pool member.
+ */
+static int SelectMemberAsync(boolean isWrite) {
+  int i, best;
+
+  if(threadSlot < 0) threadSlot = nextSlot++;
+
+  if(!isWrite && unreadMember >= 0) {
+    // The read's response on the same connection implies that the earlier writes were processed.
+    i = unreadMember;
+    unreadMember = -1;
+    if(i < nMembers) return i;
+  }
+
+  if(isWrite || policy == SMAX_POOL_THREAD_AFFINITY) return threadSlot % nMembers;
+
+  for(best = 0, i = 1; i < nMembers; i++) if(members[i].busy < members[best].busy) best = i;
+  return best;
+}
+
+/**
+ * Returns a locked and connected interactive Redis client from the connection pool. The caller must
+ * release the client with smaxReleaseInteractiveClient() after use.
+ *
+ * @param isWrite   Whether the client is used for writing (shares). Writes always use the connection
+ *                  assigned to the calling thread, to keep them ordered.
+ * @return          A locked and connected interactive Redis client, or NULL if SMA-X is not connected.
+ *
+ * @sa smaxReleaseInteractiveClient()
+ */
+RedisClient *smaxGetInteractiveClient(boolean isWrite) {
+  Redis *r = smaxGetRedis();
+  RedisClient *cl;
+  int i;
+
+  if(!r) return NULL;
+
+  pthread_mutex_lock(&poolLock);
+
+  if(nMembers < 2) {
+    pthread_mutex_unlock(&poolLock);
+    return redisxGetLockedConnectedClient(r, REDISX_INTERACTIVE_CHANNEL);
+  }
+
+  i = SelectMemberAsync(isWrite);
+  members[i].busy++;
+  r = members[i].redis;
+
+  pthread_mutex_unlock(&poolLock);
+
+  cl = redisxGetLockedConnectedClient(r, REDISX_INTERACTIVE_CHANNEL);
+
+  if(cl == NULL && i > 0) {
+    // Pool member not connected, use the main connection instead
+    pthread_mutex_lock(&poolLock);
+    members[i].busy--;
+    members[0].busy++;
+    pthread_mutex_unlock(&poolLock);
+
+    cl = redisxGetLockedConnectedClient(smaxGetRedis(), REDISX_INTERACTIVE_CHANNEL);
+    i = 0;
+  }
+
+  if(cl == NULL) {
+    pthread_mutex_lock(&poolLock);
+    members[i].busy--;
+    pthread_mutex_unlock(&poolLock);
+  }
+  else if(isWrite) unreadMember = i;    // The next read goes where the write did.
+
+  return cl;
+}
+
+/**
+ * Unlocks and releases an interactive Redis client that was obtained via smaxGetInteractiveClient().
+ *
+ * @param cl    The interactive Redis client to release.
+ *
+ * @sa smaxGetInteractiveClient()
+ */
+void smaxReleaseInteractiveClient(RedisClient *cl) {
+  int i;
+
+  if(!cl) return;
+
+  redisxUnlockClient(cl);
+
+  pthread_mutex_lock(&poolLock);
+  for(i = 0; i < nMembers; i++) if(members[i].redis->interactive == cl) {
+    if(members[i].busy > 0) members[i].busy--;
+    break;
+  }
+  pthread_mutex_unlock(&poolLock);
+}
+
+/// \endcond
@@ -9,6 +9,13 @@
  *      Because they don't requite a sequence of round-trips, pipelined pulls can
  *      be orders of magnitude faster than staggered regular pull requests.
  *
+ *      Queued requests are kept in a ring buffer of recycled slots, which hold the pull requests
+ *      (and short table / key names) inline, so queuing does not allocate memory in the common case.
+ *      Producers reserve slots by atomically incrementing the tail ticket, and pass them to the
+ *      (single) consumer, i.e. the pipeline response processor, via a per-slot sequence number.
+ *      Neither side needs a mutex for the hand-off. (Pull requests are reserved and sent while
+ *      holding the pipeline client, which keeps the queue in the same order as the requests on the
+ *      wire.)
  */
 
 /// For clock_gettime()
@@ -20,6 +27,7 @@
 #include <errno.h>
 #include <unistd.h>
 #include <string.h>
+#include <sched.h>
 
 #include "smax-private.h"
 
@@ -29,36 +37,155 @@
 
 #define X_SYNCPOINT             111111
 #define X_CALLBACK              111112
+#define X_HMGET                 111113      ///< Grouped pull of several fields from the same table
+
+#define CALLBACK_INLINE         1           ///< Flag (in the count field) for callbacks that run on the pipeline thread
+
+#define QUEUE_MIN_SLOTS         256         ///< Minimum number of slots in the queue ring buffer
+#define QUEUE_INLINE_GROUP      64          ///< Table names shorter than this are stored inline in queue slots
+#define QUEUE_INLINE_KEY        32          ///< Keys shorter than this are stored inline in queue slots
+
+/**
+ * A slot in the ring buffer of queued pull requests.
+ */
+typedef struct {
+  unsigned long seq;                  ///< Ticket of the slot if free, or ticket + 1 once the request is published.
+  boolean isCancelled;                ///< Whether the request was withdrawn, because it could not be sent.
+  boolean isBorrowed;                 ///< Whether the request's names are borrowed from the caller (not owned).
+  PullRequest req;                    ///< The queued request (its names may point to the inline storage below).
+  XPullHandle *handle;                ///< (optional) Handle for the deadline and cancellation of the request.
+  char group[QUEUE_INLINE_GROUP];     ///< Inline storage for short table names
+  char key[QUEUE_INLINE_KEY];         ///< Inline storage for short keys
+} QueueSlot;
+#define PULL_PENDING            0           ///< Pull handle state: awaiting response
+#define PULL_ACTIVE             1           ///< Pull handle state: response is being processed
+#define PULL_DONE               2           ///< Pull handle state: response was processed
+#define PULL_CANCELLED          3           ///< Pull handle state: cancelled by the caller
+#define PULL_EXPIRED            4           ///< Pull handle state: deadline passed before the response was processed
+
+/**
+ * Handle to a queued pull, for deadlines and cancellation, shared between the caller and the queue.
+ */
+struct XPullHandle {
+  int state;                          ///< PULL_PENDING, PULL_ACTIVE etc. (atomic)
+  int status;                         ///< Completion status, once the state is final
+  struct timespec deadline;           ///< (CLOCK_REALTIME) deadline, or zero if none
+  int refs;                           ///< Number of references (atomic)
+  pthread_mutex_t lock;               ///< Mutex for waiting on completion
+  pthread_cond_t isComplete;          ///< Signals reaching a final state
+};
 /// \endcond
 
 // Queued (pipelined) pulls ------------------------------>
 typedef struct XQueue {
-  void *first;                // Pointer to PullRequest list...
-  void *last;                 // Pointer to the last PullRequest...
+  QueueSlot *slots;           // Ring buffer of queued requests
+  unsigned long size;         // Number of slots in the ring buffer (power of 2).
+  unsigned long head;         // Ticket of the next request to process (changed by the consumer only)
+  unsigned long tail;         // Ticket of the next request to queue (changed atomically by producers)
   int status;
 } XQueue;
 
 static pthread_mutex_t qLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t consumerLock = PTHREAD_MUTEX_INITIALIZER;   // Serializes consumers of the queue head
+static __thread boolean isConsumer;  // Whether the calling thread holds the consumerLock
 static pthread_cond_t qComplete = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t qDrained = PTHREAD_COND_INITIALIZER;
+
+#define QUEUE_DRAIN_CHECK_MICROS  100000     ///< [us] Interval for checking the pipeline connection while waiting to drain
+
+static int nDrainWaiting;           // Number of producers waiting for the queue to drain (atomic)
+static int drainLevel;              // Queue level at which waiting producers are to be signalled (atomic)
+static enum smax_queue_overflow overflowPolicy = SMAX_QUEUE_BLOCK;
+static XQueueStats qStats;          // Queue overflow statistics, protected by qLock
+
+/// \cond PRIVATE
+/**
+ * Completion signal for a batch of pulls, which is shared between the caller and the pipeline
+ * consumer (hence the reference counting), so it remains valid even if the caller gives up on
+ * waiting before the batch completes.
+ */
+typedef struct {
+  pthread_mutex_t lock;       ///< mutex for accessing the fields
+  pthread_cond_t isComplete;  ///< condition that is signalled when the batch completes
+  boolean done;               ///< whether the batch has completed
+  int refs;                   ///< number of references to this signal
+} BatchSync;
+/// \endcond
 
 // Local prototypes -------------------------------------->
 static void InitQueueAsync();
-static void QueueAsync(PullRequest *req);
+static int InitRing();
+static QueueSlot *ReserveSlot();
+static void PublishSlot(QueueSlot *slot);
 static void ResubmitQueueAsync();
 static int DrainQueueAsync(int maxRemaining, int timeoutMicros);
 static void ProcessPipeResponseAsync(RESP *reply);
 static void Sync();
-static void RemoveQueueHead();
+static void ReleaseHead();
 static void DiscardQueuedAsync();
-
-// The variables below should be accessed only after an exclusive lock on pipeline->channelLock
-// e.g. via lockChannel(REDISX_PIPELINE_CHANNEL);
+static void SyncFromProducer();
+static int SendPullAsync(RedisClient *cl, const PullRequest *req);
+static void DestroyQueuedRequest(PullRequest *req);
+static void BatchComplete(void *arg);
+static int QueueCallback(void (*f)(void *), void *arg, boolean isInline);
+static int QueuePull(const char *table, const char *key, XType type, int count, void *value, XMeta *meta, XPullHandle *h, boolean isBorrowed);
+static boolean ClaimPull(XPullHandle *h, int state);
+static void FinishPull(XPullHandle *h, int state, int status);
+static void ReleasePull(XPullHandle *h);
+static void ExpireIfDue(XPullHandle *h);
+
+// The head of the queue is advanced only by the pipeline consumer, while producers reserve
+// slots at the tail atomically.
 static XQueue queued;
-static int nQueued = 0;
 static int maxQueued = SMAX_DEFAULT_MAX_QUEUED;
 
 static boolean isQueueInitialized = FALSE;
 
+/**
+ * Returns the number of requests currently in the queue, including the ones that are still being queued.
+ *
+ */
+static __inline__ int GetQueuedCount() {
+  return (int) (__atomic_load_n(&queued.tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&queued.head, __ATOMIC_ACQUIRE));
+}
+
+/**
+ * Returns the effective limit for the number of queued requests, which is never more than half
+ * the capacity of the ring buffer.
+ *
+ */
+static int GetQueueLimit() {
+  int limit = (int) (queued.size >> 1);
+  return maxQueued < limit ? maxQueued : limit;
+}
+
+/**
+ * Checks if the queue is empty.
+ *
+ */
+static __inline__ boolean IsQueueEmpty() {
+  return __atomic_load_n(&queued.head, __ATOMIC_ACQUIRE) == __atomic_load_n(&queued.tail, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Obtains exclusive access to the head of the queue, for consuming it.
+ *
+ * @sa UnlockConsumer()
+ */
+static void LockConsumer() {
+  pthread_mutex_lock(&consumerLock);
+  isConsumer = TRUE;
+}
+
+/**
+ * Releases the exclusive access to the head of the queue, obtained via LockConsumer().
+ *
+ */
+static void UnlockConsumer() {
+  isConsumer = FALSE;
+  pthread_mutex_unlock(&consumerLock);
+}
+
 /**
  * Creates a synchronization point that can be waited upon until all elements queued prior to creation
  * are processed (retrieved from the database.
@@ -81,23 +208,23 @@ XSyncPoint *smaxCreateSyncPoint() {
   x_check_alloc(s->isComplete);
   pthread_cond_init(s->isComplete, NULL);
 
-  if(queued.first == NULL) {
+  if(IsQueueEmpty()) {
     // If queue is empty then just set status accordingly...
     s->status = X_SUCCESS;
   }
   else {
     // Otherwise put the synchronization point onto the queue.
-    PullRequest *req = (PullRequest *) calloc(1, sizeof(PullRequest));
-    x_check_alloc(req);
+    QueueSlot *slot = ReserveSlot();
 
-    req->type = X_SYNCPOINT;
-    req->value = s;
+    slot->req.type = X_SYNCPOINT;
+    slot->req.value = s;
 
     s->status = X_INCOMPLETE;
 
-    pthread_mutex_lock(&qLock);
-    QueueAsync(req);
-    pthread_mutex_unlock(&qLock);
+    PublishSlot(slot);
+
+    // In case the consumer is done with the requests before it already.
+    SyncFromProducer();
   }
 
   return s;
@@ -129,40 +256,77 @@ void smaxDestroySyncPoint(XSyncPoint *s) {
  * Adds a callback function to the queue to be called with the specified argument once all prior
  * requests in the queue have been fullfilled (retrieved from the database).
  *
- * As a general rule callbacks added to the pipeline should return very fast, and avoid blocking
- * operations for the most part (using mutexes that may block for very short periods only may be
- * excepted). If the user needs to do more processing, or make blocking calls (e.g. IO operartions)
- * that may not return for longer periods, the callback should fire off processing in a separate
- * thread, or else simply move the result into another asynchronous processing queue.
+ * Unless completion threads are enabled (via smaxSetCompletionThreads()), callbacks run on the pipeline
+ * consumer thread, and so they should return very fast, and avoid blocking operations for the most part
+ * (using mutexes that may block for very short periods only may be excepted). If the user needs to do
+ * more processing, or make blocking calls (e.g. IO operartions) that may not return for longer periods,
+ * the callback should fire off processing in a separate thread, or else simply move the result into
+ * another asynchronous processing queue.
  *
  * \param f         The callback function that takes a pointer argument
  * \param arg       Argument to call the specified function with.
  *
  * \return          X_SUCCESS (0) or else X_NULL if the function parameter is NULL.
  *
+ * @sa smaxQueueInlineCallback()
+ * @sa smaxSetCompletionThreads()
  * @sa smaxCreateSyncPoint()
  * @sa smaxQueue()
  */
 int smaxQueueCallback(void (*f)(void *), void *arg) {
-  if(!f) return x_error(X_NULL, EINVAL, "smaxQueueCallback", "function parameter is NULL");
+  prop_error("smaxQueueCallback", QueueCallback(f, arg, FALSE));
+  return X_SUCCESS;
+}
+
+/**
+ * Same as smaxQueueCallback(), except that the callback always runs on the pipeline consumer thread,
+ * even if completion threads are enabled. It is meant for cheap callbacks, which return quickly, and
+ * for which the hand-off to a completion thread would be more costly than the call itself.
+ *
+ * \param f         The callback function that takes a pointer argument
+ * \param arg       Argument to call the specified function with.
+ *
+ * \return          X_SUCCESS (0) or else X_NULL if the function parameter is NULL.
+ *
+ * @sa smaxQueueCallback()
+ * @sa smaxSetCompletionThreads()
+ */
+int smaxQueueInlineCallback(void (*f)(void *), void *arg) {
+  prop_error("smaxQueueInlineCallback", QueueCallback(f, arg, TRUE));
+  return X_SUCCESS;
+}
 
-  if(queued.first == NULL) {
-    // If nothing is queued, just call back right away...
-    f(arg);
+/**
+ * Adds a callback to the queue.
+ *
+ * \param f         The callback function that takes a pointer argument
+ * \param arg       Argument to call the specified function with.
+ * \param isInline  Whether the callback should run on the pipeline consumer thread always.
+ *
+ * \return          X_SUCCESS (0) or else X_NULL if the function parameter is NULL.
+ */
+static int QueueCallback(void (*f)(void *), void *arg, boolean isInline) {
+  if(!f) return x_error(X_NULL, EINVAL, "xQueueCallback", "function parameter is NULL");
+
+  if(IsQueueEmpty()) {
+    // If nothing is queued, just call back right away (keeping the order with callbacks that
+    // were handed to the completion threads already)...
+    if(isInline) f(arg);
+    else smaxRunCompletion(f, arg);
   }
   else {
     // Otherwise, place the callback request onto the queue...
-    PullRequest *req = (PullRequest *) calloc(1, sizeof(PullRequest));
+    QueueSlot *slot = ReserveSlot();
 
-    x_check_alloc(req);
+    slot->req.type = X_CALLBACK;
+    slot->req.value = f;
+    slot->req.key = (char *) arg;
+    slot->req.count = isInline ? CALLBACK_INLINE : 0;
 
-    req->type = X_CALLBACK;
-    req->value = f;
-    req->key = (char *) arg;
+    PublishSlot(slot);
 
-    pthread_mutex_lock(&qLock);
-    QueueAsync(req);
-    pthread_mutex_unlock(&qLock);
+    // In case the consumer is done with the requests before it already.
+    SyncFromProducer();
   }
 
   return X_SUCCESS;
@@ -188,11 +352,168 @@ static void InitQueueAsync() {
   else fprintf(stderr, "WARNING! SMA-X : failed to set pipeline consumer.\n");
 }
 
+/**
+ * Allocates the ring buffer for queued requests (once), and initializes pipelined pulls as necessary.
+ * The ring buffer is sized to hold at least twice the maximum number of pending pulls at the time
+ * it is created.
+ *
+ * \return      X_SUCCESS (0) if successful, or else X_FAILURE if the ring buffer could not be allocated.
+ */
+static int InitRing() {
+  if(__atomic_load_n(&queued.slots, __ATOMIC_ACQUIRE) != NULL) return X_SUCCESS;
+
+  pthread_mutex_lock(&qLock);
+
+  if(queued.slots == NULL) {
+    QueueSlot *slots;
+    unsigned long i, size = QUEUE_MIN_SLOTS;
+
+    while(size < 2 * (unsigned long) maxQueued) size <<= 1;
+
+    slots = (QueueSlot *) calloc(size, sizeof(QueueSlot));
+    if(!slots) {
+      pthread_mutex_unlock(&qLock);
+      return x_error(X_FAILURE, errno, "xInitRing", "calloc() error (%lu QueueSlot)", size);
+    }
+
+    for(i = 0; i < size; i++) slots[i].seq = i;
+
+    queued.size = size;
+    __atomic_store_n(&queued.slots, slots, __ATOMIC_RELEASE);
+  }
+
+  if(!isQueueInitialized) InitQueueAsync();
+
+  pthread_mutex_unlock(&qLock);
+
+  return X_SUCCESS;
+}
+
+/**
+ * Reserves the next slot in the queue for a new request. If the ring buffer is full, it will wait
+ * until the slot is freed up by the consumer. The caller should populate the returned slot's request
+ * and then publish it via PublishSlot().
+ *
+ * \return      The reserved slot.
+ *
+ * @sa PublishSlot()
+ */
+static QueueSlot *ReserveSlot() {
+  unsigned long ticket = __atomic_fetch_add(&queued.tail, 1, __ATOMIC_ACQ_REL);
+  QueueSlot *slot = &queued.slots[ticket & (queued.size - 1)];
+
+  // Wait for the consumer to free the slot, if the ring is full...
+  while(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != ticket) sched_yield();
+
+  // Reset the queue status when starting a new batch of pulls...
+  if(ticket == __atomic_load_n(&queued.head, __ATOMIC_ACQUIRE)) queued.status = X_SUCCESS;
+
+  slot->isCancelled = FALSE;
+  slot->isBorrowed = FALSE;
+  slot->handle = NULL;
+  return slot;
+}
+
+/**
+ * Makes a reserved and populated slot available to the consumer.
+ *
+ * \param slot    The slot, previously obtained via ReserveSlot().
+ *
+ * @sa ReserveSlot()
+ */
+static void PublishSlot(QueueSlot *slot) {
+  __atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Withdraws a published request, which could not be sent, so the consumer will skip it.
+ *
+ * \param slot    The slot containing the request that was not sent.
+ */
+static void CancelSlot(QueueSlot *slot) {
+  __atomic_store_n(&slot->isCancelled, TRUE, __ATOMIC_RELEASE);
+}
+
+/**
+ * Returns the slot at the head of the queue, if it has been published. Only the consumer may call this,
+ * while holding the consumer lock.
+ *
+ * \return      The slot at the head of the queue, or NULL if there is no published request there.
+ */
+static QueueSlot *PeekHead() {
+  QueueSlot *slot;
+  unsigned long head = queued.head;
+
+  if(queued.slots == NULL) return NULL;
+
+  slot = &queued.slots[head & (queued.size - 1)];
+  if(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != head + 1) return NULL;
+
+  return slot;
+}
+
+/**
+ * Stores a table or key name in a queue slot, inline if it fits, or else as a dynamically
+ * allocated copy.
+ *
+ */
+static void SetSlotName(char **dst, const char *name, char *storage, int size) {
+  int n;
+
+  if(!name) {
+    *dst = NULL;
+    return;
+  }
+
+  n = strlen(name) + 1;
+
+  if(n <= size) {
+    memcpy(storage, name, n);
+    *dst = storage;
+  }
+  else *dst = xStringCopyOf(name);
+}
+
+/**
+ * Clears the request in a queue slot, releasing any resources it holds.
+ *
+ */
+static void ClearSlot(QueueSlot *slot) {
+  PullRequest *req = &slot->req;
+
+  if(req->type == X_HMGET) {
+    PullRequest *sub = (PullRequest *) req->value;
+    int i;
+
+    for(i = 0; i < req->count; i++) if(sub[i].key) free(sub[i].key);
+    free(sub);
+  }
+
+  // Sync points and callbacks do not own what their fields point to.
+  if(req->type != X_SYNCPOINT && req->type != X_CALLBACK && !slot->isBorrowed) {
+    if(req->group != NULL && req->group != slot->group) free(req->group);
+    if(req->key != NULL && req->key != slot->key) free(req->key);
+  }
+
+  memset(req, 0, sizeof(PullRequest));
+
+  if(slot->handle) {
+    // Requests that are discarded, or never sent, will not complete.
+    if(ClaimPull(slot->handle, PULL_DONE)) FinishPull(slot->handle, PULL_DONE, X_INTERRUPTED);
+    ReleasePull(slot->handle);
+    slot->handle = NULL;
+  }
+}
+
 /**
  * Configures how many pull requests can be queued in when piped pulls are enabled. If the
  * queue reaches the specified limit, no new pull requests can be submitted until responses
  * arrive, draining the queue somewhat.
  *
+ * The queue's ring buffer is allocated with the first queued request, with room for twice the
+ * limit set at that point (but at least 256 requests). Raising the limit beyond half of that
+ * later will not allow more requests to be queued than the allocated capacity.
+ *
  * \param n     The maximum number of pull requests that can be queued.
  *
  * \return      TRUE if the argument was valid, and the queue size was set to it, otherwise FALSE
@@ -203,23 +524,120 @@ int smaxSetMaxPendingPulls(int n) {
   return X_SUCCESS;
 }
 
+/**
+ * Sets what happens when a pipelined pull is submitted while the queue is full, i.e. when the
+ * number of pending pulls exceeds the limit set by smaxSetMaxPendingPulls().
+ *
+ * \param policy    SMAX_QUEUE_BLOCK (default) to wait until the queue drains to about half its
+ *                  limit, SMAX_QUEUE_FAIL to return X_INCOMPLETE right away without queuing, or
+ *                  SMAX_QUEUE_INTERACTIVE to pull the value on an interactive connection instead.
+ *                  Batch pulls (smaxPullBatch()) block under the interactive policy.
+ *
+ * \return          X_SUCCESS (0) if successful, or else X_FAILURE if the policy is invalid.
+ *
+ * @sa smaxGetQueueOverflowPolicy()
+ * @sa smaxSetMaxPendingPulls()
+ * @sa smaxGetQueueStats()
+ */
+int smaxSetQueueOverflowPolicy(enum smax_queue_overflow policy) {
+  if(policy != SMAX_QUEUE_BLOCK && policy != SMAX_QUEUE_FAIL && policy != SMAX_QUEUE_INTERACTIVE)
+    return x_error(X_FAILURE, EINVAL, "smaxSetQueueOverflowPolicy", "invalid policy: %d", policy);
+
+  overflowPolicy = policy;
+  return X_SUCCESS;
+}
+
+/**
+ * Returns the current policy for handling pipelined pulls when the queue is full.
+ *
+ * \return      The queue overflow policy, e.g. SMAX_QUEUE_BLOCK.
+ *
+ * @sa smaxSetQueueOverflowPolicy()
+ */
+enum smax_queue_overflow smaxGetQueueOverflowPolicy() {
+  return overflowPolicy;
+}
+
+/**
+ * Increments one of the overflow counters in the queue statistics.
+ *
+ */
+static void CountOverflow(long *counter) {
+  pthread_mutex_lock(&qLock);
+  (*counter)++;
+  pthread_mutex_unlock(&qLock);
+}
+
+/**
+ * Obtains statistics on how often, and for how long, callers were held up because the queue of
+ * pipelined pulls was full, since the start of the program or the last call to smaxResetQueueStats().
+ *
+ * \param[out] stats    Pointer to the structure to populate.
+ *
+ * \return      X_SUCCESS (0) if successful, or else X_NULL if the argument is NULL.
+ *
+ * @sa smaxResetQueueStats()
+ * @sa smaxSetQueueOverflowPolicy()
+ */
+int smaxGetQueueStats(XQueueStats *stats) {
+  if(!stats) return x_error(X_NULL, EINVAL, "smaxGetQueueStats", "output stats is NULL");
+
+  pthread_mutex_lock(&qLock);
+  *stats = qStats;
+  pthread_mutex_unlock(&qLock);
+
+  return X_SUCCESS;
+}
+
+/**
+ * Resets the statistics on the pipelined pull queue overflows.
+ *
+ * @sa smaxGetQueueStats()
+ */
+void smaxResetQueueStats() {
+  pthread_mutex_lock(&qLock);
+  memset(&qStats, 0, sizeof(qStats));
+  pthread_mutex_unlock(&qLock);
+}
+
 
 
 static void ResubmitQueueAsync() {
-  PullRequest *p;
+  unsigned long ticket, tail;
+  RedisClient *cl;
+
+  // Lock the consumer before the pipeline client, the same as callbacks that queue pulls do.
+  LockConsumer();
+
+  cl = redisxGetLockedConnectedClient(smaxGetRedis(), REDISX_PIPELINE_CHANNEL);
+  if(cl == NULL) {
+    UnlockConsumer();
+    smaxError("xResubmitQueueAsync()", X_NO_SERVICE);
+    return;
+  }
+
+  tail = __atomic_load_n(&queued.tail, __ATOMIC_ACQUIRE);
 
-  for(p = queued.first; p != NULL; p = p->next) {
+  for(ticket = queued.head; ticket != tail; ticket++) {
+    QueueSlot *slot = &queued.slots[ticket & (queued.size - 1)];
+    const PullRequest *p = &slot->req;
     int status;
 
+    if(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != ticket + 1) break;   // not (yet) published
+    if(__atomic_load_n(&slot->isCancelled, __ATOMIC_ACQUIRE)) continue;
     if(p->type == X_SYNCPOINT) continue;
     if(p->type == X_CALLBACK) continue;
 
-    status = smaxRead(p, REDISX_PIPELINE_CHANNEL);
+    status = SendPullAsync(cl, p);
     if(status) {
       //smaxZero(p->value, p->type, p->count);
       smaxError("xResubmitQueueAsync()", status);
     }
   }
+
+  redisxUnlockClient(cl);
+
+  UnlockConsumer();
 }
 
 /**
@@ -272,7 +690,7 @@ int smaxSync(XSyncPoint *sync, int timeoutMillis) {
   }
 
   // Check if there is anything to actually wait for...
-  if(sync->status != X_INCOMPLETE && queued.first == NULL) {
+  if(sync->status != X_INCOMPLETE && IsQueueEmpty()) {
     xvprintf("SMA-X> Already synchronized.\n");
     pthread_mutex_unlock(sync->lock);
     return x_error(sync->status, EALREADY, fn, "already synched");
@@ -284,7 +702,7 @@ int smaxSync(XSyncPoint *sync, int timeoutMillis) {
     if(timeoutMillis > 0) status = pthread_cond_timedwait(sync->isComplete, sync->lock, &end);
     else status = pthread_cond_wait(sync->isComplete, sync->lock);
 
-    if(queued.first == NULL) sync->status = X_SUCCESS;  // If the queue is empty, then we are synchronized
+    if(IsQueueEmpty()) sync->status = X_SUCCESS;  // If the queue is empty, then we are synchronized
   }
 
   xvprintf("SMA-X> End wait for synchronization.\n");
@@ -328,7 +746,7 @@ int smaxSync(XSyncPoint *sync, int timeoutMillis) {
 int smaxWaitQueueComplete(int timeoutMillis) {
   XSyncPoint sync;
 
-  if(queued.first == NULL) return X_SUCCESS;
+  if(IsQueueEmpty()) return X_SUCCESS;
 
   sync.status = X_INCOMPLETE;
   sync.isComplete = &qComplete;
@@ -351,28 +769,99 @@ int smaxWaitQueueComplete(int timeoutMillis) {
 static int DrainQueueAsync(int maxRemaining, int timeoutMicros) {
   static const char *fn = "xDrainQueue";
   Redis *r = smaxGetRedis();
-  int totalSleep = 0;
-  struct timespec interval;
+  struct timespec start, now;
+  double waited = 0.0;
+  int status = X_SUCCESS;
 
   if(!r) return smaxError(fn, X_NO_INIT);
+  if(GetQueuedCount() <= maxRemaining) return X_SUCCESS;
 
   xvprintf("SMA-X> read queue full. Waiting to drain...\n");
-  while(nQueued > maxRemaining) {
-    int sleepMicros;
 
-    if(!redisxHasPipeline(r)) return x_error(X_NO_SERVICE, ENOTCONN, fn, "no pipeline client");
-    if(timeoutMicros > 0) if(totalSleep > timeoutMicros) return x_error(X_TIMEDOUT, ETIMEDOUT, fn, "timed out");
-    sleepMicros = 1 + nQueued - maxRemaining;
-    totalSleep += sleepMicros;
+  clock_gettime(CLOCK_REALTIME, &start);
+
+  pthread_mutex_lock(&qLock);
+
+  // Register as waiting before checking the queue level, so the consumer will not miss us.
+  __atomic_add_fetch(&nDrainWaiting, 1, __ATOMIC_SEQ_CST);
+  if(maxRemaining > __atomic_load_n(&drainLevel, __ATOMIC_RELAXED)) __atomic_store_n(&drainLevel, maxRemaining, __ATOMIC_RELAXED);
+
+  while(GetQueuedCount() > maxRemaining) {
+    struct timespec wake;
+    long waitMicros = QUEUE_DRAIN_CHECK_MICROS;
+
+    if(!redisxHasPipeline(r)) {
+      status = x_error(X_NO_SERVICE, ENOTCONN, fn, "no pipeline client");
+      break;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    waited = (now.tv_sec - start.tv_sec) + 1e-9 * (now.tv_nsec - start.tv_nsec);
+
+    if(timeoutMicros > 0) {
+      long left = timeoutMicros - (long) (1e6 * waited);
+      if(left <= 0) {
+        status = x_error(X_TIMEDOUT, ETIMEDOUT, fn, "timed out");
+        break;
+      }
+      if(left < waitMicros) waitMicros = left;
+    }
 
-    interval.tv_sec = sleepMicros / E6;
-    interval.tv_nsec = (sleepMicros % E6) * 1000;
+    // Wake up periodically, even without a signal, to check on the pipeline connection.
+    wake = now;
+    wake.tv_sec += waitMicros / E6;
+    wake.tv_nsec += 1000 * (waitMicros % E6);
+    if(wake.tv_nsec >= E9) {
+      wake.tv_sec++;
+      wake.tv_nsec -= E9;
+    }
 
-    if(nanosleep(&interval, NULL) < 0) return x_error(X_FAILURE, errno, fn, "nanosleep() error");
+    pthread_cond_timedwait(&qDrained, &qLock, &wake);
   }
-  xvprintf("SMA-X> read queue drained, resuming pipelined reads.\n");
 
-  return X_SUCCESS;
+  if(__atomic_sub_fetch(&nDrainWaiting, 1, __ATOMIC_SEQ_CST) == 0) __atomic_store_n(&drainLevel, 0, __ATOMIC_RELAXED);
+
+  clock_gettime(CLOCK_REALTIME, &now);
+  waited = (now.tv_sec - start.tv_sec) + 1e-9 * (now.tv_nsec - start.tv_nsec);
+
+  qStats.stalls++;
+  qStats.stallTime += waited;
+  if(waited > qStats.maxStallTime) qStats.maxStallTime = waited;
+
+  pthread_mutex_unlock(&qLock);
+
+  if(!status) xvprintf("SMA-X> read queue drained, resuming pipelined reads.\n");
+
+  return status;
+}
+
+/**
+ * Processes the response to a grouped (HMGET) pull request, distributing the returned values to the
+ * constituent pull requests.
+ *
+ * \param reply     The RESP array response to HMGET.
+ * \param req       The grouped pull request.
+ *
+ * \return          X_SUCCESS (0) if all values were processed successfully, or else the first error
+ *                  encountered.
+ */
+static int ProcessMultiGetResponse(RESP *reply, PullRequest *req) {
+  PullRequest *sub = (PullRequest *) req->value;
+  RESP **component = (RESP **) reply->value;
+  int i, status = X_SUCCESS;
+
+  if(reply->type != RESP_ARRAY || reply->n != req->count) {
+    for(i = 0; i < req->count; i++) if(sub[i].status) *sub[i].status = X_PARSE_ERROR;
+    return x_error(X_PARSE_ERROR, EBADMSG, "xProcessMultiGetResponse", "unexpected HMGET response for %d fields", req->count);
+  }
+
+  for(i = 0; i < req->count; i++) {
+    int s = smaxProcessReadResponse(component[i], &sub[i]);
+    if(sub[i].status) *sub[i].status = s;
+    if(s && !status) status = s;
+  }
+
+  return status;
 }
 
 /**
@@ -384,19 +873,46 @@ static int DrainQueueAsync(int maxRemaining, int timeoutMicros) {
 static void ProcessPipeResponseAsync(RESP *reply) {
   if(reply->type == RESP_BULK_STRING || reply->type == RESP_ARRAY) {
     static int lastError = 0;
+    QueueSlot *slot;
+    PullRequest *req;
     int status;
 
-    // Peek at the head of the queue (no lock needed as we aren't modifying the queue).
-    PullRequest *req = (PullRequest *) queued.first;
-
     xvprintf("pipe RESP: %s.\n", (char *) reply->value);
 
-    if(req == NULL) {
+    LockConsumer();
+
+    // Skip past any synchronization points, callbacks, or withdrawn requests at the head.
+    Sync();
+
+    // Peek at the head of the queue.
+    slot = PeekHead();
+
+    if(slot == NULL) {
+      UnlockConsumer();
       fprintf(stderr, "ERROR! SMA-X : No pending read request for piped bulk string RESP.\n");
       return;
     }
 
-    status = smaxProcessReadResponse(reply, req);           // parse into the pull request
+    req = &slot->req;
+
+    if(slot->handle) {
+      // Leave the destination untouched if the pull was cancelled or it expired.
+      ExpireIfDue(slot->handle);
+      if(!ClaimPull(slot->handle, PULL_ACTIVE)) {
+        ReleaseHead();
+        Sync();
+        UnlockConsumer();
+        return;
+      }
+    }
+
+    if(req->type == X_HMGET) status = ProcessMultiGetResponse(reply, req);
+    else {
+      status = smaxProcessReadResponse(reply, req);           // parse into the pull request
+      if(req->status) *req->status = status;
+    }
+
+    if(slot->handle) FinishPull(slot->handle, PULL_DONE, status);
 
     if(status) {
       if(status != lastError) fprintf(stderr, "ERROR! SMA-X : piped read value error %d on %s:%s.\n", status, req->group == NULL ? "" : req->group, req->key);
@@ -404,12 +920,28 @@ static void ProcessPipeResponseAsync(RESP *reply) {
     }
     lastError = status;
 
-    RemoveQueueHead();
+    ReleaseHead();
     Sync();
+
+    UnlockConsumer();
   }
   else smaxProcessPipedWritesAsync(reply);
 }
 
+/**
+ * Signals that a synchronization point has been reached.
+ *
+ * \param arg   Pointer to the synchronization point (XSyncPoint *)
+ */
+static void SignalSyncPoint(void *arg) {
+  XSyncPoint *s = (XSyncPoint *) arg;
+
+  pthread_mutex_lock(s->lock);
+  s->status = X_SUCCESS;
+  pthread_cond_broadcast(s->isComplete);
+  pthread_mutex_unlock(s->lock);
+}
+
 /**
  * Processes timely synchronizations, whether callbacks, or synchronization points.
  *
@@ -417,52 +949,102 @@ static void ProcessPipeResponseAsync(RESP *reply) {
 static void Sync() {
   // While the next request is a synchronization point or callback then act on them...
   while(TRUE) {
-    // Peek at the head of the queue (no lock needed as we aren't modifying the queue).
-    PullRequest *req = (PullRequest *) queued.first;
+    // Peek at the head of the queue.
+    QueueSlot *slot = PeekHead();
+    PullRequest *req;
+
+    if(slot == NULL) return;
+
+    req = &slot->req;
+
+    if(__atomic_load_n(&slot->isCancelled, __ATOMIC_ACQUIRE)) {
+      // Withdrawn request, which was never sent...
+      ReleaseHead();
+      continue;
+    }
 
-    if(req == NULL) return;
     if(req->value == NULL) return;
 
     if(req->type == X_SYNCPOINT) {
-      XSyncPoint *s = (XSyncPoint *) req->value;
-      pthread_mutex_lock(s->lock);
-      s->status = X_SUCCESS;
-      pthread_cond_broadcast(s->isComplete);
-      pthread_mutex_unlock(s->lock);
+      // Signal inline, since the waiter may destroy the sync point as soon as the queue is drained.
+      SignalSyncPoint(req->value);
       req->value = NULL;            // Dereference SyncPoint before destroying.
     }
 
     else if(req->type == X_CALLBACK) {
-      void (*f)(char *) = (void (*)(char *)) req->value;
-      f(req->key);
+      void (*f)(void *) = (void (*)(void *)) req->value;
+      if(req->count == CALLBACK_INLINE) f(req->key);
+      else smaxRunCompletion(f, req->key);
       req->key = req->value = NULL;  // Dereference the callback function and argument before destroying.
     }
 
     else return;
 
-    RemoveQueueHead();
+    ReleaseHead();
   }
 }
 
 /**
- *  Discard all piped reads, setting values to zeroes.
+ * Processes the synchronization points, callbacks, and withdrawn requests at the head of the queue, on
+ * behalf of the consumer, after a producer published one, or withdrew a request. The consumer processes
+ * these only after the responses that precede them. So, if there are no more responses to wait for, e.g.
+ * because the entry was published after the last response was processed, or because the request at the
+ * head was withdrawn, the producer must process them itself, or else no one will.
+ *
+ * It is not to be called while holding the pipeline client, since callbacks that run here may queue pulls
+ * themselves. From within a callback, it does nothing, since the consumer loop that is running the callback
+ * will also process the entry in turn.
+ */
+static void SyncFromProducer() {
+  if(isConsumer) return;
+
+  LockConsumer();
+  Sync();
+  UnlockConsumer();
+}
+
+/**
+ *  Discard all piped reads, setting values to zeroes. It is called from the disconnect hook, and
+ *  it is serialized with the processing of pipelined responses, which consume the same queue head.
  *
  */
 static void DiscardQueuedAsync() {
-  PullRequest *p = queued.first;
+  QueueSlot *slot;
   int n = 0;
 
-  while(p != NULL) {
-    PullRequest *next = p->next;
-    smaxDestroyPullRequest(p);
-    p = next;
+  LockConsumer();
+
+  while((slot = PeekHead()) != NULL) {
+    PullRequest *p = &slot->req;
+
+    if(__atomic_load_n(&slot->isCancelled, __ATOMIC_ACQUIRE)) {
+      ReleaseHead();
+      continue;
+    }
+
+    if(p->type == X_HMGET) {
+      PullRequest *sub = (PullRequest *) p->value;
+      int i;
+      for(i = 0; i < p->count; i++) if(sub[i].status) *sub[i].status = X_INTERRUPTED;
+    }
+    else if(p->type == X_CALLBACK) {
+      // Batch completions must be signalled, so the waiting caller can clean up
+      if(p->value == (void *) BatchComplete) BatchComplete(p->key);
+    }
+    else if(p->status) *p->status = X_INTERRUPTED;
+
+    ReleaseHead();
     n++;
   }
 
   queued.status = n > 0 ? X_INTERRUPTED : 0;
-  nQueued = 0;
 
+  UnlockConsumer();
+
+  pthread_mutex_lock(&qLock);
   pthread_cond_broadcast(&qComplete);
+  pthread_cond_broadcast(&qDrained);
+  pthread_mutex_unlock(&qLock);
 }
 
 /**
@@ -493,105 +1075,821 @@ static void DiscardQueuedAsync() {
  *
  */
 int smaxQueue(const char *table, const char *key, XType type, int count, void *value, XMeta *meta) {
-  static const char *fn = "smaxQueue";
-
-  PullRequest *req, *last;
-  int status;
+  prop_error("smaxQueue", QueuePull(table, key, type, count, value, meta, NULL, FALSE));
+  return X_SUCCESS;
+}
 
-  if(table == NULL) return x_error(X_GROUP_INVALID, EINVAL, fn, "table is NULL");
-  if(!table[0]) return x_error(X_GROUP_INVALID, EINVAL, fn, "table is empty");
-  if(key == NULL) return x_error(X_NAME_INVALID, EINVAL, fn, "key is NULL");
-  if(!key[0]) return x_error(X_NAME_INVALID, EINVAL, fn, "key is empty");
-  if(value == NULL) return x_error(X_NULL, EINVAL, fn, "outut value is NULL");
+/**
+ * Same as smaxQueue(), but without copying the table name and key, which therefore must remain
+ * valid until the pull completes, e.g. because they belong to a variable handle.
+ *
+ * \param table     Hash table name (or the aggregate ID for structures).
+ * \param key       Variable name under which the data is stored (ignored for structures).
+ * \param type      SMA-X variable type, e.g. X_FLOAT or X_CHARS(40), of the buffer.
+ * \param count     Number of points to retrieve into the buffer.
+ * \param value     Pointer to the buffer to which the data is to be retrieved.
+ * \param meta      Pointer to the corresponding metadata structure, or NULL.
+ *
+ * \return          X_SUCCESS (0) if successful, or else an error code (&lt;0), as for smaxQueue().
+ *
+ * @sa smaxQueue()
+ */
+int smaxQueueBorrowed(const char *table, const char *key, XType type, int count, void *value, XMeta *meta) {
+  prop_error("smaxQueueBorrowed", QueuePull(table, key, type, count, value, meta, NULL, TRUE));
+  return X_SUCCESS;
+}
 
-  req = (PullRequest *) calloc(1, sizeof(PullRequest));
-  x_check_alloc(req);
+/**
+ * Queues a pull request, optionally with a handle for its deadline and cancellation.
+ *
+ * \param h             (optional) The pull handle, whose reference is taken over by the queue on
+ *                      success, or NULL.
+ * \param isBorrowed    Whether to use the table and key without copying them.
+ *
+ * \return          X_SUCCESS (0) if successful, or else an error code (&lt;0).
+ *
+ * @sa smaxQueue()
+ */
+static int QueuePull(const char *table, const char *key, XType type, int count, void *value, XMeta *meta, XPullHandle *h, boolean isBorrowed) {
+  static const char *fn = "xQueuePull";
 
-  req->group = xStringCopyOf(table);
-  req->key = xStringCopyOf(key);
-  req->value = value;
-  req->type = type;
-  req->count = count;
-  req->meta = meta;
+  Redis *r = smaxGetRedis();
+  RedisClient *cl;
+  QueueSlot *slot;
+  PullRequest *req;
+  int status;
+
+  if(table == NULL) return x_error(X_GROUP_INVALID, EINVAL, fn, "table is NULL");
+  if(!table[0]) return x_error(X_GROUP_INVALID, EINVAL, fn, "table is empty");
+  if(type != X_STRUCT) {
+    if(key == NULL) return x_error(X_NAME_INVALID, EINVAL, fn, "key is NULL");
+    if(!key[0]) return x_error(X_NAME_INVALID, EINVAL, fn, "key is empty");
+  }
+  if(value == NULL) return x_error(X_NULL, EINVAL, fn, "outut value is NULL");
+  if(!r) return smaxError(fn, X_NO_INIT);
+
+  prop_error(fn, InitRing());
 
-  // If the queue is full, then drain it to ~50% capacity...
-  if(nQueued > maxQueued) {
-    status = DrainQueueAsync(maxQueued >> 1, 1000 * SMAX_PIPE_READ_TIMEOUT_MILLIS);
+  // If the queue is full, then act according to the overflow policy...
+  if(GetQueuedCount() > GetQueueLimit()) {
+    if(overflowPolicy == SMAX_QUEUE_FAIL) {
+      CountOverflow(&qStats.rejected);
+      return x_error(X_INCOMPLETE, EAGAIN, fn, "pull queue is full");
+    }
+
+    if(overflowPolicy == SMAX_QUEUE_INTERACTIVE) {
+      CountOverflow(&qStats.redirected);
+      prop_error(fn, smaxPull(table, key, type, count, value, meta));
+      if(h) {
+        if(ClaimPull(h, PULL_DONE)) FinishPull(h, PULL_DONE, X_SUCCESS);
+        ReleasePull(h);
+      }
+      return X_SUCCESS;
+    }
+
+    // Drain it to ~50% capacity...
+    status = DrainQueueAsync(GetQueueLimit() >> 1, 1000 * SMAX_PIPE_READ_TIMEOUT_MILLIS);
     if(status) {
       if(status != X_NO_SERVICE)
-         fprintf(stderr, "ERROR! SMA-X : piped read timed out on %s:%s.\n", (req->group == NULL ? "" : req->group), req->key);
-      free(req);
+         fprintf(stderr, "ERROR! SMA-X : piped read timed out on %s:%s.\n", table, key ? key : "");
       return x_trace(fn, NULL, status);
     }
   }
 
-  pthread_mutex_lock(&qLock);
+  // Queue and send while holding the pipeline client, so the queue order is the same as the
+  // order of requests sent.
+  cl = redisxGetLockedConnectedClient(r, REDISX_PIPELINE_CHANNEL);
+  if(cl == NULL) return x_trace(fn, NULL, X_NO_SERVICE);
 
-  last = queued.last;
-  QueueAsync(req);
+  slot = ReserveSlot();
+  req = &slot->req;
 
-  // Send the pull request to Redis for this queued entry
-  status = smaxRead(req, REDISX_PIPELINE_CHANNEL);
+  if(isBorrowed) {
+    req->group = (char *) table;
+    req->key = (char *) key;
+    slot->isBorrowed = TRUE;
+  }
+  else {
+    SetSlotName(&req->group, table, slot->group, QUEUE_INLINE_GROUP);
+    SetSlotName(&req->key, key, slot->key, QUEUE_INLINE_KEY);
+  }
+  req->value = value;
+  req->type = type;
+  req->count = count;
+  req->meta = meta;
+  slot->handle = h;
 
-  // If the pull request was not submitted to SMA-X, then undo the queuing...
-  if(status) queued.last = last;
+  // Publish before sending, so the response always finds it in the queue.
+  PublishSlot(slot);
 
-  pthread_mutex_unlock(&qLock);
+  // Send the pull request to Redis for this queued entry
+  status = smaxSendReadAsync(cl, req);
 
+  // If the pull request was not submitted to SMA-X, then withdraw it from the queue
+  // (the handle, if any, remains with the caller)...
   if(status) {
-    smaxDestroyPullRequest(req);
-    // smaxZero(req->value, req->type, req->count);
+    slot->handle = NULL;
+    CancelSlot(slot);
   }
 
+  redisxUnlockClient(cl);
+
+  // No response will come for a withdrawn request, so skip past it ourselves if it's at the head.
+  if(status) SyncFromProducer();
+
   prop_error(fn, status);
 
   return X_SUCCESS;
 }
 
 /**
- * Queues a pull request for pipelined retrieval. Apart from retrieving regular variables, the pull
- * request may specify a synchronization point or callback function.
+ * Initializes the deadline of a pull handle.
  *
- * \param req   Pointer to the pull request to queue.
+ */
+static void SetPullDeadline(XPullHandle *h, int timeoutMillis) {
+  if(timeoutMillis <= 0) return;
+
+  clock_gettime(CLOCK_REALTIME, &h->deadline);
+  h->deadline.tv_sec += timeoutMillis / 1000;
+  h->deadline.tv_nsec += E6 * (timeoutMillis % 1000);
+  if(h->deadline.tv_nsec >= E9) {
+    h->deadline.tv_sec++;
+    h->deadline.tv_nsec -= E9;
+  }
+}
+
+/**
+ * Attempts to move a pending pull to the specified state.
  *
- * \return      X_SUCCESS (0)       if successful
- *              or else the  return value of xDrainQueue().
+ * \return      TRUE if the pull was pending and is now in the new state, or else FALSE.
  */
-static void QueueAsync(PullRequest *req) {
-  if(!isQueueInitialized) InitQueueAsync();
+static boolean ClaimPull(XPullHandle *h, int state) {
+  int expected = PULL_PENDING;
+  return __atomic_compare_exchange_n(&h->state, &expected, state, FALSE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
 
-  req->next = NULL;
+/**
+ * Sets the final state and completion status of a pull, and notifies those waiting on it.
+ *
+ */
+static void FinishPull(XPullHandle *h, int state, int status) {
+  pthread_mutex_lock(&h->lock);
+  h->status = status;
+  __atomic_store_n(&h->state, state, __ATOMIC_RELEASE);
+  pthread_cond_broadcast(&h->isComplete);
+  pthread_mutex_unlock(&h->lock);
+}
+
+/**
+ * Releases a reference to a pull handle, destroying it when no longer referenced.
+ *
+ */
+static void ReleasePull(XPullHandle *h) {
+  if(__atomic_sub_fetch(&h->refs, 1, __ATOMIC_ACQ_REL) > 0) return;
+
+  pthread_cond_destroy(&h->isComplete);
+  pthread_mutex_destroy(&h->lock);
+  free(h);
+}
+
+/**
+ * Expires a pending pull with X_TIMEDOUT, if its deadline has passed.
+ *
+ */
+static void ExpireIfDue(XPullHandle *h) {
+  struct timespec now;
+
+  if(!h->deadline.tv_sec) return;
+  if(__atomic_load_n(&h->state, __ATOMIC_ACQUIRE) != PULL_PENDING) return;
+
+  clock_gettime(CLOCK_REALTIME, &now);
+  if(now.tv_sec < h->deadline.tv_sec) return;
+  if(now.tv_sec == h->deadline.tv_sec && now.tv_nsec < h->deadline.tv_nsec) return;
+
+  if(ClaimPull(h, PULL_EXPIRED)) FinishPull(h, PULL_EXPIRED, X_TIMEDOUT);
+}
 
-  // Add the item to the queue.
-  if(queued.last != NULL) ((PullRequest *) queued.last)->next = req;
-  queued.last = req;
-  if(queued.first == NULL) {
-    queued.first = queued.last;
-    queued.status = X_SUCCESS;     // Reset the queue status when starting a new batch of pulls...
+/**
+ * Checks if a pull has reached a final state.
+ *
+ */
+static boolean IsPullFinal(const XPullHandle *h) {
+  int state = __atomic_load_n(&h->state, __ATOMIC_ACQUIRE);
+  return state != PULL_PENDING && state != PULL_ACTIVE;
+}
+
+/**
+ * Same as smaxQueue(), but with a deadline, and returning a handle, through which the pull may be
+ * monitored, waited on, or cancelled. If the response does not arrive by the deadline, the pull is
+ * completed with X_TIMEDOUT, and the destination buffer (and metadata) is left untouched, even if
+ * the response arrives later. Similarly, cancelled pulls leave the destination untouched. As such,
+ * real-time code may bound its latency, without having to discard the entire pipeline queue.
+ *
+ * Once the handle is no longer needed, it should be destroyed via smaxDestroyPullHandle().
+ *
+ * \param table           Hash table name.
+ * \param key             Variable name under which the data is stored.
+ * \param type            SMA-X variable type, e.g. X_FLOAT or X_CHARS(40), of the buffer.
+ * \param count           Number of points to retrieve into the buffer.
+ * \param[out] value      Pointer to the buffer to which the data is to be retrieved.
+ * \param[out] meta       (optional) Pointer to the corresponding metadata structure, or NULL.
+ * \param timeoutMillis   [ms] Time allowed for the pull to complete, or &lt;=0 for no deadline.
+ * \param[out] handle     Pointer to where the handle of the queued pull is returned. It is set to
+ *                        NULL if the pull could not be queued.
+ *
+ * \return      X_SUCCESS (0) if the pull was queued, or else an error code (&lt;0), as for
+ *              smaxQueue().
+ *
+ * @sa smaxQueue()
+ * @sa smaxGetPullStatus()
+ * @sa smaxWaitPull()
+ * @sa smaxCancelPull()
+ * @sa smaxDestroyPullHandle()
+ */
+int smaxQueueWithDeadline(const char *table, const char *key, XType type, int count, void *value, XMeta *meta, int timeoutMillis, XPullHandle **handle) {
+  static const char *fn = "smaxQueueWithDeadline";
+
+  XPullHandle *h;
+  int status;
+
+  if(handle == NULL) return x_error(X_NULL, EINVAL, fn, "output handle is NULL");
+  *handle = NULL;
+
+  h = (XPullHandle *) calloc(1, sizeof(XPullHandle));
+  x_check_alloc(h);
+
+  pthread_mutex_init(&h->lock, NULL);
+  pthread_cond_init(&h->isComplete, NULL);
+  h->status = X_INCOMPLETE;
+  h->refs = 2;      // One for the caller, and one for the queue
+  SetPullDeadline(h, timeoutMillis);
+
+  status = QueuePull(table, key, type, count, value, meta, h, FALSE);
+  if(status) {
+    ReleasePull(h);
+    ReleasePull(h);
+    return x_trace(fn, NULL, status);
   }
 
-  nQueued++;
+  *handle = h;
+  return X_SUCCESS;
 }
 
-static void RemoveQueueHead() {
-  PullRequest *req = NULL;
+/**
+ * Returns the current status of a queued pull, without waiting. If the pull's deadline has passed
+ * without a response, it is expired by this call.
+ *
+ * \param h     The handle of the queued pull.
+ *
+ * \return      X_INCOMPLETE if the pull is still pending, X_SUCCESS (0) if it was completed
+ *              successfully, X_TIMEDOUT if it expired, X_INTERRUPTED if it was cancelled or
+ *              discarded, or else the error from processing the response (&lt;0).
+ *
+ * @sa smaxQueueWithDeadline()
+ * @sa smaxWaitPull()
+ */
+int smaxGetPullStatus(XPullHandle *h) {
+  if(!h) return x_error(X_NULL, EINVAL, "smaxGetPullStatus", "handle is NULL");
 
-  pthread_mutex_lock(&qLock);
+  ExpireIfDue(h);
+  if(!IsPullFinal(h)) return X_INCOMPLETE;
+
+  return h->status;
+}
 
-  if(queued.first != NULL) {
-    req = queued.first;
-    queued.first = req->next;
+/**
+ * Waits until a queued pull completes, is cancelled, or its deadline passes, whichever comes first.
+ *
+ * \param h     The handle of the queued pull.
+ *
+ * \return      The final status of the pull, as returned by smaxGetPullStatus(), e.g. X_SUCCESS (0)
+ *              or X_TIMEDOUT.
+ *
+ * @sa smaxQueueWithDeadline()
+ * @sa smaxGetPullStatus()
+ */
+int smaxWaitPull(XPullHandle *h) {
+  static const char *fn = "smaxWaitPull";
 
-    if(queued.first == NULL) {
-      queued.last = NULL;
-      nQueued = 0;
-      pthread_cond_broadcast(&qComplete);
+  if(!h) return x_error(X_NULL, EINVAL, fn, "handle is NULL");
+
+  pthread_mutex_lock(&h->lock);
+
+  while(!IsPullFinal(h)) {
+    int state = __atomic_load_n(&h->state, __ATOMIC_ACQUIRE);
+
+    if(h->deadline.tv_sec && state == PULL_PENDING) {
+      if(pthread_cond_timedwait(&h->isComplete, &h->lock, &h->deadline) == ETIMEDOUT) {
+        pthread_mutex_unlock(&h->lock);
+        ExpireIfDue(h);
+        pthread_mutex_lock(&h->lock);
+      }
     }
-    else nQueued--;
+    else pthread_cond_wait(&h->isComplete, &h->lock);
   }
 
-  pthread_mutex_unlock(&qLock);
+  pthread_mutex_unlock(&h->lock);
 
-  if(req != NULL) smaxDestroyPullRequest(req);
+  prop_error(fn, h->status);
+  return X_SUCCESS;
+}
+
+/**
+ * Cancels a queued pull, if it has not completed yet. The destination buffer (and metadata) of a
+ * cancelled pull is left untouched, and its status becomes X_INTERRUPTED.
+ *
+ * \param h     The handle of the queued pull.
+ *
+ * \return      X_SUCCESS (0) if the pull was cancelled, or else X_FAILURE if it has already
+ *              completed, expired, or its response is being processed.
+ *
+ * @sa smaxQueueWithDeadline()
+ */
+int smaxCancelPull(XPullHandle *h) {
+  static const char *fn = "smaxCancelPull";
+
+  if(!h) return x_error(X_NULL, EINVAL, fn, "handle is NULL");
+  if(!ClaimPull(h, PULL_CANCELLED)) return x_error(X_FAILURE, EALREADY, fn, "pull is no longer pending");
+
+  FinishPull(h, PULL_CANCELLED, X_INTERRUPTED);
+  return X_SUCCESS;
+}
+
+/**
+ * Destroys the caller's handle to a queued pull. If the pull is still pending, it will continue
+ * in the background (and may still update the destination buffer), unless it was cancelled first.
+ *
+ * \param h     The handle of the queued pull.
+ *
+ * @sa smaxQueueWithDeadline()
+ * @sa smaxCancelPull()
+ */
+void smaxDestroyPullHandle(XPullHandle *h) {
+  if(h) ReleasePull(h);
+}
+
+static void ReleaseBatchSync(BatchSync *b) {
+  boolean destroy;
+
+  pthread_mutex_lock(&b->lock);
+  destroy = (--b->refs <= 0);
+  pthread_mutex_unlock(&b->lock);
+
+  if(destroy) {
+    pthread_cond_destroy(&b->isComplete);
+    pthread_mutex_destroy(&b->lock);
+    free(b);
+  }
+}
+
+static void BatchComplete(void *arg) {
+  BatchSync *b = (BatchSync *) arg;
+
+  pthread_mutex_lock(&b->lock);
+  b->done = TRUE;
+  pthread_cond_broadcast(&b->isComplete);
+  pthread_mutex_unlock(&b->lock);
+
+  ReleaseBatchSync(b);
+}
+
+/**
+ * Waits for a queued batch of pulls to complete.
+ *
+ * \param b                 The completion signal of the batch.
+ * \param timeoutMillis     [ms] Maximum time to wait, or &lt;=0 to wait indefinitely.
+ *
+ * \return      X_SUCCESS (0) if the batch completed, or else X_TIMEDOUT or X_INTERRUPTED.
+ */
+static int WaitBatch(BatchSync *b, int timeoutMillis) {
+  static const char *fn = "xWaitBatch";
+
+  struct timespec end;
+  int status = X_SUCCESS;
+
+  if(timeoutMillis > 0) {
+    clock_gettime(CLOCK_REALTIME, &end);
+    end.tv_sec += timeoutMillis / 1000;
+    end.tv_nsec += E6 * (timeoutMillis % 1000);
+    if(end.tv_nsec >= E9) {
+      end.tv_sec++;
+      end.tv_nsec -= E9;
+    }
+  }
+
+  pthread_mutex_lock(&b->lock);
+
+  while(!b->done) {
+    struct timespec poll;
+    boolean isFinal = FALSE;
+
+    // Wake up every second to check if the queue has been discarded in the meantime
+    clock_gettime(CLOCK_REALTIME, &poll);
+    poll.tv_sec++;
+
+    if(timeoutMillis > 0) if(end.tv_sec < poll.tv_sec || (end.tv_sec == poll.tv_sec && end.tv_nsec <= poll.tv_nsec)) {
+      poll = end;
+      isFinal = TRUE;
+    }
+
+    if(pthread_cond_timedwait(&b->isComplete, &b->lock, &poll) != ETIMEDOUT) isFinal = FALSE;
+    if(b->done) break;
+
+    if(IsQueueEmpty()) {
+      status = x_error(X_INTERRUPTED, ECONNRESET, fn, "pipeline queue was discarded");
+      break;
+    }
+
+    if(isFinal) {
+      status = x_error(X_TIMEDOUT, ETIMEDOUT, fn, "timed out waiting for batch");
+      break;
+    }
+  }
+
+  pthread_mutex_unlock(&b->lock);
+
+  return status;
+}
+
+/**
+ * Checks whether a batch item is a simple value (no metadata, no structure), which can be pulled
+ * together with other values from the same table in a single HMGET request.
+ *
+ * \param item      The batch item
+ *
+ * \return          TRUE (1) if the item can be grouped with others, otherwise FALSE (0).
+ */
+static boolean IsGroupable(const XPullItem *item) {
+  if(item->meta != NULL) return FALSE;
+  if(item->type == X_STRUCT) return FALSE;
+  return TRUE;
+}
+
+/**
+ * Validates a batch pull item, setting its status accordingly.
+ *
+ * \param item      The batch item
+ *
+ * \return          X_SUCCESS (0) if the item is valid, or else an error code (&lt;0).
+ */
+static int CheckPullItem(XPullItem *item) {
+  static const char *fn = "smaxPullBatch";
+
+  item->status = X_INCOMPLETE;
+
+  if(item->table == NULL) item->status = x_error(X_GROUP_INVALID, EINVAL, fn, "table is NULL");
+  else if(!item->table[0]) item->status = x_error(X_GROUP_INVALID, EINVAL, fn, "table is empty");
+  else if(item->type != X_STRUCT && item->key == NULL) item->status = x_error(X_NAME_INVALID, EINVAL, fn, "key is NULL");
+  else if(item->type != X_STRUCT && !item->key[0]) item->status = x_error(X_NAME_INVALID, EINVAL, fn, "key is empty");
+  else if(item->value == NULL) item->status = x_error(X_NULL, EINVAL, fn, "output value is NULL");
+  else if(item->type == X_FIELD) item->status = x_error(X_TYPE_INVALID, EINVAL, fn, "X_FIELD is not supported in batch pulls");
+
+  return item->status == X_INCOMPLETE ? X_SUCCESS : item->status;
+}
+
+/**
+ * Creates a regular (non-grouped) pull request for a batch item.
+ *
+ * \param item      The batch item
+ *
+ * \return          The new pull request, or NULL if there was an error.
+ */
+static PullRequest *CreateItemRequest(XPullItem *item) {
+  PullRequest *req = (PullRequest *) calloc(1, sizeof(PullRequest));
+  x_check_alloc(req);
+
+  if(item->type == X_STRUCT) {
+    // Make sure structures are retrieved all the same no matter how their names are split
+    req->group = xGetAggregateID(item->table, item->key);
+    if(!req->group) {
+      free(req);
+      item->status = x_trace("smaxPullBatch", NULL, X_NULL);
+      return NULL;
+    }
+  }
+  else {
+    req->group = xStringCopyOf(item->table);
+    req->key = xStringCopyOf(item->key);
+  }
+
+  req->value = item->value;
+  req->type = item->type;
+  req->count = item->count;
+  req->meta = item->meta;
+  req->status = &item->status;
+
+  return req;
+}
+
+/**
+ * Creates a grouped (HMGET) pull request for simple values in the same table.
+ *
+ * \param items     The batch items
+ * \param idx       Array of indices of the items to group.
+ * \param n         Number of items to group.
+ *
+ * \return          The new grouped pull request.
+ */
+static PullRequest *CreateGroupRequest(XPullItem *items, const int *idx, int n) {
+  PullRequest *req = (PullRequest *) calloc(1, sizeof(PullRequest)), *sub;
+  int i;
+
+  x_check_alloc(req);
+
+  sub = (PullRequest *) calloc(n, sizeof(PullRequest));
+  x_check_alloc(sub);
+
+  req->type = X_HMGET;
+  req->group = xStringCopyOf(items[idx[0]].table);
+  req->value = sub;
+  req->count = n;
+
+  for(i = 0; i < n; i++) {
+    XPullItem *item = &items[idx[i]];
+    sub[i].group = req->group;
+    sub[i].key = xStringCopyOf(item->key);
+    sub[i].value = item->value;
+    sub[i].type = item->type;
+    sub[i].count = item->count;
+    sub[i].status = &item->status;
+  }
+
+  return req;
+}
+
+/**
+ * Sets the completion status of a (possibly grouped) pull request.
+ *
+ * \param req       The pull request
+ * \param status    The status to set.
+ */
+static void SetRequestStatus(const PullRequest *req, int status) {
+  if(req->type == X_HMGET) {
+    const PullRequest *sub = (const PullRequest *) req->value;
+    int j;
+    for(j = 0; j < req->count; j++) if(sub[j].status) *sub[j].status = status;
+  }
+  else if(req->status) *req->status = status;
+}
+
+/**
+ * Pulls a batch of variables in a single pipelined round-trip, and waits until all of them have been
+ * retrieved, or until the specified timeout. Simple values (without metadata) residing in the same
+ * hash table are retrieved together via a single HMGET request, while structures and values with
+ * metadata are retrieved individually. All requests in the batch are sent in one go on the pipeline
+ * channel, so the batch takes about as long as a single round-trip to the server, plus the time to
+ * process the responses. If the pipeline is not enabled, the items are pulled one by one on the
+ * interactive channel instead.
+ *
+ * Each item's status field is set to indicate the outcome of its pull: X_SUCCESS (0), X_INCOMPLETE
+ * if it has not (yet) completed, or else an error code (&lt;0). Because the items may be updated after
+ * the call returns if it has timed out, the items (and the value buffers they point to) must remain
+ * valid until the queue completes, e.g. by calling smaxWaitQueueComplete(), in case of a timeout.
+ *
+ * \param[in,out] items     Array of items to pull. Their status fields are set upon return.
+ * \param n                 Number of items in the array.
+ * \param timeoutMillis     [ms] Maximum time to wait for the batch to complete, or &lt;=0 to wait
+ *                          indefinitely.
+ *
+ * \return      X_SUCCESS (0)       if all items were pulled successfully, or
+ *              X_NULL              if the items argument is NULL,
+ *              X_SIZE_INVALID      if n is not positive,
+ *              X_TIMEDOUT          if the batch did not complete within the timeout period,
+ *              X_INTERRUPTED       if the pipeline was disconnected while waiting,
+ *              or else the first error among the items.
+ *
+ * @sa smaxPull()
+ * @sa smaxQueue()
+ */
+int smaxPullBatch(XPullItem *items, int n, int timeoutMillis) {
+  static const char *fn = "smaxPullBatch";
+
+  PullRequest **reqs;
+  BatchSync *b;
+  RedisClient *cl;
+  boolean *isAssigned, isQueued = FALSE;
+  int *idx, i, nreq = 0, status = X_SUCCESS;
+
+  if(items == NULL) return x_error(X_NULL, EINVAL, fn, "items is NULL");
+  if(n < 1) return x_error(X_SIZE_INVALID, EINVAL, fn, "invalid number of items: %d", n);
+
+  if(!smaxIsPipelined()) {
+    // Without pipeline, just pull items one at a time...
+    for(i = 0; i < n; i++) {
+      XPullItem *item = &items[i];
+      item->status = smaxPull(item->table, item->key, item->type, item->count, item->value, item->meta);
+      if(item->status && !status) status = item->status;
+    }
+    prop_error(fn, status);
+    return X_SUCCESS;
+  }
+
+  reqs = (PullRequest **) calloc(n, sizeof(PullRequest *));
+  x_check_alloc(reqs);
+
+  idx = (int *) calloc(n, sizeof(int));
+  x_check_alloc(idx);
+
+  isAssigned = (boolean *) calloc(n, sizeof(boolean));
+  x_check_alloc(isAssigned);
+
+  for(i = 0; i < n; i++) CheckPullItem(&items[i]);
+
+  // Group simple values by table, and create individual requests for the rest.
+  for(i = 0; i < n; i++) {
+    XPullItem *item = &items[i];
+    int j, m = 0;
+
+    if(isAssigned[i] || item->status != X_INCOMPLETE) continue;
+
+    if(IsGroupable(item)) for(j = i; j < n; j++) {
+      XPullItem *other = &items[j];
+      if(isAssigned[j] || other->status != X_INCOMPLETE || !IsGroupable(other)) continue;
+      if(strcmp(other->table, item->table) != 0) continue;
+      isAssigned[j] = TRUE;
+      idx[m++] = j;
+    }
+
+    reqs[nreq] = (m > 1) ? CreateGroupRequest(items, idx, m) : CreateItemRequest(item);
+    if(reqs[nreq]) nreq++;
+  }
+
+  free(isAssigned);
+  free(idx);
+
+  if(nreq == 0) {
+    free(reqs);
+    for(i = 0; i < n; i++) if(items[i].status) return x_trace(fn, NULL, items[i].status);
+    return X_SUCCESS;
+  }
+
+  b = (BatchSync *) calloc(1, sizeof(BatchSync));
+  x_check_alloc(b);
+  pthread_mutex_init(&b->lock, NULL);
+  pthread_cond_init(&b->isComplete, NULL);
+  b->refs = 2;
+
+  status = InitRing();
+
+  // Make room in the queue as necessary (batches fall back to blocking under the interactive policy)...
+  if(!status) {
+    int limit = GetQueueLimit();
+    if(GetQueuedCount() + nreq > limit) {
+      if(overflowPolicy == SMAX_QUEUE_FAIL) {
+        CountOverflow(&qStats.rejected);
+        status = x_error(X_INCOMPLETE, EAGAIN, fn, "pull queue is full");
+      }
+      else status = DrainQueueAsync(nreq < limit ? limit - nreq : 0, 1000 * SMAX_PIPE_READ_TIMEOUT_MILLIS);
+    }
+  }
+
+  if(!status) {
+    cl = redisxGetLockedConnectedClient(smaxGetRedis(), REDISX_PIPELINE_CHANNEL);
+    if(cl == NULL) status = x_trace(fn, NULL, X_NO_SERVICE);
+    else {
+      QueueSlot *slot;
+
+      // Queue and send all requests in one go, while holding the pipeline client
+      for(i = 0; i < nreq; i++) {
+        slot = ReserveSlot();
+        slot->req = *reqs[i];       // The slot takes over the request's resources
+        free(reqs[i]);
+        reqs[i] = NULL;
+
+        PublishSlot(slot);
+
+        status = SendPullAsync(cl, &slot->req);
+        if(status) {
+          SetRequestStatus(&slot->req, status);
+          CancelSlot(slot);
+          break;
+        }
+      }
+
+      if(i > 0) {
+        // Signal completion once the sent part of the batch has been processed
+        slot = ReserveSlot();
+        slot->req.type = X_CALLBACK;
+        slot->req.value = BatchComplete;
+        slot->req.key = (char *) b;
+        slot->req.count = CALLBACK_INLINE;
+        PublishSlot(slot);
+
+        isQueued = TRUE;
+      }
+
+      redisxUnlockClient(cl);
+
+      // Withdrawn requests get no response, so skip past them (and what follows them) as need be.
+      SyncFromProducer();
+    }
+  }
+
+  // Requests that were not sent will not complete...
+  for(i = 0; i < nreq; i++) if(reqs[i]) {
+    SetRequestStatus(reqs[i], status);
+    DestroyQueuedRequest(reqs[i]);
+  }
+
+  free(reqs);
+
+  if(isQueued) {
+    int waitStatus = WaitBatch(b, timeoutMillis);
+    if(!status) status = waitStatus;
+  }
+  else ReleaseBatchSync(b);     // The completion callback was never queued.
+
+  ReleaseBatchSync(b);
+
+  prop_error(fn, status);
+
+  for(i = 0; i < n; i++) if(items[i].status) return x_trace(fn, NULL, items[i].status);
+  return X_SUCCESS;
+}
+
+/**
+ * Releases the slot at the head of the queue, and advances the head to the next slot. If the queue
+ * becomes empty, waiters for the queue completion are notified. Only the consumer may call this, while
+ * holding the consumer lock.
+ *
+ */
+static void ReleaseHead() {
+  unsigned long head = queued.head;
+  QueueSlot *slot = &queued.slots[head & (queued.size - 1)];
+
+  ClearSlot(slot);
+
+  // Make the slot available to producers for the next round.
+  __atomic_store_n(&slot->seq, head + queued.size, __ATOMIC_RELEASE);
+  __atomic_store_n(&queued.head, head + 1, __ATOMIC_SEQ_CST);
+
+  if(head + 1 == __atomic_load_n(&queued.tail, __ATOMIC_ACQUIRE)) {
+    pthread_mutex_lock(&qLock);
+    pthread_cond_broadcast(&qComplete);
+    pthread_cond_broadcast(&qDrained);
+    pthread_mutex_unlock(&qLock);
+  }
+  else if(__atomic_load_n(&nDrainWaiting, __ATOMIC_SEQ_CST) > 0) {
+    // Wake producers waiting for the queue to drain, once it reached the desired level.
+    if(GetQueuedCount() <= __atomic_load_n(&drainLevel, __ATOMIC_RELAXED)) {
+      pthread_mutex_lock(&qLock);
+      pthread_cond_broadcast(&qDrained);
+      pthread_mutex_unlock(&qLock);
+    }
+  }
+}
+
+/**
+ * Destroys a queued pull request, including the constituent requests of grouped pulls.
+ *
+ * \param req   The queued pull request to destroy.
+ */
+static void DestroyQueuedRequest(PullRequest *req) {
+  if(req->type == X_HMGET) {
+    PullRequest *sub = (PullRequest *) req->value;
+    int i;
+
+    for(i = 0; i < req->count; i++) if(sub[i].key) free(sub[i].key);
+    free(sub);
+    req->value = NULL;
+  }
+
+  smaxDestroyPullRequest(req);
+}
+
+/**
+ * Sends a queued pull request on the pipeline client, which the caller has locked for exclusive access.
+ *
+ * \param cl    The locked pipeline client
+ * \param req   The pull request to send
+ *
+ * \return      X_SUCCESS (0) if successful, or else an error code (&lt;0).
+ */
+static int SendPullAsync(RedisClient *cl, const PullRequest *req) {
+  static const char *fn = "xSendPullAsync";
+
+  const PullRequest *sub;
+  const char **args;
+  int i, status;
+
+  if(req->type != X_HMGET) {
+    prop_error(fn, smaxSendReadAsync(cl, req));
+    return X_SUCCESS;
+  }
+
+  sub = (const PullRequest *) req->value;
+
+  args = (const char **) calloc(req->count + 2, sizeof(char *));
+  x_check_alloc(args);
+
+  args[0] = "HMGET";
+  args[1] = req->group;
+  for(i = 0; i < req->count; i++) args[i + 2] = sub[i].key;
+
+  status = redisxSendArrayRequestAsync(cl, args, NULL, req->count + 2);
+  free(args);
+
+  prop_error(fn, status);
+  return X_SUCCESS;
 }
 
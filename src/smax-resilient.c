@@ -32,10 +32,10 @@
 typedef struct PushRequest {
   char *group;
   XField *field;
-  struct PushRequest *next;
+  unsigned long long hash;
 } PushRequest;
 
-static PushRequest *table[SMAX_LOOKUP_SIZE];
+static HashIndex *table;
 static pthread_mutex_t tableLock = PTHREAD_MUTEX_INITIALIZER;
 
 static void SendStoredPushRequests();
@@ -162,7 +162,8 @@ int smaxStorePush(const char *group, const XField *field) {
  * @sa smaxSetResilientExit()
  */
 static void SendStoredPushRequests() {
-  int i;
+  void **list;
+  int i, n;
 
   pthread_mutex_lock(&tableLock);
 
@@ -176,23 +177,28 @@ static void SendStoredPushRequests() {
   // Don't push failed writes back to the store...
   resilient = FALSE;
 
-  for(i=SMAX_LOOKUP_SIZE; --i >= 0; ) while(table[i]) {
-    PushRequest *req = table[i];
+  list = smaxHashItems(table, &n);
+
+  for(i = 0; i < n; i++) {
+    PushRequest *req = (PushRequest *) list[i];
 
     int status = smaxWrite(req->group, req->field);
     if(status) {
       resilient = TRUE;
       pthread_mutex_unlock(&tableLock);
+      free(list);
       fprintf(stderr, "SMA-X> WARNING! Not all accumulated shares were sent. Will try again...\n");
       return;
     }
 
     nPending--;
 
-    table[i] = req->next;
+    smaxHashRemove(table, req->hash, req);
     DestroyPushRequest(req);
   }
 
+  if(list) free(list);
+
   if(exitAfterSync) {
     fprintf(stderr, "SMA-X> WARNING! Exiting because of prior connection error(s). All local updates were propagated to SMA-X.\n");
     exit(X_FAILURE);
@@ -204,38 +210,56 @@ static void SendStoredPushRequests() {
   pthread_mutex_unlock(&tableLock);
 }
 
+/**
+ * Checks if a stored push request is for the specified field.
+ *
+ */
+static boolean IsRequestFor(const void *item, const void *arg) {
+  const PushRequest *req = (const PushRequest *) item;
+  const PushRequest *ref = (const PushRequest *) arg;
+
+  return !strcmp(req->group, ref->group) && !strcmp(req->field->name, ref->field->name);
+}
+
 /**
  * IMPORTANT: Do not call with structure...
  *
  */
 static void UpdatePushRequest(const char *group, const XField *field) {
-  PushRequest *req;
-  int idx = smaxGetHashLookupIndex(group, 0, field->name, 0);
+  PushRequest *req, ref = { (char *) group, (XField *) field, 0 };
+  unsigned long long hash = smaxHashID(group, 0, field->name, 0);
 
   pthread_mutex_lock(&tableLock);
 
-  for(req = table[idx]; req != NULL; req = req->next)
-  if(!strcmp(req->group, group)) if(!strcmp(req->field->name, field->name)) break;
+  if(!table) table = smaxCreateHashIndex();
+
+  req = (PushRequest *) smaxHashFind(table, hash, IsRequestFor, &ref);
 
   if(req == NULL) {
     req = (PushRequest *) calloc(1, sizeof(PushRequest));
     x_check_alloc(req);
 
     req->group = xStringCopyOf(group);
+    req->hash = hash;
     req->field = (XField *) calloc(1, sizeof(XField));
     x_check_alloc(req->field);
 
-    if(table[idx] == NULL) table[idx] = req;
-    else {
-      req->next = table[idx];
-      table[idx] = req;
-    }
+    smaxHashAdd(table, hash, req);
 
     nPending++;
   }
 
   memcpy(req->field, field, sizeof(XField));
-  req->field->value = xStringCopyOf(field->value);
+
+  if(field->value != NULL && smaxGetBinaryType(field->value, smaxGetSerializedSize(field)) != X_UNKNOWN) {
+    // Binary encoded values are copied by length...
+    int n = smaxGetSerializedSize(field);
+    req->field->value = (char *) malloc(n + 1);
+    x_check_alloc(req->field->value);
+    memcpy(req->field->value, field->value, n);
+    req->field->value[n] = '\0';
+  }
+  else req->field->value = xStringCopyOf(field->value);
 
   pthread_mutex_unlock(&tableLock);
 }
@@ -0,0 +1,904 @@
+/**
+ * \file
+ *
+ * \date Oct 16, 2026
+ * \author Attila Kovacs
+ *
+ * \brief
+ *      A host-local, shared-memory mirror of the lazy cache, so that many processes on the same host can share
+ *      the cached variables of a single process, rather than each subscribing to, and pulling, the same data
+ *      separately. One process maintains the lazy cache as usual (see smax-lazy.c), and publishes the current
+ *      serialized data, and metadata, of its cached variables into a POSIX shared-memory segment (see
+ *      smaxShareLazyCache()). Other processes attach to the segment read-only (see smaxAttachLazyCache()), after
+ *      which smaxGetCached() serves the variables in the mirror directly from shared memory.
+ *
+ *      The segment holds an open-addressing hash table of fixed-size slots, indexed by the same variable hashes
+ *      as the lazy cache, and a data area for the serialized values. Readers do not lock, and never write to the
+ *      segment. Instead, each slot has a sequence counter, which is odd while the slot is being modified, and
+ *      the segment as a whole has another, for when the data area is compacted. Readers copy the data out, and
+ *      retry if either counter changed in the meantime.
+ *
+ *      Variables that are not in the mirror are cached locally by the reader, as usual. Variables that are in
+ *      the mirror, but are not current (e.g. because an update is in flight), are pulled from SMA-X directly.
+ *      Structures are not mirrored. Readers also stop using the mirror if the process that maintains it is no
+ *      longer running, which they check periodically.
+ *
+ *      \sa smaxShareLazyCache()
+ *      \sa smaxAttachLazyCache()
+ */
+
+#define _POSIX_C_SOURCE 200809L   ///< for shm_open(), ftruncate(), pread(), clock_gettime()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "smax-private.h"
+
+/// \cond PRIVATE
+
+#define SHM_MAGIC                   0x534d4158  ///< 'SMAX'
+#define SHM_VERSION                 1           ///< Layout version of the shared-memory segment
+#define SHM_DEFAULT_NAME            "/smax-lazy" ///< Default name of the shared-memory segment
+#define SHM_DEFAULT_SLOTS           4096        ///< Default number of variable slots
+#define SHM_DEFAULT_BYTES           (16L << 20) ///< [bytes] Default size of the data area.
+#define SHM_ID_LENGTH               256         ///< Maximum length of mirrored variable IDs (including termination).
+#define SHM_ALIGN                   16          ///< [bytes] Alignment of data in the data area.
+#define SHM_MAX_LOAD                0.75        ///< Maximum fraction of slots used (incl. deleted) before compacting.
+#define SHM_STACK_BYTES             256         ///< [bytes] Values up to this size are copied out to the stack.
+#define MAX_MIRROR_ATTEMPTS         1000        ///< Maximum number of attempts to read a consistent slot.
+#define SHM_OWNER_CHECK_MILLIS      1000        ///< [ms] Interval at which readers check that the owner is still running.
+
+#define SLOT_EMPTY                  0           ///< The slot was never used (ends probing)
+#define SLOT_USED                   1           ///< The slot holds a variable
+#define SLOT_DELETED                2           ///< The slot held a variable that was removed (continues probing)
+
+/**
+ * The header of the shared-memory segment.
+ */
+typedef struct {
+  unsigned int magic;           ///< SHM_MAGIC
+  unsigned int version;         ///< SHM_VERSION
+  unsigned int seq;             ///< Sequence counter, which is odd while the segment is being compacted.
+  int isActive;                 ///< Whether the segment is being maintained
+  pid_t owner;                  ///< The process that maintains the segment
+  int nSlots;                   ///< Number of slots (a power of 2)
+  long dataSize;                ///< [bytes] Size of the data area.
+  long used;                    ///< [bytes] Allocated part of the data area.
+  int count;                    ///< Number of used slots
+  int deleted;                  ///< Number of deleted slots
+} ShmHeader;
+
+/**
+ * A mirrored variable.
+ */
+typedef struct {
+  unsigned int seq;             ///< Sequence counter, which is odd while the slot is being modified.
+  int state;                    ///< SLOT_EMPTY, SLOT_USED, or SLOT_DELETED
+  unsigned long long hash;      ///< The variable's hash, from smaxHashID()
+  int isCurrent;                ///< Whether the data is current
+  int hasMeta;                  ///< Whether the metadata is valid
+  int length;                   ///< [bytes] Length of the serialized data (including termination).
+  int capacity;                 ///< [bytes] Space allocated for the data.
+  long offset;                  ///< [bytes] Offset of the data in the data area.
+  XMeta meta;                   ///< The variable's metadata
+  char id[SHM_ID_LENGTH];       ///< The aggregate ID of the variable, i.e. "table:key"
+} ShmSlot;
+
+/**
+ * A mapping of the shared-memory segment into this process.
+ */
+typedef struct {
+  char *name;                   ///< The name of the shared-memory segment
+  boolean isOwner;              ///< Whether we maintain the segment
+  size_t size;                  ///< [bytes] Size of the mapping
+  ShmHeader *header;            ///< The segment header
+  ShmSlot *slots;               ///< The slots
+  char *data;                   ///< The data area
+  long lastCheck;               ///< [ms] (atomic) Monotonic time when a reader last checked if the owner is running
+  int isOwnerAlive;             ///< (atomic) Whether the owner was running when last checked
+} ShmMirror;
+
+/// \endcond
+
+static ShmMirror *mirror;       ///< The mapped mirror, or NULL -- change with mirrorLock only!
+static pthread_mutex_t mirrorLock = PTHREAD_MUTEX_INITIALIZER; ///< Serializes changes to the mirror (and attaching / detaching).
+
+/**
+ * Marks the start of changes to a slot, for lock-free readers. The mirrorLock must be held.
+ *
+ * @param s     Pointer to the slot
+ */
+static __inline__ void BeginSlotWrite(ShmSlot *s) {
+  __atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static __inline__ void EndSlotWrite(ShmSlot *s) {
+  __atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Returns the size of the segment for the given number of slots and data area.
+ *
+ * @param nSlots    Number of slots
+ * @param bytes     [bytes] Size of the data area.
+ * @return          [bytes] The total size of the segment.
+ */
+static size_t GetSegmentSize(int nSlots, long bytes) {
+  return sizeof(ShmHeader) + (size_t) nSlots * sizeof(ShmSlot) + (size_t) bytes;
+}
+
+/**
+ * Creates a process-local mapping of a shared-memory segment.
+ *
+ * @param name      The name of the segment
+ * @param fd        The file descriptor of the segment, from shm_open().
+ * @param size      [bytes] Size of the segment.
+ * @param isOwner   Whether we maintain the segment (and map it read-write).
+ * @return          The new mapping, or NULL if there was an error (errno is set to indicate the type of error).
+ */
+static ShmMirror *MapSegment(const char *name, int fd, size_t size, boolean isOwner) {
+  ShmMirror *m;
+  void *base;
+
+  base = mmap(NULL, size, isOwner ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+  if(base == MAP_FAILED) return NULL;
+
+  m = (ShmMirror *) calloc(1, sizeof(ShmMirror));
+  x_check_alloc(m);
+
+  m->name = xStringCopyOf(name);
+  m->isOwner = isOwner;
+  m->size = size;
+  m->header = (ShmHeader *) base;
+  m->slots = (ShmSlot *) (m->header + 1);
+  m->data = (char *) (m->slots + m->header->nSlots);
+  m->lastCheck = -SHM_OWNER_CHECK_MILLIS;
+  m->isOwnerAlive = TRUE;
+
+  return m;
+}
+
+/**
+ * Unmaps the shared-memory segment, and destroys the mapping, after no more readers can be accessing it.
+ *
+ * @param p     Pointer to the mapping (ShmMirror *).
+ */
+static void DestroyMirror(void *p) {
+  ShmMirror *m = (ShmMirror *) p;
+
+  if(!m) return;
+
+  munmap(m->header, m->size);
+  if(m->name) free(m->name);
+  free(m);
+}
+
+/**
+ * Returns the canonical (POSIX) name for a shared-memory segment, with a leading '/'.
+ *
+ * @param name    The user-supplied name, or NULL for the default.
+ * @return        A newly allocated canonical name.
+ */
+static char *GetSegmentName(const char *name) {
+  char *canonical;
+
+  if(!name || !*name) return xStringCopyOf(SHM_DEFAULT_NAME);
+  if(*name == '/') return xStringCopyOf(name);
+
+  canonical = (char *) malloc(strlen(name) + 2);
+  x_check_alloc(canonical);
+  sprintf(canonical, "/%s", name);
+
+  return canonical;
+}
+
+/**
+ * Prints the aggregate ID of a variable into a buffer.
+ *
+ * @param table   The hash table name
+ * @param key     The variable name
+ * @param id      Buffer of SHM_ID_LENGTH bytes.
+ * @return        TRUE (1) if the ID fit into the buffer, or else FALSE (0).
+ */
+static boolean GetID(const char *table, const char *key, char *id) {
+  const int n = snprintf(id, SHM_ID_LENGTH, "%s" X_SEP "%s", table, key);
+  return n >= 0 && n < SHM_ID_LENGTH;
+}
+
+/**
+ * Finds the slot of a variable in the mirror. The mirrorLock must be held.
+ *
+ * @param m         The mirror we maintain.
+ * @param hash      The variable's hash
+ * @param id        The variable's aggregate ID
+ * @param[out] pos  The slot in which the variable was found, or else the first free slot in which it may
+ *                  be added (or -1 if there is none).
+ * @return          TRUE (1) if the variable was found, or else FALSE (0).
+ */
+static boolean FindSlotAsync(const ShmMirror *m, unsigned long long hash, const char *id, int *pos) {
+  const int mask = m->header->nSlots - 1;
+  int i, n;
+
+  *pos = -1;
+
+  for(n = 0, i = (int) (hash & mask); n <= mask; n++, i = (i + 1) & mask) {
+    const ShmSlot *s = &m->slots[i];
+
+    if(s->state == SLOT_EMPTY) {
+      if(*pos < 0) *pos = i;
+      return FALSE;
+    }
+
+    if(s->state == SLOT_DELETED) {
+      if(*pos < 0) *pos = i;
+      continue;
+    }
+
+    if(s->hash == hash && strcmp(s->id, id) == 0) {
+      *pos = i;
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/**
+ * Allocates space in the data area. The mirrorLock must be held.
+ *
+ * @param m         The mirror we maintain.
+ * @param length    [bytes] The space needed.
+ * @param[out] cap  [bytes] The space allocated.
+ * @return          The offset of the allocated space in the data area, or -1 if there is no room.
+ */
+static long AllocateAsync(ShmMirror *m, int length, int *cap) {
+  ShmHeader *h = m->header;
+  long offset;
+
+  *cap = (length + SHM_ALIGN - 1) & ~(SHM_ALIGN - 1);
+  if(h->used + *cap > h->dataSize) return -1;
+
+  offset = h->used;
+  h->used += *cap;
+  return offset;
+}
+
+/**
+ * Rebuilds the slots and the data area of the mirror, dropping deleted slots and the space of replaced
+ * values. Readers retry while it is in progress. The mirrorLock must be held.
+ *
+ * @param m     The mirror we maintain.
+ */
+static void CompactAsync(ShmMirror *m) {
+  ShmHeader *h = m->header;
+  ShmSlot *old;
+  char *oldData;
+  int i;
+
+  old = (ShmSlot *) malloc(h->nSlots * sizeof(ShmSlot));
+  oldData = (char *) malloc(h->used > 0 ? h->used : 1);
+  if(!old || !oldData) {
+    if(old) free(old);
+    if(oldData) free(oldData);
+    return;
+  }
+
+  xvprintf("SMA-X: compacting shared lazy cache (%d of %d slots used).\n", h->count, h->nSlots);
+
+  __atomic_store_n(&h->seq, h->seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  memcpy(old, m->slots, h->nSlots * sizeof(ShmSlot));
+  memcpy(oldData, m->data, h->used);
+
+  // Empty the slots, but keep the sequence counters increasing, for readers.
+  for(i = h->nSlots; --i >= 0; ) {
+    ShmSlot *s = &m->slots[i];
+    s->seq += 2;
+    s->state = SLOT_EMPTY;
+  }
+
+  h->used = 0;
+  h->count = 0;
+  h->deleted = 0;
+
+  for(i = 0; i < h->nSlots; i++) {
+    const ShmSlot *from = &old[i];
+    ShmSlot *s;
+    int pos, cap;
+    long offset;
+
+    if(from->state != SLOT_USED) continue;
+
+    FindSlotAsync(m, from->hash, from->id, &pos);
+    offset = AllocateAsync(m, from->length, &cap);
+    if(pos < 0 || offset < 0) continue;
+
+    s = &m->slots[pos];
+    memcpy(&m->data[offset], &oldData[from->offset], from->length);
+    s->state = SLOT_USED;
+    s->hash = from->hash;
+    s->isCurrent = from->isCurrent;
+    s->hasMeta = from->hasMeta;
+    s->length = from->length;
+    s->capacity = cap;
+    s->offset = offset;
+    s->meta = from->meta;
+    strcpy(s->id, from->id);
+    h->count++;
+  }
+
+  __atomic_store_n(&h->seq, h->seq + 1, __ATOMIC_RELEASE);
+
+  free(old);
+  free(oldData);
+}
+
+/**
+ * Removes a variable from the mirror. The mirrorLock must be held.
+ *
+ * @param m     The mirror we maintain.
+ * @param pos   The slot of the variable.
+ */
+static void RemoveSlotAsync(ShmMirror *m, int pos) {
+  ShmSlot *s = &m->slots[pos];
+
+  BeginSlotWrite(s);
+  s->state = SLOT_DELETED;
+  EndSlotWrite(s);
+
+  m->header->count--;
+  m->header->deleted++;
+}
+
+/**
+ * Checks if a shared-memory segment exists, and is being maintained by a running process.
+ *
+ * @param name    The canonical name of the segment
+ * @return        TRUE (1) if the segment is maintained by a running process, or else FALSE (0).
+ */
+static boolean IsMaintained(const char *name) {
+  ShmHeader h;
+  int fd = shm_open(name, O_RDONLY, 0);
+
+  if(fd < 0) return FALSE;
+
+  if(pread(fd, &h, sizeof(h), 0) != sizeof(h)) h.magic = 0;
+  close(fd);
+
+  if(h.magic != SHM_MAGIC || !h.isActive) return FALSE;
+  if(h.owner == getpid()) return FALSE;
+
+  // A process of another user may not be signalled, but it is running nevertheless (EPERM).
+  return kill(h.owner, 0) == 0 || errno == EPERM;
+}
+
+/**
+ * Checks, as a reader, if the process that maintains the mirror is still running. The check is done at
+ * most once every second (per attached process), and its result is remembered in the process-local
+ * mapping, so it does not write to the shared memory.
+ *
+ * @param m     The mirror we are attached to (as a reader).
+ * @return      TRUE (1) if the owner was running when last checked, or else FALSE (0).
+ */
+static boolean IsOwnerAlive(ShmMirror *m) {
+  struct timespec t;
+  long now;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  now = 1000L * t.tv_sec + t.tv_nsec / 1000000;
+
+  if(now - __atomic_load_n(&m->lastCheck, __ATOMIC_RELAXED) >= SHM_OWNER_CHECK_MILLIS) {
+    // A process of another user may not be signalled, but it is running nevertheless (EPERM).
+    const boolean isAlive = kill(m->header->owner, 0) == 0 || errno == EPERM;
+
+    if(!isAlive && __atomic_load_n(&m->isOwnerAlive, __ATOMIC_RELAXED))
+      fprintf(stderr, "WARNING! SMA-X : the process sharing the lazy cache (pid %d) is gone. Will not use it.\n", (int) m->header->owner);
+
+    __atomic_store_n(&m->isOwnerAlive, isAlive, __ATOMIC_RELAXED);
+    __atomic_store_n(&m->lastCheck, now, __ATOMIC_RELAXED);
+  }
+
+  return __atomic_load_n(&m->isOwnerAlive, __ATOMIC_RELAXED);
+}
+
+/// \cond PROTECTED
+
+/**
+ * Publishes the current data of a lazy variable to the shared-memory mirror, if we maintain one, or
+ * removes the variable from the mirror if the data is NULL. It is called by the lazy cache as the variable
+ * is updated (or discarded).
+ *
+ * @param table     The hash table name.
+ * @param key       The variable name under which the data is stored.
+ * @param data      The serialized data, as stored in Redis, or NULL to remove the variable from the mirror.
+ * @param meta      The variable's metadata, or NULL if not available.
+ *
+ * @sa smaxMirrorInvalidate()
+ * @sa smaxShareLazyCache()
+ */
+void smaxMirrorUpdate(const char *table, const char *key, const char *data, const XMeta *meta) {
+  char id[SHM_ID_LENGTH];
+  unsigned long long hash;
+  ShmMirror *m;
+  ShmSlot *s;
+  int pos, length = 0;
+
+  if(!__atomic_load_n(&mirror, __ATOMIC_ACQUIRE)) return;
+  if(!table || !key) return;
+  if(!GetID(table, key, id)) return;
+
+  hash = smaxHashID(table, 0, key, 0);
+
+  if(data) length = (meta && meta->storeBytes > 0) ? meta->storeBytes + 1 : (int) strlen(data) + 1;
+
+  pthread_mutex_lock(&mirrorLock);
+
+  m = mirror;
+  if(!m || !m->isOwner) {
+    pthread_mutex_unlock(&mirrorLock);
+    return;
+  }
+
+  if(FindSlotAsync(m, hash, id, &pos)) {
+    s = &m->slots[pos];
+
+    if(!data) RemoveSlotAsync(m, pos);
+    else if(length <= s->capacity) {
+      // Update in place
+      BeginSlotWrite(s);
+      memcpy(&m->data[s->offset], data, length - 1);
+      m->data[s->offset + length - 1] = '\0';
+      s->length = length;
+      s->isCurrent = TRUE;
+      s->hasMeta = (meta != NULL);
+      if(meta) s->meta = *meta;
+      EndSlotWrite(s);
+    }
+    else {
+      // Remove, and add again below with more space.
+      RemoveSlotAsync(m, pos);
+      FindSlotAsync(m, hash, id, &pos);
+    }
+  }
+
+  if(data && (pos < 0 || m->slots[pos].state != SLOT_USED)) {
+    ShmHeader *h = m->header;
+    long offset;
+    int cap;
+
+    if(pos < 0 || h->count + h->deleted + 1 > SHM_MAX_LOAD * h->nSlots || h->used + length > h->dataSize) {
+      CompactAsync(m);
+      FindSlotAsync(m, hash, id, &pos);
+    }
+
+    offset = (pos < 0 || h->count + 1 > SHM_MAX_LOAD * h->nSlots) ? -1 : AllocateAsync(m, length, &cap);
+
+    if(offset >= 0) {
+      s = &m->slots[pos];
+
+      BeginSlotWrite(s);
+      if(s->state == SLOT_DELETED) h->deleted--;
+      memcpy(&m->data[offset], data, length - 1);
+      m->data[offset + length - 1] = '\0';
+      s->state = SLOT_USED;
+      s->hash = hash;
+      s->isCurrent = TRUE;
+      s->hasMeta = (meta != NULL);
+      if(meta) s->meta = *meta;
+      s->length = length;
+      s->capacity = cap;
+      s->offset = offset;
+      strcpy(s->id, id);
+      EndSlotWrite(s);
+
+      h->count++;
+    }
+    else xvprintf("SMA-X: shared lazy cache is full. %s is not shared.\n", id);
+  }
+
+  pthread_mutex_unlock(&mirrorLock);
+}
+
+/**
+ * Marks a variable in the shared-memory mirror as not current, if we maintain a mirror, e.g. because it
+ * was updated in SMA-X and the new data has not been fetched yet.
+ *
+ * @param table     The hash table name.
+ * @param key       The variable name under which the data is stored.
+ *
+ * @sa smaxMirrorUpdate()
+ */
+void smaxMirrorInvalidate(const char *table, const char *key) {
+  char id[SHM_ID_LENGTH];
+  ShmMirror *m;
+  int pos;
+
+  if(!__atomic_load_n(&mirror, __ATOMIC_ACQUIRE)) return;
+  if(!table || !key) return;
+  if(!GetID(table, key, id)) return;
+
+  pthread_mutex_lock(&mirrorLock);
+
+  m = mirror;
+  if(m && m->isOwner) if(FindSlotAsync(m, smaxHashID(table, 0, key, 0), id, &pos)) {
+    ShmSlot *s = &m->slots[pos];
+    BeginSlotWrite(s);
+    s->isCurrent = FALSE;
+    EndSlotWrite(s);
+  }
+
+  pthread_mutex_unlock(&mirrorLock);
+}
+
+/**
+ * Checks if a variable is in the shared-memory mirror that we maintain. Other processes may be reading
+ * such variables from the mirror at any time, without the lazy cache knowing about it, so the lazy cache
+ * keeps them, rather than collecting or evicting them as unused.
+ *
+ * @param table     The hash table name.
+ * @param key       The variable name under which the data is stored.
+ * @return          TRUE (1) if we maintain a mirror that holds the variable, or else FALSE (0).
+ *
+ * @sa smaxShareLazyCache()
+ */
+boolean smaxIsMirrored(const char *table, const char *key) {
+  char id[SHM_ID_LENGTH];
+  boolean isMirrored = FALSE;
+  int pos;
+
+  if(!__atomic_load_n(&mirror, __ATOMIC_ACQUIRE)) return FALSE;
+  if(!table || !key) return FALSE;
+  if(!GetID(table, key, id)) return FALSE;
+
+  pthread_mutex_lock(&mirrorLock);
+  if(mirror && mirror->isOwner) isMirrored = FindSlotAsync(mirror, smaxHashID(table, 0, key, 0), id, &pos);
+  pthread_mutex_unlock(&mirrorLock);
+
+  return isMirrored;
+}
+
+/**
+ * Reads a variable from the shared-memory mirror we are attached to (as a reader). It neither locks,
+ * nor writes to the shared memory.
+ *
+ * @param table     The hash table name.
+ * @param key       The variable name under which the data is stored.
+ * @param type      The SMA-X variable type, e.g. X_FLOAT or X_CHARS(40), of the buffer.
+ * @param count     The number of elements to retrieve
+ * @param value     Pointer to the native data buffer in which to restore values
+ * @param meta      Optional metadata pointer, or NULL if metadata is not required.
+ * @return          X_SUCCESS (0) if the data was returned from the mirror, or X_NAME_INVALID if the
+ *                  variable is not mirrored, or X_INCOMPLETE if it is mirrored but the data is not current
+ *                  (or could not be read consistently), or else another error (&lt;0) from decoding the data.
+ *
+ * @sa smaxAttachLazyCache()
+ */
+int smaxMirrorRead(const char *table, const char *key, XType type, int count, void *value, XMeta *meta) {
+  static const char *fn = "smaxMirrorRead";
+
+  char id[SHM_ID_LENGTH], local[SHM_STACK_BYTES], *buf = local;
+  unsigned long long hash;
+  ShmMirror *m;
+  int attempt, bufSize = sizeof(local), length = 0, status = X_NAME_INVALID;
+
+  if(!__atomic_load_n(&mirror, __ATOMIC_ACQUIRE)) return X_NAME_INVALID;
+  if(!table || !key || type == X_STRUCT) return X_NAME_INVALID;
+  if(!GetID(table, key, id)) return X_NAME_INVALID;
+
+  hash = smaxHashID(table, 0, key, 0);
+
+  smaxEpochEnter();
+
+  m = __atomic_load_n(&mirror, __ATOMIC_ACQUIRE);
+  if(m) if(m->isOwner || !__atomic_load_n(&m->header->isActive, __ATOMIC_ACQUIRE) || !IsOwnerAlive(m)) m = NULL;
+
+  for(attempt = 0; m && attempt < MAX_MIRROR_ATTEMPTS; attempt++) {
+    const ShmHeader *h = m->header;
+    const ShmSlot *s = NULL;
+    const int mask = h->nSlots - 1;
+    unsigned int gseq, sseq;
+    long offset;
+    int i, n;
+
+    gseq = __atomic_load_n(&h->seq, __ATOMIC_ACQUIRE);
+    if(gseq & 1) continue;        // Compacting...
+
+    for(n = 0, i = (int) (hash & mask); n <= mask; n++, i = (i + 1) & mask) {
+      const ShmSlot *si = &m->slots[i];
+      const int state = __atomic_load_n(&si->state, __ATOMIC_ACQUIRE);
+
+      if(state == SLOT_EMPTY) break;
+      if(state == SLOT_USED && si->hash == hash && strncmp(si->id, id, SHM_ID_LENGTH) == 0) {
+        s = si;
+        break;
+      }
+    }
+
+    if(!s) {
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      if(__atomic_load_n(&h->seq, __ATOMIC_RELAXED) != gseq) continue;
+      status = X_NAME_INVALID;
+      break;
+    }
+
+    sseq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+    if(sseq & 1) continue;        // Being updated...
+
+    status = X_SUCCESS;
+    length = s->length;
+    offset = s->offset;
+
+    if(!s->isCurrent || (meta && !s->hasMeta)) status = X_INCOMPLETE;
+    else if(length <= 0 || offset < 0 || offset + length > h->dataSize) continue;   // torn read
+    else {
+      if(length > bufSize) {
+        if(buf != local) free(buf);
+        buf = (char *) malloc(length);
+        x_check_alloc(buf);
+        bufSize = length;
+      }
+      memcpy(buf, &m->data[offset], length);
+      if(meta) *meta = s->meta;
+    }
+
+    // Make sure the slot was not changed while we were reading it.
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if(__atomic_load_n(&s->seq, __ATOMIC_RELAXED) == sseq && __atomic_load_n(&h->seq, __ATOMIC_RELAXED) == gseq) break;
+
+    status = X_INCOMPLETE;
+  }
+
+  smaxEpochExit();
+
+  if(status == X_SUCCESS) {
+    buf[length - 1] = '\0';
+
+    if(type == X_RAW) {
+      char *str = (char *) malloc(length);
+      x_check_alloc(str);
+      memcpy(str, buf, length);
+      *(char **) value = str;
+    }
+    else {
+      int n;
+      status = smaxStringToValues(buf, value, type, count, &n);
+      status = (status > 0) ? X_SUCCESS : x_trace(fn, NULL, status);
+    }
+  }
+
+  if(buf != local) free(buf);
+
+  return status;
+}
+
+/// \endcond
+
+/**
+ * Starts sharing the lazy cache of this process with other processes on the same host, via a
+ * shared-memory segment. From here on, the current data (and metadata) of the variables that this process
+ * lazy accesses or caches (except structures) is published into the segment, from where other processes
+ * can read them after calling smaxAttachLazyCache(), without having to subscribe to, or pull, the same data
+ * themselves. Only one process on the host should maintain a given segment. To get the most of it, the
+ * maintaining process should cache the variables of interest, e.g. via smaxCache() or smaxCachePattern().
+ *
+ * Variables whose aggregate ID is 256 characters or longer are not shared. Nor are variables that no longer
+ * fit into the segment. Since this process cannot tell which of the shared variables other processes read,
+ * the shared variables are exempt from the collection of unused variables, and from eviction under the limits
+ * set by smaxSetLazyCacheLimits(), for as long as the lazy cache is shared.
+ *
+ * @param name      The name of the shared-memory segment (see shm_open()), or NULL for the default.
+ * @param slots     The maximum number of variables to share (rounded up to a power of 2, with some room to
+ *                  spare), or &lt;=0 for the default (3072).
+ * @param bytes     [bytes] Space for the serialized data of the shared variables, or &lt;=0 for the default
+ *                  (16 MB).
+ * @return          X_SUCCESS (0) if successful, or X_ALREADY_OPEN if this process is already sharing, or
+ *                  attached to, a lazy cache, or X_FAILURE if the shared-memory segment could not be created
+ *                  (errno is set to indicate the type of error).
+ *
+ * @sa smaxAttachLazyCache()
+ * @sa smaxDetachLazyCache()
+ */
+int smaxShareLazyCache(const char *name, int slots, long bytes) {
+  static const char *fn = "smaxShareLazyCache";
+
+  ShmMirror *m;
+  ShmHeader *h;
+  char *shmName;
+  size_t size;
+  int n, fd;
+
+  if(slots <= 0) slots = SHM_DEFAULT_SLOTS * SHM_MAX_LOAD;
+  if(bytes <= 0) bytes = SHM_DEFAULT_BYTES;
+
+  // Number of slots, a power of 2, with room to spare.
+  for(n = 1; n < slots / SHM_MAX_LOAD; n <<= 1);
+
+  bytes = (bytes + SHM_ALIGN - 1) & ~(SHM_ALIGN - 1);
+  size = GetSegmentSize(n, bytes);
+
+  pthread_mutex_lock(&mirrorLock);
+
+  if(mirror) {
+    pthread_mutex_unlock(&mirrorLock);
+    return x_error(X_ALREADY_OPEN, EALREADY, fn, "already sharing or attached to a lazy cache");
+  }
+
+  shmName = GetSegmentName(name);
+
+  if(IsMaintained(shmName)) {
+    pthread_mutex_unlock(&mirrorLock);
+    free(shmName);
+    return x_error(X_ALREADY_OPEN, EEXIST, fn, "lazy cache is already shared by another process");
+  }
+
+  // Replace any leftover segment of the same name, from a process that no longer runs.
+  shm_unlink(shmName);
+
+  fd = shm_open(shmName, O_CREAT | O_EXCL | O_RDWR, 0644);
+  if(fd < 0) {
+    pthread_mutex_unlock(&mirrorLock);
+    free(shmName);
+    return x_error(X_FAILURE, errno, fn, "shm_open() error: %s", strerror(errno));
+  }
+
+  if(ftruncate(fd, (off_t) size) != 0) {
+    int err = errno;
+    close(fd);
+    shm_unlink(shmName);
+    pthread_mutex_unlock(&mirrorLock);
+    free(shmName);
+    return x_error(X_FAILURE, err, fn, "ftruncate() error: %s", strerror(err));
+  }
+
+  // Initialize the header before mapping the rest.
+  h = (ShmHeader *) mmap(NULL, sizeof(ShmHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if(h != MAP_FAILED) {
+    h->nSlots = n;
+    h->dataSize = bytes;
+    h->owner = getpid();
+    munmap(h, sizeof(ShmHeader));
+    m = MapSegment(shmName, fd, size, TRUE);
+  }
+  else m = NULL;
+
+  close(fd);
+
+  if(!m) {
+    int err = errno;
+    shm_unlink(shmName);
+    pthread_mutex_unlock(&mirrorLock);
+    free(shmName);
+    return x_error(X_FAILURE, err, fn, "mmap() error: %s", strerror(err));
+  }
+
+  free(shmName);
+
+  h = m->header;
+  h->magic = SHM_MAGIC;
+  h->version = SHM_VERSION;
+  __atomic_store_n(&h->isActive, TRUE, __ATOMIC_RELEASE);
+
+  __atomic_store_n(&mirror, m, __ATOMIC_RELEASE);
+
+  pthread_mutex_unlock(&mirrorLock);
+
+  // Publish what we have cached already.
+  smaxLazyMirrorAll();
+
+  return X_SUCCESS;
+}
+
+/**
+ * Attaches to the lazy cache shared by another process on the same host, via smaxShareLazyCache(). From
+ * here on smaxGetCached() (and the related smaxGetCached...() functions) return the variables in the shared
+ * cache directly from shared memory, without locking, and without network traffic. Variables that are not
+ * in the shared cache are cached locally, as usual, while those that are, but are not current at the time,
+ * (e.g. because an update is in flight) are pulled from SMA-X. The shared cache is not used for structures,
+ * nor by smaxGetCachedView() and smaxGetCachedMany().
+ *
+ * If the maintaining process stops sharing, or if it is no longer running (which is checked about once a
+ * second), the shared cache is no longer used, and variables are cached locally instead.
+ *
+ * @param name      The name of the shared-memory segment (see shm_open()), or NULL for the default.
+ * @return          X_SUCCESS (0) if successful, or X_ALREADY_OPEN if this process is already sharing, or
+ *                  attached to, a lazy cache, or X_NO_SERVICE if there is no such shared cache, or else
+ *                  X_FAILURE if it could not be mapped (errno is set to indicate the type of error).
+ *
+ * @sa smaxShareLazyCache()
+ * @sa smaxDetachLazyCache()
+ */
+int smaxAttachLazyCache(const char *name) {
+  static const char *fn = "smaxAttachLazyCache";
+
+  ShmHeader header;
+  ShmMirror *m;
+  struct stat st;
+  char *shmName;
+  int fd;
+
+  pthread_mutex_lock(&mirrorLock);
+
+  if(mirror) {
+    pthread_mutex_unlock(&mirrorLock);
+    return x_error(X_ALREADY_OPEN, EALREADY, fn, "already sharing or attached to a lazy cache");
+  }
+
+  shmName = GetSegmentName(name);
+
+  fd = shm_open(shmName, O_RDONLY, 0);
+  if(fd < 0) {
+    pthread_mutex_unlock(&mirrorLock);
+    free(shmName);
+    return x_error(X_NO_SERVICE, errno, fn, "shm_open() error: %s", strerror(errno));
+  }
+
+  if(fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(ShmHeader) || pread(fd, &header, sizeof(header), 0) != sizeof(header)
+          || header.magic != SHM_MAGIC || header.version != SHM_VERSION
+          || header.nSlots <= 0 || (header.nSlots & (header.nSlots - 1)) != 0
+          || st.st_size < (off_t) GetSegmentSize(header.nSlots, header.dataSize)) {
+    close(fd);
+    pthread_mutex_unlock(&mirrorLock);
+    free(shmName);
+    return x_error(X_NO_SERVICE, EPROTO, fn, "incompatible or incomplete shared lazy cache");
+  }
+
+  m = MapSegment(shmName, fd, GetSegmentSize(header.nSlots, header.dataSize), FALSE);
+  close(fd);
+  free(shmName);
+
+  if(!m) {
+    pthread_mutex_unlock(&mirrorLock);
+    return x_error(X_FAILURE, errno, fn, "mmap() error: %s", strerror(errno));
+  }
+
+  __atomic_store_n(&mirror, m, __ATOMIC_RELEASE);
+
+  pthread_mutex_unlock(&mirrorLock);
+
+  return X_SUCCESS;
+}
+
+/**
+ * Stops sharing the lazy cache with other processes, or detaches from the lazy cache shared by another
+ * process, whichever applies.
+ *
+ * @return      X_SUCCESS (0) if successful, or X_NO_INIT if this process was neither sharing, nor attached
+ *              to a shared lazy cache.
+ *
+ * @sa smaxShareLazyCache()
+ * @sa smaxAttachLazyCache()
+ */
+int smaxDetachLazyCache() {
+  ShmMirror *m;
+
+  pthread_mutex_lock(&mirrorLock);
+
+  m = mirror;
+  if(m) {
+    if(m->isOwner) {
+      __atomic_store_n(&m->header->isActive, FALSE, __ATOMIC_RELEASE);
+      shm_unlink(m->name);
+    }
+    __atomic_store_n(&mirror, NULL, __ATOMIC_RELEASE);
+  }
+
+  pthread_mutex_unlock(&mirrorLock);
+
+  if(!m) return X_NO_INIT;
+
+  // Unmap once no reader in this process is accessing it any longer.
+  smaxEpochRetire(m, DestroyMirror);
+
+  return X_SUCCESS;
+}
@@ -3,6 +3,12 @@
  *
  * @date Created  on Jun 11, 2025
  * @author Attila Kovacs
+ *
+ *  Subscriptions to update notifications, and waiting on them. Update notifications are delivered to event
+ *  queues, each of which belongs to a consumer (such as a waiting call), and holds the updates that match its
+ *  optional table / key filters, in order. Consumers are woken only by the events they are interested in, and
+ *  notifications that arrive in quick succession are queued rather than overwritten. When a queue is full,
+ *  further events are dropped, and counted, until the consumer catches up.
  */
 
 
@@ -12,76 +18,595 @@
 #include <string.h>
 #include <pthread.h>
 #include <errno.h>
+#include <fnmatch.h>
 
 #include "smax-private.h"
 
 /// \cond PRIVATE
 #define SMAX_SUBSCRIPTION_LOOKUP_SIZE   1024      ///< Hash lookup slots for tracking subscriptions
+#define SMAX_EVENT_QUEUE_SIZE           1024      ///< Default capacity of event queues
+
+/**
+ * A queue of update notifications for a consumer.
+ */
+struct XEventQueue {
+  char *table;                  ///< Table name (or pattern) to match, or NULL to match any.
+  char *key;                    ///< Key name (or pattern) to match, or NULL to match any.
+  boolean isPattern;            ///< Whether table and key are glob patterns, rather than exact names.
+  XEvent *events;               ///< Ring buffer of queued events
+  int size;                     ///< Capacity of the ring buffer
+  int first;                    ///< Index of the oldest queued event
+  int n;                        ///< Number of queued events
+  int dropped;                  ///< Number of events dropped since the last one queued
+  long received;                ///< Number of matching events received
+  long overflows;               ///< Number of events dropped because the queue was full
+  unsigned int releases;        ///< Number of times waits were released, via smaxReleaseWaits()
+  pthread_mutex_t lock;         ///< Mutex for the queue
+  pthread_cond_t cond;          ///< Condition that is signalled when an event is queued
+  struct XEventQueue *next;     ///< The next queue in the list of active queues
+};
 /// \endcond
 
 
-// A lock for ensuring exlusive access for the monitor list...
+// A lock for ensuring exlusive access for the event queue list...
 // and the variables that it controls, e.g. via lockNotify()
 static pthread_mutex_t notifyLock = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t notifyBlock = PTHREAD_COND_INITIALIZER;
 
-// The most recent key update notification info, to be used by smaxWait() exclusively...
-static char *notifyID;
-static int notifySize;
+// The active event queues -- with notifyLock only!
+static XEventQueue *queues;
 
 static XLookupTable *lookup;
+static char *bootstrapped;      // Exact channel subscribed with PSUBSCRIBE, via redisxSubscribe() -- with mutex only!
 static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
 
 
+/**
+ * Checks if a name matches a filter.
+ *
+ * @param filter      The name or pattern to match, or NULL to match any.
+ * @param name        The name to check, or NULL.
+ * @param isPattern   Whether the filter is a glob pattern, rather than an exact name.
+ * @return            TRUE (1) if the name matches the filter, or else FALSE (0).
+ */
+static boolean MatchesFilter(const char *filter, const char *name, boolean isPattern) {
+  if(!filter) return TRUE;
+  if(!name) return FALSE;
+  if(isPattern) return fnmatch(filter, name, 0) == 0;
+  return strcmp(filter, name) == 0;
+}
+
+/**
+ * Adds a copy of an event to a queue, or else counts it as dropped if the queue is full, and wakes
+ * a consumer that waits on the queue.
+ *
+ * @param q       The event queue
+ * @param e       The event, whose strings are allocated together, starting with the table name.
+ * @param bytes   [bytes] The size of the event's strings.
+ */
+static void PushEvent(XEventQueue *q, const XEvent *e, int bytes) {
+  pthread_mutex_lock(&q->lock);
+
+  q->received++;
+
+  if(q->n >= q->size) {
+    q->dropped++;
+    q->overflows++;
+  }
+  else {
+    XEvent *to = &q->events[(q->first + q->n) % q->size];
+    char *buf = (char *) malloc(bytes);
+
+    if(buf) {
+      memcpy(buf, e->table, bytes);
+      to->table = buf;
+      to->key = e->key ? buf + (e->key - e->table) : NULL;
+      to->origin = e->origin ? buf + (e->origin - e->table) : NULL;
+      to->dropped = q->dropped;
+      q->dropped = 0;
+      q->n++;
+      pthread_cond_signal(&q->cond);
+    }
+    else {
+      q->dropped++;
+      q->overflows++;
+    }
+  }
+
+  pthread_mutex_unlock(&q->lock);
+}
+
 /// \cond PRIVATE
 
 void ProcessUpdateNotificationAsync(const char *pattern, const char *channel, const char *msg, long length) {
+  const char *id, *sep;
+  XEventQueue *q;
+  XEvent e = {};
+  char *buf;
+  int lTab, lKey, lOrigin, bytes;
+
   (void) pattern;
+  (void) length;
 
   xvprintf("{message} %s %s\n", channel, msg);
 
   if(strncmp(channel, SMAX_UPDATES, SMAX_UPDATES_LENGTH)) return; // Wrong message prefix
 
-  smaxLockNotify();
+  id = channel + SMAX_UPDATES_LENGTH;
+  if(!*id) return;
 
-  // Resize the notify values as needed.
-  if(length > 0) if(notifySize < length+1) {
-    char *oldid = notifyID;
-    notifyID = realloc(notifyID, length+1);
-    if(!notifyID) {
-      perror("WARNING! realloc notifyID");
-      free(oldid);
-    }
-    notifySize = notifyID ? length+1 : 0;
+  // Split the ID into table and key, as "table\0key\0origin\0"
+  sep = xLastSeparator(id);
+  lTab = sep ? (int) (sep - id) : (int) strlen(id);
+  lKey = sep ? (int) strlen(sep + X_SEP_LENGTH) : -1;
+  lOrigin = msg ? (int) strcspn(msg, "\n") : -1;   // The origin is on the first line of the message.
+  bytes = lTab + 1 + (lKey + 1) + (lOrigin + 1);
+
+  buf = (char *) malloc(bytes);
+  if(!buf) {
+    perror("WARNING! SMA-X: alloc error for update notification");
+    return;
   }
 
-  if(notifySize > 0) notifyID[0] = '\0';  // Reset the notify values to empty strings (if not NULL)
-  strcpy(notifyID, channel + SMAX_UPDATES_LENGTH);
+  e.table = buf;
+  memcpy(buf, id, lTab);
+  buf[lTab] = '\0';
 
-  // Send notification to all blocking threads...
-  pthread_cond_broadcast(&notifyBlock);
+  if(sep) {
+    e.key = buf + lTab + 1;
+    strcpy(e.key, sep + X_SEP_LENGTH);
+  }
+
+  if(msg) {
+    e.origin = buf + lTab + 1 + (lKey + 1);
+    memcpy(e.origin, msg, lOrigin);
+    e.origin[lOrigin] = '\0';
+  }
+
+  smaxLockNotify();
+
+  // Deliver to the queues that are interested in it...
+  for(q = queues; q != NULL; q = q->next)
+    if(MatchesFilter(q->table, e.table, q->isPattern) && MatchesFilter(q->key, e.key, q->isPattern)) PushEvent(q, &e, bytes);
 
   smaxUnlockNotify();
+
+  free(buf);
 }
 
 void smaxInitNotify() {
-  // Initial sotrage for update notifications
-  notifySize = 80;
-  notifyID = (char *) calloc(1, notifySize);
-  x_check_alloc(notifyID);
-
   smaxAddSubscriber(NULL, ProcessUpdateNotificationAsync);
 }
 
 /// \endcond
 
+/**
+ * Creates an event queue, with an exact or pattern match filter.
+ *
+ * @param table       Table name (or pattern) to match, or NULL to match any.
+ * @param key         Key name (or pattern) to match, or NULL to match any.
+ * @param isPattern   Whether table and key are glob patterns, rather than exact names.
+ * @param capacity    The maximum number of events to queue.
+ * @return            The new event queue, which is already receiving events.
+ */
+static XEventQueue *CreateQueue(const char *table, const char *key, boolean isPattern, int capacity) {
+  XEventQueue *q = (XEventQueue *) calloc(1, sizeof(XEventQueue));
+  x_check_alloc(q);
+
+  q->events = (XEvent *) calloc(capacity, sizeof(XEvent));
+  x_check_alloc(q->events);
+
+  q->size = capacity;
+  q->table = (table && strcmp(table, "*")) ? xStringCopyOf(table) : NULL;
+  q->key = (key && strcmp(key, "*")) ? xStringCopyOf(key) : NULL;
+  q->isPattern = isPattern;
+
+  pthread_mutex_init(&q->lock, NULL);
+  pthread_cond_init(&q->cond, NULL);
+
+  smaxLockNotify();
+  q->next = queues;
+  queues = q;
+  smaxUnlockNotify();
+
+  return q;
+}
+
+/**
+ * Waits for the next event in a queue.
+ *
+ * @param q               The event queue
+ * @param[out] event      The event
+ * @param timeoutMillis   [ms] Timeout, or 0 or negative to wait indefinitely.
+ * @return                X_SUCCESS (0), or X_TIMEDOUT, or X_INTERRUPTED if smaxReleaseWaits() was called.
+ */
+static int NextEvent(XEventQueue *q, XEvent *event, int timeoutMillis) {
+  static const char *fn = "NextEvent";
+
+  struct timespec endTime = {};
+  unsigned int releases;
+
+  pthread_mutex_lock(&q->lock);
+
+  releases = q->releases;
+
+  if(timeoutMillis > 0) {
+    clock_gettime(CLOCK_REALTIME, &endTime);
+    endTime.tv_sec += timeoutMillis / 1000;
+    endTime.tv_nsec += 1000000L * (timeoutMillis % 1000);
+    if(endTime.tv_nsec >= 1000000000L) {
+      endTime.tv_sec++;
+      endTime.tv_nsec -= 1000000000L;
+    }
+  }
+
+  while(q->n == 0) {
+    int status = timeoutMillis > 0 ? pthread_cond_timedwait(&q->cond, &q->lock, &endTime) : pthread_cond_wait(&q->cond, &q->lock);
+
+    if(q->releases != releases) {
+      pthread_mutex_unlock(&q->lock);
+      return x_error(X_INTERRUPTED, EINTR, fn, "wait interrupted");
+    }
+
+    if(status == ETIMEDOUT) if(q->n == 0) {
+      pthread_mutex_unlock(&q->lock);
+      return x_error(X_TIMEDOUT, ETIMEDOUT, fn, "wait timed out");
+    }
+  }
+
+  *event = q->events[q->first];
+  memset(&q->events[q->first], 0, sizeof(XEvent));
+  q->first = (q->first + 1) % q->size;
+  q->n--;
+
+  pthread_mutex_unlock(&q->lock);
+
+  return X_SUCCESS;
+}
+
+/**
+ * Creates a new queue for update notifications, which will receive the updates to the subscribed variables
+ * that match the specified table and key patterns, in order, until it is destroyed. Each consumer (such as a
+ * thread) should have its own queue, from which it retrieves the events via smaxNextEvent(). Consumers are
+ * woken only for the events they are interested in, and events that arrive while the consumer is busy are
+ * queued for it. If the queue is full, further events are dropped (and counted), until the consumer makes
+ * room by retrieving the queued ones.
+ *
+ * The queue only receives events for variables that have been subscribed to, via smaxSubscribe().
+ *
+ * @param table     Table name pattern to match (e.g. "antenna*:rx"), or NULL to match any.
+ * @param key       Key name pattern to match (e.g. "temp*"), or NULL to match any.
+ * @param capacity  The maximum number of events to hold in the queue, or &lt;=0 to use the default (1024).
+ * @return          The new event queue, or NULL if there was an error.
+ *
+ * @sa smaxNextEvent()
+ * @sa smaxDestroyEventQueue()
+ * @sa smaxSubscribe()
+ */
+XEventQueue *smaxCreateEventQueue(const char *table, const char *key, int capacity) {
+  return CreateQueue(table, key, TRUE, capacity > 0 ? capacity : SMAX_EVENT_QUEUE_SIZE);
+}
+
+/**
+ * Stops queueing events on an event queue, and destroys it, together with the events that are still in it.
+ * It should not be called while another thread may be waiting on the queue.
+ *
+ * @param q     The event queue, or NULL.
+ *
+ * @sa smaxCreateEventQueue()
+ */
+void smaxDestroyEventQueue(XEventQueue *q) {
+  XEventQueue *e;
+
+  if(!q) return;
+
+  smaxLockNotify();
+  if(queues == q) queues = q->next;
+  else for(e = queues; e != NULL; e = e->next) if(e->next == q) {
+    e->next = q->next;
+    break;
+  }
+  smaxUnlockNotify();
+
+  // No notification can be delivered to it any longer...
+  while(q->n > 0) {
+    smaxClearEvent(&q->events[q->first]);
+    q->first = (q->first + 1) % q->size;
+    q->n--;
+  }
+
+  pthread_mutex_destroy(&q->lock);
+  pthread_cond_destroy(&q->cond);
+
+  if(q->table) free(q->table);
+  if(q->key) free(q->key);
+  free(q->events);
+  free(q);
+}
+
+/**
+ * Returns the next event from an event queue, waiting for one if the queue is empty. The event's strings
+ * should be released via smaxClearEvent() after use.
+ *
+ * @param q               The event queue
+ * @param[out] event      The event, whose strings are to be released via smaxClearEvent() after use.
+ * @param timeoutMillis   [ms] Timeout for waiting on an event, or 0 or negative to wait indefinitely.
+ * @return                X_SUCCESS (0) if an event was returned, or else
+ *                        X_NULL          if either argument is NULL.
+ *                        X_TIMEDOUT      if no event was received before the timeout.
+ *                        X_INTERRUPTED   if smaxReleaseWaits() was called.
+ *
+ * @sa smaxCreateEventQueue()
+ * @sa smaxClearEvent()
+ * @sa smaxReleaseWaits()
+ */
+int smaxNextEvent(XEventQueue *q, XEvent *event, int timeoutMillis) {
+  static const char *fn = "smaxNextEvent";
+
+  if(!q) return x_error(X_NULL, EINVAL, fn, "event queue is NULL");
+  if(!event) return x_error(X_NULL, EINVAL, fn, "output event is NULL");
+
+  prop_error(fn, NextEvent(q, event, timeoutMillis));
+  return X_SUCCESS;
+}
+
+/**
+ * Releases the strings of an event, returned by smaxNextEvent(), and clears it.
+ *
+ * @param event     The event, or NULL.
+ *
+ * @sa smaxNextEvent()
+ */
+void smaxClearEvent(XEvent *event) {
+  if(!event) return;
+  if(event->table) free(event->table);    // The strings are allocated together with the table name.
+  memset(event, 0, sizeof(XEvent));
+}
+
+/**
+ * Returns statistics on the events received by an event queue, and on those dropped due to overflow.
+ *
+ * @param q             The event queue
+ * @param[out] stats    The statistics to fill.
+ * @return              X_SUCCESS (0), or else X_NULL if either argument is NULL.
+ *
+ * @sa smaxCreateEventQueue()
+ */
+int smaxGetEventQueueStats(XEventQueue *q, XEventQueueStats *stats) {
+  static const char *fn = "smaxGetEventQueueStats";
+
+  if(!q) return x_error(X_NULL, EINVAL, fn, "event queue is NULL");
+  if(!stats) return x_error(X_NULL, EINVAL, fn, "output stats is NULL");
+
+  pthread_mutex_lock(&q->lock);
+  stats->received = q->received;
+  stats->overflows = q->overflows;
+  stats->pending = q->n;
+  stats->capacity = q->size;
+  pthread_mutex_unlock(&q->lock);
+
+  return X_SUCCESS;
+}
+
 static void DiscardLookup() {
   pthread_mutex_lock(&mutex);
   xDestroyLookupAndData(lookup);
   lookup = NULL;
+  free(bootstrapped);
+  bootstrapped = NULL;
   pthread_mutex_unlock(&mutex);
 }
 
+/**
+ * Returns the number of subscribers to a notification channel pattern in the lookup. The mutex should be
+ * locked.
+ *
+ * @param p     The notification channel pattern, e.g. from smaxGetUpdateChannelPattern().
+ * @return      Pointer to the number of subscribers, or NULL if the pattern is not subscribed.
+ */
+static int *GetSubscribersAsync(const char *p) {
+  XField *f;
+
+  if(!lookup) return NULL;
+
+  f = xLookupField(lookup, p);
+  return f ? (int *) f->value : NULL;
+}
+
+/**
+ * Adds a notification channel pattern to the lookup of subscribed patterns, with a single subscriber.
+ * The mutex should be locked.
+ *
+ * @param p     The notification channel pattern, e.g. from smaxGetUpdateChannelPattern().
+ */
+static void AddSubscribedAsync(const char *p) {
+  char *id = xStringCopyOf(p), *key = NULL;
+
+  x_check_alloc(id);
+
+  if(!lookup) {
+    // Create lookup table to track the number of active subscribers to each pattern
+    lookup = xAllocLookup(SMAX_SUBSCRIPTION_LOOKUP_SIZE);
+    x_check_alloc(lookup);
+
+    // Disconnect from the Redis server will discard all active subscriptions.
+    smaxAddDisconnectHook(DiscardLookup);
+  }
+
+  xSplitID(id, &key);
+  xLookupPut(lookup, id, xCreateIntField(key, 1), NULL);
+  free(id);
+}
+
+/**
+ * Removes a notification channel pattern from the lookup of subscribed patterns. The mutex should be
+ * locked.
+ *
+ * @param p     The notification channel pattern, e.g. from smaxGetUpdateChannelPattern().
+ */
+static void RemoveSubscribedAsync(const char *p) {
+  if(lookup) xDestroyField(xLookupRemove(lookup, p));
+
+  if(bootstrapped) if(strcmp(p, bootstrapped) == 0) {
+    free(bootstrapped);
+    bootstrapped = NULL;
+  }
+}
+
+/**
+ * Checks if a notification channel contains glob pattern characters, and therefore needs a pattern
+ * subscription (PSUBSCRIBE). Other channels are subscribed to exactly (SUBSCRIBE), which is much cheaper
+ * for the server, since it need not match every published message against them.
+ *
+ * @param channel   The notification channel or pattern.
+ * @return          TRUE (1) if the channel contains glob pattern characters, or else FALSE (0).
+ */
+static boolean IsGlobPattern(const char *channel) {
+  return strpbrk(channel, "*?[\\") != NULL;
+}
+
+/**
+ * Checks if a notification channel was, or is to be, subscribed to via PSUBSCRIBE, and therefore must be
+ * unsubscribed from via PUNSUBSCRIBE. Besides glob patterns, it is the case for the exact channel that
+ * connected the subscription client via redisxSubscribe(), which subscribes to everything as a pattern.
+ * The mutex should be locked.
+ *
+ * @param channel   The notification channel or pattern.
+ * @return          TRUE (1) if the channel is (to be) subscribed via PSUBSCRIBE, or else FALSE (0).
+ */
+static boolean IsPatternSubscriptionAsync(const char *channel) {
+  if(IsGlobPattern(channel)) return TRUE;
+  return bootstrapped && strcmp(channel, bootstrapped) == 0;
+}
+
+/**
+ * Sends a single (P)SUBSCRIBE or (P)UNSUBSCRIBE command for a set of channels.
+ *
+ * @param cl        The locked subscription client.
+ * @param command   The Redis command, e.g. "PSUBSCRIBE".
+ * @param p         The notification channels / patterns
+ * @param n         The number of channels / patterns.
+ * @return          X_SUCCESS (0) if successful, or else an error code (&lt;0).
+ */
+static int SendCommandAsync(RedisClient *cl, const char *command, char **p, int n) {
+  static const char *fn = "SendCommandAsync";
+
+  const char **args;
+  int status;
+
+  if(n <= 0) return X_SUCCESS;
+
+  args = (const char **) malloc((n + 1) * sizeof(char *));
+  if(!args) return x_error(X_FAILURE, errno, fn, "alloc error (%d channels)", n);
+
+  args[0] = command;
+  memcpy(&args[1], p, n * sizeof(char *));
+
+  status = redisxSendArrayRequestAsync(cl, args, NULL, n + 1);
+  free(args);
+
+  prop_error(fn, status);
+  return X_SUCCESS;
+}
+
+/**
+ * Sends subscription (or unsubscription) requests for a set of notification channel patterns, using as
+ * few Redis commands as possible. Channels without glob pattern characters are subscribed to exactly,
+ * via SUBSCRIBE, while the others via PSUBSCRIBE. Channels are unsubscribed from with the same kind of
+ * command that subscribed them. The mutex should be locked.
+ *
+ * @param r             The Redis instance.
+ * @param isSubscribe   TRUE (1) to subscribe, or FALSE (0) to unsubscribe.
+ * @param p             The notification channel patterns. The array may be reordered.
+ * @param n             The number of patterns.
+ * @return              X_SUCCESS (0) if successful, or else an error code (&lt;0).
+ */
+static int SendPatternsAsync(Redis *r, boolean isSubscribe, char **p, int n) {
+  static const char *fn = "SendPatternsAsync";
+
+  RedisClient *cl;
+  char **sorted;
+  int i, nExact = 0, nGlob = 0, status;
+
+  if(n <= 0) return X_SUCCESS;
+
+  cl = redisxGetLockedConnectedClient(r, REDISX_SUBSCRIPTION_CHANNEL);
+
+  if(!cl) {
+    char *first;
+
+    if(!isSubscribe) return x_error(X_NO_SERVICE, ENOTCONN, fn, "subscription client is not connected");
+
+    // Subscribe to one via RedisX, which also connects the subscription client. Prefer a glob pattern,
+    // which is certain to be subscribed with PSUBSCRIBE, consistently with our own requests.
+    for(i = 0; i < n; i++) if(IsGlobPattern(p[i])) break;
+    if(i >= n) i = 0;
+
+    first = p[i];
+    p[i] = p[0];
+    p[0] = first;
+
+    prop_error(fn, redisxSubscribe(r, first));
+
+    // Remember if an exact channel was subscribed as a pattern, so we unsubscribe from it the same way.
+    if(!IsGlobPattern(first)) {
+      free(bootstrapped);
+      bootstrapped = xStringCopyOf(first);
+    }
+
+    if(--n == 0) return X_SUCCESS;
+
+    p++;
+
+    cl = redisxGetLockedConnectedClient(r, REDISX_SUBSCRIPTION_CHANNEL);
+    if(!cl) return x_error(X_NO_SERVICE, ENOTCONN, fn, "subscription client is not connected");
+  }
+
+  sorted = (char **) malloc(n * sizeof(char *));
+  if(!sorted) {
+    redisxUnlockClient(cl);
+    return x_error(X_FAILURE, errno, fn, "alloc error (%d channels)", n);
+  }
+
+  // Exact channels first, patterns last...
+  for(i = 0; i < n; i++) {
+    if(IsPatternSubscriptionAsync(p[i])) sorted[n - (++nGlob)] = p[i];
+    else sorted[nExact++] = p[i];
+  }
+
+  status = SendCommandAsync(cl, isSubscribe ? "SUBSCRIBE" : "UNSUBSCRIBE", sorted, nExact);
+  if(!status) status = SendCommandAsync(cl, isSubscribe ? "PSUBSCRIBE" : "PUNSUBSCRIBE", &sorted[nExact], nGlob);
+
+  redisxUnlockClient(cl);
+
+  free(sorted);
+
+  prop_error(fn, status);
+  return X_SUCCESS;
+}
+
+/**
+ * Creates the notification channel patterns for sets of table and key names / patterns.
+ *
+ * @param tables    Array of table names / patterns, or NULL.
+ * @param keys      Array of key names / patterns, or NULL.
+ * @param n         The number of table / key pairs.
+ * @return          Array of n notification channel patterns.
+ */
+static char **GetChannelPatterns(const char **tables, const char **keys, int n) {
+  char **p = (char **) calloc(n, sizeof(char *));
+  int i;
+
+  x_check_alloc(p);
+
+  for(i = 0; i < n; i++) p[i] = smaxGetUpdateChannelPattern(tables ? tables[i] : NULL, keys ? keys[i] : NULL);
+  return p;
+}
+
+static void DestroyChannelPatterns(char **p, int n) {
+  while(--n >= 0) free(p[n]);
+  free(p);
+}
+
 /**
  * Subscribes to a specific key(s) in specific group(s). Both the group and key names may contain Redis
  * subscription patterns, e.g. '*' or '?', or bound characters in square-brackets, e.g. '[ab]'. The
@@ -89,6 +614,10 @@ static void DiscardLookup() {
  * variables. After subscribing, you can either wait on the subscribed variables to change, or add
  * callback functions to process subscribed variables changes, via smaxAddSubscriber().
  *
+ * Variables specified without pattern characters are subscribed to exactly, which is much cheaper for the
+ * Redis server than pattern subscriptions, which have to be matched against every message that is published.
+ * So, subscribe to patterns only when you actually need them.
+ *
  * \param table         Variable group pattern, i.e. hash-table names. (NULL is the same as '*').
  * \param key           Variable name pattern. (if NULL then subscribes only to the table stem).
  *
@@ -98,6 +627,7 @@ static void DiscardLookup() {
  *              X_NO_INIT       if the SMA-X library was not initialized.
  *
  * \sa smaxUnsubscribe()
+ * @sa smaxSubscribeMany()
  * @sa smaxWaitOnSubscribed()
  * @sa smaxWaitOnSubscribedGroup()
  * @sa smaxWaitOnSubscribedVar()
@@ -105,42 +635,70 @@ static void DiscardLookup() {
  * @sa smaxAddSubscriber()
  */
 int smaxSubscribe(const char *table, const char *key) {
-  static const char *fn = "smaxSubscribe";
+  prop_error("smaxSubscribe", smaxSubscribeMany(&table, &key, 1));
+  return X_SUCCESS;
+}
+
+/**
+ * Subscribes to a number of variables, or patterns, at once, as for smaxSubscribe(). The patterns that we
+ * were not yet subscribed to are requested from Redis together, which is much faster than subscribing to
+ * each separately, e.g. when an application needs to follow the updates of thousands of variables.
+ *
+ * \param tables    Array of variable group patterns, i.e. hash-table names (NULL entries are the same as '*'),
+ *                  or NULL to use '*' for all.
+ * \param keys      Array of variable name patterns (NULL entries subscribe only to the table stem), or NULL
+ *                  to subscribe to the table stems only.
+ * \param n         The number of table / key pairs.
+ *
+ * \return      X_SUCCESS       if successfully subscribed to the Redis distribution channels.
+ *              X_NO_SERVICE    if there is no active connection to the Redis server.
+ *              X_SIZE_INVALID  if n is negative.
+ *              X_NO_INIT       if the SMA-X library was not initialized.
+ *
+ * @sa smaxSubscribe()
+ * @sa smaxUnsubscribeMany()
+ */
+int smaxSubscribeMany(const char **tables, const char **keys, int n) {
+  static const char *fn = "smaxSubscribeMany";
+
   Redis *r = smaxGetRedis();
-  XField *f;
-  char *p;
-  int status = X_SUCCESS;
+  char **p, **added;
+  int i, nAdded = 0, status;
 
   if(!r) return smaxError(fn, X_NO_INIT);
+  if(n < 0) return x_error(X_SIZE_INVALID, EINVAL, fn, "invalid number of patterns: %d", n);
+  if(n == 0) return X_SUCCESS;
 
-  p = smaxGetUpdateChannelPattern(table, key);
+  p = GetChannelPatterns(tables, keys, n);
+
+  added = (char **) calloc(n, sizeof(char *));
+  x_check_alloc(added);
 
   pthread_mutex_lock(&mutex);
 
   // manage subscriber lists with call counter...
   //  - Redis subscribe only if new
   //  - Redis unsubscribe only when last user unsubscribes
-  if(!lookup) {
-    // Create lookup table to track the number of active subscribers to each pattern
-    lookup = xAllocLookup(SMAX_SUBSCRIPTION_LOOKUP_SIZE);
-    x_check_alloc(lookup);
-
-    // Disconnect from the Redis server will discard all active subscriptions.
-    smaxAddDisconnectHook(DiscardLookup);
+  for(i = 0; i < n; i++) {
+    int *count = GetSubscribersAsync(p[i]);
+    if(count) (*count)++; // Increment the number of subscribers...
+    else {
+      // We are the first subscriber to this pattern so we'll subscribe on Redis....
+      AddSubscribedAsync(p[i]);
+      added[nAdded++] = p[i];
+    }
   }
 
-  f = xLookupField(lookup, p);
-  if(f) (*(int *) f->value)++; // Increment the number of subscribers...
-  else {
-    // We are the first subscriber to this pattern so subscribe on Redis....
-    status = redisxSubscribe(r, p);
-    xSplitID(p, NULL);
-    if(status == X_SUCCESS) xLookupPut(lookup, p, xCreateIntField(key, 1), NULL);
-  }
+  status = SendPatternsAsync(r, TRUE, added, nAdded);
+
+  // If we could not subscribe, then forget the new patterns.
+  if(status) for(i = 0; i < nAdded; i++) RemoveSubscribedAsync(added[i]);
 
   pthread_mutex_unlock(&mutex);
 
-  free(p);
+  free(added);
+  DestroyChannelPatterns(p, n);
+
   prop_error(fn, status);
   return X_SUCCESS;
 }
@@ -162,36 +720,64 @@ int smaxSubscribe(const char *table, const char *key) {
  *              X_NO_INIT       if the SMA-X library was not initialized.
  *
  * \sa smaxSubscribe()
+ * @sa smaxUnsubscribeMany()
  * @sa smaxRemoveSubscribers()
  */
 int smaxUnsubscribe(const char *table, const char *key) {
-  static const char *fn = "smaxUnsubscribe";
-  Redis *r = smaxGetRedis();
+  prop_error("smaxUnsubscribe", smaxUnsubscribeMany(&table, &key, 1));
+  return X_SUCCESS;
+}
 
-  char *p;
-  int status = X_SUCCESS;
+/**
+ * Unsubscribes from a number of variables, or patterns, at once, as for smaxUnsubscribe(). The patterns that
+ * no longer have subscribers are unsubscribed from Redis together.
+ *
+ * \param tables    Array of variable group patterns, i.e. hash-table names (NULL entries are the same as '*'),
+ *                  or NULL to use '*' for all.
+ * \param keys      Array of variable name patterns (NULL entries unsubscribe only from the table stem), or NULL
+ *                  to unsubscribe from the table stems only.
+ * \param n         The number of table / key pairs.
+ *
+ * \return      X_SUCCESS       if successfully unsubscribed from the Redis distribution channels.
+ *              X_NO_SERVICE    if there is no active connection to the Redis server.
+ *              X_SIZE_INVALID  if n is negative.
+ *              X_NO_INIT       if the SMA-X library was not initialized.
+ *
+ * @sa smaxUnsubscribe()
+ * @sa smaxSubscribeMany()
+ */
+int smaxUnsubscribeMany(const char **tables, const char **keys, int n) {
+  static const char *fn = "smaxUnsubscribeMany";
+
+  Redis *r = smaxGetRedis();
+  char **p, **removed;
+  int i, nRemoved = 0, status;
 
   if(!r) return smaxError(fn, X_NO_INIT);
-  p = smaxGetUpdateChannelPattern(table, key);
+  if(n < 0) return x_error(X_SIZE_INVALID, EINVAL, fn, "invalid number of patterns: %d", n);
+  if(n == 0) return X_SUCCESS;
+
+  p = GetChannelPatterns(tables, keys, n);
+
+  removed = (char **) calloc(n, sizeof(char *));
+  x_check_alloc(removed);
 
   pthread_mutex_lock(&mutex);
 
-  if(lookup) {
-    XField *f = xLookupField(lookup, p);
-    if(f != NULL) {
-      // Descrement the number of subscribers to the pattern,
-      // and unsubscribe from Redis of no subsciber reamins for
-      // the pattern.
-      int *count = (int *) f->value;
-      if(--(*count) <= 0) {
-        status = redisxUnsubscribe(r, p);
-        if(status == X_SUCCESS) xDestroyField(xLookupRemove(lookup, p));
-      }
-    }
+  for(i = 0; i < n; i++) {
+    // Decrement the number of subscribers to the pattern, and unsubscribe from Redis
+    // if no subsciber remains for the pattern.
+    int *count = GetSubscribersAsync(p[i]);
+    if(count) if(--(*count) == 0) removed[nRemoved++] = p[i];
   }
 
+  status = SendPatternsAsync(r, FALSE, removed, nRemoved);
+  if(status == X_SUCCESS) for(i = 0; i < nRemoved; i++) RemoveSubscribedAsync(removed[i]);
+
   pthread_mutex_unlock(&mutex);
-  free(p);
+
+  free(removed);
+  DestroyChannelPatterns(p, n);
 
   prop_error(fn, status);
   return X_SUCCESS;
@@ -206,6 +792,10 @@ int smaxUnsubscribe(const char *table, const char *key) {
  * to subscrive to any relevant variables with smaxSubscribe() to enable delivering update notifications for the
  * variables of your choice.
  *
+ * Incoming notifications are routed to only those callbacks whose stem matches the updated variable, so you may
+ * add any number of callbacks (for different stems) without slowing down the processing of the others. Adding
+ * the same callback for the same stem again has no effect.
+ *
  * @param idStem    Table name or ID stem for which the supplied callback function will be invoked as long
  *                  as the beginning of the PUB/SUB update channel matches the given stem.
  *                  Alternatively, it can be a fully qualified SMA-X ID (of the form table:key) of a single
@@ -218,17 +808,7 @@ int smaxUnsubscribe(const char *table, const char *key) {
  * @sa smaxSubscribe()
  */
 int smaxAddSubscriber(const char *idStem, RedisSubscriberCall f) {
-  static const char *fn = "smaxAddSubscriber";
-  Redis *r = smaxGetRedis();
-  char *stem;
-  int status;
-
-  if(!r) return smaxError(fn, X_NO_INIT);
-
-  stem = xGetAggregateID(SMAX_UPDATES_ROOT, idStem ? idStem : "");
-  status = redisxAddSubscriber(r, stem, f);
-  free(stem);
-  prop_error(fn, status);
+  prop_error("smaxAddSubscriber", smaxAddRoute(idStem, FALSE, f));
   return X_SUCCESS;
 }
 
@@ -238,15 +818,19 @@ int smaxAddSubscriber(const char *idStem, RedisSubscriberCall f) {
  * the Redis server. You should therefore also call smaxUnsubscribe() as appropriate to stop notifications
  * for variables that no longer have associated callbacks.
  *
+ * Once it returns, the callback is no longer called, except when called from within a subscriber callback
+ * (which cannot wait for the ongoing notification to complete). Hence, it should not be called while
+ * holding a lock that the callback may also need.
+ *
  * @param f     Function to remove
- * @return      X_SUCCESS (0) if successful, or else an error (&lt;0) returned by redisxRemoveSubscriber().
+ * @return      X_SUCCESS (0) if successful, or else X_NO_INIT if the SMA-X library was not initialized.
  *
  * @sa smaxUnsubscribe()
  */
 int smaxRemoveSubscribers(RedisSubscriberCall f) {
-  Redis *r = smaxGetRedis();
-  if(!r) return smaxError("smaxRemoveSubscribers", X_NO_INIT);
-  prop_error("smaxRemoveSubscribers", redisxRemoveSubscribers(r, f));
+  if(!smaxGetRedis()) return smaxError("smaxRemoveSubscribers", X_NO_INIT);
+  smaxRemoveRoutes(f);
+  smaxWaitDispatched();
   return X_SUCCESS;
 }
 
@@ -280,6 +864,46 @@ char *smaxGetUpdateChannelPattern(const char *table, const char *key) {
 }
 /// \endcond
 
+/**
+ * Waits for the next update notification for a given table and/or key, via a temporary event queue, which
+ * receives only the matching notifications.
+ *
+ * \param[in] table       Hash table name to match, or NULL to match any.
+ * \param[in] key         Variable name to match, or NULL to match any.
+ * \param[in] timeout     (s) Timeout value. 0 or negative values result in an indefinite wait.
+ * \param[in,out] gating  Optional semaphore to post once the wait is ready to receive notifications.
+ * \param[out] event      The notification received.
+ * \return                X_SUCCESS (0), or else an error code, as for smaxWaitOnAnySubscribed().
+ */
+static int WaitEvent(const char *table, const char *key, int timeout, sem_t *gating, XEvent *event) {
+  static const char *fn = "WaitEvent";
+
+  XEventQueue *q;
+  int status;
+
+  if(!smaxGetRedis()) return smaxError(fn, X_NO_INIT);
+  if(!smaxIsConnected()) return x_error(X_NO_SERVICE, ENOTCONN, fn, "not connected to SMA-X server.");
+
+  xvprintf("SMA-X> waiting for notification...\n");
+
+  // We need only the first matching notification...
+  q = CreateQueue(table, key, FALSE, 1);
+
+  // Allow other threads to proceed as soon as we are receiving notifications.
+  if(gating) sem_post(gating);
+
+  status = NextEvent(q, event, timeout > 0 ? 1000 * timeout : 0);
+
+  smaxDestroyEventQueue(q);
+
+  if(status == X_INTERRUPTED) if(!smaxIsConnected()) return x_error(X_NO_SERVICE, EPIPE, fn, "wait aborted due to broken connection");
+  prop_error(fn, status);
+
+  xvprintf("SMA-X> %s: got %s" X_SEP "%s.\n", fn, event->table, event->key ? event->key : "");
+
+  return X_SUCCESS;
+}
+
 /**
  * Waits until any variable was pushed on any host, returning both the host and variable name for the updated value.
  * The variable must be already subscribed to with smaxSubscribe(), or else the wait will not receive update
@@ -312,78 +936,19 @@ char *smaxGetUpdateChannelPattern(const char *table, const char *key) {
  */
 int smaxWaitOnAnySubscribed(char **changedTable, char **changedKey, int timeout, sem_t *gating) {
   static const char *fn = "smaxWaitOnAnySubscribed";
-  struct timespec endTime = {};
+  XEvent e = {};
 
   if(changedTable == NULL) return x_error(X_GROUP_INVALID, EINVAL, fn, "'changedTable' parameter is NULL");
   if(changedKey == NULL) return x_error(X_NAME_INVALID, EINVAL, fn, "'changedKey' parameter is NULL");
-  if(!smaxGetRedis()) return smaxError(fn, X_NO_INIT);
-  if(!smaxIsConnected()) return x_error(X_NO_SERVICE, ENOTCONN, fn, "not connected to SMA-X server.");
-
-  xvprintf("SMA-X> waiting for notification...\n");
 
   *changedTable = NULL;
   *changedKey = NULL;
 
-  smaxLockNotify();
-
-  // Time the wait only from the point we obtained exclusive access to begin...
-  if(timeout > 0) {
-    clock_gettime(CLOCK_REALTIME, &endTime);
-    endTime.tv_sec += timeout;
-  }
-
-  // Allow other threads to proceed with exclusive access to notifications as soon as we enter waiting
-  // (or fail to do so).
-  if(gating) sem_post(gating);
-
-  // Waits for a notification...
-  while(*changedTable == NULL) {
-    const char *sep;
-
-    int status = timeout > 0 ? pthread_cond_timedwait(&notifyBlock, &notifyLock, &endTime) : pthread_cond_wait(&notifyBlock, &notifyLock);
-    if(status) {
-      // If the wait returns with an error, the mutex is unlocked.
-      if(status == ETIMEDOUT) {
-        smaxUnlockNotify();
-        return x_error(X_TIMEDOUT, ETIMEDOUT, fn, "wait timed out");
-      }
-      return x_error(X_INCOMPLETE, status, fn, "pthread_cond_wait() error: %s", strerror(status));
-    }
-
-    if(!smaxIsConnected()) {
-      smaxUnlockNotify();
-      return x_error(X_NO_SERVICE, EPIPE, fn, "wait aborted due to broken connection");
-    }
-
-    // Check for premature release...
-    if(!strcmp(notifyID, RELEASEID)) {
-      smaxUnlockNotify();
-      return x_error(X_INTERRUPTED, EINTR, fn, "wait interrupted");
-    }
+  prop_error(fn, WaitEvent(NULL, NULL, timeout, gating, &e));
 
-    if(notifyID[0] == '\0') {
-      x_warn(fn, "published message contained NULL. Ignored.\n");
-      continue;
-    }
-
-    xvprintf("SMA-X> %s: got %s.\n", fn, notifyID);
-
-    // Find the last separator
-    sep = xLastSeparator(notifyID);
-
-    if(sep != NULL) {
-      *changedKey = xStringCopyOf(sep + X_SEP_LENGTH);
-      *changedTable = (char *) malloc(sep - notifyID);
-      memcpy(*changedTable, notifyID, sep - notifyID);
-      (*changedTable)[sep - notifyID] = '\0';
-    }
-    else {
-      *changedKey = NULL;
-      *changedTable = xStringCopyOf(notifyID);
-    }
-  }
-
-  smaxUnlockNotify();
+  *changedTable = xStringCopyOf(e.table);
+  *changedKey = xStringCopyOf(e.key);
+  smaxClearEvent(&e);
 
   return X_SUCCESS;
 }
@@ -424,53 +989,27 @@ int smaxWaitOnAnySubscribed(char **changedTable, char **changedKey, int timeout,
  */
 static int WaitOn(const char *table, const char *key, int timeout, sem_t *gating, ...) {
   static const char *fn = "WaitOn";
-  char *gotTable = NULL, *gotKey = NULL;
+  XEvent e = {};
   va_list args;
 
-  va_start(args, gating);         /* Initialize the argument list. */
-
-  while(TRUE) {
-    int status;
-    char **ptr;
+  prop_error(fn, WaitEvent(table, key, timeout, gating, &e));
 
-    status = smaxWaitOnAnySubscribed(&gotTable, &gotKey, timeout, gating);
-    if(status) {
-      va_end(args);
-      return x_trace(fn, NULL, status);
-    }
+  va_start(args, gating);         /* Initialize the argument list. */
 
-    if(table != NULL) {
-      if(!gotTable) {
-        x_warn(fn, "got NULL table.\n", fn);
-        continue;
-      }
-      if(strcmp(gotTable, table)) {
-        continue;
-      }
-    }
-    if(key != NULL) {
-      if(!gotKey) {
-        x_warn(fn, "got NULL key.\n", fn);
-        continue;
-      }
-      if(strcmp(gotKey, key)) {
-        continue;
-      }
-    }
+  if(table == NULL) {
+    char **ptr = va_arg(args, char **);
+    *ptr = xStringCopyOf(e.table);
+  }
+  if(key == NULL) {
+    char **ptr = va_arg(args, char **);
+    *ptr = xStringCopyOf(e.key);
+  }
 
-    if(table == NULL) {
-      ptr = va_arg(args, char **);
-      *ptr = gotTable;
-    }
-    if(key == NULL) {
-      ptr = va_arg(args, char **);
-      *ptr = gotKey;
-    }
+  va_end(args);
 
-    if(table == NULL || key == NULL) va_end(args);
+  smaxClearEvent(&e);
 
-    return X_SUCCESS;
-  }
+  return X_SUCCESS;
 }
 
 /**
@@ -586,7 +1125,8 @@ int smaxWaitOnSubscribedVar(const char *matchKey, char **changedTable, int timeo
 
 
 /**
- * Unblocks all smax_wait*() calls, which will return X_REL_PREMATURE, as a result.
+ * Unblocks all smax_wait*() calls, and smaxNextEvent() calls that are waiting on an event, which will
+ * return X_INTERRUPTED, as a result.
  *
  * \return  X_SUCCESS (0)
  *
@@ -594,24 +1134,17 @@ int smaxWaitOnSubscribedVar(const char *matchKey, char **changedTable, int timeo
  *
  */
 int smaxReleaseWaits() {
+  XEventQueue *q;
+
   xvprintf("SMA-X> release read.\n");
 
   smaxLockNotify();
 
-  if(notifySize < (int) sizeof(RELEASEID)) {
-    char *oldid = notifyID;
-    notifyID = realloc(notifyID, sizeof(RELEASEID));
-    if(!notifyID) {
-      perror("ERROR! alloc error");
-      free(oldid);
-      exit(errno);
-    }
-    notifySize = sizeof(RELEASEID);
-  }
-
-  if(notifyID) {
-    strcpy(notifyID, RELEASEID);
-    pthread_cond_broadcast(&notifyBlock);
+  for(q = queues; q != NULL; q = q->next) {
+    pthread_mutex_lock(&q->lock);
+    q->releases++;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
   }
 
   smaxUnlockNotify();
@@ -0,0 +1,331 @@
+/**
+ * \file
+ *
+ * \date Oct 16, 2026
+ * \author Attila Kovacs
+ *
+ * \brief
+ *      Server-assisted invalidation of the lazy cache, via Redis client-side caching support (CLIENT TRACKING,
+ *      Redis 6 or later), as an alternative to subscribing to the update notifications of each lazy variable
+ *      individually. When enabled, a dedicated connection to the SMA-X server, configured identically to the main
+ *      one, turns on tracking in broadcasting (BCAST) mode, for all keys or for the keys with a given prefix, and
+ *      receives the invalidation messages as RESP3 push messages on its pipeline channel. The server thus need
+ *      not match every update notification against the per-variable subscription patterns of the client.
+ *
+ *      Since Redis tracks keys, i.e. hash tables, rather than the fields in them, an invalidation applies to all
+ *      cached variables in the table that was modified, and to the cached structures that contain it.
+ *
+ *      The tracking connection is connected and disconnected together with the main SMA-X connection. The lazy
+ *      cache is flushed whenever it is disconnected, since invalidations may be missed while disconnected.
+ *
+ *      \sa smaxSetLazyTracking()
+ */
+
+#define _POSIX_C_SOURCE 199309    ///< for clock_gettime()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "smax-private.h"
+
+/// \cond PRIVATE
+
+#define TRACKING_TIMEOUT_MILLIS     3000      ///< [ms] Timeout for the server to confirm enabling tracking.
+
+static boolean isEnabled;                     ///< Whether tracking was requested by the user
+static char *prefix;                          ///< The prefix of keys to track, or NULL to track all keys.
+static Redis *tracker;                        ///< The Redis instance that receives the invalidations
+static boolean isActive;                      ///< Whether the server confirmed tracking on the tracker connection
+
+static int reply = X_INCOMPLETE;              ///< The server's response to enabling tracking
+static pthread_mutex_t trackLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t trackCond = PTHREAD_COND_INITIALIZER;
+
+/// \endcond
+
+/**
+ * Processes invalidation push messages from the server, which are of the form
+ * `["invalidate", [key1, key2, ...]]`, or else `["invalidate", null]` if the database was flushed.
+ *
+ * \param cl        The Redis client on which the message was received (unused).
+ * \param message   The RESP3 push message.
+ * \param ptr       Unused.
+ */
+static void ProcessInvalidation(RedisClient *cl, RESP *message, void *ptr) {
+  RESP **component, *keys;
+  int i;
+
+  (void) cl;
+  (void) ptr;
+
+  if(redisxCheckRESP(message, RESP3_PUSH, 2) != X_SUCCESS) return;
+
+  component = (RESP **) message->value;
+  if(redisxCheckRESP(component[0], RESP_BULK_STRING, 0) != X_SUCCESS) return;
+  if(strcmp((char *) component[0]->value, "invalidate") != 0) return;
+
+  keys = component[1];
+
+  if(redisxCheckRESP(keys, RESP_ARRAY, 0) != X_SUCCESS) {
+    // Flushed database, or unknown extent of invalidation.
+    xvprintf("SMA-X: invalidating the entire lazy cache.\n");
+    smaxLazyFlush();
+    return;
+  }
+
+  for(i = 0; i < keys->n; i++) {
+    const RESP *key = ((RESP **) keys->value)[i];
+    if(key->type == RESP_BULK_STRING && key->value) smaxLazyInvalidate((char *) key->value);
+  }
+}
+
+/**
+ * Processes the responses to our requests on the tracking connection's pipeline (i.e., to enabling
+ * tracking).
+ *
+ * \param r     The response from the server.
+ */
+static void ProcessTrackingReply(RESP *r) {
+  int status = X_SUCCESS;
+
+  if(r->type == RESP_ERROR) {
+    fprintf(stderr, "WARNING! SMA-X: could not enable tracking: %s\n", (char *) r->value);
+    status = X_FAILURE;
+  }
+
+  pthread_mutex_lock(&trackLock);
+  reply = status;
+  pthread_cond_broadcast(&trackCond);
+  pthread_mutex_unlock(&trackLock);
+}
+
+/**
+ * Called when the tracking connection is closed, e.g. because of an error. Since invalidations may be
+ * missed from here on, the lazy cache is flushed.
+ *
+ * \param r     The tracking Redis instance.
+ */
+static void TrackingDisconnected(Redis *r) {
+  (void) r;
+
+  pthread_mutex_lock(&trackLock);
+  isActive = FALSE;
+  pthread_mutex_unlock(&trackLock);
+
+  smaxLazyFlush();
+}
+
+/**
+ * Requests the server to start tracking on the tracking connection, and waits for its confirmation.
+ *
+ * \param r   The tracking Redis instance.
+ * \return    X_SUCCESS (0) if tracking was enabled, or else an error code (&lt;0).
+ */
+static int EnableTracking(Redis *r) {
+  static const char *fn = "EnableTracking";
+
+  const char *args[] = { "CLIENT", "TRACKING", "ON", "BCAST", "PREFIX", NULL };
+  RedisClient *cl;
+  struct timespec end;
+  int status;
+
+  cl = redisxGetLockedConnectedClient(r, REDISX_PIPELINE_CHANNEL);
+  if(!cl) return x_error(X_NO_SERVICE, ENOTCONN, fn, "tracking pipeline is not connected");
+
+  pthread_mutex_lock(&trackLock);
+
+  reply = X_INCOMPLETE;
+  args[5] = prefix;
+
+  status = redisxSendArrayRequestAsync(cl, args, NULL, prefix ? 6 : 4);
+  redisxUnlockClient(cl);
+
+  if(status) {
+    pthread_mutex_unlock(&trackLock);
+    return x_trace(fn, NULL, status);
+  }
+
+  clock_gettime(CLOCK_REALTIME, &end);
+  end.tv_sec += TRACKING_TIMEOUT_MILLIS / 1000;
+  end.tv_nsec += 1000000L * (TRACKING_TIMEOUT_MILLIS % 1000);
+  if(end.tv_nsec >= 1000000000L) {
+    end.tv_sec++;
+    end.tv_nsec -= 1000000000L;
+  }
+
+  while(reply == X_INCOMPLETE) if(pthread_cond_timedwait(&trackCond, &trackLock, &end) == ETIMEDOUT) break;
+
+  status = reply;
+
+  pthread_mutex_unlock(&trackLock);
+
+  if(status == X_INCOMPLETE) return x_error(X_TIMEDOUT, ETIMEDOUT, fn, "no response to enabling tracking");
+  prop_error(fn, status);
+
+  return X_SUCCESS;
+}
+
+/// \cond PROTECTED
+
+/**
+ * Connects the tracking connection, and enables tracking on it, if tracking is enabled. It is called as
+ * a connect hook of the main SMA-X Redis instance, so tracking is (re)established together with it. If
+ * tracking cannot be established, lazy variables will subscribe to update notifications instead.
+ *
+ * @sa smaxDisconnectTracking()
+ */
+void smaxConnectTracking() {
+  Redis *r;
+  int status = X_FAILURE;
+
+  pthread_mutex_lock(&trackLock);
+
+  if(!isEnabled || isActive) {
+    pthread_mutex_unlock(&trackLock);
+    return;
+  }
+
+  if(!tracker) {
+    tracker = smaxCreateRedisAsync();
+
+    if(tracker) {
+      redisxSetProtocol(tracker, REDISX_RESP3);
+      redisxSetPushProcessor(tracker, ProcessInvalidation, NULL);
+      redisxSetPipelineConsumer(tracker, ProcessTrackingReply);
+      redisxAddDisconnectHook(tracker, TrackingDisconnected);
+    }
+  }
+
+  r = tracker;
+
+  pthread_mutex_unlock(&trackLock);
+
+  if(r) {
+    if(!redisxIsConnected(r)) redisxConnect(r, TRUE);
+    if(redisxIsConnected(r)) status = EnableTracking(r);
+  }
+
+  pthread_mutex_lock(&trackLock);
+  isActive = (status == X_SUCCESS);
+  pthread_mutex_unlock(&trackLock);
+
+  if(status) fprintf(stderr, "WARNING! SMA-X : could not enable tracking. Will subscribe to lazy updates instead.\n");
+}
+
+/**
+ * Disconnects the tracking connection, if connected. It is called as a disconnect hook of the main SMA-X
+ * Redis instance, so tracking is stopped together with it.
+ *
+ * @sa smaxConnectTracking()
+ */
+void smaxDisconnectTracking() {
+  Redis *r;
+
+  pthread_mutex_lock(&trackLock);
+  r = tracker;
+  isActive = FALSE;
+  pthread_mutex_unlock(&trackLock);
+
+  if(r) if(redisxIsConnected(r)) redisxDisconnect(r);
+}
+
+/**
+ * Checks if the lazy variables in a given hash table are invalidated by the server, so they need not
+ * subscribe to update notifications.
+ *
+ * @param table     The hash table name.
+ * @return          TRUE (1) if the table is being tracked, or else FALSE (0).
+ */
+boolean smaxIsTracked(const char *table) {
+  boolean result;
+
+  if(!table) return FALSE;
+
+  pthread_mutex_lock(&trackLock);
+  result = isActive && (!prefix || strncmp(table, prefix, strlen(prefix)) == 0);
+  pthread_mutex_unlock(&trackLock);
+
+  return result;
+}
+
+/**
+ * Checks if a Redis instance is the one used for tracking.
+ *
+ * @param r     The Redis instance
+ * @return      TRUE (1) if it is the SMA-X tracking connection, or else FALSE (0).
+ */
+boolean smaxIsTrackingRedis(const Redis *r) {
+  return r && r == tracker;
+}
+
+/// \endcond
+
+/**
+ * Enables or disables server-assisted invalidation of the lazy cache (Redis 6 or later). When enabled, the
+ * server notifies us of the modified hash tables via a single, dedicated connection, and so lazy variables
+ * no longer need to subscribe to update notifications individually. This reduces the load on the server
+ * when many variables are lazy accessed (or cached). Variables that were lazy accessed before keep using
+ * their subscriptions.
+ *
+ * Since invalidations are per hash table, rather than per variable, a change to any variable in a table will
+ * refresh all cached variables in that table. Therefore, it is best suited for caching (most) variables of
+ * the tables of interest.
+ *
+ * If tracking cannot be enabled (e.g. with an older Redis server), the lazy cache falls back to subscribing
+ * to update notifications, as usual.
+ *
+ * @param value     TRUE (non-zero) to enable tracking, or FALSE (0) to disable it.
+ * @param keyPrefix The prefix of the hash tables to track, or NULL to track all tables. Lazy variables
+ *                  in other tables will subscribe to update notifications as usual.
+ * @return          X_SUCCESS (0)
+ *
+ * @sa smaxIsLazyTracking()
+ * @sa smaxLazyPull()
+ * @sa smaxGetCached()
+ */
+int smaxSetLazyTracking(boolean value, const char *keyPrefix) {
+  boolean wasActive;
+
+  pthread_mutex_lock(&trackLock);
+
+  wasActive = isActive;
+
+  if(prefix) free(prefix);
+  prefix = (keyPrefix && *keyPrefix) ? xStringCopyOf(keyPrefix) : NULL;
+
+  isEnabled = value ? TRUE : FALSE;
+
+  pthread_mutex_unlock(&trackLock);
+
+  // Restart tracking with the new settings, as necessary.
+  if(wasActive) {
+    smaxDisconnectTracking();
+    smaxLazyFlush();
+  }
+
+  if(value && smaxIsConnected()) smaxConnectTracking();
+
+  return X_SUCCESS;
+}
+
+/**
+ * Checks if the lazy cache is currently invalidated by the server (rather than via subscriptions to
+ * update notifications).
+ *
+ * @return      TRUE (1) if server-assisted invalidation is enabled and active, or else FALSE (0).
+ *
+ * @sa smaxSetLazyTracking()
+ */
+boolean smaxIsLazyTracking() {
+  boolean result;
+
+  pthread_mutex_lock(&trackLock);
+  result = isActive;
+  pthread_mutex_unlock(&trackLock);
+
+  return result;
+}
@@ -128,7 +128,8 @@ void smaxSetOrigin(XMeta *m, const char *origin) {
  * exits the program with X_NO_SERVICE.
  *
  * @param redis     The Redis instance in which the error occurred. In case of SMA-X this will always
- *                  be the Redis instance used by SMA-X.
+ *                  be the Redis instance used by SMA-X, one of its interactive pool members, or the
+ *                  lazy tracking connection.
  * @param channel   The Redis channel index on which the error occured, such as REDIS_INTERAVTIVE_CHANNEL
  * @param op        The operation during which the error occurred, e.g. 'send' or 'read'.
  *
@@ -140,7 +141,7 @@ void smaxSetOrigin(XMeta *m, const char *origin) {
 void smaxSocketErrorHandler(Redis *redis, enum redisx_channel channel, const char *op) {
   pthread_t tid;
 
-  if(redis != smaxGetRedis()) {
+  if(redis != smaxGetRedis() && !smaxIsPoolRedis(redis) && !smaxIsTrackingRedis(redis)) {
     fprintf(stderr, "WARNING! SMA-X transmit error handling called with non-SMA-X Redis instance. Contact maintainer.\n");
     return;
   }
@@ -769,6 +770,34 @@ int smaxGetServerTime(struct timespec *t) {
   return X_SUCCESS;
 }
 
+/**
+ * Returns the integer value of an element in an array of the given integer type.
+ *
+ * \param value     Pointer to the array
+ * \param type      The integer type of the array elements
+ * \param k         The array index of the element
+ *
+ * \return          The integer value of the element (or 0 if the type is not an integer type)
+ */
+static __inline__ long long GetIntegerElement(const void *value, XType type, int k) {
+  // Check for possibly overlapping types
+  if(type == X_BOOLEAN) return ((const boolean *) value)[k] != 0;
+  if(type == X_BYTE) return ((const signed char *) value)[k];
+  if(type == X_SHORT) return ((const short *) value)[k];
+  if(type == X_INT) return ((const int *) value)[k];
+  if(type == X_LONG) return ((const long *) value)[k];
+  if(type == X_LLONG) return ((const long long *) value)[k];
+  return 0;
+}
+
+/**
+ * Checks if a type is one of the integer types that are serialized as decimal integers.
+ *
+ */
+static boolean IsIntegerType(XType type) {
+  return (type == X_BOOLEAN || type == X_BYTE || type == X_SHORT || type == X_INT || type == X_LONG || type == X_LLONG);
+}
+
 /**
  * Serializes binary values into a string representation (for Redis).
  *
@@ -813,6 +842,11 @@ char *smaxValuesToString(const void *value, XType type, int eCount, char *trybuf
     stringSize = 1;
     for(k = 0; k < eCount; k++) stringSize += (S[k] ? strlen(S[k]) : 0) + 1;
   }
+  else if(IsIntegerType(type)) {
+    // Exact size: the digits of each element, plus a separator (or termination) after each.
+    stringSize = eCount;
+    for(k = 0; k < eCount; k++) stringSize += smaxPrintLongSize(GetIntegerElement(value, type, k));
+  }
   else {
     eSize = xElementSizeOf(type);
     if(eSize <= 0) return x_trace_null(fn, NULL);       // Unsupported element type...
@@ -838,7 +872,10 @@ char *smaxValuesToString(const void *value, XType type, int eCount, char *trybuf
 
   if(!value) {
     if(type == X_STRING || xIsCharSequence(type)) for(k=0; k<eCount; k++) *(next++) = '\r';
-    else for(k=0; k<eCount; k++) next += sprintf(next, "0 ");
+    else for(k=0; k<eCount; k++) {
+      *(next++) = '0';
+      *(next++) = ' ';
+    }
   }
 
   else if(xIsCharSequence(type)) {
@@ -859,68 +896,55 @@ char *smaxValuesToString(const void *value, XType type, int eCount, char *trybuf
     }
   }
 
-  // For all the types...
-  else switch(type) {
-    case X_BOOLEAN: {
-      const boolean *b = (boolean *) value;
-      for(k=0; k<eCount; k++) next += sprintf(next, "%c ", (b[k] != 0 ? '1' : '0'));
-      break;
+  else if(IsIntegerType(type)) {
+    for(k=0; k<eCount; k++) {
+      next += smaxPrintLong(next, GetIntegerElement(value, type, k));
+      *(next++) = ' ';
     }
+  }
 
-    case X_BYTE: {
-      const char *c = (const char *) value;
-      for(k=0; k<eCount; k++) next += sprintf(next, "%hhd ", c[k]);
-      break;
+  else if(type == X_FLOAT) {
+    const float *f = (const float *) value;
+    for(k=0; k<eCount; k++) {
+      next += smaxPrintFloat(next, f[k]);
+      *(next++) = ' ';
     }
+  }
 
-    case X_FLOAT: {
-      const float *f = (const float *) value;
-      for(k=0; k<eCount; k++) {
-        next += xPrintFloat(next, f[k]);
-        *(next++) = ' ';
-      }
-      break;
+  else if(type == X_DOUBLE) {
+    const double *d = (const double *) value;
+    for(k=0; k<eCount; k++) {
+      next += smaxPrintDouble(next, d[k]);
+      *(next++) = ' ';
     }
+  }
 
-    case X_DOUBLE: {
-      const double *d = (const double *) value;
-      for(k=0; k<eCount; k++) {
-        next += xPrintDouble(next, d[k]);
-        *(next++) = ' ';
+  else if(type == X_STRING) {
+    char **S = (char **) value;
+    for(k=0; k<eCount; k++) {
+      if(S[k]) {
+        int L = strlen(S[k]);
+        memcpy(next, S[k], L);
+        next += L;
       }
-      break;
-    }
-
-    case X_STRING: {
-      char **S = (char **) value;
-      for(k=0; k<eCount; k++) next += sprintf(next, "%s\r", S[k] ? S[k] : "");
-      break;
+      *(next++) = '\r';
     }
+  }
 
-    default:
-      // Check for possibly overlapping types
-      if(type == X_SHORT) {
-        const short *s = (const short *) value;
-        for(k=0; k<eCount; k++) next += sprintf(next, "%hd ", s[k]);
-      }
-      else if(type == X_INT) {
-        const int *i = (const int *) value;
-        for(k=0; k<eCount; k++) next += sprintf(next, "%d ", i[k]);
-      }
-      else if(type == X_LONG) {
-        const long *l = (const long *) value;
-        for(k=0; k<eCount; k++) next += sprintf(next, "%ld ", l[k]);
-      }
-      else if(type == X_LLONG) {
-        const long long *ll = (const long long *) value;
-        for(k=0; k<eCount; k++) next += sprintf(next, "%lld ", ll[k]);
-      }
-      else
-        for(k=0; k<eCount; k++) next += sprintf(next, "0 ");
+  else for(k=0; k<eCount; k++) {
+    *(next++) = '0';
+    *(next++) = ' ';
   }
 
   // Replace trailing item separator with string termination.
   if(next > sValue) *(next-1) = '\0';
+  else *sValue = '\0';
+
+  // Trim dynamically allocated buffers to the actual size used.
+  if(sValue != trybuf && (next - sValue) < stringSize) {
+    char *trimmed = (char *) realloc(sValue, next > sValue ? next - sValue : 1);
+    if(trimmed) sValue = trimmed;
+  }
 
   return sValue;
 }
@@ -944,6 +968,86 @@ static __inline__ void CheckParseError(char **next, int *status) {
   }
 }
 
+/**
+ * Parses the next integer token, using the fast decimal parser if possible, or else strtoll() for
+ * everything else (e.g. octal or hexadecimal values, or values that may overflow).
+ *
+ * @param[in,out] next    Parse position, which is advanced past the token.
+ * @param end             End of the input string.
+ * @param[out] status     Set to X_PARSE_ERROR if the token could not be parsed.
+ * @return                The parsed value.
+ */
+static __inline__ long long ParseIntegerToken(char **next, const char *end, int *status) {
+  char *from = *next;
+  long long value;
+  int n = smaxParseLong(from, end, &value);
+
+  if(n > 0) {
+    *next += n;
+    return value;
+  }
+
+  errno = 0;
+  value = strtoll(from, next, 0);
+  if(*next == from) errno = EINVAL;
+  CheckParseError(next, status);
+  return value;
+}
+
+/**
+ * Parses the next single-precision floating-point token, using the fast decimal parser if
+ * possible, or else xParseFloat().
+ *
+ * @param[in,out] next    Parse position, which is advanced past the token.
+ * @param end             End of the input string.
+ * @param[out] status     Set to X_PARSE_ERROR if the token could not be parsed.
+ * @return                The parsed value.
+ */
+static __inline__ float ParseFloatToken(char **next, const char *end, int *status) {
+  char *from = *next;
+  float value;
+  int n = smaxParseFloat(from, end, &value);
+
+  if(n > 0) {
+    *next += n;
+    return value;
+  }
+
+  errno = 0;
+  value = xParseFloat(from, next);
+  if(*next == from) errno = EINVAL;
+  else if(errno == ERANGE && value != 0.0F && isfinite(value)) errno = 0;   // denormal, not an error
+  CheckParseError(next, status);
+  return value;
+}
+
+/**
+ * Parses the next double-precision floating-point token, using the fast decimal parser if
+ * possible, or else xParseDouble().
+ *
+ * @param[in,out] next    Parse position, which is advanced past the token.
+ * @param end             End of the input string.
+ * @param[out] status     Set to X_PARSE_ERROR if the token could not be parsed.
+ * @return                The parsed value.
+ */
+static __inline__ double ParseDoubleToken(char **next, const char *end, int *status) {
+  char *from = *next;
+  double value;
+  int n = smaxParseDouble(from, end, &value);
+
+  if(n > 0) {
+    *next += n;
+    return value;
+  }
+
+  errno = 0;
+  value = xParseDouble(from, next);
+  if(*next == from) errno = EINVAL;
+  else if(errno == ERANGE && value != 0.0 && isfinite(value)) errno = 0;    // denormal, not an error
+  CheckParseError(next, status);
+  return value;
+}
+
 /**
  * Deserializes a string to binary values.
  *
@@ -1013,11 +1117,15 @@ int smaxStringToValues(const char *str, void *value, XType type, int eCount, int
   }
 
   else {
-    // Parse numerical type
+    const char *end = str + strlen(str);
+
+    // Parse numerical type. Each token is parsed by the fast decimal parser if possible, and falls
+    // back to the libc parsers otherwise.
     switch(type) {
       case X_BOOLEAN: {
         boolean *b = (boolean *) value;
-        for(k=0; k<eCount && *next; k++) {
+        for(k=0; k<eCount && *(next = (char *) smaxSkipSpaces(next, end)); k++) {
+          errno = 0;
           b[k] = xParseBoolean(next, &next);
           CheckParseError(&next, &status);
         }
@@ -1025,28 +1133,21 @@ int smaxStringToValues(const char *str, void *value, XType type, int eCount, int
       }
 
       case X_BYTE:
-        for(k=0; k<eCount && *next; k++) {
-          errno = 0;
-          c[k] = (char) strtol(next, &next, 0);
-          CheckParseError(&next, &status);
-        }
+        for(k=0; k<eCount && *(next = (char *) smaxSkipSpaces(next, end)); k++)
+          c[k] = (char) ParseIntegerToken(&next, end, &status);
         break;
 
       case X_FLOAT: {
         float *f = (float *) value;
-        for(k=0; k<eCount && *next; k++) {
-          f[k] = xParseFloat(next, &next);
-          CheckParseError(&next, &status);
-        }
+        for(k=0; k<eCount && *(next = (char *) smaxSkipSpaces(next, end)); k++)
+          f[k] = ParseFloatToken(&next, end, &status);
         break;
       }
 
       case X_DOUBLE: {
         double *d = (double *) value;
-        for(k=0; k<eCount && *next; k++) {
-          d[k] = xParseDouble(next, &next);
-          CheckParseError(&next, &status);
-        }
+        for(k=0; k<eCount && *(next = (char *) smaxSkipSpaces(next, end)); k++)
+          d[k] = ParseDoubleToken(&next, end, &status);
         break;
       }
 
@@ -1054,42 +1155,30 @@ int smaxStringToValues(const char *str, void *value, XType type, int eCount, int
         // Check for possibly overlapping types...
         if(type == X_SHORT) {
           short *s = (short *) value;
-          for(k=0; k<eCount && *next; k++) {
-            errno = 0;
-            s[k] = (short) strtol(next, &next, 0);
-            CheckParseError(&next, &status);
-          }
+          for(k=0; k<eCount && *(next = (char *) smaxSkipSpaces(next, end)); k++)
+            s[k] = (short) ParseIntegerToken(&next, end, &status);
         }
         else if(type == X_INT) {
           int *i = (int *) value;
-          for(k=0; k<eCount && *next; k++) {
-            errno = 0;
-            i[k] = (int) strtol(next, &next, 0);
-            CheckParseError(&next, &status);
-          }
+          for(k=0; k<eCount && *(next = (char *) smaxSkipSpaces(next, end)); k++)
+            i[k] = (int) ParseIntegerToken(&next, end, &status);
         }
         else if(type == X_LONG) {
           long *l = (long *) value;
-          for(k=0; k<eCount && *next; k++) {
-            errno = 0;
-            l[k] = strtol(next, &next, 0);
-            CheckParseError(&next, &status);
-          }
+          for(k=0; k<eCount && *(next = (char *) smaxSkipSpaces(next, end)); k++)
+            l[k] = (long) ParseIntegerToken(&next, end, &status);
         }
         else if(type == X_LLONG) {
           long long *ll = (long long *) value;
-          for(k=0; k<eCount && *next; k++) {
-            errno = 0;
-            ll[k] = (int) strtoll(next, &next, 0);
-            CheckParseError(&next, &status);
-          }
+          for(k=0; k<eCount && *(next = (char *) smaxSkipSpaces(next, end)); k++)
+            ll[k] = ParseIntegerToken(&next, end, &status);
         }
         else
           return x_error(X_TYPE_INVALID, EINVAL, fn, "unsupported type: %d", type);         // Unknown type...
     }
 
     // Zero out the remaining elements...
-    if(k < eCount) xZero(&c[k], type, eCount - k);
+    if(k < eCount) xZero(c + k * eSize, type, eCount - k);
   }
 
   *pos = next - str;
@@ -1176,6 +1265,14 @@ XType smaxTypeForString(const char *type) {
   if(!strcmp("struct", type)) return X_STRUCT;
   if(!strcmp("raw", type)) return X_RAW;
 
+  // Native binary encoded types
+  if(!strcmp("int8-le", type)) return smaxIntTypeForBytes(1);
+  if(!strcmp("int16-le", type)) return smaxIntTypeForBytes(2);
+  if(!strcmp("int32-le", type)) return smaxIntTypeForBytes(4);
+  if(!strcmp("int64-le", type)) return smaxIntTypeForBytes(8);
+  if(!strcmp("float32-le", type)) return X_FLOAT;
+  if(!strcmp("float64-le", type)) return X_DOUBLE;
+
   return x_error(X_UNKNOWN, EINVAL, "smaxTypeForString", "invalid SMA-X type: '%s'", type);
 }
 
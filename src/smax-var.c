@@ -0,0 +1,338 @@
+/**
+ * \file
+ *
+ * \date Oct 16, 2026
+ * \author Attila Kovacs
+ *
+ * \brief
+ *      Pre-resolved variable handles. A handle resolves everything about a variable that the regular
+ *      name-based calls work out on every call -- the aggregate ID, the update channel, the arguments
+ *      for sharing, the binary encoding setting, and the lazy monitor point -- once, when it is created
+ *      (or the first time it is needed). Pulls, shares, lazy pulls, and queued pulls on a handle do not
+ *      copy or hash names, and do not allocate memory (except for values too large for the stack
+ *      buffers).
+ *
+ *      \sa smaxCreateVar()
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "smax-private.h"
+
+/// \cond PRIVATE
+
+/**
+ * A pre-resolved SMA-X variable.
+ */
+struct SmaxVar {
+  char *table;                  ///< Hash table name
+  char *key;                    ///< Variable name, or NULL for the structure represented by the table
+  char *id;                     ///< Aggregate ID, i.e. table:key
+  char *channel;                ///< The update notification channel, i.e. "smax:<id>"
+  XType type;                   ///< The native type of the variable
+  int count;                    ///< Number of elements
+  char dims[X_MAX_STRING_DIMS]; ///< Dimensions string for sharing
+  char *args[9];                ///< Prebuilt argument vector for sharing (HSetWithMeta)
+  long binaryState;             ///< (atomic) 2 x the binary encoding settings version it was resolved for, +1 if sharing in binary
+  void *monitor;                ///< Persistent reference to the lazy monitor point, or NULL
+};
+
+/// \endcond
+
+/**
+ * Creates a handle for an SMA-X variable, which resolves the variable's names and the associated
+ * resources once, s.t. pulling and sharing it via the handle is faster than with the name-based
+ * functions. Handles may be used from multiple threads concurrently, and should be destroyed with
+ * smaxDestroyVar() once no longer needed.
+ *
+ * @param table     The hash table name.
+ * @param key       The variable name under which the data is stored. It may be NULL for
+ *                  structures (X_STRUCT), if the table itself represents the structure.
+ * @param type      The native type of the variable, e.g. X_FLOAT, or X_STRUCT. X_FIELD is not supported.
+ * @param count     The number of elements in the variable (1 for X_STRUCT).
+ * @return          The new variable handle, or NULL if there was an error.
+ *
+ * @sa smaxDestroyVar()
+ * @sa smaxPullVar()
+ * @sa smaxShareVar()
+ * @sa smaxLazyPullVar()
+ * @sa smaxQueueVar()
+ */
+SmaxVar *smaxCreateVar(const char *table, const char *key, XType type, int count) {
+  static const char *fn = "smaxCreateVar";
+
+  SmaxVar *v;
+
+  if(!table || !table[0]) {
+    x_error(0, EINVAL, fn, "table is NULL or empty");
+    return NULL;
+  }
+  if(type == X_STRUCT) count = 1;
+  else if(!key || !key[0]) {
+    x_error(0, EINVAL, fn, "key is NULL or empty");
+    return NULL;
+  }
+  if(type == X_FIELD || type == X_UNKNOWN) {
+    x_error(0, EINVAL, fn, "unsupported type: %d", type);
+    return NULL;
+  }
+  if(count < 1 || count > X_MAX_ELEMENTS) {
+    x_error(0, EINVAL, fn, "invalid element count: %d", count);
+    return NULL;
+  }
+
+  v = (SmaxVar *) calloc(1, sizeof(SmaxVar));
+  x_check_alloc(v);
+
+  v->table = xStringCopyOf(table);
+  v->key = xStringCopyOf(key);
+  v->id = xGetAggregateID(table, key);
+  if(!v->id) {
+    smaxDestroyVar(v);
+    return x_trace_null(fn, NULL);
+  }
+
+  v->channel = (char *) malloc(sizeof(SMAX_UPDATES) + strlen(v->id));
+  if(!v->channel) {
+    x_error(0, errno, fn, "malloc() error (%d bytes)", (int) (sizeof(SMAX_UPDATES) + strlen(v->id)));
+    smaxDestroyVar(v);
+    return NULL;
+  }
+  sprintf(v->channel, SMAX_UPDATES "%s", v->id);
+
+  v->type = type;
+  v->count = count;
+  v->binaryState = -1L;
+  xPrintDims(v->dims, 1, &count);
+
+  v->args[0] = "EVALSHA";
+  v->args[2] = "1";             // number of Redis keys sent.
+  v->args[3] = v->table;
+  v->args[5] = v->key;
+  v->args[7] = smaxStringType(type);
+  v->args[8] = v->dims;
+
+  return v;
+}
+
+/**
+ * Destroys a variable handle, releasing the resources it holds. It must not be destroyed while other
+ * calls are using it, or while pulls queued via smaxQueueVar() are still pending on it.
+ *
+ * @param v     The variable handle, or NULL.
+ *
+ * @sa smaxCreateVar()
+ */
+void smaxDestroyVar(SmaxVar *v) {
+  if(!v) return;
+
+  smaxLazyReleaseMonitor(v->monitor);
+
+  if(v->table) free(v->table);
+  if(v->key) free(v->key);
+  if(v->id) free(v->id);
+  if(v->channel) free(v->channel);
+
+  free(v);
+}
+
+/**
+ * Returns the update notification channel of a variable, e.g. for matching channels in subscriber
+ * callbacks without having to construct them.
+ *
+ * @param v     The variable handle.
+ * @return      The PUB/SUB channel on which updates to the variable are announced, or NULL if the
+ *              handle is NULL.
+ *
+ * @sa smaxAddSubscriber()
+ */
+const char *smaxGetVarChannel(const SmaxVar *v) {
+  if(!v) {
+    x_error(0, EINVAL, "smaxGetVarChannel", "variable handle is NULL");
+    return NULL;
+  }
+  return v->channel;
+}
+
+/**
+ * Pulls the variable's data from SMA-X, interactively, similarly to smaxPull().
+ *
+ * @param v             The variable handle.
+ * @param[out] value    The buffer to fill with the variable's type and element count.
+ * @param[out] meta     (optional) Pointer to the metadata to fill, or NULL.
+ * @return              X_SUCCESS (0) if successful, or else an error code (&lt;0), as for smaxPull().
+ *
+ * @sa smaxPull()
+ * @sa smaxLazyPullVar()
+ * @sa smaxQueueVar()
+ */
+int smaxPullVar(SmaxVar *v, void *value, XMeta *meta) {
+  static const char *fn = "smaxPullVar";
+
+  PullRequest req = {0};
+
+  if(!v) return x_error(X_NULL, EINVAL, fn, "variable handle is NULL");
+  if(!value) return x_error(X_NULL, EINVAL, fn, "output value pointer is NULL");
+
+  // Make sure structures are retrieved all the same no matter how their names are split
+  // into group + key.
+  if(v->type == X_STRUCT) req.group = v->id;
+  else {
+    req.group = v->table;
+    req.key = v->key;
+  }
+
+  req.value = value;
+  req.type = v->type;
+  req.count = v->count;
+  req.meta = meta;
+
+  prop_error(fn, smaxRead(&req, REDISX_INTERACTIVE_CHANNEL));
+  return X_SUCCESS;
+}
+
+/**
+ * Shares the variable's data to SMA-X, similarly to smaxShare().
+ *
+ * @param v         The variable handle.
+ * @param value     The buffer containing the variable's data, with the variable's type and element count.
+ * @return          X_SUCCESS (0) if successful, or else an error code (&lt;0), as for smaxShare().
+ *
+ * @sa smaxShare()
+ */
+int smaxShareVar(SmaxVar *v, const void *value) {
+  static const char *fn = "smaxShareVar";
+
+  char trybuf[REDISX_CMDBUF_SIZE];
+  char *args[9];
+  int L[9] = {0};
+  long state;
+  int version, status;
+  boolean isBinary;
+
+  if(!v) return x_error(X_NULL, EINVAL, fn, "variable handle is NULL");
+  if(!value) return x_error(X_NULL, EINVAL, fn, "value is NULL");
+  if(!smaxGetRedis()) return smaxError(fn, X_NO_INIT);
+
+  if(v->type == X_STRUCT) {
+    prop_error(fn, smaxShareStruct(v->id, (const XStructure *) value));
+    return X_SUCCESS;
+  }
+
+  // Re-resolve the binary encoding setting only if the settings have changed. The setting and the
+  // version it is for are published together, as a single word, since the handle may be shared by
+  // concurrent threads.
+  version = smaxGetBinaryRulesVersion();
+  state = __atomic_load_n(&v->binaryState, __ATOMIC_ACQUIRE);
+
+  if((state >> 1) != version) {
+    isBinary = smaxIsBinaryType(v->type) && smaxIsBinaryEncodingFor(v->table, v->key);
+    __atomic_store_n(&v->binaryState, ((long) version << 1) | (isBinary ? 1 : 0), __ATOMIC_RELEASE);
+  }
+  else isBinary = (boolean) (state & 1);
+
+  memcpy(args, v->args, sizeof(args));
+  args[4] = smaxGetProgramID();
+
+  if(isBinary) {
+    L[6] = smaxValuesToBinaryBuffer(value, v->type, v->count, trybuf, sizeof(trybuf));
+    if(L[6] > 0) args[6] = trybuf;
+    else args[6] = smaxValuesToBinary(value, v->type, v->count, &L[6]);
+    args[7] = smaxBinaryStringType(v->type);
+  }
+  else args[6] = smaxValuesToString(value, v->type, v->count, trybuf, sizeof(trybuf));
+
+  if(!args[6]) return x_trace(fn, NULL, X_NULL);
+
+  status = smaxWriteArgs(args, L);
+
+  if(status == X_NO_SERVICE) {
+    // Store for later, the same way as smaxShareField() does...
+    XField f = X_FIELD_INIT;
+
+    f.name = v->key;
+    f.value = args[6];
+    f.type = v->type;
+    f.ndim = 1;
+    f.sizes[0] = v->count;
+    f.isSerialized = TRUE;
+
+    status = smaxStorePush(v->table, &f);
+  }
+
+  if(args[6] != trybuf) if(v->type != X_RAW) free(args[6]);
+
+  prop_error(fn, status);
+  return X_SUCCESS;
+}
+
+/**
+ * Lazy pulls the variable's data, similarly to smaxLazyPull(), except that the variable's monitor
+ * point is looked up only once.
+ *
+ * @param v             The variable handle.
+ * @param[out] value    The buffer to fill with the variable's type and element count.
+ * @param[out] meta     (optional) Pointer to the metadata to fill, or NULL.
+ * @return              X_SUCCESS (0) if successful, or else an error code (&lt;0), as for smaxLazyPull().
+ *
+ * @sa smaxLazyPull()
+ * @sa smaxGetCachedVar()
+ */
+int smaxLazyPullVar(SmaxVar *v, void *value, XMeta *meta) {
+  static const char *fn = "smaxLazyPullVar";
+
+  if(!v) return x_error(X_NULL, EINVAL, fn, "variable handle is NULL");
+
+  if(v->type == X_STRUCT) prop_error(fn, smaxLazyPullMonitor(&v->monitor, v->id, NULL, X_STRUCT, 1, value, meta, FALSE))
+  else prop_error(fn, smaxLazyPullMonitor(&v->monitor, v->table, v->key, v->type, v->count, value, meta, FALSE));
+
+  return X_SUCCESS;
+}
+
+/**
+ * Gets the variable's data from the local cache, similarly to smaxGetCached(), except that the variable's
+ * monitor point is looked up only once.
+ *
+ * @param v             The variable handle.
+ * @param[out] value    The buffer to fill with the variable's type and element count.
+ * @param[out] meta     (optional) Pointer to the metadata to fill, or NULL.
+ * @return              X_SUCCESS (0) if successful, or else an error code (&lt;0), as for smaxGetCached().
+ *
+ * @sa smaxGetCached()
+ * @sa smaxLazyPullVar()
+ */
+int smaxGetCachedVar(SmaxVar *v, void *value, XMeta *meta) {
+  static const char *fn = "smaxGetCachedVar";
+
+  if(!v) return x_error(X_NULL, EINVAL, fn, "variable handle is NULL");
+
+  if(v->type == X_STRUCT) prop_error(fn, smaxLazyPullMonitor(&v->monitor, v->id, NULL, X_STRUCT, 1, value, meta, TRUE))
+  else prop_error(fn, smaxLazyPullMonitor(&v->monitor, v->table, v->key, v->type, v->count, value, meta, TRUE));
+
+  return X_SUCCESS;
+}
+
+/**
+ * Queues a pipelined pull of the variable's data, similarly to smaxQueue(). The handle must not be
+ * destroyed until the pull completes.
+ *
+ * @param v             The variable handle.
+ * @param[out] value    The buffer to fill with the variable's type and element count.
+ * @param[out] meta     (optional) Pointer to the metadata to fill, or NULL.
+ * @return              X_SUCCESS (0) if successful, or else an error code (&lt;0), as for smaxQueue().
+ *
+ * @sa smaxQueue()
+ */
+int smaxQueueVar(SmaxVar *v, void *value, XMeta *meta) {
+  static const char *fn = "smaxQueueVar";
+
+  if(!v) return x_error(X_NULL, EINVAL, fn, "variable handle is NULL");
+
+  if(v->type == X_STRUCT) prop_error(fn, smaxQueueBorrowed(v->id, NULL, X_STRUCT, 1, value, meta))
+  else prop_error(fn, smaxQueueBorrowed(v->table, v->key, v->type, v->count, value, meta));
+
+  return X_SUCCESS;
+}
@@ -51,6 +51,24 @@
 #define SHA1_LENGTH             41
 
 #define STATE_UNKNOWN           (-1)
+
+/**
+ * Fields destined to the same hash table in a batch of shares.
+ */
+typedef struct ShareBatchTable {
+  char *table;                    ///< Hash table name
+  XStructure *s;                  ///< Serialized fields to share in the table
+  struct ShareBatchTable *next;   ///< The next table in the batch
+} ShareBatchTable;
+
+/**
+ * A batch of shares, which are sent to SMA-X together.
+ */
+struct XShareBatch {
+  ShareBatchTable *first;         ///< The first table in the batch
+  ShareBatchTable *last;          ///< The last table in the batch
+  int count;                      ///< Number of fields in the batch
+};
 /// \endcond
 
 
@@ -59,6 +77,7 @@ char *HSET_WITH_META;       ///< SHA1 key for calling HSetWithMeta LUA script
 char *HGET_WITH_META;       ///< SHA1 key for calling HGetWithMeta LUA script
 char *HMSET_WITH_META;      ///< SHA1 key for calling HMSetWithMeta LUA script
 char *GET_STRUCT;           ///< SHA1 key for calling HGetStruct LUA script
+char *HSET_WITH_META_VALUE; ///< SHA1 key for calling the (optional) HSetWithMetaValue LUA script, or NULL
 
 /// \cond PRIVATE
 // 'private' prototypes ------------->
@@ -68,12 +87,14 @@ void smaxInitNotify();
 // Local prototypes ------------------->
 static int ProcessStructRead(RESP **component, PullRequest *req);
 static int ParseStructData(XStructure *s, RESP *names, RESP *data, XMeta *meta);
+static int ProcessBinaryRead(RESP *data, PullRequest *req);
 
 static int SendStructDataAsync(RedisClient *cl, const char *id, const XStructure *s, boolean isTop);
 
 static void InitScriptsAsync();
 
 static boolean usePipeline = TRUE;
+static int valueNotifyBytes;      ///< [bytes] Size limit for values sent with update notifications, or 0 if disabled.
 static int tcpBufSize = REDISX_TCP_BUF_SIZE;
 
 static char *server;
@@ -90,6 +111,8 @@ static Redis *redis;
 static char *hostName;
 static char *programID;
 
+static boolean useLocalhost;      ///< Whether we fell back to localhost in the absence of the default server
+
 /**
  * Configures the SMA-X server before connecting.
  *
@@ -267,6 +290,56 @@ boolean smaxIsPipelined() {
   return usePipeline;
 }
 
+/**
+ * Enables or disables sending the values we write along with their update notifications, up to the
+ * specified size. Programs that cache or lazy access our variables can then apply the new values
+ * directly, instead of having to pull them from the database after each update notification. It
+ * halves the latency of propagating updates to such programs, and reduces the load on the server.
+ * Larger values are written with the regular update notifications.
+ *
+ * It requires the optional `HSetWithMetaValue` LUA script on the server. It takes the same arguments
+ * as `HSetWithMeta`, but it publishes the newline-separated origin, timestamp, serial number, type and
+ * dimensions of the update, followed by the serialized value, as the notification message. If the
+ * script is not available, writes use the regular `HSetWithMeta` script.
+ *
+ * The origin remains the first line of the update notifications, so it may be parsed the same way as
+ * before by subscribers (up to the newline).
+ *
+ * Batched shares (see smaxShareCommit()), and structures, are sent via `HMSetWithMeta`, and so their
+ * update notifications do not carry values.
+ *
+ * @param value       TRUE (non-zero) to send values with update notifications, or FALSE (0) to disable.
+ * @param maxBytes    [bytes] The size limit of the serialized values to send with update notifications,
+ *                    or &lt;=0 to use the default (SMAX_DEFAULT_VALUE_NOTIFY_BYTES).
+ * @return            X_SUCCESS (0)
+ *
+ * @sa smaxIsValueNotifications()
+ * @sa smaxLazyPull()
+ * @sa smaxGetCached()
+ */
+int smaxSetValueNotifications(boolean value, int maxBytes) {
+  if(maxBytes <= 0) maxBytes = SMAX_DEFAULT_VALUE_NOTIFY_BYTES;
+
+  smaxLockConfig();
+  valueNotifyBytes = value ? maxBytes : 0;
+  smaxUnlockConfig();
+
+  return X_SUCCESS;
+}
+
+/**
+ * Checks if the values we write are sent along with their update notifications, i.e. if it is enabled
+ * and supported by the server.
+ *
+ * @return    TRUE (1) if values are sent with update notifications (up to the configured size), or
+ *            else FALSE (0).
+ *
+ * @sa smaxSetValueNotifications()
+ */
+boolean smaxIsValueNotifications() {
+  return valueNotifyBytes > 0 && HSET_WITH_META_VALUE != NULL;
+}
+
 /**
  * Set the size of the TCP/IP buffers (send and receive) for future client connections.
  *
@@ -389,6 +462,47 @@ int smaxIsConnected() {
 
 
 
+/**
+ * \cond PROTECTED
+ *
+ * Creates a new Redis instance configured for SMA-X (server or Sentinel, port, authentication, database,
+ * TCP buffer size, TLS, and socket error handling), but does not connect it. The caller must hold the
+ * configuration lock (via smaxLockConfig()).
+ *
+ * \return      A newly created Redis instance configured for SMA-X, or NULL if there was an error.
+ *
+ * @sa smaxConnect()
+ */
+Redis *smaxCreateRedisAsync() {
+  static const char *fn = "smaxCreateRedisAsync";
+
+  Redis *r;
+
+  if(sentinel) r = redisxInitSentinel(SMAX_SENTINEL_SERVICENAME, sentinel, nSentinel);
+  else r = redisxInit(server ? server : (useLocalhost ? "127.0.0.1" : SMAX_DEFAULT_HOSTNAME));
+
+  if(r == NULL) return x_trace_null(fn, NULL);
+
+  // Configuration...
+  if(!sentinel) redisxSetPort(r, serverPort);
+
+  redisxSetTcpBuf(r, tcpBufSize);
+
+  if(user) redisxSetUser(r, user);
+  if(auth) redisxSetPassword(r, auth);
+  if(dbIndex) redisxSelectDB(r, dbIndex);
+
+  if(smaxConfigTLSAsync(r) != X_SUCCESS) {
+    redisxDestroy(r);
+    return x_trace_null(fn, NULL);
+  }
+
+  redisxSetSocketErrorHandler(r, smaxSocketErrorHandler);
+
+  return r;
+}
+/// \endcond
+
 /**
  * Initializes the SMA-X sharing library in this runtime instance with the specified Redis server. SMA-X is
  * initialized in resilient mode, so that we'll automatically attempt to reconnect to the Redis server if
@@ -460,36 +574,24 @@ int smaxConnect() {
       if(server) xvprintf("SMA-X> server from SMAX_HOST: %s\n", server);
     }
 
-    if(sentinel) redis = redisxInitSentinel(SMAX_SENTINEL_SERVICENAME, sentinel, nSentinel);
-    else redis = redisxInit(server ? server : SMAX_DEFAULT_HOSTNAME);
-
+    redis = smaxCreateRedisAsync();
     if(redis == NULL) {
       smaxUnlockConfig();
       return x_trace(fn, NULL, X_NO_INIT);
     }
 
-    // Configuration...
-    if(!sentinel) redisxSetPort(redis, serverPort);
-
-    redisxSetTcpBuf(redis, tcpBufSize);
-
-    if(user) redisxSetUser(redis, user);
-    if(auth) redisxSetPassword(redis, auth);
-    if(dbIndex) redisxSelectDB(redis, dbIndex);
-
-    status = smaxConfigTLSAsync(redis);
-    if(status) {
-      smaxUnlockConfig();
-      return x_trace(fn, NULL, status);
-    }
-
-    redisxSetSocketErrorHandler(redis, smaxSocketErrorHandler);
-
     smaxSetPipelineConsumer(smaxProcessPipedWritesAsync);
     smaxInitNotify();
   }
   // END one-time-only initialization <--------
 
+  // Additional interactive connections, as configured.
+  status = smaxCreatePoolAsync(redis);
+  if(status) {
+    smaxUnlockConfig();
+    return x_trace(fn, NULL, status);
+  }
+
   xvprintf("SMA-X> Connecting...\n");
 
   // Reset LUA script hashes after connecting to Redis.
@@ -501,13 +603,24 @@ int smaxConnect() {
   // Release pending waits if disconnected
   smaxAddDisconnectHook((void (*)) smaxReleaseWaits);
 
+  // Keep the interactive connection pool in sync with the main connection.
+  smaxAddConnectHook(smaxConnectPool);
+  smaxAddDisconnectHook(smaxDisconnectPool);
+
+  // Keep the lazy tracking connection (if enabled) in sync with the main connection.
+  smaxAddConnectHook(smaxConnectTracking);
+  smaxAddDisconnectHook(smaxDisconnectTracking);
+
   status = redisxConnect(redis, usePipeline);
 
   // If failed on default host, then try localhost...
-  if(status && !server) {
+  if(status && !server && !sentinel) {
     xvprintf("Trying localhost...\n");
     redisxSetHostname(redis, "127.0.0.1");
-    status = redisxConnect(redis, usePipeline);
+    useLocalhost = TRUE;
+    smaxDestroyPoolAsync();   // Pool members must use localhost also...
+    status = smaxCreatePoolAsync(redis);
+    if(!status) status = redisxConnect(redis, usePipeline);
   }
 
   if(status) {
@@ -592,8 +705,11 @@ int smaxReset() {
     return x_error(X_ALREADY_OPEN, EBUSY, "smaxReset", "cannot reset while connected");
   }
 
+  smaxDestroyPoolAsync();
+
   redisxDestroy(redis);
   redis = NULL;
+  useLocalhost = FALSE;
 
   smaxUnlockConfig();
 
@@ -838,8 +954,9 @@ int smaxShareArray(const char *table, const char *key, const void *ptr, XType ty
 
   if(count < 1 || count > X_MAX_ELEMENTS) return x_error(X_SIZE_INVALID, EINVAL, fn, "invalid element count: %d", count);
 
-  f.value = (type == X_STRUCT) ?
-          (void *) ptr : smaxValuesToString(ptr, type, count, trybuf, REDISX_CMDBUF_SIZE);
+  if(type == X_STRUCT) f.value = (void *) ptr;
+  else if(smaxIsBinaryType(type) && smaxIsBinaryEncodingFor(table, key)) f.value = smaxValuesToBinary(ptr, type, count, NULL);
+  else f.value = smaxValuesToString(ptr, type, count, trybuf, REDISX_CMDBUF_SIZE);
 
   if(f.value == NULL) return x_trace(fn, NULL, X_NULL);
 
@@ -927,16 +1044,15 @@ static int SendStruct(const char *id, const XStructure *s) {
 
   if(!r) return smaxError(fn, X_NO_INIT);
 
-  cl = r->interactive;
-
-  status = redisxLockConnected(cl);
-  if(!status) {
+  cl = smaxGetInteractiveClient(TRUE);
+  if(cl == NULL) status = X_NO_SERVICE;
+  else {
     // TODO the following should be done atomically, but multi/exec blocks don't work
     // with evalsha(?)...
 
     // Send the structure data, recursively
     status = SendStructDataAsync(cl, id, s, TRUE);
-    redisxUnlockClient(cl);
+    smaxReleaseInteractiveClient(cl);
   }
 
   prop_error(fn, status);
@@ -981,6 +1097,211 @@ int smaxShareStruct(const char *id, const XStructure *s) {
   return X_SUCCESS;
 }
 
+/**
+ * Starts a new batch of shares. Shares can be added to the batch via smaxShareAdd(), and are sent to
+ * SMA-X together when smaxShareCommit() is called. Shares to the same hash table are collapsed into
+ * a single HMSetWithMeta call, and all of the batch is sent while holding the interactive client only
+ * once. This is much more efficient than calling smaxShare() individually for a large number of
+ * variables.
+ *
+ * A batch should be populated and committed by a single thread only.
+ *
+ * \return      A new empty batch of shares.
+ *
+ * @sa smaxShareAdd()
+ * @sa smaxShareCommit()
+ * @sa smaxShareCancel()
+ */
+XShareBatch *smaxShareBegin() {
+  XShareBatch *b = (XShareBatch *) calloc(1, sizeof(XShareBatch));
+  x_check_alloc(b);
+  return b;
+}
+
+/**
+ * Returns the table entry for the given hash table in a batch, adding a new one if necessary.
+ *
+ */
+static ShareBatchTable *GetBatchTable(XShareBatch *b, const char *table) {
+  ShareBatchTable *t;
+
+  // Check the most recent table first, since consecutive shares are often to the same table.
+  if(b->last) if(!strcmp(b->last->table, table)) return b->last;
+
+  for(t = b->first; t != NULL; t = t->next) if(!strcmp(t->table, table)) return t;
+
+  t = (ShareBatchTable *) calloc(1, sizeof(ShareBatchTable));
+  x_check_alloc(t);
+
+  t->table = xStringCopyOf(table);
+  t->s = xCreateStruct();
+
+  if(b->last) b->last->next = t;
+  else b->first = t;
+  b->last = t;
+
+  return t;
+}
+
+/**
+ * Adds a share to a batch of shares. The data is serialized at the time of the call, so the buffer may
+ * be reused or modified after the call returns. If the same variable is added more than once to the
+ * batch, only the last value is shared.
+ *
+ * \param b         Pointer to the batch of shares, created by smaxShareBegin().
+ * \param table     Hash table in which to write entry.
+ * \param key       Variable name under which the data is stored.
+ * \param value     Pointer to the buffer whose data is to be shared.
+ * \param type      SMA-X variable type, e.g. X_FLOAT or X_CHARS(40), of the buffer.
+ * \param count     Number of 1D elements.
+ *
+ * \return          X_SUCCESS (0)       if successful, or
+ *                  X_NULL              if the batch or the 'value' argument is NULL.
+ *                  X_GROUP_INVALID     if the table name is invalid.
+ *                  X_NAME_INVALID      if the 'key' argument is invalid.
+ *                  X_TYPE_INVALID      if the type is not supported (e.g. X_STRUCT).
+ *                  X_SIZE_INVALID      if count < 1 or count > X_MAX_ELEMENTS
+ *
+ * @sa smaxShareBegin()
+ * @sa smaxShareCommit()
+ * @sa smaxShare()
+ */
+int smaxShareAdd(XShareBatch *b, const char *table, const char *key, const void *value, XType type, int count) {
+  static const char *fn = "smaxShareAdd";
+
+  XField *f;
+
+  if(b == NULL) return x_error(X_NULL, EINVAL, fn, "batch is NULL");
+  if(table == NULL) return x_error(X_GROUP_INVALID, EINVAL, fn, "table is NULL");
+  if(!table[0]) return x_error(X_GROUP_INVALID, EINVAL, fn, "table is empty");
+  if(key == NULL) return x_error(X_NAME_INVALID, EINVAL, fn, "key is NULL");
+  if(!key[0]) return x_error(X_NAME_INVALID, EINVAL, fn, "key is empty");
+  if(value == NULL) return x_error(X_NULL, EINVAL, fn, "value is NULL");
+  if(type == X_STRUCT || type == X_FIELD) return x_error(X_TYPE_INVALID, EINVAL, fn, "structures and fields are not supported");
+  if(count < 1 || count > X_MAX_ELEMENTS) return x_error(X_SIZE_INVALID, EINVAL, fn, "invalid element count: %d", count);
+
+  if(smaxIsBinaryType(type) && smaxIsBinaryEncodingFor(table, key)) {
+    // Binary encoded, same as for smaxShareArray()
+    f = xCreateField(key, type, 1, &count, NULL);
+    if(!f) return x_trace(fn, NULL, X_NULL);
+
+    f->value = smaxValuesToBinary(value, type, count, NULL);
+    f->isSerialized = TRUE;
+
+    if(!f->value) {
+      xDestroyField(f);
+      return x_trace(fn, NULL, X_NULL);
+    }
+  }
+  else {
+    f = smaxCreateField(key, type, 1, &count, value);
+    if(!f) return x_trace(fn, NULL, X_NULL);
+  }
+
+  f = xSetField(GetBatchTable(b, table)->s, f);
+  if(f) xDestroyField(f);   // Replaced an earlier value for the same variable
+  else b->count++;
+
+  return X_SUCCESS;
+}
+
+/**
+ * Discards a batch of shares without sending it, and frees up the resources used by it.
+ *
+ * \param b     Pointer to the batch of shares, created by smaxShareBegin(). It may not be used after
+ *              this call.
+ *
+ * @sa smaxShareBegin()
+ * @sa smaxShareCommit()
+ */
+void smaxShareCancel(XShareBatch *b) {
+  if(b == NULL) return;
+
+  while(b->first) {
+    ShareBatchTable *t = b->first;
+    b->first = t->next;
+    xDestroyStruct(t->s);
+    free(t->table);
+    free(t);
+  }
+
+  free(b);
+}
+
+/**
+ * Sends a batch of shares to SMA-X and destroys the batch. All shares destined to the same hash table
+ * are sent via a single HMSetWithMeta call, and the calls for all tables are sent back-to-back, while
+ * holding the interactive client only once. Like smaxShare(), it does not wait for confirmation from
+ * the server. If there is no connection to the server, the shares are stored locally for sending
+ * later, as with smaxShare().
+ *
+ * Unlike smaxShare(), batched shares are not written through to our own lazy cache, and their update
+ * notifications do not carry the new values, even if enabled via smaxSetValueNotifications(), since
+ * `HMSetWithMeta` publishes the regular notifications only. Lazy accessed or cached variables (ours or
+ * others') are therefore refreshed from the database after a batched share, as for any other update.
+ *
+ * \param b     Pointer to the batch of shares, created by smaxShareBegin(). It may not be used after
+ *              this call.
+ *
+ * \return      X_SUCCESS (0)       if successful, or
+ *              X_NULL              if the batch is NULL.
+ *              X_NO_INIT           if the SMA-X library was not initialized.
+ *              X_NO_SERVICE        if there was no connection to the Redis server.
+ *              X_FAILURE           if there was an underlying failure.
+ *
+ * @sa smaxShareBegin()
+ * @sa smaxShareAdd()
+ * @sa smaxShareCancel()
+ */
+int smaxShareCommit(XShareBatch *b) {
+  static const char *fn = "smaxShareCommit";
+
+  Redis *r = smaxGetRedis();
+  RedisClient *cl = NULL;
+  ShareBatchTable *t;
+  int status = X_SUCCESS;
+
+  if(b == NULL) return x_error(X_NULL, EINVAL, fn, "batch is NULL");
+
+  if(b->count == 0) {
+    smaxShareCancel(b);
+    return X_SUCCESS;
+  }
+
+  if(!r) {
+    smaxShareCancel(b);
+    return smaxError(fn, X_NO_INIT);
+  }
+
+  cl = smaxGetInteractiveClient(TRUE);
+  if(cl == NULL) status = X_NO_SERVICE;
+  else {
+    for(t = b->first; t != NULL; t = t->next) {
+      status = SendStructDataAsync(cl, t->table, t->s, TRUE);
+      if(status) break;
+    }
+    smaxReleaseInteractiveClient(cl);
+  }
+
+  if(status == X_NO_SERVICE) {
+    // Store the tables that were not sent for later delivery
+    for(t = (cl == NULL) ? b->first : t; t != NULL; t = t->next) {
+      XField *f = smaxCreateField(t->table, X_STRUCT, 0, NULL, t->s);
+      if(f) {
+        status = smaxStorePush(NULL, f);
+        free(f);
+      }
+      if(status) break;
+    }
+  }
+
+  smaxShareCancel(b);
+
+  prop_error(fn, status);
+
+  return X_SUCCESS;
+}
+
 /**
  * Retrieve the current number of variables stored on host (or owner ID).
  *
@@ -1071,28 +1392,28 @@ char **smaxGetKeys(const char *table, int *n) {
 /**
  * \cond PROTECTED
  *
- * Retrieves data from the SMA-X database, interactively or as a pipelined request.
+ * Sends a read request for the specified pull request to Redis on a client, which the caller
+ * has already locked for exclusive access, without waiting for or reading the response. The
+ * caller is responsible for consuming the response (or else having it consumed by the pipeline
+ * consumer, when sending on the pipeline channel).
  *
- * \param[in,out]   req           Pull request
- * \param[in]       channel       REDISX_INTERACTIVE_CHANNEL or REDISX_PIPELINE_CHANNEL
+ * \param          cl            The locked Redis client to send the request on.
+ * \param[in]      req           Pull request
  *
  * \return              X_SUCCESS (0)       if successful, or
- *                      X_NULL              if the request or its value field is NULL
- *                      X_NO_INIT           if the SMA-X library was not initialized.
+ *                      X_NULL              if the request or its value field is NULL, or if the
+ *                                          required LUA script is not available.
  *                      X_GROUP_INVALID     if the table name is invalid.
  *                      X_NAME_INVALID      if the 'key argument is invalid.
- *                      X_NO_SERVICE        if there was no connection to the Redis server.
- *                      X_TIMEDOUT          if timed out waiting for a response
- *                      X_FAILURE           if there was an underlying failure.
+ *                      or else an error returned by redisxSendArrayRequestAsync().
+ *
+ * @sa smaxRead()
  */
-int smaxRead(PullRequest *req, int channel) {
-  static const char *fn = "smaxRead";
+int smaxSendReadAsync(RedisClient *cl, const PullRequest *req) {
+  static const char *fn = "smaxSendReadAsync";
 
   const char *args[5], *script = NULL;
-  Redis *r = smaxGetRedis();
-  RESP *reply = NULL;
-  RedisClient *cl;
-  int status, n = 0;
+  int n = 0;
 
   if(req == NULL) return x_error(X_NULL, EINVAL, fn, "'req' is NULL");
   if(req->group == NULL) return x_error(X_GROUP_INVALID, EINVAL, fn, "req->group is NULL");
@@ -1102,7 +1423,6 @@ int smaxRead(PullRequest *req, int channel) {
     if(req->key == NULL) return x_error(X_NAME_INVALID, EINVAL, fn, "req->group is NULL");
     if(!req->key[0]) return x_error(X_NAME_INVALID, EINVAL, fn, "req->group is empty");
   }
-  if(!r) return smaxError(fn, X_NO_INIT);
 
   xvprintf("SMA-X> read %s:%s.\n", (req->group ? req->group : ""), (req->key ? req->key : ""));
 
@@ -1131,15 +1451,49 @@ int smaxRead(PullRequest *req, int channel) {
     args[n++] = req->key;
   }
 
-  cl = redisxGetLockedConnectedClient(r, channel);
+  // Call script
+  prop_error(fn, redisxSendArrayRequestAsync(cl, args, NULL, n));
+  return X_SUCCESS;
+}
+
+/**
+ * Retrieves data from the SMA-X database, interactively or as a pipelined request.
+ *
+ * \param[in,out]   req           Pull request
+ * \param[in]       channel       REDISX_INTERACTIVE_CHANNEL or REDISX_PIPELINE_CHANNEL
+ *
+ * \return              X_SUCCESS (0)       if successful, or
+ *                      X_NULL              if the request or its value field is NULL
+ *                      X_NO_INIT           if the SMA-X library was not initialized.
+ *                      X_GROUP_INVALID     if the table name is invalid.
+ *                      X_NAME_INVALID      if the 'key argument is invalid.
+ *                      X_NO_SERVICE        if there was no connection to the Redis server.
+ *                      X_TIMEDOUT          if timed out waiting for a response
+ *                      X_FAILURE           if there was an underlying failure.
+ *
+ * @sa smaxSendReadAsync()
+ */
+int smaxRead(PullRequest *req, int channel) {
+  static const char *fn = "smaxRead";
+
+  Redis *r = smaxGetRedis();
+  RESP *reply = NULL;
+  RedisClient *cl;
+  int status;
+
+  if(req == NULL) return x_error(X_NULL, EINVAL, fn, "'req' is NULL");
+  if(!r) return smaxError(fn, X_NO_INIT);
+
+  if(channel == REDISX_INTERACTIVE_CHANNEL) cl = smaxGetInteractiveClient(FALSE);
+  else cl = redisxGetLockedConnectedClient(r, channel);
   if(cl == NULL) return x_trace(fn, NULL, X_NO_SERVICE);
 
-  // Call script
-  status = redisxSendArrayRequestAsync(cl, args, NULL, n);
+  status = smaxSendReadAsync(cl, req);
 
   if(channel != REDISX_PIPELINE_CHANNEL) if(!status) reply = redisxReadReplyAsync(cl, &status);
 
-  redisxUnlockClient(cl);
+  if(channel == REDISX_INTERACTIVE_CHANNEL) smaxReleaseInteractiveClient(cl);
+  else redisxUnlockClient(cl);
 
   // Process reply as needed...
   if(!status && reply) {
@@ -1248,6 +1602,10 @@ int smaxProcessReadResponse(RESP *reply, PullRequest *req) {
       // Fill with zeroes...
       xZero(req->value, req->type, req->count);
     }
+    else if(smaxGetBinaryType((char *) data->value, data->n) != X_UNKNOWN) {
+      // Decode binary data, converting to the requested type as necessary.
+      status = ProcessBinaryRead(data, req);
+    }
     else if(req->type == X_RAW) {
       // Simply move the pointer to the raw value over to the pull request.
       *(char **) req->value = (char *) data->value;    // req->value is a pointer to a string reference, i.e. char**
@@ -1273,6 +1631,51 @@ int smaxProcessReadResponse(RESP *reply, PullRequest *req) {
 }
 /// \endcond
 
+/**
+ * Deserializes binary encoded data from a Redis response into the pull request, converting to the
+ * requested type as necessary. Requests for raw or string values receive the ASCII representation
+ * of the values, the same as if the data were stored as text.
+ *
+ * \param[in]       data    The RESP containing the binary encoded data.
+ * \param[in,out]   req     Pointer to a PullRequest structure to be completed with the data.
+ *
+ * \return          X_SUCCESS (0) if successful, or else an appropriate error code (&lt;0).
+ */
+static int ProcessBinaryRead(RESP *data, PullRequest *req) {
+  static const char *fn = "ProcessBinaryRead";
+
+  char *str;
+  int status = X_SUCCESS;
+
+  if(req->type == X_BOOLEAN || smaxIsBinaryType(req->type)) {
+    prop_error(fn, smaxBinaryToValues((char *) data->value, data->n, req->value, req->type, req->count));
+    return X_SUCCESS;
+  }
+
+  // Transcode to ASCII for all other types
+  str = smaxBinaryToString((char *) data->value, data->n);
+  if(!str) return x_trace(fn, NULL, X_NULL);
+
+  // Report the size of the data we deliver...
+  if(req->meta != NULL) req->meta->storeBytes = strlen(str);
+
+  if(req->type == X_RAW) {
+    *(char **) req->value = str;
+    return X_SUCCESS;
+  }
+
+  if(req->type == X_STRING) smaxUnpackStrings(str, strlen(str), req->count, (char **) req->value);
+  else {
+    int parsed;
+    status = smaxStringToValues(str, req->value, req->type, req->count, &parsed);
+  }
+
+  free(str);
+
+  prop_error(fn, status);
+  return X_SUCCESS;
+}
+
 static int ProcessStructRead(RESP **component, PullRequest *req) {
   static const char *fn = "xProcessStructRead";
 
@@ -1421,8 +1824,14 @@ static int ParseStructData(XStructure *s, RESP *names, RESP *data, XMeta *meta)
     f->name = keys[i]->value;
     keys[i]->value = NULL;      // Dereference the RESP field name so it does not get destroyed with RESP.
 
-    f->value = (char *) values[i]->value;
-    values[i]->value = NULL;    // Dereference the RESP data so it does not get destroyed with RESP.
+    if(smaxGetBinaryType((char *) values[i]->value, values[i]->n) != X_UNKNOWN) {
+      // Structure fields are serialized as ASCII, so transcode binary values.
+      f->value = smaxBinaryToString((char *) values[i]->value, values[i]->n);
+    }
+    else {
+      f->value = (char *) values[i]->value;
+      values[i]->value = NULL;  // Dereference the RESP data so it does not get destroyed with RESP.
+    }
 
     f->type = smaxTypeForString((char *) types[i]->value);
     f->ndim = xParseDims((char *) dims[i]->value, f->sizes);
@@ -1478,11 +1887,10 @@ static int ParseStructData(XStructure *s, RESP *names, RESP *data, XMeta *meta)
 int smaxWrite(const char *table, const XField *f) {
   static const char *fn = "smaxWrite";
 
-  int status;
+  int status, L[9] = {0};
   char *args[9];
   char dims[X_MAX_STRING_DIMS];
   Redis *r = smaxGetRedis();
-  RedisClient *cl;
 
   if(table == NULL) return x_error(X_GROUP_INVALID, EINVAL, fn, "table is NULL");
   if(!table[0]) return x_error(X_GROUP_INVALID, EINVAL, fn, "table is empty");
@@ -1514,23 +1922,71 @@ int smaxWrite(const char *table, const XField *f) {
     args[6] = smaxValuesToString(f->value, f->type, xGetFieldCount(f), NULL, 0);
     if(!args[6]) return x_trace(fn, NULL, X_NULL);
   }
-
-  cl = redisxGetLockedConnectedClient(r, REDISX_INTERACTIVE_CHANNEL);
-  if(cl == NULL) {
-    if(!f->isSerialized) if(f->type != X_RAW) free(args[6]);
-    return x_trace(fn, NULL, X_NO_SERVICE);
+  else if(smaxIsBinaryType(f->type)) {
+    // Binary encoded values must be sent with explicit length...
+    L[6] = smaxGetSerializedSize(f);
+    if(smaxGetBinaryType(f->value, L[6]) != X_UNKNOWN) args[7] = smaxBinaryStringType(f->type);
+    else L[6] = 0;
   }
 
-  // Writes not to request reply.
-  status = redisxSkipReplyAsync(cl);
-  if(!status) {
-    // Call script
-    status = redisxSendArrayRequestAsync(cl, (const char **) args, NULL, 9);
+  status = smaxWriteArgs(args, L);
+
+  if(!f->isSerialized) if(f->type != X_RAW) free(args[6]);
+
+  prop_error(fn, status);
+
+  return X_SUCCESS;
+}
+
+/**
+ * Sends a prepared HSetWithMeta call on the interactive connection of the calling thread, without
+ * waiting for a response. If the variable is lazy cached, the cache is updated with the data sent also.
+ *
+ * \param args          The 9 element argument vector, as in smaxWrite(), whose 2nd element (the
+ *                      script's SHA1) is set by this call. Small values are sent with HSetWithMetaValue
+ *                      instead of HSetWithMeta, if enabled (see smaxSetValueNotifications()).
+ * \param L             The lengths of the arguments, or 0 for string arguments.
+ *
+ * \return              X_SUCCESS (0) if successful, or else X_NULL if the script is not available,
+ *                      X_NO_SERVICE if not connected, or another error (&lt;0) from redisx.
+ *
+ * @sa smaxWrite()
+ */
+int smaxWriteArgs(char **args, const int *L) {
+  static const char *fn = "smaxWriteArgs";
+
+  RedisClient *cl;
+  boolean isCached;
+  int status;
+
+  if(HSET_WITH_META == NULL) return smaxScriptError("HSetWithMeta", X_NULL);
+  args[1] = HSET_WITH_META;
+
+  // Send small values with the update notification, if enabled and supported by the server.
+  if(valueNotifyBytes > 0 && HSET_WITH_META_VALUE) {
+    int length = (L && L[6] > 0) ? L[6] : (int) strlen(args[6]);
+    if(length <= valueNotifyBytes) args[1] = HSET_WITH_META_VALUE;
   }
 
-  redisxUnlockClient(cl);
+  // Update our own lazy cache (if the variable is cached) with what we are about to send, before the
+  // update notification can arrive.
+  isCached = smaxLazyWriteThrough(args[3], args[5], args[6], L ? L[6] : 0, args[7], args[8]);
 
-  if(!f->isSerialized) if(f->type != X_RAW) free(args[6]);
+  cl = smaxGetInteractiveClient(TRUE);
+  if(cl == NULL) status = X_NO_SERVICE;
+  else {
+    // Writes not to request reply.
+    status = redisxSkipReplyAsync(cl);
+    if(!status) {
+      // Call script
+      status = redisxSendArrayRequestAsync(cl, (const char **) args, L, 9);
+    }
+
+    smaxReleaseInteractiveClient(cl);
+  }
+
+  // Don't keep data in the cache that did not make it to the database.
+  if(status && isCached) smaxLazyWriteFailed(args[3], args[5]);
 
   prop_error(fn, status);
 
@@ -1603,6 +2059,15 @@ static int SendStructDataAsync(RedisClient *cl, const char *id, const XStructure
     else {
       args[next + HMSET_VALUE_OFFSET] = f->isSerialized ? f->value : smaxValuesToString(f->value, f->type, xGetFieldCount(f), NULL, 0);
       args[next + HMSET_DIMS_OFFSET] = (char *) malloc(X_MAX_STRING_DIMS);
+
+      if(f->isSerialized && smaxIsBinaryType(f->type)) {
+        // Binary encoded values must be sent with explicit length...
+        int len = smaxGetSerializedSize(f);
+        if(smaxGetBinaryType(f->value, len) != X_UNKNOWN) {
+          L[next + HMSET_VALUE_OFFSET] = len;
+          args[next + HMSET_TYPE_OFFSET] = smaxBinaryStringType(f->type);
+        }
+      }
       xPrintDims(args[next + HMSET_DIMS_OFFSET], f->ndim, f->sizes);
     }
   }
@@ -1615,7 +2080,7 @@ static int SendStructDataAsync(RedisClient *cl, const char *id, const XStructure
     status = redisxSkipReplyAsync(cl);
 
     // Call script
-    if(!status) status = redisxSendArrayRequestAsync(cl, (const char **) args, NULL, n);
+    if(!status) status = redisxSendArrayRequestAsync(cl, (const char **) args, L, n);
   }
 
   next = 5;
@@ -1719,4 +2184,8 @@ static void InitScriptsAsync() {
       if(SMAX_RECONNECT_RETRY_SECONDS > 0) sleep(SMAX_RECONNECT_RETRY_SECONDS);
     }
   }
+
+  // Optional scripts...
+  if(InitScript("HSetWithMetaValue", &HSET_WITH_META_VALUE) != X_SUCCESS)
+    xvprintf("SMA-X: HSetWithMetaValue is not available. Values won't be sent with update notifications.\n");
 }
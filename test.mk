@@ -9,16 +9,29 @@ LDFLAGS += -L$(LIB) -lsmax
 LD_LIBRARY_PATH := $(LIB):$(LD_LIBRARY_PATH)
 
 TESTS = $(BIN)/simpleIntTest $(BIN)/simpleIntsTest $(BIN)/structTest $(BIN)/queueTest $(BIN)/lazyTest \
-		$(BIN)/lazyCacheTest $(BIN)/waitTest $(BIN)/controlTest $(BIN)/resilientTest
+		$(BIN)/lazyCacheTest $(BIN)/waitTest $(BIN)/controlTest $(BIN)/resilientTest $(BIN)/batchTest \
+		$(BIN)/binaryTest $(BIN)/poolTest $(BIN)/varTest $(BIN)/lazyPatternTest $(BIN)/sharedCacheTest \
+		$(BIN)/trackingTest $(BIN)/subscribeTest $(BIN)/numericTest $(BIN)/epochTest $(BIN)/hashTest
 
 .PHONY: run
 run: build test-tools
+	$(BIN)/numericTest
+	$(BIN)/epochTest
+	$(BIN)/hashTest
 	$(BIN)/simpleIntTest
 	$(BIN)/simpleIntsTest
 	$(BIN)/structTest
 	$(BIN)/queueTest
+	$(BIN)/batchTest
+	$(BIN)/binaryTest
+	$(BIN)/poolTest
+	$(BIN)/varTest
 	$(BIN)/lazyTest
 	$(BIN)/lazyCacheTest
+	$(BIN)/lazyPatternTest
+	$(BIN)/sharedCacheTest
+	$(BIN)/trackingTest
+	$(BIN)/subscribeTest
 	$(BIN)/waitTest
 	$(BIN)/controlTest
 
@@ -0,0 +1,78 @@
+/**
+ * @file
+ *
+ * @date Created on: Oct 16, 2026
+ * @author Attila Kovacs
+ *
+ *      Tests pulling a batch of variables, from one and several tables, in a single pipelined
+ *      round-trip via smaxPullBatch().
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "smax.h"
+
+#define TABLE1  "_test_" X_SEP "batch1"
+#define TABLE2  "_test_" X_SEP "batch2"
+#define IVALUE  2026
+#define DVALUE  2.718281828
+
+static void checkStatus(char *op, int status) {
+  if(!status) return;
+  fprintf(stderr, "ERROR! %s: %s\n", op, smaxErrorDescription(status));
+  exit(-1);
+}
+
+int main() {
+  XMeta meta = X_META_INIT;
+  int i = 0, j = 0, k = 0, n;
+  double d = 0.0;
+
+  XPullItem items[] = {
+          { TABLE1, "int1", X_INT, 1, &i, NULL, 0 },
+          { TABLE2, "double", X_DOUBLE, 1, &d, &meta, 0 },
+          { TABLE1, "int2", X_INT, 1, &j, NULL, 0 },
+          { TABLE1, "int3", X_INT, 1, &k, NULL, 0 }
+  };
+
+  n = sizeof(items) / sizeof(XPullItem);
+
+  xSetDebug(TRUE);
+  smaxSetPipelined(TRUE);
+
+  checkStatus("connect", smaxConnect());
+
+  checkStatus("share1", smaxShareInt(TABLE1, "int1", IVALUE));
+  checkStatus("share2", smaxShareInt(TABLE1, "int2", IVALUE + 1));
+  checkStatus("share3", smaxShareInt(TABLE1, "int3", IVALUE + 2));
+  checkStatus("share4", smaxShareDouble(TABLE2, "double", DVALUE));
+
+  // Make sure the shares have been processed before pulling on the pipeline...
+  checkStatus("sync", smaxPull(TABLE2, "double", X_DOUBLE, 1, &d, NULL));
+  d = 0.0;
+
+  checkStatus("batch", smaxPullBatch(items, n, 3000));
+
+  if(i != IVALUE || j != IVALUE + 1 || k != IVALUE + 2) {
+    fprintf(stderr, "ERROR! batch int mismatch: got %d, %d, %d\n", i, j, k);
+    exit(-1);
+  }
+
+  if(d != DVALUE) {
+    fprintf(stderr, "ERROR! batch double mismatch: got %.9f, expected %.9f\n", d, DVALUE);
+    exit(-1);
+  }
+
+  if(meta.storeType != X_DOUBLE) {
+    fprintf(stderr, "ERROR! batch meta type mismatch: got %d\n", meta.storeType);
+    exit(-1);
+  }
+
+  checkStatus("disconnect", smaxDisconnect());
+
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1,134 @@
+/**
+ * @file
+ *
+ * @date Created on: Oct 16, 2026
+ * @author Attila Kovacs
+ *
+ *      Tests sharing numerical arrays with native binary encoding, and pulling them back as the
+ *      same type, as a different type, and as raw (ASCII) data.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "smax.h"
+
+#define TABLE   "_test_" X_SEP "binary"
+#define N       5
+
+static void checkStatus(char *op, int status) {
+  if(!status) return;
+  fprintf(stderr, "ERROR! %s: %s\n", op, smaxErrorDescription(status));
+  exit(-1);
+}
+
+int main() {
+  float f[N] = { 0.0F, -1.5F, 3.25F, 1e-7F, 123456.0F }, g[N] = {0};
+  double d[N] = {0};
+  int i[N] = {0}, k;
+  char *raw = NULL;
+  XMeta meta = X_META_INIT;
+
+  xSetDebug(TRUE);
+
+  checkStatus("connect", smaxConnect());
+
+  checkStatus("enable", smaxSetBinaryEncodingFor(TABLE, "floats", TRUE));
+  if(!smaxIsBinaryEncodingFor(TABLE, "floats")) {
+    fprintf(stderr, "ERROR! binary encoding not enabled for variable\n");
+    exit(-1);
+  }
+  if(smaxIsBinaryEncodingFor(TABLE, "other")) {
+    fprintf(stderr, "ERROR! binary encoding enabled for other variable\n");
+    exit(-1);
+  }
+
+  checkStatus("share", smaxShare(TABLE, "floats", f, X_FLOAT, N));
+
+  checkStatus("pull float", smaxPull(TABLE, "floats", X_FLOAT, N, g, &meta));
+  for(k = 0; k < N; k++) if(g[k] != f[k]) {
+    fprintf(stderr, "ERROR! float mismatch at %d: got %g, expected %g\n", k, g[k], f[k]);
+    exit(-1);
+  }
+
+  if(meta.storeType != X_FLOAT) {
+    fprintf(stderr, "ERROR! meta type mismatch: got %d\n", meta.storeType);
+    exit(-1);
+  }
+
+  checkStatus("pull double", smaxPull(TABLE, "floats", X_DOUBLE, N, d, NULL));
+  for(k = 0; k < N; k++) if(d[k] != f[k]) {
+    fprintf(stderr, "ERROR! double mismatch at %d: got %g, expected %g\n", k, d[k], f[k]);
+    exit(-1);
+  }
+
+  checkStatus("pull int", smaxPull(TABLE, "floats", X_INT, N, i, NULL));
+  for(k = 0; k < N; k++) if(i[k] != (int) f[k]) {
+    fprintf(stderr, "ERROR! int mismatch at %d: got %d, expected %d\n", k, i[k], (int) f[k]);
+    exit(-1);
+  }
+
+  checkStatus("pull raw", smaxPull(TABLE, "floats", X_RAW, 1, &raw, NULL));
+  if(!raw || strcmp(raw, "0 -1.5 3.25 1e-07 123456")) {
+    fprintf(stderr, "ERROR! raw mismatch: got '%s'\n", raw ? raw : "(null)");
+    exit(-1);
+  }
+  free(raw);
+
+  // Batched shares should follow the same binary encoding rules...
+  {
+    XShareBatch *b = smaxShareBegin();
+    char *type;
+
+    checkStatus("enable batched", smaxSetBinaryEncodingFor(TABLE, "batched", TRUE));
+    checkStatus("batch add", smaxShareAdd(b, TABLE, "batched", f, X_FLOAT, N));
+    checkStatus("batch commit", smaxShareCommit(b));
+
+    checkStatus("pull batched", smaxPull(TABLE, "batched", X_FLOAT, N, g, NULL));
+    for(k = 0; k < N; k++) if(g[k] != f[k]) {
+      fprintf(stderr, "ERROR! batched mismatch at %d: got %g, expected %g\n", k, g[k], f[k]);
+      exit(-1);
+    }
+
+    type = smaxPullMeta(SMAX_TYPES, TABLE, "batched", NULL);
+    if(!type || strcmp(type, "float32-le")) {
+      fprintf(stderr, "ERROR! batched share was not binary: '%s'\n", type ? type : "(null)");
+      exit(-1);
+    }
+    free(type);
+  }
+
+  // Sharing NULL values should share zeroes, as with text encoding...
+  checkStatus("enable zeroes", smaxSetBinaryEncodingFor(TABLE, "zeroes", TRUE));
+  checkStatus("share NULL", smaxShare(TABLE, "zeroes", NULL, X_FLOAT, N));
+  for(k = 0; k < N; k++) g[k] = -1.0F;
+  checkStatus("pull zeroes", smaxPull(TABLE, "zeroes", X_FLOAT, N, g, NULL));
+  for(k = 0; k < N; k++) if(g[k] != 0.0F) {
+    fprintf(stderr, "ERROR! zeroes mismatch at %d: got %g\n", k, g[k]);
+    exit(-1);
+  }
+
+  // Binary shares of cached variables should update the cache with the same values...
+  {
+    float c[N] = {0};
+
+    checkStatus("cache", smaxCache(TABLE, "floats", X_FLOAT));
+    for(k = 0; k < N; k++) g[k] = 2.0F * f[k];
+    checkStatus("share cached", smaxShare(TABLE, "floats", g, X_FLOAT, N));
+
+    checkStatus("get cached", smaxGetCached(TABLE, "floats", X_FLOAT, N, c, &meta));
+    for(k = 0; k < N; k++) if(c[k] != g[k]) {
+      fprintf(stderr, "ERROR! cached mismatch at %d: got %g, expected %g\n", k, c[k], g[k]);
+      exit(-1);
+    }
+
+    smaxLazyEnd(TABLE, "floats");
+  }
+
+  checkStatus("disconnect", smaxDisconnect());
+
+  printf("OK\n");
+  return 0;
+}
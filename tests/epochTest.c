@@ -0,0 +1,90 @@
+/**
+ * @file
+ *
+ * @date Created on: Oct 16, 2026
+ * @author Attila Kovacs
+ *
+ *      This program tests the epoch-based reclamation of retired data (see smax-epoch.c), without
+ *      connecting to SMA-X. Retired data must not be destroyed while a reader that may have seen it
+ *      remains in its read section, and it must be destroyed once all such readers have exited, even
+ *      if nothing else is retired afterwards.
+ */
+
+#define _POSIX_C_SOURCE 200112L       ///< for pthread barriers
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "smax-private.h"
+
+static int nDestroyed;
+static pthread_barrier_t barrier;
+
+static void destroy(void *p) {
+  free(p);
+  __atomic_add_fetch(&nDestroyed, 1, __ATOMIC_SEQ_CST);
+}
+
+static void checkDestroyed(const char *what, int expected) {
+  int n = __atomic_load_n(&nDestroyed, __ATOMIC_SEQ_CST);
+  if(n == expected) return;
+  fprintf(stderr, "ERROR! %s: %d destroyed, expected %d.\n", what, n, expected);
+  exit(-1);
+}
+
+// Enters a read section, and exits it only once the main thread has retired data.
+static void *Reader(void *arg) {
+  (void) arg;
+
+  smaxEpochEnter();
+  pthread_barrier_wait(&barrier);     // Entered
+  pthread_barrier_wait(&barrier);     // Retired
+  smaxEpochExit();
+
+  return NULL;
+}
+
+int main() {
+  pthread_t tid;
+
+  // No readers: destroyed right away.
+  smaxEpochRetire(malloc(1), destroy);
+  checkDestroyed("retire without readers", 1);
+
+  // Our own (nested) read section holds it back, until we exit the outermost level.
+  smaxEpochEnter();
+  smaxEpochEnter();
+  smaxEpochRetire(malloc(1), destroy);
+  checkDestroyed("retire in read section", 1);
+  smaxEpochExit();
+  checkDestroyed("exit nested read section", 1);
+  smaxEpochExit();
+  checkDestroyed("exit read section", 2);
+
+  // Another thread's read section holds it back, until that thread exits it.
+  pthread_barrier_init(&barrier, NULL, 2);
+
+  if(pthread_create(&tid, NULL, Reader, NULL) != 0) {
+    perror("pthread_create");
+    exit(-1);
+  }
+
+  pthread_barrier_wait(&barrier);     // Reader entered
+  smaxEpochRetire(malloc(1), destroy);
+  checkDestroyed("retire while other thread reads", 2);
+
+  // Readers that enter after the retirement cannot see it, and do not hold it back.
+  smaxEpochEnter();
+  smaxEpochExit();
+  checkDestroyed("read section after retirement", 2);
+
+  pthread_barrier_wait(&barrier);     // Let the reader exit
+  pthread_join(tid, NULL);
+  checkDestroyed("other thread exited read section", 3);
+
+  pthread_barrier_destroy(&barrier);
+
+  printf("epoch: OK\n");
+  return 0;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file
+ *
+ * @date Created on: Oct 16, 2026
+ * @author Attila Kovacs
+ *
+ *      This program tests the hash index of variables (see smax-hash.c), without connecting to SMA-X:
+ *      lookups across resizes, removals, the reuse of vacated slots (tombstones), and colliding hashes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "smax-private.h"
+
+#define N_ITEMS     10000       ///< Number of items to index
+#define N_COLLIDING 20          ///< Number of items with the same hash
+#define N_REUSE     100000      ///< Number of add / remove cycles
+
+typedef struct {
+  char name[16];
+  unsigned long long hash;
+} Item;
+
+static Item items[N_ITEMS];
+
+static boolean matches(const void *item, const void *name) {
+  return strcmp(((const Item *) item)->name, (const char *) name) == 0;
+}
+
+static void check(const char *what, boolean ok) {
+  if(ok) return;
+  fprintf(stderr, "ERROR! %s\n", what);
+  exit(-1);
+}
+
+static boolean isIndexed(HashIndex *idx, const Item *item) {
+  return smaxHashFind(idx, item->hash, matches, item->name) == item;
+}
+
+static void testResize(HashIndex *idx) {
+  int i;
+
+  for(i = 0; i < N_ITEMS; i++) {
+    sprintf(items[i].name, "var%d", i);
+    items[i].hash = smaxHashID("_test_:hash", 0, items[i].name, 0);
+    check("add", smaxHashAdd(idx, items[i].hash, &items[i]) == X_SUCCESS);
+  }
+
+  check("count after adding", smaxHashCount(idx) == N_ITEMS);
+  for(i = 0; i < N_ITEMS; i++) check("lookup after resizing", isIndexed(idx, &items[i]));
+  check("lookup of missing item", smaxHashFind(idx, smaxHashID("_test_:hash", 0, "none", 0), matches, "none") == NULL);
+}
+
+static void testRemove(HashIndex *idx) {
+  int i;
+
+  for(i = 0; i < N_ITEMS; i += 2) check("remove", smaxHashRemove(idx, items[i].hash, &items[i]));
+  check("remove again", !smaxHashRemove(idx, items[0].hash, &items[0]));
+  check("count after removing", smaxHashCount(idx) == N_ITEMS / 2);
+
+  for(i = 0; i < N_ITEMS; i++) check(i & 1 ? "lookup of remaining" : "lookup of removed", isIndexed(idx, &items[i]) == (i & 1));
+
+  // Add the removed ones back, into the vacated slots.
+  for(i = 0; i < N_ITEMS; i += 2) check("add back", smaxHashAdd(idx, items[i].hash, &items[i]) == X_SUCCESS);
+  check("count after adding back", smaxHashCount(idx) == N_ITEMS);
+  for(i = 0; i < N_ITEMS; i++) check("lookup after adding back", isIndexed(idx, &items[i]));
+}
+
+static void testIterate(HashIndex *idx) {
+  char *seen = (char *) calloc(N_ITEMS, 1);
+  void **all;
+  int i, n, pos = 0;
+
+  for(i = 0; i < N_ITEMS; i++) {
+    Item *item = (Item *) smaxHashNext(idx, &pos);
+    check("next item", item != NULL);
+    check("next item repeated", !seen[item - items]);
+    seen[item - items] = 1;
+  }
+
+  all = smaxHashItems(idx, &n);
+  check("number of items", n == N_ITEMS);
+  free(all);
+  free(seen);
+}
+
+static void testCollisions() {
+  HashIndex *idx = smaxCreateHashIndex();
+  int i, k;
+
+  // Items with the same hash share a probe sequence, which must continue past the removed ones.
+  for(i = 0; i < N_COLLIDING; i++) {
+    items[i].hash = 42;
+    check("add colliding", smaxHashAdd(idx, 42, &items[i]) == X_SUCCESS);
+  }
+
+  for(i = 0; i < N_COLLIDING; i += 3) check("remove colliding", smaxHashRemove(idx, 42, &items[i]));
+  for(i = 0; i < N_COLLIDING; i++) check("lookup colliding", isIndexed(idx, &items[i]) == (i % 3 != 0));
+
+  for(i = 0; i < N_COLLIDING; i += 3) check("add back colliding", smaxHashAdd(idx, 42, &items[i]) == X_SUCCESS);
+  for(i = 0; i < N_COLLIDING; i++) check("lookup colliding after adding back", isIndexed(idx, &items[i]));
+
+  // Repeated add / remove cycles reuse the tombstones, or else trigger a rehash, without losing items.
+  for(k = 0; k < N_REUSE; k++) {
+    Item *item = &items[N_COLLIDING + (k % 100)];
+    item->hash = 1000 + k;
+    check("add cycled", smaxHashAdd(idx, item->hash, item) == X_SUCCESS);
+    check("lookup cycled", isIndexed(idx, item));
+    check("remove cycled", smaxHashRemove(idx, item->hash, item));
+    check("lookup removed cycled", !isIndexed(idx, item));
+  }
+
+  check("count after cycles", smaxHashCount(idx) == N_COLLIDING);
+  for(i = 0; i < N_COLLIDING; i++) check("lookup colliding after cycles", isIndexed(idx, &items[i]));
+
+  smaxHashClear(idx);
+  check("count after clear", smaxHashCount(idx) == 0);
+  check("lookup after clear", !isIndexed(idx, &items[0]));
+
+  smaxDestroyHashIndex(idx);
+}
+
+int main() {
+  HashIndex *idx = smaxCreateHashIndex();
+
+  testResize(idx);
+  testRemove(idx);
+  testIterate(idx);
+  smaxDestroyHashIndex(idx);
+
+  testCollisions();
+
+  printf("hash: OK\n");
+  return 0;
+}
@@ -16,11 +16,17 @@
 #include <stdlib.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <string.h>
 
 #include "smax.h"
 
+#ifndef SMAX_TEST_TIMEOUT
+#  define SMAX_TEST_TIMEOUT 3   ///< [s] Default timeout
+#endif
+
 #define TABLE   "_test_" X_SEP "lazy"
 #define NAME    "value"
+#define PAYLOAD "payload"
 
 // Variables updated by the polling thread and checked/reported by main()
 static int gotUpdate = FALSE;
@@ -82,6 +88,9 @@ int main() {
 
   smaxSetPipelined(TRUE);
 
+  // Send our (small) values with the update notifications, if the server supports it.
+  checkStatus("value notifications", smaxSetValueNotifications(TRUE, 0));
+
   checkStatus("connect", smaxConnect());
 
   // Initialize the value that we will poll, and change at some later time...
@@ -90,6 +99,98 @@ int main() {
   // Wait until we are sure the starting value is in the database.
   while(smaxPullInt(TABLE, NAME, -1) != 0) continue;
 
+  // Check that we can view the cached value without copying it...
+  {
+    const int *view = (const int *) smaxGetCachedView(TABLE, NAME, X_INT, 1, NULL);
+    if(!view || *view != 0) {
+      fprintf(stderr, "ERROR! Cached view returned the wrong value.\n");
+      exit(-1);
+    }
+    smaxReleaseCachedView(view);
+  }
+
+  // Check that the cache accounts for the variable...
+  {
+    XLazyCacheStats stats;
+    checkStatus("stats", smaxGetLazyCacheStats(&stats));
+    if(stats.entries < 1 || stats.bytes <= 0) {
+      fprintf(stderr, "ERROR! Lazy cache stats: %d entries, %ld bytes.\n", stats.entries, stats.bytes);
+      exit(-1);
+    }
+  }
+
+  // Check that we can read a consistent set of cached values...
+  {
+    int a = -1, b = -1;
+    XPullItem items[2] = {
+            { TABLE, NAME, X_INT, 1, &a, NULL, 0 },
+            { TABLE, NAME, X_INT, 1, &b, NULL, 0 }
+    };
+
+    checkStatus("get cached many", smaxGetCachedMany(items, 2));
+    if(a != 0 || b != 0) {
+      fprintf(stderr, "ERROR! Cached set returned the wrong values: %d, %d.\n", a, b);
+      exit(-1);
+    }
+  }
+
+  // Check that a value arriving with an update notification is cached without pulling it...
+  {
+    XEventQueue *q = smaxCreateEventQueue(TABLE, PAYLOAD, 0);
+    char ts[X_TIMESTAMP_LENGTH], msg[200];
+    XEvent e;
+    int i, value = -1;
+
+    if(!q) {
+      fprintf(stderr, "ERROR! Could not create event queue.\n");
+      exit(-1);
+    }
+
+    checkStatus("share payload", smaxShareInt(TABLE, PAYLOAD, 5));
+    checkStatus("cache payload", smaxGetCached(TABLE, PAYLOAD, X_INT, 1, &value, NULL));
+
+    // Wait for the update notification of our share, and for any resulting refresh, to be done with it.
+    checkStatus("payload share event", smaxNextEvent(q, &e, 1000 * SMAX_TEST_TIMEOUT));
+    smaxClearEvent(&e);
+    checkStatus("payload settle", smaxWaitQueueComplete(1000 * SMAX_TEST_TIMEOUT));
+
+    // Publish a different value than what is in the database, the same way HSetWithMetaValue would.
+    smaxTimestamp(ts);
+    sprintf(msg, "elsewhere\n%s\n1\nint32\n1\n42", ts);
+    checkStatus("publish payload", redisxNotify(smaxGetRedis(), SMAX_UPDATES TABLE X_SEP PAYLOAD, msg));
+
+    checkStatus("payload event", smaxNextEvent(q, &e, 1000 * SMAX_TEST_TIMEOUT));
+    if(!e.origin || strcmp(e.origin, "elsewhere") != 0) {
+      fprintf(stderr, "ERROR! Event origin is '%s', expected 'elsewhere'.\n", e.origin ? e.origin : "(null)");
+      exit(-1);
+    }
+    smaxClearEvent(&e);
+    smaxDestroyEventQueue(q);
+
+    // The database still holds 5, so we can only get 42 from the notification.
+    for(i = 0; i < 100; i++) {
+      struct timespec interval = { 0, 10000000 }; // 10 ms
+      checkStatus("get payload", smaxGetCached(TABLE, PAYLOAD, X_INT, 1, &value, NULL));
+      if(value == 42) break;
+
+      // A refresh, that was still in flight, may have overwritten it. Publish again.
+      if(i % 20 == 19) checkStatus("publish payload", redisxNotify(smaxGetRedis(), SMAX_UPDATES TABLE X_SEP PAYLOAD, msg));
+      nanosleep(&interval, NULL);
+    }
+
+    if(value != 42) {
+      fprintf(stderr, "ERROR! Value from notification was not cached: %d.\n", value);
+      exit(-1);
+    }
+
+    if(smaxPullInt(TABLE, PAYLOAD, -1) != 5) {
+      fprintf(stderr, "ERROR! Database value changed.\n");
+      exit(-1);
+    }
+
+    smaxLazyEnd(TABLE, PAYLOAD);
+  }
+
   // Start the thread that will pound on lazy pulls...
   if(pthread_create(&tid, NULL, PollingThread, NULL)) {
     perror("create PollingThread");
@@ -102,6 +203,16 @@ int main() {
   // We'll update the value here...
   checkStatus("update", smaxShareInt(TABLE, NAME, 1));
 
+  // Our own write should be in the cache right away...
+  {
+    int value = -1;
+    checkStatus("get cached", smaxGetCached(TABLE, NAME, X_INT, 1, &value, NULL));
+    if(value != 1) {
+      fprintf(stderr, "ERROR! Cache was not written through: %d.\n", value);
+      exit(-1);
+    }
+  }
+
   // Give the PollingThread a bit of time to detect the change and exit normally
   while(--timeoutLoops >= 0) {
     struct timespec interval = { 0, 10000000 }; // Check every 10ms
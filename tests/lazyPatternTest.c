@@ -0,0 +1,81 @@
+/**
+ * @file
+ *
+ * @date Created on: Oct 16, 2026
+ * @author Attila Kovacs
+ *
+ *      Tests caching a pattern of variables via smaxCachePattern(), including variables that appear
+ *      under the pattern after it was cached.
+ */
+
+#define _POSIX_C_SOURCE 199309L       ///< for nanosleep()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "smax.h"
+
+#define TABLE   "_test_" X_SEP "pattern"
+#define PATTERN TABLE X_SEP "*"
+
+static void checkStatus(char *op, int status) {
+  if(!status) return;
+  fprintf(stderr, "ERROR! %s: %s\n", op, smaxErrorDescription(status));
+  exit(-1);
+}
+
+int main() {
+  int i, n, value = -1;
+
+  xSetDebug(TRUE);
+
+  smaxSetPipelined(TRUE);
+
+  checkStatus("connect", smaxConnect());
+
+  checkStatus("share a", smaxShareInt(TABLE, "a", 1));
+  checkStatus("share b", smaxShareInt(TABLE, "b", 2));
+  checkStatus("share c", smaxShareInt(TABLE, "c", 3));
+
+  // Wait until we are sure the values are in the database.
+  while(smaxPullInt(TABLE, "c", -1) != 3) continue;
+
+  n = smaxCachePattern(PATTERN);
+  if(n < 3) {
+    fprintf(stderr, "ERROR! Cached %d variables under the pattern (expected 3).\n", n);
+    return -1;
+  }
+
+  checkStatus("get cached b", smaxGetCached(TABLE, "b", X_INT, 1, &value, NULL));
+  if(value != 2) {
+    fprintf(stderr, "ERROR! Cached value of b is %d (expected 2).\n", value);
+    return -1;
+  }
+
+  // A new variable under the pattern should be cached automatically.
+  checkStatus("share d", smaxShareInt(TABLE, "d", 4));
+
+  for(i = 100; --i >= 0; ) {
+    struct timespec interval = { 0, 10000000 }; // Check every 10ms
+    if(smaxGetLazyUpdateCount(TABLE, "d") >= 0) break;
+    nanosleep(&interval, NULL);
+  }
+
+  if(i < 0) {
+    fprintf(stderr, "ERROR! New variable was not cached.\n");
+    return -1;
+  }
+
+  checkStatus("end pattern", smaxLazyEndPattern(PATTERN));
+
+  if(smaxGetLazyUpdateCount(TABLE, "a") >= 0) {
+    fprintf(stderr, "ERROR! Variable is still cached after ending the pattern.\n");
+    return -1;
+  }
+
+  smaxDisconnect();
+
+  printf("lazy pattern: OK (%d variables)\n", n);
+  return 0;
+}
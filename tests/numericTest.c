@@ -0,0 +1,289 @@
+/**
+ * @file
+ *
+ * @date Created on: Oct 16, 2026
+ * @author Attila Kovacs
+ *
+ *      This program tests the conversion of numerical values to and from their ASCII representation,
+ *      via smaxValuesToString() and smaxStringToValues(), without connecting to SMA-X. Formatted values
+ *      must parse back to the same binary values, with the shortest representation for common cases,
+ *      and the fast parsers must agree with the C library for every token they accept (or leave it to
+ *      the C library).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <float.h>
+#include <math.h>
+
+#include "smax.h"
+
+#define ROUNDS    100000      ///< Number of random values to test
+
+static int nErrors;
+
+static uint64_t seed = 0x9E3779B97F4A7C15ULL;
+
+// xorshift64* random bits.
+static uint64_t randomBits() {
+  seed ^= seed >> 12;
+  seed ^= seed << 25;
+  seed ^= seed >> 27;
+  return seed * 2685821657736338717ULL;
+}
+
+static void fail(const char *what, const char *str) {
+  fprintf(stderr, "ERROR! %s: '%s'\n", what, str);
+  nErrors++;
+}
+
+// Formats a double, and checks that it parses back to the identical value.
+static void checkDouble(double value, const char *expected) {
+  char buf[40], *str = smaxValuesToString(&value, X_DOUBLE, 1, buf, sizeof(buf));
+  double d = 0.0;
+  int pos;
+
+  if(!str) {
+    fail("format double", "");
+    return;
+  }
+
+  if(expected) if(strcmp(str, expected) != 0) fail("double not formatted as expected", str);
+
+  if(smaxStringToValues(str, &d, X_DOUBLE, 1, &pos) != 1) fail("parse double", str);
+  else if(isnan(value) ? !isnan(d) : (memcmp(&d, &value, sizeof(d)) != 0)) fail("double round-trip", str);
+  else if(strtod(str, NULL) != d && !isnan(d)) fail("double disagrees with strtod()", str);
+
+  if(str != buf) free(str);
+}
+
+// Formats a float, and checks that it parses back to the identical value.
+static void checkFloat(float value, const char *expected) {
+  char buf[40], *str = smaxValuesToString(&value, X_FLOAT, 1, buf, sizeof(buf));
+  float f = 0.0F;
+  int pos;
+
+  if(!str) {
+    fail("format float", "");
+    return;
+  }
+
+  if(expected) if(strcmp(str, expected) != 0) fail("float not formatted as expected", str);
+
+  if(smaxStringToValues(str, &f, X_FLOAT, 1, &pos) != 1) fail("parse float", str);
+  else if(isnan(value) ? !isnan(f) : (memcmp(&f, &value, sizeof(f)) != 0)) fail("float round-trip", str);
+  else if(strtof(str, NULL) != f && !isnan(f)) fail("float disagrees with strtof()", str);
+
+  if(str != buf) free(str);
+}
+
+// Formats a long long, and checks that it parses back to the same value.
+static void checkLong(long long value, const char *expected) {
+  char buf[40], *str = smaxValuesToString(&value, X_LLONG, 1, buf, sizeof(buf));
+  long long l = 0;
+  int pos;
+
+  if(!str) {
+    fail("format long", "");
+    return;
+  }
+
+  if(strcmp(str, expected) != 0) fail("long not formatted as expected", str);
+  if(smaxStringToValues(str, &l, X_LLONG, 1, &pos) != 1 || l != value) fail("long round-trip", str);
+
+  if(str != buf) free(str);
+}
+
+// Parses a double, and checks it against strtod().
+static void checkParseDouble(const char *str) {
+  double d = 0.0;
+  int pos;
+
+  if(smaxStringToValues(str, &d, X_DOUBLE, 1, &pos) != 1) fail("parse double", str);
+  else if(memcmp(&d, &(double) { strtod(str, NULL) }, sizeof(d)) != 0) fail("parsed double disagrees with strtod()", str);
+}
+
+// Parses a float, and checks it against strtof().
+static void checkParseFloat(const char *str) {
+  float f = 0.0F;
+  int pos;
+
+  if(smaxStringToValues(str, &f, X_FLOAT, 1, &pos) != 1) fail("parse float", str);
+  else if(memcmp(&f, &(float) { strtof(str, NULL) }, sizeof(f)) != 0) fail("parsed float disagrees with strtof()", str);
+}
+
+static void testShortest() {
+  checkDouble(0.1, "0.1");
+  checkDouble(0.3, "0.3");
+  checkDouble(1.0 / 3.0, "0.3333333333333333");
+  checkDouble(123.456, "123.456");
+  checkDouble(100.0, "100");
+  checkDouble(1e16, "10000000000000000");
+  checkDouble(1e17, "1e+17");
+  checkDouble(1e-4, "0.0001");
+  checkDouble(1e-5, "1e-05");
+  checkDouble(1.5e-7, "1.5e-07");
+  checkDouble(DBL_MAX, "1.7976931348623157e+308");
+  checkDouble(DBL_MIN, "2.2250738585072014e-308");
+
+  checkFloat(0.1F, "0.1");
+  checkFloat(1.0F / 3.0F, "0.33333334");
+  checkFloat(3.14159265F, "3.1415927");
+  checkFloat(16777216.0F, "16777216");
+  checkFloat(1e9F, "1e+09");
+  checkFloat(FLT_MAX, "3.4028235e+38");
+  checkFloat(FLT_MIN, "1.1754944e-38");
+}
+
+static void testSpecial() {
+  // Denormals
+  checkDouble(4.9406564584124654e-324, "5e-324");
+  checkDouble(2.2250738585072009e-308, "2.225073858507201e-308");
+  checkFloat(1.40129846e-45F, "1e-45");
+  checkFloat(1.17549421e-38F, NULL);
+
+  // Signed zeroes
+  checkDouble(0.0, "0");
+  checkDouble(-0.0, "-0");
+  checkFloat(0.0F, "0");
+  checkFloat(-0.0F, "-0");
+
+  // Infinite and NaN values
+  checkDouble(INFINITY, NULL);
+  checkDouble(-INFINITY, NULL);
+  checkDouble(NAN, NULL);
+  checkFloat(INFINITY, NULL);
+  checkFloat(-INFINITY, NULL);
+  checkFloat(NAN, NULL);
+
+  // Integer limits
+  checkLong(LLONG_MAX, "9223372036854775807");
+  checkLong(LLONG_MIN, "-9223372036854775808");
+  checkLong(0, "0");
+  checkLong(-1, "-1");
+}
+
+static void testRandom() {
+  int i;
+
+  for(i = 0; i < ROUNDS; i++) {
+    uint64_t bits = randomBits();
+    double d;
+    float f;
+    char str[40];
+
+    // Any bit pattern (including denormals, infinities and NaNs)
+    memcpy(&d, &bits, sizeof(d));
+    checkDouble(d, NULL);
+
+    bits >>= 32;
+    memcpy(&f, &bits, sizeof(f));
+    checkFloat(f, NULL);
+
+    // Decimal tokens of various lengths, which may or may not qualify for the fast path.
+    // (Rounding to fewer digits may overflow near the maximum, which is a parse error).
+    sprintf(str, "%.*g", 1 + (int) (randomBits() % 17), d);
+    if(isfinite(strtod(str, NULL))) checkParseDouble(str);
+
+    sprintf(str, "%.*g", 1 + (int) (randomBits() % 9), (double) f);
+    if(isfinite(strtof(str, NULL))) checkParseFloat(str);
+  }
+}
+
+static void testDigits() {
+  static const char *tokens[] = {
+          "1", "12", "1234567", "12345678", "123456789", "1234567890123456", "12345678901234567",
+          "-12345678", "+12345678", "0.12345678", "12345678.12345678", "9007199254740993", "1e22", "1e23",
+          "123456789e-22", "0.000000001234567890", "3.4028235e+38", "1e-45", NULL
+  };
+  int i;
+
+  for(i = 0; tokens[i]; i++) {
+    checkParseDouble(tokens[i]);
+    checkParseFloat(tokens[i]);
+  }
+
+  // Beyond the range of floats
+  checkParseDouble("1.0e+308");
+  checkParseDouble("2.4703282292062328e-324");
+
+  // Too many digits for the fast path (or leading zeroes, which are not)
+  checkParseDouble("0.1000000000000000055511151231257827021181583404541015625");
+  checkParseDouble("123456789012345678901234567890");
+  checkParseDouble("00000000000000000000000000000000001.5");
+  checkParseFloat("0.100000001490116119384765625");
+}
+
+static void testGarbage() {
+  double d[2];
+  long long l[2];
+  int pos;
+
+  // Trailing garbage ends the token
+  if(smaxStringToValues("1.5abc", d, X_DOUBLE, 1, &pos) != 1 || d[0] != 1.5 || pos != 3) fail("trailing garbage", "1.5abc");
+  if(smaxStringToValues("12345678x", l, X_LLONG, 1, &pos) != 1 || l[0] != 12345678 || pos != 8) fail("trailing garbage", "12345678x");
+
+  // ... and is not a value
+  if(smaxStringToValues("1.5abc", d, X_DOUBLE, 2, &pos) != X_PARSE_ERROR) fail("garbage element", "1.5abc");
+
+  // Leading garbage
+  if(smaxStringToValues("abc 1.5", d, X_DOUBLE, 2, &pos) != X_PARSE_ERROR) fail("leading garbage", "abc 1.5");
+  if(smaxStringToValues("x12345678", l, X_LLONG, 1, &pos) != X_PARSE_ERROR) fail("leading garbage", "x12345678");
+
+  // Integers that do not fit into a long long
+  if(smaxStringToValues("123456789012345678901234567890", l, X_LLONG, 1, &pos) != X_PARSE_ERROR) fail("integer overflow", "1234567890...");
+  if(smaxStringToValues("-9223372036854775809", l, X_LLONG, 1, &pos) != X_PARSE_ERROR) fail("integer underflow", "-9223372036854775809");
+
+  // Octal and hexadecimal integers are left to strtoll()
+  if(smaxStringToValues("010 0x10", l, X_LLONG, 2, &pos) != 2 || l[0] != 8 || l[1] != 16) fail("octal / hex", "010 0x10");
+}
+
+static void testSpaces() {
+  static const char *ws = " \t\n\v\f\r";
+  char str[200];
+  double d[3];
+  int i, pos;
+
+  // Separators of every length around the 16-byte vector width, so both the vectorized and the scalar
+  // paths of skipping spaces are exercised (on either side of a value).
+  for(i = 1; i < 50; i++) {
+    int j, n = 0;
+
+    for(j = 0; j < i; j++) str[n++] = ws[j % 6];
+    n += sprintf(&str[n], "1.25");
+    for(j = 0; j < i; j++) str[n++] = ws[(i + j) % 6];
+    n += sprintf(&str[n], "-2.5");
+    for(j = 0; j < i; j++) str[n++] = ' ';
+    n += sprintf(&str[n], "1e3");
+    for(j = 0; j < i; j++) str[n++] = '\t';
+    str[n] = '\0';
+
+    if(smaxStringToValues(str, d, X_DOUBLE, 3, &pos) != 3 || d[0] != 1.25 || d[1] != -2.5 || d[2] != 1e3) {
+      fprintf(stderr, "ERROR! %d-byte separators\n", i);
+      nErrors++;
+    }
+  }
+
+  // Non-space control characters are not separators.
+  if(smaxStringToValues("1\b2", d, X_DOUBLE, 2, &pos) == 2) fail("control character as separator", "1\\b2");
+}
+
+int main() {
+  testShortest();
+  testSpecial();
+  testRandom();
+  testDigits();
+  testGarbage();
+  testSpaces();
+
+  if(nErrors) {
+    fprintf(stderr, "FAILED with %d errors.\n", nErrors);
+    return -1;
+  }
+
+  printf("numeric: OK\n");
+  return 0;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file
+ *
+ * @date Created on: Oct 16, 2026
+ * @author Attila Kovacs
+ *
+ *      Tests sharing and pulling data concurrently from multiple threads, using a pool of
+ *      interactive connections.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "smax.h"
+
+#define TABLE       "_test_" X_SEP "pool"
+#define THREADS     8
+#define ITERATIONS  100
+
+static void checkStatus(char *op, int status) {
+  if(!status) return;
+  fprintf(stderr, "ERROR! %s: %s\n", op, smaxErrorDescription(status));
+  exit(-1);
+}
+
+static void *Worker(void *arg) {
+  int id = *(int *) arg, i;
+  char key[20];
+
+  sprintf(key, "thread%d", id);
+
+  for(i = 0; i < ITERATIONS; i++) {
+    int value = -1;
+
+    checkStatus("share", smaxShareInt(TABLE, key, id * ITERATIONS + i));
+    checkStatus("pull", smaxPull(TABLE, key, X_INT, 1, &value, NULL));
+
+    if(value != id * ITERATIONS + i) {
+      fprintf(stderr, "ERROR! %s mismatch: got %d, expected %d\n", key, value, id * ITERATIONS + i);
+      exit(-1);
+    }
+  }
+
+  return NULL;
+}
+
+int main() {
+  pthread_t tid[THREADS];
+  int ids[THREADS], i;
+
+  xSetDebug(TRUE);
+
+  checkStatus("pool size", smaxSetInteractivePoolSize(4));
+  checkStatus("policy", smaxSetPoolPolicy(SMAX_POOL_THREAD_AFFINITY));
+
+  checkStatus("connect", smaxConnect());
+
+  if(smaxSetInteractivePoolSize(2) != X_ALREADY_OPEN) {
+    fprintf(stderr, "ERROR! pool size changed while connected\n");
+    exit(-1);
+  }
+
+  for(i = 0; i < THREADS; i++) {
+    ids[i] = i;
+    if(pthread_create(&tid[i], NULL, Worker, &ids[i])) {
+      perror("ERROR! pthread_create");
+      exit(-1);
+    }
+  }
+
+  for(i = 0; i < THREADS; i++) pthread_join(tid[i], NULL);
+
+  // Pulls right after shares must still read back the thread's own writes
+  checkStatus("policy", smaxSetPoolPolicy(SMAX_POOL_LEAST_BUSY));
+
+  for(i = 0; i < THREADS; i++) {
+    if(pthread_create(&tid[i], NULL, Worker, &ids[i])) {
+      perror("ERROR! pthread_create");
+      exit(-1);
+    }
+  }
+
+  for(i = 0; i < THREADS; i++) pthread_join(tid[i], NULL);
+
+  checkStatus("disconnect", smaxDisconnect());
+
+  printf("OK\n");
+  return 0;
+}
@@ -16,6 +16,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <stdint.h>
 
 #include "smax.h"
 
@@ -33,6 +34,10 @@
 
 static int testSyncPoint();
 static int testWaitComplete();
+static int testDeadline();
+static int testOverflow();
+static int testCompletionThreads();
+static int testTailRace();
 static int testCallback();
 
 static void checkStatus(char *op, int status) {
@@ -56,6 +61,10 @@ int main() {
 
   if(testSyncPoint()) exit(-1);
   if(testWaitComplete()) exit(-1);
+  if(testDeadline()) exit(-1);
+  if(testOverflow()) exit(-1);
+  if(testCompletionThreads()) exit(-1);
+  if(testTailRace()) exit(-1);
   if(testCallback()) exit(-1);
 
   checkStatus("disconnect", smaxDisconnect());
@@ -161,6 +170,237 @@ static int testWaitComplete() {
 
 
 
+// This test demonstrates queueing a pull with a deadline, and waiting on it via its handle.
+// Had the response not arrived before the deadline, the wait would return X_TIMEDOUT, and
+// the variable would be left untouched.
+static int testDeadline() {
+  XPullHandle *h = NULL;
+  int i = 0;
+
+  checkStatus("deadline queue", smaxQueueWithDeadline(TABLE, NAME1, X_INT, 1, &i, NULL, 1000 * SMAX_TEST_TIMEOUT, &h));
+  checkStatus("deadline wait", smaxWaitPull(h));
+
+  if(i != IVALUE) {
+    fprintf(stderr, "ERROR! deadline: Integer value mismatch (%d vs %d).\n", i, IVALUE);
+    exit(-1);
+  }
+
+  // A completed pull can no longer be cancelled.
+  if(smaxCancelPull(h) == X_SUCCESS) {
+    fprintf(stderr, "ERROR! deadline: Cancelled a completed pull.\n");
+    exit(-1);
+  }
+
+  smaxDestroyPullHandle(h);
+
+  printf("deadline: OK\n");
+
+  return 0;
+}
+
+
+// Submits a burst of pulls against a tiny queue limit, and checks that each overflow policy
+// does what it should, with the corresponding overflow statistics.
+#define OVERFLOW_PULLS    1000
+
+static int overflowValues[OVERFLOW_PULLS];
+
+static int queueBurst(enum smax_queue_overflow policy, int *incomplete) {
+  int k;
+
+  checkStatus("overflow policy", smaxSetQueueOverflowPolicy(policy));
+
+  *incomplete = 0;
+  memset(overflowValues, 0, sizeof(overflowValues));
+
+  for(k = 0; k < OVERFLOW_PULLS; k++) {
+    int status = smaxQueue(TABLE, NAME1, X_INT, 1, &overflowValues[k], NULL);
+    if(status == X_INCOMPLETE && policy == SMAX_QUEUE_FAIL) {
+      overflowValues[k] = IVALUE;    // Not queued, so will not be set.
+      (*incomplete)++;
+    }
+    else checkStatus("overflow queue", status);
+  }
+
+  checkStatus("overflow wait", smaxWaitQueueComplete(1000 * SMAX_TEST_TIMEOUT));
+
+  for(k = 0; k < OVERFLOW_PULLS; k++) if(overflowValues[k] != IVALUE) {
+    fprintf(stderr, "ERROR! overflow: value %d mismatch (%d vs %d).\n", k, overflowValues[k], IVALUE);
+    exit(-1);
+  }
+
+  return 0;
+}
+
+static int testOverflow() {
+  XQueueStats stats;
+  int n;
+
+  checkStatus("max pending", smaxSetMaxPendingPulls(1));
+
+  // SMAX_QUEUE_BLOCK: all pulls are queued, after waiting for the queue to drain.
+  smaxResetQueueStats();
+  queueBurst(SMAX_QUEUE_BLOCK, &n);
+  checkStatus("overflow stats", smaxGetQueueStats(&stats));
+  if(stats.stalls <= 0 || stats.maxStallTime > stats.stallTime) {
+    fprintf(stderr, "ERROR! overflow: no stalls recorded with SMAX_QUEUE_BLOCK.\n");
+    exit(-1);
+  }
+  if(stats.rejected || stats.redirected) {
+    fprintf(stderr, "ERROR! overflow: unexpected rejected / redirected pulls with SMAX_QUEUE_BLOCK.\n");
+    exit(-1);
+  }
+
+  // SMAX_QUEUE_FAIL: overflowing pulls are rejected with X_INCOMPLETE.
+  smaxResetQueueStats();
+  queueBurst(SMAX_QUEUE_FAIL, &n);
+  checkStatus("overflow stats", smaxGetQueueStats(&stats));
+  if(n <= 0 || stats.rejected != n) {
+    fprintf(stderr, "ERROR! overflow: rejected %d pulls, with %ld counted.\n", n, stats.rejected);
+    exit(-1);
+  }
+  if(stats.stalls || stats.redirected) {
+    fprintf(stderr, "ERROR! overflow: unexpected stalls / redirected pulls with SMAX_QUEUE_FAIL.\n");
+    exit(-1);
+  }
+
+  // SMAX_QUEUE_INTERACTIVE: overflowing pulls are done right away, interactively.
+  smaxResetQueueStats();
+  queueBurst(SMAX_QUEUE_INTERACTIVE, &n);
+  checkStatus("overflow stats", smaxGetQueueStats(&stats));
+  if(stats.redirected <= 0) {
+    fprintf(stderr, "ERROR! overflow: no redirected pulls with SMAX_QUEUE_INTERACTIVE.\n");
+    exit(-1);
+  }
+  if(stats.stalls || stats.rejected) {
+    fprintf(stderr, "ERROR! overflow: unexpected stalls / rejected pulls with SMAX_QUEUE_INTERACTIVE.\n");
+    exit(-1);
+  }
+
+  // Restore defaults
+  checkStatus("overflow policy", smaxSetQueueOverflowPolicy(SMAX_QUEUE_BLOCK));
+  checkStatus("max pending", smaxSetMaxPendingPulls(SMAX_DEFAULT_MAX_QUEUED));
+  smaxResetQueueStats();
+
+  printf("overflow: OK\n");
+
+  return 0;
+}
+
+
+// This test runs callbacks on a single completion thread, and checks that they are called in the
+// order they were queued, that synchronization points are reached once the pulls and inline
+// callbacks before them are done, and that stopping the completion thread still runs all the
+// callbacks that were handed to it.
+#define COMPLETIONS   100
+
+static int completionOrder[COMPLETIONS];
+static int nCompleted;
+
+static void recordCompletion(void *arg) {
+  usleep(1000);     // Slow enough to have pending tasks when the thread is stopped
+  completionOrder[__atomic_fetch_add(&nCompleted, 1, __ATOMIC_SEQ_CST)] = (int) (intptr_t) arg;
+}
+
+static void markCalled(void *arg) {
+  *(int *) arg = TRUE;
+}
+
+static int testCompletionThreads() {
+  XSyncPoint *s;
+  int values[COMPLETIONS], isInlineCalled = FALSE, k;
+
+  checkStatus("completion threads", smaxSetCompletionThreads(1));
+
+  if(smaxGetCompletionThreads() != 1) {
+    fprintf(stderr, "ERROR! completion: got %d threads, expected 1.\n", smaxGetCompletionThreads());
+    exit(-1);
+  }
+
+  nCompleted = 0;
+  memset(values, 0, sizeof(values));
+
+  for(k = 0; k < COMPLETIONS; k++) {
+    checkStatus("completion queue", smaxQueue(TABLE, NAME1, X_INT, 1, &values[k], NULL));
+    checkStatus("completion callback", smaxQueueCallback(recordCompletion, (void *) (intptr_t) k));
+  }
+
+  checkStatus("completion inline", smaxQueueInlineCallback(markCalled, &isInlineCalled));
+
+  s = smaxCreateSyncPoint();
+  checkStatus("completion sync", smaxSync(s, 1000 * SMAX_TEST_TIMEOUT));
+  smaxDestroySyncPoint(s);
+
+  // Pulls and inline callbacks before the sync point are done
+  for(k = 0; k < COMPLETIONS; k++) if(values[k] != IVALUE) {
+    fprintf(stderr, "ERROR! completion: value %d mismatch (%d vs %d).\n", k, values[k], IVALUE);
+    exit(-1);
+  }
+
+  if(!isInlineCalled) {
+    fprintf(stderr, "ERROR! completion: inline callback not called before sync point.\n");
+    exit(-1);
+  }
+
+  // Stopping the thread runs the callbacks still pending.
+  checkStatus("completion stop", smaxSetCompletionThreads(0));
+
+  if(nCompleted != COMPLETIONS) {
+    fprintf(stderr, "ERROR! completion: %d of %d callbacks called after stopping.\n", nCompleted, COMPLETIONS);
+    exit(-1);
+  }
+
+  for(k = 0; k < COMPLETIONS; k++) if(completionOrder[k] != k) {
+    fprintf(stderr, "ERROR! completion: callback %d called as #%d.\n", completionOrder[k], k);
+    exit(-1);
+  }
+
+  printf("completion threads: OK\n");
+
+  return 0;
+}
+
+
+// This test queues sync points and callbacks right behind single pulls, over and over, so that
+// they are often published just as the response to the pull is processed. Each must still be
+// reached without any further response to follow, or else the waits below would time out.
+#define RACE_ROUNDS   1000
+
+static int nRaceCalls;
+
+static void countRaceCall(void *arg) {
+  (void) arg;
+  __atomic_add_fetch(&nRaceCalls, 1, __ATOMIC_SEQ_CST);
+}
+
+static int testTailRace() {
+  int k, value;
+
+  nRaceCalls = 0;
+
+  for(k = 0; k < RACE_ROUNDS; k++) {
+    XSyncPoint *s;
+
+    checkStatus("race queue", smaxQueue(TABLE, NAME1, X_INT, 1, &value, NULL));
+    checkStatus("race callback", smaxQueueCallback(countRaceCall, NULL));
+
+    s = smaxCreateSyncPoint();
+    checkStatus("race sync", smaxSync(s, 1000 * SMAX_TEST_TIMEOUT));
+    smaxDestroySyncPoint(s);
+  }
+
+  checkStatus("race wait", smaxWaitQueueComplete(1000 * SMAX_TEST_TIMEOUT));
+
+  if(nRaceCalls != RACE_ROUNDS) {
+    fprintf(stderr, "ERROR! race: %d of %d callbacks called.\n", nRaceCalls, RACE_ROUNDS);
+    exit(-1);
+  }
+
+  printf("tail race: OK\n");
+
+  return 0;
+}
+
 
 // For the callback example, we need variables that will exists beyond and outside
 // of the function that queues them, so they are valid even if that function finishes
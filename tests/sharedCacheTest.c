@@ -0,0 +1,104 @@
+/**
+ * @file
+ *
+ * @date Created on: Oct 16, 2026
+ * @author Attila Kovacs
+ *
+ *      This program tests sharing the lazy cache between processes on the same host. The parent process
+ *      maintains the cache, while a child process reads the cached variable from shared memory.
+ */
+
+#define _POSIX_C_SOURCE 199309L       ///< for nanosleep()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/wait.h>
+
+#include "smax.h"
+
+#define TABLE   "_test_" X_SEP "shared"
+#define NAME    "value"
+#define SHM     "smax-shared-test"
+
+static void checkStatus(char *op, int status) {
+  if(!status) return;
+  fprintf(stderr, "ERROR! %s: %s\n", op, smaxErrorDescription(status));
+  exit(-1);
+}
+
+static int RunReader() {
+  struct timespec interval = { 0, 10000000 }; // 10 ms
+  int i, value = -1;
+
+  // Wait for the parent to share its cache
+  for(i = 0; smaxAttachLazyCache(SHM) != X_SUCCESS; i++) {
+    if(i > 500) {
+      fprintf(stderr, "ERROR! Could not attach to shared cache.\n");
+      return -1;
+    }
+    nanosleep(&interval, NULL);
+  }
+
+  // We do not connect to SMA-X, so the value can only come from the shared cache. (While the parent's
+  // update is in flight, the mirror has no current value, and the fallback pull fails.)
+  for(i = 0; i < 500; i++) {
+    if(smaxGetCached(TABLE, NAME, X_INT, 1, &value, NULL) == X_SUCCESS) if(value == 2) break;
+    nanosleep(&interval, NULL);
+  }
+
+  smaxDetachLazyCache();
+
+  if(value != 2) {
+    fprintf(stderr, "ERROR! Shared cache returned %d.\n", value);
+    return -1;
+  }
+
+  return 0;
+}
+
+int main() {
+  pid_t pid;
+  int status;
+
+  xSetDebug(TRUE);
+
+  pid = fork();
+  if(pid < 0) {
+    perror("fork");
+    exit(-1);
+  }
+
+  if(pid == 0) exit(RunReader());
+
+  smaxSetPipelined(TRUE);
+  checkStatus("connect", smaxConnect());
+
+  checkStatus("share", smaxShareInt(TABLE, NAME, 1));
+  while(smaxPullInt(TABLE, NAME, -1) != 1) continue;
+
+  checkStatus("cache", smaxCache(TABLE, NAME, X_INT));
+  checkStatus("share cache", smaxShareLazyCache(SHM, 0, 0));
+
+  sleep(1);
+
+  // Update the value, which the child should see in the shared cache.
+  checkStatus("update", smaxShareInt(TABLE, NAME, 2));
+
+  if(waitpid(pid, &status, 0) < 0) {
+    perror("waitpid");
+    exit(-1);
+  }
+
+  smaxDetachLazyCache();
+  smaxDisconnect();
+
+  if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    fprintf(stderr, "ERROR! Reader process failed.\n");
+    return -1;
+  }
+
+  printf("shared cache: OK\n");
+  return 0;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file
+ *
+ * @date Created on: Oct 16, 2026
+ * @author Attila Kovacs
+ *
+ *      This program tests exact subscriptions to variables, including the first one, which connects the
+ *      subscription client. Unsubscribing must remove every subscription from the server, whether it was
+ *      made as an exact channel or a pattern.
+ */
+
+#define _POSIX_C_SOURCE 199309L       ///< for nanosleep()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "smax.h"
+
+#define TABLE   "_test_" X_SEP "subscribe"
+
+static void checkStatus(char *op, int status) {
+  if(!status) return;
+  fprintf(stderr, "ERROR! %s: %s\n", op, smaxErrorDescription(status));
+  exit(-1);
+}
+
+// Returns the number of pattern subscriptions on the server.
+static int countPatterns() {
+  RESP *reply;
+  int status = X_SUCCESS, n;
+
+  reply = redisxRequest(smaxGetRedis(), "PUBSUB", "NUMPAT", NULL, NULL, &status);
+  checkStatus("numpat", status);
+  checkStatus("numpat reply", redisxCheckRESP(reply, RESP_INT, 0));
+
+  n = reply->n;
+  redisxDestroyRESP(reply);
+
+  return n;
+}
+
+// Returns the number of clients subscribed to the update notifications of a variable exactly.
+static int countSubscribers(const char *key) {
+  RESP *reply;
+  char *channel = xGetAggregateID(SMAX_UPDATES TABLE, key);
+  int status = X_SUCCESS, n;
+
+  reply = redisxRequest(smaxGetRedis(), "PUBSUB", "NUMSUB", channel, NULL, &status);
+  checkStatus("numsub", status);
+  checkStatus("numsub reply", redisxCheckRESP(reply, RESP_ARRAY, 2));
+
+  n = ((RESP **) reply->value)[1]->n;
+  redisxDestroyRESP(reply);
+  free(channel);
+
+  return n;
+}
+
+// Waits until the server reports the expected subscriptions, or else exits with an error.
+static void waitFor(const char *what, int patterns, int exact) {
+  struct timespec interval = { 0, 10000000 }; // 10 ms
+  int i;
+
+  for(i = 0; i < 500; i++) {
+    if(countPatterns() == patterns && countSubscribers("second") == exact) return;
+    nanosleep(&interval, NULL);
+  }
+
+  fprintf(stderr, "ERROR! %s: %d patterns, %d exact (expected %d, %d).\n", what, countPatterns(),
+          countSubscribers("second"), patterns, exact);
+  exit(-1);
+}
+
+int main() {
+  int patterns;
+
+  xSetDebug(TRUE);
+
+  checkStatus("connect", smaxConnect());
+
+  patterns = countPatterns();
+
+  // The first subscription connects the subscription client also.
+  checkStatus("subscribe first", smaxSubscribe(TABLE, "first"));
+  checkStatus("subscribe second", smaxSubscribe(TABLE, "second"));
+  waitFor("subscribe", countPatterns(), 1);
+
+  checkStatus("unsubscribe first", smaxUnsubscribe(TABLE, "first"));
+  checkStatus("unsubscribe second", smaxUnsubscribe(TABLE, "second"));
+  waitFor("unsubscribe", patterns, 0);
+
+  if(countSubscribers("first") != 0) {
+    fprintf(stderr, "ERROR! Still subscribed to the first variable.\n");
+    exit(-1);
+  }
+
+  // Once more, now that the subscription client is connected.
+  checkStatus("resubscribe first", smaxSubscribe(TABLE, "first"));
+  checkStatus("resubscribe second", smaxSubscribe(TABLE, "second"));
+  waitFor("resubscribe", patterns, 1);
+
+  checkStatus("unsubscribe first again", smaxUnsubscribe(TABLE, "first"));
+  checkStatus("unsubscribe second again", smaxUnsubscribe(TABLE, "second"));
+  waitFor("unsubscribe again", patterns, 0);
+
+  smaxDisconnect();
+
+  printf("subscribe: OK\n");
+  return 0;
+}
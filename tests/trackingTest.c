@@ -0,0 +1,158 @@
+/**
+ * @file
+ *
+ * @date Created on: Oct 16, 2026
+ * @author Attila Kovacs
+ *
+ *      This program tests server-assisted invalidation of the lazy cache (Redis 6 or later). The parent
+ *      process caches a variable with tracking enabled, while a child process updates it on its own
+ *      connection. The parent's cached value must refresh, without it subscribing to the variable's
+ *      update notifications.
+ */
+
+#define _POSIX_C_SOURCE 199309L       ///< for nanosleep()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/wait.h>
+
+#include "smax.h"
+
+#define TABLE   "_test_" X_SEP "tracking"
+#define NAME    "value"
+
+static void checkStatus(char *op, int status) {
+  if(!status) return;
+  fprintf(stderr, "ERROR! %s: %s\n", op, smaxErrorDescription(status));
+  exit(-1);
+}
+
+// Updates the variable on the child's own connection, once the parent is ready.
+static int RunWriter(int fd) {
+  char go;
+
+  if(read(fd, &go, 1) != 1) {
+    perror("ERROR! writer read()");
+    return -1;
+  }
+
+  checkStatus("writer connect", smaxConnect());
+  checkStatus("writer share", smaxShareInt(TABLE, NAME, 2));
+
+  // Pulling on the same connection makes sure the share was processed before we disconnect.
+  if(smaxPullInt(TABLE, NAME, -1) != 2) {
+    fprintf(stderr, "ERROR! writer could not update the variable.\n");
+    return -1;
+  }
+
+  smaxDisconnect();
+  return 0;
+}
+
+// Returns the number of clients subscribed to the variable's update notifications exactly.
+static int countSubscribers() {
+  RESP *reply;
+  int status = X_SUCCESS, n;
+
+  reply = redisxRequest(smaxGetRedis(), "PUBSUB", "NUMSUB", SMAX_UPDATES TABLE X_SEP NAME, NULL, &status);
+  checkStatus("numsub", status);
+  checkStatus("numsub reply", redisxCheckRESP(reply, RESP_ARRAY, 2));
+
+  n = ((RESP **) reply->value)[1]->n;
+  redisxDestroyRESP(reply);
+
+  return n;
+}
+
+int main() {
+  struct timespec interval = { 0, 10000000 }; // 10 ms
+  pid_t pid;
+  int fd[2], i, status, value = -1;
+
+  xSetDebug(TRUE);
+
+  if(pipe(fd) < 0) {
+    perror("pipe");
+    exit(-1);
+  }
+
+  // Fork before connecting, so the child has its own connection.
+  pid = fork();
+  if(pid < 0) {
+    perror("fork");
+    exit(-1);
+  }
+
+  if(pid == 0) {
+    close(fd[1]);
+    exit(RunWriter(fd[0]));
+  }
+
+  close(fd[0]);
+
+  checkStatus("tracking", smaxSetLazyTracking(TRUE, TABLE));
+  checkStatus("connect", smaxConnect());
+
+  if(!smaxIsLazyTracking()) {
+    fprintf(stderr, "ERROR! Tracking is not active.\n");
+    exit(-1);
+  }
+
+  checkStatus("share", smaxShareInt(TABLE, NAME, 1));
+  while(smaxPullInt(TABLE, NAME, -1) != 1) continue;
+
+  checkStatus("cache", smaxCache(TABLE, NAME, X_INT));
+  checkStatus("get cached", smaxGetCached(TABLE, NAME, X_INT, 1, &value, NULL));
+
+  if(value != 1) {
+    fprintf(stderr, "ERROR! Cached %d, expected 1.\n", value);
+    exit(-1);
+  }
+
+  if(countSubscribers() != 0) {
+    fprintf(stderr, "ERROR! Tracked variable is subscribed to.\n");
+    exit(-1);
+  }
+
+  // Let the child update the variable.
+  if(write(fd[1], "!", 1) != 1) {
+    perror("write");
+    exit(-1);
+  }
+
+  if(waitpid(pid, &status, 0) < 0) {
+    perror("waitpid");
+    exit(-1);
+  }
+
+  if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    fprintf(stderr, "ERROR! Writer process failed.\n");
+    exit(-1);
+  }
+
+  // Wait for the invalidation to refresh the cached value
+  for(i = 0; i < 500; i++) {
+    checkStatus("get cached", smaxGetCached(TABLE, NAME, X_INT, 1, &value, NULL));
+    if(value == 2) break;
+    nanosleep(&interval, NULL);
+  }
+
+  if(value != 2) {
+    fprintf(stderr, "ERROR! Cached value was not refreshed (%d).\n", value);
+    exit(-1);
+  }
+
+  if(countSubscribers() != 0) {
+    fprintf(stderr, "ERROR! Tracked variable was subscribed to.\n");
+    exit(-1);
+  }
+
+  smaxLazyEnd(TABLE, NAME);
+  smaxDisconnect();
+
+  printf("tracking: OK\n");
+  return 0;
+}
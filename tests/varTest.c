@@ -0,0 +1,76 @@
+/**
+ * @file
+ *
+ * @date Created on: Oct 16, 2026
+ * @author Attila Kovacs
+ *
+ *      This program demonstrates and tests sharing and pulling data via pre-resolved variable
+ *      handles, interactively, lazily, and via the pipeline.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "smax.h"
+
+#define TABLE   "_test_" X_SEP "var"
+#define NAME    "doubles"
+#define COUNT   3
+
+static void checkStatus(char *op, int status) {
+  if(status >= 0) return;
+  fprintf(stderr, "ERROR! %s: %s\n", op, smaxErrorDescription(status));
+  exit(-1);
+}
+
+static void checkValues(char *op, const double *a, const double *b) {
+  int i;
+
+  for(i = 0; i < COUNT; i++) if(a[i] != b[i]) {
+    fprintf(stderr, "ERROR! %s: value mismatch at [%d]: %g vs %g\n", op, i, a[i], b[i]);
+    exit(-1);
+  }
+}
+
+int main() {
+  double in[COUNT] = { 1.0, -2.5, 3.14159265 };
+  double out[COUNT] = {0.0};
+  SmaxVar *v;
+
+  xSetDebug(TRUE);
+
+  checkStatus("connect", smaxConnect());
+
+  v = smaxCreateVar(TABLE, NAME, X_DOUBLE, COUNT);
+  if(!v) {
+    fprintf(stderr, "ERROR! could not create variable handle.\n");
+    exit(-1);
+  }
+
+  checkStatus("share", smaxShareVar(v, in));
+
+  // The interactive pull follows the share on the same connection.
+  checkStatus("pull", smaxPullVar(v, out, NULL));
+  checkValues("pull", in, out);
+
+  out[0] = 0.0;
+  checkStatus("queue", smaxQueueVar(v, out, NULL));
+  checkStatus("wait", smaxWaitQueueComplete(3000));
+  checkValues("queue", in, out);
+
+  checkStatus("lazy", smaxLazyPullVar(v, out, NULL));
+  checkValues("lazy", in, out);
+
+  // Again, from the lazy cache this time...
+  checkStatus("lazy", smaxLazyPullVar(v, out, NULL));
+  checkValues("lazy (cached)", in, out);
+
+  smaxLazyFlush();
+  smaxDestroyVar(v);
+
+  checkStatus("disconnect", smaxDisconnect());
+
+  printf("OK\n");
+  return 0;
+}
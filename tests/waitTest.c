@@ -31,6 +31,9 @@
 // Variables updated by the polling thread and checked/reported by main()
 static int gotUpdate = FALSE;
 
+// Counters of the updates routed to our subscriber callbacks
+static int nRouted, nMisrouted;
+
 static void checkStatus(char *op, int status) {
   if(!status) return;
   fprintf(stderr, "ERROR! %s: %s\n", op, smaxErrorDescription(status));
@@ -38,6 +41,24 @@ static void checkStatus(char *op, int status) {
 }
 
 
+static void RoutedSubscriber(const char *pattern, const char *channel, const char *msg, long length) {
+  (void) pattern;
+  (void) channel;
+  (void) msg;
+  (void) length;
+
+  __atomic_add_fetch(&nRouted, 1, __ATOMIC_RELAXED);
+}
+
+static void OtherSubscriber(const char *pattern, const char *channel, const char *msg, long length) {
+  (void) pattern;
+  (void) msg;
+  (void) length;
+
+  fprintf(stderr, "ERROR! Misrouted update on %s\n", channel);
+  __atomic_add_fetch(&nMisrouted, 1, __ATOMIC_RELAXED);
+}
+
 // This thread will be running in the background, pounding on a variable
 // without causing unnecessary network traffic. It will exit normally
 // when it detects a change of the checked value.
@@ -87,6 +108,68 @@ int main() {
 
   checkStatus("subscribe", smaxSubscribe(TABLE, NAME));
 
+  // Check subscribing to several variables at once...
+  {
+    const char *tables[] = { TABLE, TABLE, TABLE };
+    const char *keys[] = { "other1", "other2", "other1" };
+    XEventQueue *q;
+    XEvent e;
+
+    checkStatus("subscribe many", smaxSubscribeMany(tables, keys, 3));
+
+    q = smaxCreateEventQueue(TABLE, "other2", 0);
+    checkStatus("share other", smaxShareInt(TABLE, "other2", 1));
+    checkStatus("other event", smaxNextEvent(q, &e, 1000 * SMAX_TEST_TIMEOUT));
+    smaxClearEvent(&e);
+    smaxDestroyEventQueue(q);
+
+    checkStatus("unsubscribe many", smaxUnsubscribeMany(tables, keys, 3));
+  }
+
+  // Check that a burst of updates is queued for us, without losing any...
+  {
+    XEventQueue *q = smaxCreateEventQueue(TABLE, "val*", 0);
+    XEventQueueStats stats;
+    int i;
+
+    // Only the subscriber for our table should be called...
+    checkStatus("add subscriber", smaxAddSubscriber(TABLE, RoutedSubscriber));
+    checkStatus("add other subscriber", smaxAddSubscriber("_test_" X_SEP "other", OtherSubscriber));
+
+    for(i = 0; i < 10; i++) checkStatus("burst", smaxShareInt(TABLE, NAME, 10 + i));
+
+    for(i = 0; i < 10; i++) {
+      XEvent e;
+      checkStatus("next event", smaxNextEvent(q, &e, 1000 * SMAX_TEST_TIMEOUT));
+      if(strcmp(e.key, NAME) || e.dropped) {
+        fprintf(stderr, "ERROR! Unexpected event for %s (%d dropped).\n", e.key, e.dropped);
+        exit(-1);
+      }
+      smaxClearEvent(&e);
+    }
+
+    checkStatus("event stats", smaxGetEventQueueStats(q, &stats));
+    if(stats.received != 10 || stats.overflows) {
+      fprintf(stderr, "ERROR! Event queue received %ld, dropped %ld.\n", stats.received, stats.overflows);
+      exit(-1);
+    }
+
+    smaxDestroyEventQueue(q);
+
+    for(i = 100 * SMAX_TEST_TIMEOUT; --i >= 0 && __atomic_load_n(&nRouted, __ATOMIC_RELAXED) < 10; ) {
+      struct timespec interval = { 0, 10000000 }; // 10 ms
+      nanosleep(&interval, NULL);
+    }
+
+    smaxRemoveSubscribers(RoutedSubscriber);
+    smaxRemoveSubscribers(OtherSubscriber);
+
+    if(nRouted != 10 || nMisrouted) {
+      fprintf(stderr, "ERROR! Subscriber got %d updates, and %d misrouted.\n", nRouted, nMisrouted);
+      exit(-1);
+    }
+  }
+
   // Start the thread that will wait on a change...
   if(pthread_create(&tid, NULL, WaitingThread, NULL)) {
     perror("create WaitingThread");